@@ -8,6 +8,7 @@
 #include "utils.h"
 
 #include "esp_log.h"
+#include "deflog.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "frequency_transition_bmXX.h"
@@ -305,7 +306,7 @@ task_result * BM1368_process_work(GlobalState * GLOBAL_STATE)
     uint8_t core_id = (uint8_t)((ntohl(asic_result.nonce) >> 25) & 0x7f);
     uint8_t small_core_id = asic_result.job_id & 0x0f;
     uint32_t version_bits = (ntohs(asic_result.version) << 13);
-    ESP_LOGI(TAG, "Job ID: %02X, Core: %d/%d, Ver: %08" PRIX32, job_id, core_id, small_core_id, version_bits);
+    DEFLOG_I(TAG, "Job ID: %02X, Core: %d/%d, Ver: %08" PRIX32, job_id, core_id, small_core_id, version_bits);
 
     // GlobalState * GLOBAL_STATE = (GlobalState *) pvParameters;
 
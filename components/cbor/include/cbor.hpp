@@ -0,0 +1,188 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <bit>
+#include <type_traits>
+
+/*
+    Minimal CBOR (RFC 8949) encoding primitives.
+    All functions write to a caller-supplied buffer, which must have room for
+    at least MAX_HEAD_SIZE bytes, and return the number of bytes written.
+*/
+namespace cbor {
+
+    enum class Major : uint8_t {
+        UINT = 0,
+        NINT = 1,
+        BYTES = 2,
+        TEXT = 3,
+        ARRAY = 4,
+        MAP = 5,
+        TAG = 6,
+        SIMPLE = 7
+    };
+
+    static constexpr std::size_t MAX_HEAD_SIZE = 9;
+
+    static constexpr uint8_t INDEF_ARRAY = 0x9f;
+    static constexpr uint8_t INDEF_MAP = 0xbf;
+    static constexpr uint8_t BREAK = 0xff;
+
+    static constexpr uint8_t SIMPLE_FALSE = 0xf4;
+    static constexpr uint8_t SIMPLE_TRUE = 0xf5;
+    static constexpr uint8_t SIMPLE_NULL = 0xf6;
+
+    /**
+     * @brief Tag 262: "embedded JSON", a text string containing JSON.
+     */
+    static constexpr uint32_t TAG_JSON = 262;
+
+    static constexpr uint8_t initialByte(const Major major, const uint8_t info) {
+        return ((uint8_t)major << 5) | info;
+    }
+
+    /**
+     * @brief Encodes the head of a data item, i.e. major type plus argument
+     * in the shortest form.
+     */
+    static constexpr std::size_t head(const Major major, const uint64_t arg, uint8_t* const out) {
+        if(arg < 24) {
+            out[0] = initialByte(major, arg);
+            return 1;
+        } else {
+            unsigned bytes;
+            uint8_t info;
+            if(arg <= 0xff) {
+                bytes = 1;
+                info = 24;
+            } else
+            if(arg <= 0xffff) {
+                bytes = 2;
+                info = 25;
+            } else
+            if(arg <= 0xffffffff) {
+                bytes = 4;
+                info = 26;
+            } else {
+                bytes = 8;
+                info = 27;
+            }
+            out[0] = initialByte(major, info);
+            // Big endian:
+            for(unsigned i = 0; i < bytes; ++i) {
+                out[bytes-i] = (uint8_t)(arg >> (8*i));
+            }
+            return bytes + 1;
+        }
+    }
+
+    template<typename T> requires std::is_integral_v<T>
+    static constexpr std::size_t encodeInt(const T value, uint8_t* const out) {
+        if constexpr (std::is_signed_v<T>) {
+            if(value < 0) {
+                // -1 - n
+                return head(Major::NINT, (uint64_t)(-(value + 1)), out);
+            }
+        }
+        return head(Major::UINT, (uint64_t)value, out);
+    }
+
+    namespace detail {
+
+        /**
+         * @brief Converts \p value to IEEE 754 binary16 if that can be done without
+         * loss of precision.
+         * 
+         * @return true if \p half holds the exact value
+         */
+        static constexpr bool toHalf(const float value, uint16_t& half) {
+            const uint32_t bits = std::bit_cast<uint32_t>(value);
+            const uint16_t sign = (bits >> 16) & 0x8000;
+            const int32_t exp = (int32_t)((bits >> 23) & 0xff);
+            const uint32_t mant = bits & 0x7fffff;
+
+            if(exp == 0xff) {
+                // Inf or NaN; only keep NaNs whose payload fits.
+                if((mant & 0x1fff) != 0) {
+                    return false;
+                }
+                half = sign | 0x7c00 | (mant >> 13);
+                return true;
+            }
+            if(exp == 0 && mant == 0) {
+                half = sign;
+                return true;
+            }
+
+            const int32_t hexp = exp - 127 + 15;
+            if(hexp <= 0 || hexp >= 0x1f) {
+                // Would need half-precision subnormals or overflow; not worth it.
+                return false;
+            }
+            if((mant & 0x1fff) != 0) {
+                return false;
+            }
+            half = sign | (uint16_t)(hexp << 10) | (uint16_t)(mant >> 13);
+            return true;
+        }
+
+        static constexpr std::size_t putBE(const uint8_t ib, const uint64_t v, const unsigned bytes, uint8_t* const out) {
+            out[0] = ib;
+            for(unsigned i = 0; i < bytes; ++i) {
+                out[bytes-i] = (uint8_t)(v >> (8*i));
+            }
+            return bytes + 1;
+        }
+
+    }
+
+    /**
+     * @brief Encodes a float as half precision if that is exact, else as single precision.
+     */
+    static constexpr std::size_t encodeFloat(const float value, uint8_t* const out) {
+        uint16_t half = 0;
+        if(detail::toHalf(value, half)) {
+            return detail::putBE(initialByte(Major::SIMPLE, 25), half, 2, out);
+        } else {
+            return detail::putBE(initialByte(Major::SIMPLE, 26), std::bit_cast<uint32_t>(value), 4, out);
+        }
+    }
+
+    /**
+     * @brief Encodes a double in the shortest of the three IEEE formats which
+     * represents it exactly.
+     */
+    static constexpr std::size_t encodeDouble(const double value, uint8_t* const out) {
+        const float f = (float)value;
+        if((double)f == value || value != value) {
+            return encodeFloat(f, out);
+        } else {
+            return detail::putBE(initialByte(Major::SIMPLE, 27), std::bit_cast<uint64_t>(value), 8, out);
+        }
+    }
+
+    template<typename T> requires std::is_arithmetic_v<T>
+    static constexpr std::size_t encodeNumber(const T value, uint8_t* const out) {
+        if constexpr (std::is_integral_v<T>) {
+            return encodeInt(value, out);
+        } else
+        if constexpr (sizeof(T) <= sizeof(float)) {
+            return encodeFloat(value, out);
+        } else {
+            return encodeDouble(value, out);
+        }
+    }
+
+    /**
+     * @brief Encodes the head of a text string of \p len bytes; the string's bytes
+     * must follow.
+     */
+    static constexpr std::size_t textHead(const std::size_t len, uint8_t* const out) {
+        return head(Major::TEXT, len, out);
+    }
+
+    static constexpr std::size_t tag(const uint64_t tagNo, uint8_t* const out) {
+        return head(Major::TAG, tagNo, out);
+    }
+
+}
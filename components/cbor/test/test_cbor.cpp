@@ -0,0 +1,181 @@
+#include "unity.h"
+#include "cbor.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+// Test vectors from RFC 8949, Appendix A.
+
+template<typename T>
+static void checkNumber(const T value, const uint8_t* const expected, const std::size_t len) {
+    uint8_t buf[cbor::MAX_HEAD_SIZE];
+    const std::size_t n = cbor::encodeNumber(value, buf);
+    TEST_ASSERT_EQUAL(len, n);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, buf, len);
+}
+
+#define CHECK_NUMBER(value, ...) do { \
+        const uint8_t exp[] = {__VA_ARGS__}; \
+        checkNumber((value), exp, sizeof(exp)); \
+    } while(0)
+
+TEST_CASE("Encode CBOR integers", "[cbor]")
+{
+    CHECK_NUMBER(0, 0x00);
+    CHECK_NUMBER(23, 0x17);
+    CHECK_NUMBER(24, 0x18, 0x18);
+    CHECK_NUMBER(100, 0x18, 0x64);
+    CHECK_NUMBER(1000, 0x19, 0x03, 0xe8);
+    CHECK_NUMBER(1000000, 0x1a, 0x00, 0x0f, 0x42, 0x40);
+    CHECK_NUMBER(1000000000000ULL, 0x1b, 0x00, 0x00, 0x00, 0xe8, 0xd4, 0xa5, 0x10, 0x00);
+    CHECK_NUMBER(UINT64_MAX, 0x1b, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff);
+    CHECK_NUMBER(-1, 0x20);
+    CHECK_NUMBER(-10, 0x29);
+    CHECK_NUMBER(-100, 0x38, 0x63);
+    CHECK_NUMBER(-1000, 0x39, 0x03, 0xe7);
+    CHECK_NUMBER((int8_t)-128, 0x38, 0x7f);
+    CHECK_NUMBER(INT64_MIN, 0x3b, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff);
+}
+
+TEST_CASE("Encode CBOR floats", "[cbor]")
+{
+    CHECK_NUMBER(0.0f, 0xf9, 0x00, 0x00);
+    CHECK_NUMBER(-0.0f, 0xf9, 0x80, 0x00);
+    CHECK_NUMBER(1.0f, 0xf9, 0x3c, 0x00);
+    CHECK_NUMBER(1.5f, 0xf9, 0x3e, 0x00);
+    CHECK_NUMBER(65504.0f, 0xf9, 0x7b, 0xff);
+    CHECK_NUMBER(-4.0f, 0xf9, 0xc4, 0x00);
+    CHECK_NUMBER(100000.0f, 0xfa, 0x47, 0xc3, 0x50, 0x00);
+    CHECK_NUMBER(3.4028234663852886e+38f, 0xfa, 0x7f, 0x7f, 0xff, 0xff);
+    CHECK_NUMBER(std::numeric_limits<float>::infinity(), 0xf9, 0x7c, 0x00);
+    CHECK_NUMBER(-std::numeric_limits<float>::infinity(), 0xf9, 0xfc, 0x00);
+    CHECK_NUMBER(std::numeric_limits<float>::quiet_NaN(), 0xf9, 0x7e, 0x00);
+
+    CHECK_NUMBER(1.1, 0xfb, 0x3f, 0xf1, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9a);
+    CHECK_NUMBER(1.0e+300, 0xfb, 0x7e, 0x37, 0xe4, 0x3c, 0x88, 0x00, 0x75, 0x9c);
+    // Doubles which are exact floats use the shorter encoding:
+    CHECK_NUMBER(1.5, 0xf9, 0x3e, 0x00);
+    CHECK_NUMBER(100000.0, 0xfa, 0x47, 0xc3, 0x50, 0x00);
+}
+
+TEST_CASE("Encode CBOR heads", "[cbor]")
+{
+    uint8_t buf[cbor::MAX_HEAD_SIZE];
+
+    // "IETF"
+    TEST_ASSERT_EQUAL(1, cbor::textHead(4, buf));
+    TEST_ASSERT_EQUAL_HEX8(0x64, buf[0]);
+
+    TEST_ASSERT_EQUAL(3, cbor::textHead(300, buf));
+    TEST_ASSERT_EQUAL_HEX8(0x79, buf[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, buf[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x2c, buf[2]);
+
+    TEST_ASSERT_EQUAL(3, cbor::tag(cbor::TAG_JSON, buf));
+    TEST_ASSERT_EQUAL_HEX8(0xd9, buf[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, buf[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x06, buf[2]);
+}
+
+/*
+    Minimal decoder, just enough to read back the numbers we encode.
+*/
+static const uint8_t* decodeNumber(const uint8_t* p, double& out) {
+    const uint8_t major = p[0] >> 5;
+    const uint8_t info = p[0] & 0x1f;
+    ++p;
+    uint64_t arg = info;
+    unsigned bytes = 0;
+    if(info == 24) bytes = 1;
+    if(info == 25) bytes = 2;
+    if(info == 26) bytes = 4;
+    if(info == 27) bytes = 8;
+    if(bytes != 0) {
+        arg = 0;
+        for(unsigned i = 0; i < bytes; ++i) {
+            arg = (arg << 8) | *p++;
+        }
+    }
+    switch(major) {
+        case 0:
+            out = (double)arg;
+            break;
+        case 1:
+            out = -1.0 - (double)arg;
+            break;
+        case 7:
+            if(bytes == 2) {
+                const int exp = (arg >> 10) & 0x1f;
+                const double mant = (double)(arg & 0x3ff);
+                double v = (exp == 0) ? std::ldexp(mant, -24) : std::ldexp(mant + 1024, exp - 25);
+                if(exp == 0x1f) {
+                    v = (mant == 0) ? INFINITY : NAN;
+                }
+                out = (arg & 0x8000) ? -v : v;
+            } else
+            if(bytes == 4) {
+                const uint32_t u = (uint32_t)arg;
+                float f;
+                std::memcpy(&f, &u, sizeof(f));
+                out = f;
+            } else {
+                std::memcpy(&out, &arg, sizeof(out));
+            }
+            break;
+        default:
+            TEST_FAIL_MESSAGE("Unexpected major type");
+    }
+    return p;
+}
+
+TEST_CASE("CBOR number round trip", "[cbor]")
+{
+    static const float FLOATS[] = {
+        0.0f, 1.0f, -1.0f, 0.5f, 55.25f, 61.3f, 1234.567f, 5.12f, 0.001f, -273.15f, 1e-10f, 3e38f
+    };
+    static const int64_t INTS[] = {
+        0, 1, 23, 24, 255, 256, 65535, 65536, -1, -24, -25, -256, -257, 4294967295LL, 4294967296LL, -4294967296LL
+    };
+
+    uint8_t buf[cbor::MAX_HEAD_SIZE];
+    double d;
+
+    for(const float f : FLOATS) {
+        const std::size_t n = cbor::encodeFloat(f, buf);
+        TEST_ASSERT_EQUAL_PTR(buf + n, decodeNumber(buf, d));
+        TEST_ASSERT_EQUAL_FLOAT(f, (float)d);
+    }
+
+    for(const int64_t i : INTS) {
+        const std::size_t n = cbor::encodeInt(i, buf);
+        TEST_ASSERT_EQUAL_PTR(buf + n, decodeNumber(buf, d));
+        TEST_ASSERT_TRUE((double)i == d);
+    }
+}
+
+TEST_CASE("CBOR vs. JSON size of a statistics sample", "[cbor]")
+{
+    // A typical /api/system/statistics row:
+    // [hashRate,temp,vrTemp,power,voltage,current,coreVoltageActual,fanspeed,fanrpm,wifiRSSI,freeHeap,timestamp]
+    const float floats[] = {1123.456f, 61.25f, 52.5f, 18.75f, 5112.5f, 3667.97f};
+    const int32_t ints[] = {1150, 58, 5210, -57, 187436, 864000};
+
+    char json[256];
+    int jsonLen = std::snprintf(json, sizeof(json), "[%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%ld,%ld,%ld,%ld,%ld,%ld]",
+        floats[0], floats[1], floats[2], floats[3], floats[4], floats[5],
+        (long)ints[0], (long)ints[1], (long)ints[2], (long)ints[3], (long)ints[4], (long)ints[5]);
+
+    std::size_t cborLen = 2; // indefinite array start + break
+    uint8_t buf[cbor::MAX_HEAD_SIZE];
+    for(const float f : floats) {
+        cborLen += cbor::encodeFloat(f, buf);
+    }
+    for(const int32_t i : ints) {
+        cborLen += cbor::encodeInt(i, buf);
+    }
+
+    printf("Statistics sample: JSON %d bytes, CBOR %u bytes\n", jsonLen, (unsigned)cborLen);
+    TEST_ASSERT_LESS_THAN(jsonLen, (int)cborLen);
+}
@@ -0,0 +1,270 @@
+#include "unity.h"
+#include "cbor.hpp"
+#include "cJSON.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/*
+    Builds documents from the cbor.hpp primitives, decodes them into cJSON
+    trees and compares those with the same documents written as JSON.
+    Float values are chosen to be exact in JSON.
+*/
+
+namespace {
+
+    struct Encoder {
+        uint8_t buf[1024];
+        std::size_t len = 0;
+
+        void byte(const uint8_t b) {
+            TEST_ASSERT_TRUE(len < sizeof(buf));
+            buf[len++] = b;
+        }
+
+        void text(const char* const str) {
+            const std::size_t n = std::strlen(str);
+            TEST_ASSERT_TRUE(len + cbor::MAX_HEAD_SIZE + n <= sizeof(buf));
+            len += cbor::textHead(n, buf + len);
+            std::memcpy(buf + len, str, n);
+            len += n;
+        }
+
+        template<typename T>
+        void number(const T value) {
+            TEST_ASSERT_TRUE(len + cbor::MAX_HEAD_SIZE <= sizeof(buf));
+            len += cbor::encodeNumber(value, buf + len);
+        }
+
+        void boolean(const bool value) {
+            byte(value ? cbor::SIMPLE_TRUE : cbor::SIMPLE_FALSE);
+        }
+
+        void embeddedJson(const char* const json) {
+            TEST_ASSERT_TRUE(len + cbor::MAX_HEAD_SIZE <= sizeof(buf));
+            len += cbor::tag(cbor::TAG_JSON, buf + len);
+            text(json);
+        }
+    };
+
+}
+
+/*
+    Decoder for the encoded documents, building the equivalent cJSON tree.
+*/
+static const uint8_t* decodeItem(const uint8_t* p, const uint8_t* const end, cJSON** const out);
+
+static const uint8_t* decodeArg(const uint8_t* p, uint64_t& arg, unsigned& bytes) {
+    const uint8_t info = p[0] & 0x1f;
+    ++p;
+    arg = info;
+    bytes = 0;
+    if(info >= 24 && info <= 27) {
+        bytes = 1u << (info - 24);
+        arg = 0;
+        for(unsigned i = 0; i < bytes; ++i) {
+            arg = (arg << 8) | *p++;
+        }
+    }
+    return p;
+}
+
+static double decodeFloat(const uint64_t arg, const unsigned bytes) {
+    if(bytes == 2) {
+        const int exp = (arg >> 10) & 0x1f;
+        const double mant = (double)(arg & 0x3ff);
+        double v = (exp == 0) ? std::ldexp(mant, -24) : std::ldexp(mant + 1024, exp - 25);
+        return (arg & 0x8000) ? -v : v;
+    } else
+    if(bytes == 4) {
+        const uint32_t u = (uint32_t)arg;
+        float f;
+        std::memcpy(&f, &u, sizeof(f));
+        return f;
+    } else {
+        double d;
+        std::memcpy(&d, &arg, sizeof(d));
+        return d;
+    }
+}
+
+static char* decodeText(const uint8_t*& p, const uint8_t* const end) {
+    TEST_ASSERT_EQUAL_HEX8((uint8_t)cbor::Major::TEXT, p[0] >> 5);
+    uint64_t len;
+    unsigned bytes;
+    p = decodeArg(p, len, bytes);
+    TEST_ASSERT_TRUE(p + len <= end);
+    char* const str = (char*)std::malloc(len + 1);
+    std::memcpy(str, p, len);
+    str[len] = '\0';
+    p += len;
+    return str;
+}
+
+static const uint8_t* decodeItem(const uint8_t* p, const uint8_t* const end, cJSON** const out) {
+    TEST_ASSERT_TRUE(p < end);
+    const uint8_t ib = p[0];
+    const uint8_t major = ib >> 5;
+    uint64_t arg;
+    unsigned bytes;
+
+    if(ib == cbor::INDEF_ARRAY) {
+        ++p;
+        cJSON* const arr = cJSON_CreateArray();
+        while(p < end && *p != cbor::BREAK) {
+            cJSON* item;
+            p = decodeItem(p, end, &item);
+            cJSON_AddItemToArray(arr, item);
+        }
+        TEST_ASSERT_TRUE(p < end);
+        *out = arr;
+        return p + 1;
+    }
+    if(ib == cbor::INDEF_MAP) {
+        ++p;
+        cJSON* const obj = cJSON_CreateObject();
+        while(p < end && *p != cbor::BREAK) {
+            char* const key = decodeText(p, end);
+            cJSON* item;
+            p = decodeItem(p, end, &item);
+            cJSON_AddItemToObject(obj, key, item);
+            std::free(key);
+        }
+        TEST_ASSERT_TRUE(p < end);
+        *out = obj;
+        return p + 1;
+    }
+
+    switch(major) {
+        case (uint8_t)cbor::Major::UINT:
+            p = decodeArg(p, arg, bytes);
+            *out = cJSON_CreateNumber((double)arg);
+            break;
+        case (uint8_t)cbor::Major::NINT:
+            p = decodeArg(p, arg, bytes);
+            *out = cJSON_CreateNumber(-1.0 - (double)arg);
+            break;
+        case (uint8_t)cbor::Major::TEXT: {
+            char* const str = decodeText(p, end);
+            *out = cJSON_CreateString(str);
+            std::free(str);
+            break;
+        }
+        case (uint8_t)cbor::Major::TAG: {
+            p = decodeArg(p, arg, bytes);
+            TEST_ASSERT_EQUAL_UINT32(cbor::TAG_JSON, (uint32_t)arg);
+            char* const json = decodeText(p, end);
+            *out = cJSON_Parse(json);
+            std::free(json);
+            TEST_ASSERT_NOT_NULL(*out);
+            break;
+        }
+        case (uint8_t)cbor::Major::SIMPLE:
+            if(ib == cbor::SIMPLE_FALSE || ib == cbor::SIMPLE_TRUE) {
+                *out = cJSON_CreateBool(ib == cbor::SIMPLE_TRUE);
+                ++p;
+            } else
+            if(ib == cbor::SIMPLE_NULL) {
+                *out = cJSON_CreateNull();
+                ++p;
+            } else {
+                p = decodeArg(p, arg, bytes);
+                TEST_ASSERT_TRUE(bytes >= 2);
+                *out = cJSON_CreateNumber(decodeFloat(arg, bytes));
+            }
+            break;
+        default:
+            TEST_FAIL_MESSAGE("Unexpected major type");
+    }
+    TEST_ASSERT_TRUE(p <= end);
+    return p;
+}
+
+/**
+ * @brief Checks that \p enc decodes to the same document as \p json and
+ * prints both sizes.
+ */
+static void compare(const char* const name, const Encoder& enc, const char* const json) {
+    cJSON* const fromJson = cJSON_Parse(json);
+    TEST_ASSERT_NOT_NULL(fromJson);
+
+    cJSON* fromCbor = nullptr;
+    const uint8_t* const end = enc.buf + enc.len;
+    TEST_ASSERT_EQUAL_PTR(end, decodeItem(enc.buf, end, &fromCbor));
+
+    TEST_ASSERT_TRUE(cJSON_Compare(fromJson, fromCbor, true));
+
+    printf("%s: JSON %u bytes, CBOR %u bytes\n", name, (unsigned)std::strlen(json), (unsigned)enc.len);
+
+    cJSON_Delete(fromCbor);
+    cJSON_Delete(fromJson);
+}
+
+TEST_CASE("CBOR maps and arrays decode like the same JSON", "[cbor]")
+{
+    Encoder e;
+    e.byte(cbor::INDEF_MAP);
+        e.text("model");
+        e.text("BM1370");
+        e.text("count");
+        e.number((int32_t)1);
+        e.text("port");
+        e.number((int32_t)21496);
+        e.text("rssi");
+        e.number((int32_t)-57);
+        e.text("uptime");
+        e.number((int64_t)5000000000LL);
+        e.text("power");
+        e.number(18.75f);
+        e.text("voltage");
+        e.number(5112.5f);
+        e.text("hashRate");
+        e.number(1123.375f);
+        e.text("enabled");
+        e.boolean(false);
+        e.text("user");
+        e.text("bc1qnp980s5fpp8l94p5cvttmtdqy8rvrq74qly2yrfmzkdsntqzlc5qkc4rkq.bitaxe");
+
+        e.text("options");
+        e.byte(cbor::INDEF_ARRAY);
+            e.number((int32_t)400);
+            e.number((int32_t)525);
+            e.number((int32_t)0);
+        e.byte(cbor::BREAK);
+
+        e.text("reasons");
+        e.byte(cbor::INDEF_ARRAY);
+            e.byte(cbor::INDEF_MAP);
+                e.text("message");
+                e.text("Job not found");
+                e.text("count");
+                e.number((int32_t)16);
+            e.byte(cbor::BREAK);
+            e.byte(cbor::INDEF_MAP);
+            e.byte(cbor::BREAK);
+        e.byte(cbor::BREAK);
+    e.byte(cbor::BREAK);
+
+    compare("nested document", e,
+        "{\"model\":\"BM1370\",\"count\":1,\"port\":21496,\"rssi\":-57,\"uptime\":5000000000,"
+        "\"power\":18.75,\"voltage\":5112.5,\"hashRate\":1123.375,\"enabled\":false,"
+        "\"user\":\"bc1qnp980s5fpp8l94p5cvttmtdqy8rvrq74qly2yrfmzkdsntqzlc5qkc4rkq.bitaxe\","
+        "\"options\":[400,525,0],"
+        "\"reasons\":[{\"message\":\"Job not found\",\"count\":16},{}]}");
+}
+
+TEST_CASE("CBOR embedded JSON round trip", "[cbor]")
+{
+    Encoder e;
+    e.byte(cbor::INDEF_MAP);
+        e.text("accentColors");
+        e.embeddedJson("{\"--primary-color\":\"#F80421\",\"n\":[1,2.5,null]}");
+        e.text("nothing");
+        e.byte(cbor::SIMPLE_NULL);
+    e.byte(cbor::BREAK);
+
+    compare("embedded JSON", e,
+        "{\"accentColors\":{\"--primary-color\":\"#F80421\",\"n\":[1,2.5,null]},\"nothing\":null}");
+}
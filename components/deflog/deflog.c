@@ -0,0 +1,341 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+
+#include "deflog.h"
+#include "deflog_ring.h"
+
+static const char * const TAG = "deflog";
+
+#define BUFFER_SIZE (CONFIG_DEFLOG_BUFFER_SIZE & ~(size_t)7)
+
+_Static_assert(BUFFER_SIZE >= 2 * DEFLOG_MAX_RECORD_SIZE, "CONFIG_DEFLOG_BUFFER_SIZE too small for CONFIG_DEFLOG_STR_MAX");
+
+typedef deflog_record_t record_t;
+
+/*
+    Each core has its own ring of records, so writers only ever contend with
+    the printing task and with tasks preempting them on the same core.
+*/
+static deflog_ring_t rings[portNUM_PROCESSORS];
+static TaskHandle_t printTask;
+static uint64_t formatTimeUs;
+
+volatile uint32_t deflog_level_gen = 1;
+
+static const char * const LINE_FORMATS[] = {
+    [ESP_LOG_NONE] = "%s",
+    [ESP_LOG_ERROR] = LOG_FORMAT(E, "%s"),
+    [ESP_LOG_WARN] = LOG_FORMAT(W, "%s"),
+    [ESP_LOG_INFO] = LOG_FORMAT(I, "%s"),
+    [ESP_LOG_DEBUG] = LOG_FORMAT(D, "%s"),
+    [ESP_LOG_VERBOSE] = LOG_FORMAT(V, "%s"),
+};
+
+static int format_int(char* const out, const size_t size, char* const spec, size_t sl, const char conv, const deflog_arg_t* const a)
+{
+    switch (a->type) {
+        case DEFLOG_ARG_I32:
+        case DEFLOG_ARG_U32:
+        case DEFLOG_ARG_PTR:
+            spec[sl++] = conv;
+            spec[sl] = '\0';
+            return snprintf(out, size, spec, (unsigned)a->u32);
+        case DEFLOG_ARG_I64:
+        case DEFLOG_ARG_U64:
+            if (conv == 'c') {
+                return snprintf(out, size, "%c", (int)a->i64);
+            }
+            spec[sl++] = 'l';
+            spec[sl++] = 'l';
+            spec[sl++] = conv;
+            spec[sl] = '\0';
+            return snprintf(out, size, spec, a->u64);
+        default:
+            return snprintf(out, size, "?");
+    }
+}
+
+size_t deflog_format(char* const out, const size_t size, const char* fmt, const deflog_arg_t* const args, const unsigned argc)
+{
+    if (size == 0) {
+        return 0;
+    }
+
+    size_t len = 0;
+    unsigned argi = 0;
+    while (*fmt != '\0' && len + 1 < size) {
+        if (*fmt != '%') {
+            out[len++] = *fmt++;
+            continue;
+        }
+        if (fmt[1] == '%') {
+            out[len++] = '%';
+            fmt += 2;
+            continue;
+        }
+
+        // Keep flags, width and precision; leave room for "ll", the conversion and the NUL.
+        char spec[32];
+        size_t sl = 0;
+        spec[sl++] = *fmt++;
+        while (*fmt != '\0' && strchr("-+ #0123456789.*", *fmt) != NULL && sl < sizeof(spec) - 4) {
+            if (*fmt == '*') {
+                // Width or precision from the next argument, like printf.
+                const deflog_arg_t* const a = (argi < argc) ? &args[argi++] : NULL;
+                const int v = (a != NULL && a->type != DEFLOG_ARG_STR && a->type != DEFLOG_ARG_DOUBLE) ? a->i32 : 0;
+                if (v < 0 && spec[sl - 1] == '.') {
+                    // A negative precision counts as none.
+                    --sl;
+                    ++fmt;
+                    continue;
+                }
+                const int n = snprintf(spec + sl, sizeof(spec) - 4 - sl, "%d", v);
+                if (n < 0 || (size_t)n >= sizeof(spec) - 4 - sl) {
+                    break;
+                }
+                sl += n;
+                ++fmt;
+                continue;
+            }
+            spec[sl++] = *fmt++;
+        }
+        // Drop length modifiers; the type of the value decides.
+        while (*fmt != '\0' && strchr("hlLqjzt", *fmt) != NULL) {
+            ++fmt;
+        }
+        const char conv = *fmt;
+        if (conv == '\0') {
+            break;
+        }
+        ++fmt;
+
+        const deflog_arg_t* const a = (argi < argc) ? &args[argi++] : NULL;
+        char* const dst = out + len;
+        const size_t rem = size - len;
+        int n;
+        if (a == NULL) {
+            n = snprintf(dst, rem, "?");
+        } else {
+            switch (conv) {
+                case 'd':
+                case 'i':
+                case 'u':
+                case 'o':
+                case 'x':
+                case 'X':
+                case 'c':
+                    n = format_int(dst, rem, spec, sl, conv, a);
+                    break;
+                case 'f':
+                case 'F':
+                case 'e':
+                case 'E':
+                case 'g':
+                case 'G':
+                case 'a':
+                case 'A':
+                    spec[sl++] = conv;
+                    spec[sl] = '\0';
+                    n = (a->type == DEFLOG_ARG_DOUBLE) ? snprintf(dst, rem, spec, a->d) : snprintf(dst, rem, "?");
+                    break;
+                case 's':
+                    spec[sl++] = conv;
+                    spec[sl] = '\0';
+                    n = (a->type == DEFLOG_ARG_STR) ? snprintf(dst, rem, spec, a->s ? a->s : "(null)") : snprintf(dst, rem, "?");
+                    break;
+                case 'p':
+                    spec[sl++] = conv;
+                    spec[sl] = '\0';
+                    n = (a->type == DEFLOG_ARG_PTR || a->type == DEFLOG_ARG_STR) ? snprintf(dst, rem, spec, a->p) : snprintf(dst, rem, "?");
+                    break;
+                default:
+                    n = snprintf(dst, rem, "?");
+                    break;
+            }
+        }
+        if (n < 0) {
+            break;
+        }
+        len += ((size_t)n < rem) ? (size_t)n : rem - 1;
+    }
+    out[len] = '\0';
+    return len;
+}
+
+void deflog_refresh_site(deflog_site_t* const site, const char* const tag)
+{
+    const uint32_t gen = deflog_level_gen;
+    site->enabled = esp_log_level_get(tag) >= site->level;
+    site->levelGen = gen;
+}
+
+void deflog_level_set(const char* const tag, const esp_log_level_t level)
+{
+    esp_log_level_set(tag, level);
+    deflog_level_gen += 1;
+}
+
+static void print_line(const esp_log_level_t level, const char* const tag, const uint32_t timestamp, const char* const line)
+{
+    if (level < sizeof(LINE_FORMATS) / sizeof(LINE_FORMATS[0])) {
+        esp_log_write(level, tag, LINE_FORMATS[level], timestamp, tag, line);
+    }
+}
+
+void deflog_write(const deflog_site_t* const site, const char* const tag, const deflog_arg_t* const args, unsigned argc)
+{
+    const int64_t startTime = esp_timer_get_time();
+    const uint32_t timestamp = esp_log_timestamp();
+
+    if (argc > DEFLOG_MAX_ARGS) {
+        argc = DEFLOG_MAX_ARGS;
+    }
+
+    // Strings share DEFLOG_STR_MAX bytes; longer ones are cut.
+    size_t strLen[DEFLOG_MAX_ARGS];
+    size_t size = sizeof(record_t) + argc * sizeof(deflog_arg_t);
+    {
+        size_t budget = DEFLOG_STR_MAX;
+        for (unsigned i = 0; i < argc; ++i) {
+            if (args[i].type == DEFLOG_ARG_STR) {
+                strLen[i] = args[i].s ? strnlen(args[i].s, budget) : 0;
+                budget -= strLen[i];
+                size += strLen[i] + 1;
+            }
+        }
+    }
+    size = DEFLOG_ALIGN(size);
+
+    if (printTask == NULL) {
+        // Not started yet.
+        char line[256];
+        deflog_format(line, sizeof(line), site->fmt, args, argc);
+        print_line(site->level, tag, timestamp, line);
+        return;
+    }
+
+    deflog_ring_t* const r = &rings[xPortGetCoreID()];
+
+    bool wasEmpty;
+    record_t* const rec = deflog_ring_reserve(r, size, &wasEmpty);
+    if (rec != NULL) {
+        rec->site = site;
+        rec->tag = tag;
+        rec->timestamp = timestamp;
+        rec->argc = argc;
+        memcpy(rec->args, args, argc * sizeof(deflog_arg_t));
+        char* str = (char*)(rec->args + argc);
+        for (unsigned i = 0; i < argc; ++i) {
+            if (args[i].type == DEFLOG_ARG_STR) {
+                if (args[i].s != NULL) {
+                    memcpy(str, args[i].s, strLen[i]);
+                    str[strLen[i]] = '\0';
+                    rec->args[i].u32 = str - (char*)rec;
+                    str += strLen[i] + 1;
+                } else {
+                    rec->args[i].u32 = 0;
+                }
+            }
+        }
+        deflog_ring_commit(rec);
+    }
+
+    const int64_t writeTime = esp_timer_get_time() - startTime;
+    taskENTER_CRITICAL(&r->lock);
+    r->writeTimeUs += writeTime;
+    taskEXIT_CRITICAL(&r->lock);
+
+    if (wasEmpty && rec != NULL) {
+        xTaskNotifyGive(printTask);
+    }
+}
+
+static void print_record(record_t* const rec)
+{
+    static char line[DEFLOG_STR_MAX + 256];
+
+    for (unsigned i = 0; i < rec->argc; ++i) {
+        if (rec->args[i].type == DEFLOG_ARG_STR) {
+            rec->args[i].s = (rec->args[i].u32 != 0) ? (const char*)rec + rec->args[i].u32 : NULL;
+        }
+    }
+
+    deflog_format(line, sizeof(line), rec->site->fmt, rec->args, rec->argc);
+    print_line(rec->site->level, rec->tag, rec->timestamp, line);
+}
+
+static void deflog_task(void* pvParameters)
+{
+    static uint64_t slots[portNUM_PROCESSORS][DEFLOG_MAX_RECORD_SIZE / sizeof(uint64_t)];
+    bool have[portNUM_PROCESSORS] = {false};
+
+    while (true) {
+        // Print the records of all cores in the order they were written.
+        int oldest = -1;
+        bool pending = false;
+        for (int c = 0; c < portNUM_PROCESSORS; ++c) {
+            record_t* const rec = (record_t*)slots[c];
+            if (!have[c]) {
+                bool p;
+                have[c] = deflog_ring_take(&rings[c], rec, &p);
+                pending |= p;
+            }
+            if (have[c] && (oldest < 0 || (int32_t)(rec->timestamp - ((record_t*)slots[oldest])->timestamp) < 0)) {
+                oldest = c;
+            }
+        }
+
+        if (oldest < 0) {
+            // A record still being written comes without a notification, so
+            // only wait a tick for it.
+            ulTaskNotifyTake(pdTRUE, pending ? 1 : portMAX_DELAY);
+            continue;
+        }
+
+        const int64_t startTime = esp_timer_get_time();
+        print_record((record_t*)slots[oldest]);
+        have[oldest] = false;
+        formatTimeUs += esp_timer_get_time() - startTime;
+    }
+}
+
+esp_err_t deflog_init(void)
+{
+#ifdef CONFIG_DEFLOG_ENABLED
+    for (int c = 0; c < portNUM_PROCESSORS; ++c) {
+        uint8_t* buf = heap_caps_aligned_alloc(8, BUFFER_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (buf == NULL) {
+            buf = heap_caps_aligned_alloc(8, BUFFER_SIZE, MALLOC_CAP_8BIT);
+        }
+        if (buf == NULL) {
+            ESP_LOGE(TAG, "Error creating buffer.");
+            return ESP_ERR_NO_MEM;
+        }
+        deflog_ring_init(&rings[c], buf, BUFFER_SIZE);
+    }
+
+    if (xTaskCreate(deflog_task, "deflog", 4096, NULL, 1, &printTask) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create task.");
+        return ESP_FAIL;
+    }
+#endif
+    return ESP_OK;
+}
+
+void deflog_get_stats(deflog_stats_t* const stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    for (int c = 0; c < portNUM_PROCESSORS; ++c) {
+        stats->records += rings[c].records;
+        stats->dropped += rings[c].dropped;
+        stats->writeTimeUs += rings[c].writeTimeUs;
+    }
+    stats->formatTimeUs = formatTimeUs;
+}
@@ -0,0 +1,118 @@
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "deflog_ring.h"
+
+void deflog_ring_init(deflog_ring_t* const r, uint8_t* const buf, const size_t size)
+{
+    memset(r, 0, sizeof(*r));
+    portMUX_INITIALIZE(&r->lock);
+    r->buf = buf;
+    r->size = size & ~(size_t)7;
+}
+
+/*
+    Moves the head to a place for size bytes, or returns NULL if the ring is
+    too full. A record is never split at the end of the buffer. Called with
+    the ring locked.
+*/
+static deflog_record_t* reserve(deflog_ring_t* const r, const size_t size)
+{
+    if (r->used == 0) {
+        r->head = r->tail = 0;
+    } else if (r->size - r->used < size) {
+        return NULL;
+    }
+
+    if (r->head >= r->tail) {
+        // Free are [head, end) and [0, tail).
+        if (r->size - r->head < size) {
+            if (r->tail < size) {
+                return NULL;
+            }
+            if (r->size - r->head >= sizeof(deflog_record_t)) {
+                ((deflog_record_t*)(r->buf + r->head))->size = 0;
+            }
+            r->used += r->size - r->head;
+            r->head = 0;
+        }
+    } else if (r->tail - r->head < size) {
+        return NULL;
+    }
+
+    deflog_record_t* const rec = (deflog_record_t*)(r->buf + r->head);
+    r->head += size;
+    if (r->head == r->size) {
+        r->head = 0;
+    }
+    r->used += size;
+    return rec;
+}
+
+deflog_record_t* deflog_ring_reserve(deflog_ring_t* const r, const size_t size, bool* const wasEmpty)
+{
+    taskENTER_CRITICAL(&r->lock);
+
+    *wasEmpty = (r->used == 0);
+    deflog_record_t* const rec = reserve(r, size);
+    if (rec != NULL) {
+        // The header fields the reader looks at before the record is committed.
+        rec->size = size;
+        rec->committed = 0;
+        r->records += 1;
+    } else {
+        r->dropped += 1;
+    }
+
+    taskEXIT_CRITICAL(&r->lock);
+
+    return rec;
+}
+
+bool deflog_ring_take(deflog_ring_t* const r, deflog_record_t* const dst, bool* const pending)
+{
+    const deflog_record_t* rec = NULL;
+
+    *pending = false;
+
+    taskENTER_CRITICAL(&r->lock);
+
+    while (r->used != 0) {
+        const deflog_record_t* const next = (const deflog_record_t*)(r->buf + r->tail);
+        if (r->size - r->tail < sizeof(deflog_record_t) || next->size == 0) {
+            r->used -= r->size - r->tail;
+            r->tail = 0;
+            continue;
+        }
+        rec = next;
+        break;
+    }
+
+    taskEXIT_CRITICAL(&r->lock);
+
+    if (rec == NULL) {
+        return false;
+    }
+    if (!__atomic_load_n(&rec->committed, __ATOMIC_ACQUIRE)) {
+        *pending = true;
+        return false;
+    }
+
+    // Writers don't touch the record until the tail has moved past it.
+    const size_t size = rec->size;
+    memcpy(dst, rec, size);
+
+    taskENTER_CRITICAL(&r->lock);
+
+    r->tail += size;
+    if (r->tail == r->size) {
+        r->tail = 0;
+    }
+    r->used -= size;
+
+    taskEXIT_CRITICAL(&r->lock);
+
+    return true;
+}
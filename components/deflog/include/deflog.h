@@ -0,0 +1,208 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+/*
+    Deferred logging for hot paths.
+
+    DEFLOG_I(TAG, "Result diff %" PRIu64, diff) does not format anything: it
+    records the call site (level and format string), the tag and the raw
+    argument values into a buffer of the current core and returns. A low
+    priority task formats the records later and passes them to esp_log_write(),
+    so they show up on the console and the websocket log like any other line,
+    with the timestamp of the call. Not for use in ISRs.
+
+    Strings passed for %s are copied (at most DEFLOG_STR_MAX bytes per record),
+    so they need not outlive the call. Up to DEFLOG_MAX_ARGS arguments of integer,
+    floating point, pointer or string type are supported; '*' takes the width or
+    precision from an argument as usual. Length modifiers in the format are
+    ignored; the width of each value is taken from its type. The format is
+    checked against the arguments at compile time like that of printf().
+
+    If the buffer is full, records are dropped and counted.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DEFLOG_MAX_ARGS (6)
+#define DEFLOG_STR_MAX  (CONFIG_DEFLOG_STR_MAX)
+
+typedef enum {
+    DEFLOG_ARG_NONE,
+    DEFLOG_ARG_I32,
+    DEFLOG_ARG_U32,
+    DEFLOG_ARG_I64,
+    DEFLOG_ARG_U64,
+    DEFLOG_ARG_DOUBLE,
+    DEFLOG_ARG_PTR,
+    DEFLOG_ARG_STR,
+} deflog_arg_type_t;
+
+typedef struct deflog_arg {
+    deflog_arg_type_t type;
+    union {
+        int32_t i32;
+        uint32_t u32;
+        int64_t i64;
+        uint64_t u64;
+        double d;
+        const void* p;
+        const char* s;
+    };
+} deflog_arg_t;
+
+/**
+ * @brief One per call site; created by the DEFLOG macros.
+ */
+typedef struct deflog_site {
+    const char* const fmt;
+    const esp_log_level_t level;
+    bool enabled; // Cached result of the level check...
+    uint32_t levelGen; // ... valid while this matches the current generation.
+} deflog_site_t;
+
+typedef struct deflog_stats {
+    uint32_t records;
+    uint32_t dropped; // Records dropped because the buffer was full
+    uint64_t writeTimeUs; // Total time spent by the callers recording
+    uint64_t formatTimeUs; // Total time spent formatting and printing, i.e. not spent by the callers
+} deflog_stats_t;
+
+extern volatile uint32_t deflog_level_gen;
+
+/**
+ * @brief Allocates the buffers and starts the task printing the records.
+ * Records written before are printed immediately.
+ */
+esp_err_t deflog_init(void);
+
+/**
+ * @brief Sets the log level of a tag (or of all tags, "*") at runtime, like
+ * esp_log_level_set(), and makes the deferred call sites pick it up.
+ */
+void deflog_level_set(const char* tag, esp_log_level_t level);
+
+void deflog_get_stats(deflog_stats_t* stats);
+
+/**
+ * @brief Formats \p fmt with \p args like snprintf().
+ *
+ * @return the length of the result, which is truncated to \p size - 1
+ */
+size_t deflog_format(char* out, size_t size, const char* fmt, const deflog_arg_t* args, unsigned argc);
+
+void deflog_refresh_site(deflog_site_t* site, const char* tag);
+
+/**
+ * @brief Records a call of a DEFLOG macro; \p tag must stay valid.
+ */
+void deflog_write(const deflog_site_t* site, const char* tag, const deflog_arg_t* args, unsigned argc);
+
+/**
+ * @brief Never called; only lets the compiler check a DEFLOG format.
+ */
+static inline void __attribute__((format(printf, 1, 2))) deflog_check_format(const char* fmt, ...) {
+    (void)fmt;
+}
+
+static inline bool deflog_enabled(deflog_site_t* const site, const char* const tag) {
+    if(site->levelGen != deflog_level_gen) {
+        deflog_refresh_site(site, tag);
+    }
+    return site->enabled;
+}
+
+static inline deflog_arg_t deflog_arg_i32(const int32_t v) { deflog_arg_t a = {.type = DEFLOG_ARG_I32}; a.i32 = v; return a; }
+static inline deflog_arg_t deflog_arg_u32(const uint32_t v) { deflog_arg_t a = {.type = DEFLOG_ARG_U32}; a.u32 = v; return a; }
+static inline deflog_arg_t deflog_arg_i64(const int64_t v) { deflog_arg_t a = {.type = DEFLOG_ARG_I64}; a.i64 = v; return a; }
+static inline deflog_arg_t deflog_arg_u64(const uint64_t v) { deflog_arg_t a = {.type = DEFLOG_ARG_U64}; a.u64 = v; return a; }
+static inline deflog_arg_t deflog_arg_double(const double v) { deflog_arg_t a = {.type = DEFLOG_ARG_DOUBLE}; a.d = v; return a; }
+static inline deflog_arg_t deflog_arg_ptr(const void* const v) { deflog_arg_t a = {.type = DEFLOG_ARG_PTR}; a.p = v; return a; }
+static inline deflog_arg_t deflog_arg_str(const char* const v) { deflog_arg_t a = {.type = DEFLOG_ARG_STR}; a.s = v; return a; }
+static inline deflog_arg_t deflog_arg_long(const long v) { return (sizeof(v) > 4) ? deflog_arg_i64(v) : deflog_arg_i32(v); }
+static inline deflog_arg_t deflog_arg_ulong(const unsigned long v) { return (sizeof(v) > 4) ? deflog_arg_u64(v) : deflog_arg_u32(v); }
+static inline deflog_arg_t deflog_arg_none(void) { deflog_arg_t a = {.type = DEFLOG_ARG_NONE}; return a; }
+
+#ifdef __cplusplus
+}
+
+static inline deflog_arg_t deflog_arg(const int v) { return deflog_arg_i32(v); }
+static inline deflog_arg_t deflog_arg(const unsigned v) { return deflog_arg_u32(v); }
+static inline deflog_arg_t deflog_arg(const long v) { return deflog_arg_long(v); }
+static inline deflog_arg_t deflog_arg(const unsigned long v) { return deflog_arg_ulong(v); }
+static inline deflog_arg_t deflog_arg(const long long v) { return deflog_arg_i64(v); }
+static inline deflog_arg_t deflog_arg(const unsigned long long v) { return deflog_arg_u64(v); }
+static inline deflog_arg_t deflog_arg(const double v) { return deflog_arg_double(v); }
+static inline deflog_arg_t deflog_arg(const char* const v) { return deflog_arg_str(v); }
+static inline deflog_arg_t deflog_arg(const void* const v) { return deflog_arg_ptr(v); }
+
+#else
+
+#define deflog_arg(v) _Generic((v), \
+    _Bool: deflog_arg_i32, \
+    char: deflog_arg_i32, \
+    signed char: deflog_arg_i32, \
+    unsigned char: deflog_arg_u32, \
+    short: deflog_arg_i32, \
+    unsigned short: deflog_arg_u32, \
+    int: deflog_arg_i32, \
+    unsigned: deflog_arg_u32, \
+    long: deflog_arg_long, \
+    unsigned long: deflog_arg_ulong, \
+    long long: deflog_arg_i64, \
+    unsigned long long: deflog_arg_u64, \
+    float: deflog_arg_double, \
+    double: deflog_arg_double, \
+    char*: deflog_arg_str, \
+    const char*: deflog_arg_str, \
+    default: deflog_arg_ptr)(v)
+
+#endif
+
+#define DEFLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, N, ...) N
+#define DEFLOG_NARGS(...) DEFLOG_NARGS_(_0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define DEFLOG_CAT_(a, b) a##b
+#define DEFLOG_CAT(a, b) DEFLOG_CAT_(a, b)
+
+#define DEFLOG_ARGS_0()
+#define DEFLOG_ARGS_1(a) , deflog_arg(a)
+#define DEFLOG_ARGS_2(a, ...) , deflog_arg(a) DEFLOG_ARGS_1(__VA_ARGS__)
+#define DEFLOG_ARGS_3(a, ...) , deflog_arg(a) DEFLOG_ARGS_2(__VA_ARGS__)
+#define DEFLOG_ARGS_4(a, ...) , deflog_arg(a) DEFLOG_ARGS_3(__VA_ARGS__)
+#define DEFLOG_ARGS_5(a, ...) , deflog_arg(a) DEFLOG_ARGS_4(__VA_ARGS__)
+#define DEFLOG_ARGS_6(a, ...) , deflog_arg(a) DEFLOG_ARGS_5(__VA_ARGS__)
+#define DEFLOG_ARGS(...) DEFLOG_CAT(DEFLOG_ARGS_, DEFLOG_NARGS(__VA_ARGS__))(__VA_ARGS__)
+
+#ifdef CONFIG_DEFLOG_ENABLED
+
+#define DEFLOG_LEVEL(level, tag, format, ...) do { \
+        if(0) { \
+            deflog_check_format(format, ##__VA_ARGS__); \
+        } \
+        if(LOG_LOCAL_LEVEL >= (level)) { \
+            static deflog_site_t _deflog_site = {(format), (level), false, 0}; \
+            if(deflog_enabled(&_deflog_site, (tag))) { \
+                /* The first element only avoids an empty array. */ \
+                const deflog_arg_t _deflog_args[] = { deflog_arg_none() DEFLOG_ARGS(__VA_ARGS__) }; \
+                deflog_write(&_deflog_site, (tag), _deflog_args + 1, sizeof(_deflog_args) / sizeof(_deflog_args[0]) - 1); \
+            } \
+        } \
+    } while(0)
+
+#else
+
+#define DEFLOG_LEVEL(level, tag, format, ...) ESP_LOG_LEVEL_LOCAL(level, tag, format, ##__VA_ARGS__)
+
+#endif
+
+#define DEFLOG_E(tag, format, ...) DEFLOG_LEVEL(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define DEFLOG_W(tag, format, ...) DEFLOG_LEVEL(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define DEFLOG_I(tag, format, ...) DEFLOG_LEVEL(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#define DEFLOG_D(tag, format, ...) DEFLOG_LEVEL(ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__)
+#define DEFLOG_V(tag, format, ...) DEFLOG_LEVEL(ESP_LOG_VERBOSE, tag, format, ##__VA_ARGS__)
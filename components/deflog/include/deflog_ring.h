@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "deflog.h"
+
+/*
+    The record buffer behind deflog; only public for the tests.
+
+    Writers reserve a record under the lock and fill it in after releasing it,
+    so the lock is held for a few compares and stores regardless of the size
+    of the record. The reader copies the oldest record out once it has been
+    committed and only takes the lock again to release the space. There is
+    only one reader per ring.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DEFLOG_ALIGN(n) (((n) + 7) & ~(size_t)7)
+
+typedef struct deflog_record {
+    const deflog_site_t* site;
+    const char* tag;
+    uint32_t timestamp;
+    uint16_t size; // Of the whole record, incl. strings and padding; 0: skip to the start of the buffer
+    uint8_t argc;
+    uint8_t committed; // Set by deflog_ring_commit() once the writer is done.
+    deflog_arg_t args[]; // Strings follow; .u32 of a string argument is its offset from the record.
+} deflog_record_t;
+
+#define DEFLOG_MAX_RECORD_SIZE DEFLOG_ALIGN(sizeof(deflog_record_t) + DEFLOG_MAX_ARGS * sizeof(deflog_arg_t) + DEFLOG_STR_MAX + DEFLOG_MAX_ARGS)
+
+typedef struct deflog_ring {
+    portMUX_TYPE lock;
+    uint8_t* buf;
+    size_t size;
+    size_t head;
+    size_t tail;
+    size_t used;
+    uint32_t records;
+    uint32_t dropped;
+    uint64_t writeTimeUs;
+} deflog_ring_t;
+
+/**
+ * @brief Sets up \p r on \p buf, which must be 8 byte aligned and hold at
+ * least two records of DEFLOG_MAX_RECORD_SIZE.
+ */
+void deflog_ring_init(deflog_ring_t* r, uint8_t* buf, size_t size);
+
+/**
+ * @brief Reserves a record of \p size bytes (a multiple of 8), or counts a
+ * dropped record and returns NULL if the ring is too full. The caller fills
+ * in the record outside of any lock and passes it to deflog_ring_commit().
+ *
+ * @param wasEmpty set to whether the ring was empty before, i.e. whether the
+ * reader may have to be woken up
+ */
+deflog_record_t* deflog_ring_reserve(deflog_ring_t* r, size_t size, bool* wasEmpty);
+
+/**
+ * @brief Hands a filled in record over to the reader.
+ */
+static inline void deflog_ring_commit(deflog_record_t* const rec)
+{
+    __atomic_store_n(&rec->committed, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Moves the oldest record of \p r to \p dst, which must hold
+ * DEFLOG_MAX_RECORD_SIZE bytes.
+ *
+ * @param pending set to true if the oldest record is still being written,
+ * in which case the reader has to retry later
+ * @return false if there is no committed record
+ */
+bool deflog_ring_take(deflog_ring_t* r, deflog_record_t* dst, bool* pending);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,60 @@
+#include <inttypes.h>
+#include <string.h>
+#include "unity.h"
+#include "deflog.h"
+
+#define FORMAT(out, fmt, ...) do { \
+        const deflog_arg_t args[] = { deflog_arg_none() DEFLOG_ARGS(__VA_ARGS__) }; \
+        deflog_format(out, sizeof(out), fmt, args + 1, sizeof(args) / sizeof(args[0]) - 1); \
+    } while(0)
+
+TEST_CASE("Deferred log formats like printf", "[deflog]")
+{
+    char out[128];
+
+    FORMAT(out, "no args, 100%%");
+    TEST_ASSERT_EQUAL_STRING("no args, 100%", out);
+
+    const uint8_t jobId = 0x2a;
+    const uint32_t version = 0x20000000;
+    const int core = -3;
+    FORMAT(out, "Job ID: %02X, Core: %d, Ver: %08" PRIX32, jobId, core, version);
+    TEST_ASSERT_EQUAL_STRING("Job ID: 2A, Core: -3, Ver: 20000000", out);
+
+    const uint64_t diff = 123456789012345ULL;
+    const uint32_t poolDiff = 4096;
+    FORMAT(out, "Result diff %" PRIu64 " of %" PRIu32 ".", diff, poolDiff);
+    TEST_ASSERT_EQUAL_STRING("Result diff 123456789012345 of 4096.", out);
+
+    FORMAT(out, "%.2f ms, %-4s|%5s", 1.5f, "ab", "cd");
+    TEST_ASSERT_EQUAL_STRING("1.50 ms, ab  |   cd", out);
+
+    // Width and precision from arguments
+    FORMAT(out, "[%*d|%-*d|%.*f]", 4, 7, 3, 8, 2, 3.14159);
+    TEST_ASSERT_EQUAL_STRING("[   7|8  |3.14]", out);
+    FORMAT(out, "[%*.*s]", 4, 2, "abc");
+    TEST_ASSERT_EQUAL_STRING("[  ab]", out);
+    FORMAT(out, "[%*d|%.*f]", -3, 5, -1, 0.5);
+    TEST_ASSERT_EQUAL_STRING("[5  |0.500000]", out);
+}
+
+TEST_CASE("Deferred log handles mismatches and truncation", "[deflog]")
+{
+    char out[128];
+
+    // Missing and mistyped arguments
+    FORMAT(out, "%d %d", 1);
+    TEST_ASSERT_EQUAL_STRING("1 ?", out);
+    FORMAT(out, "%s", 1);
+    TEST_ASSERT_EQUAL_STRING("?", out);
+    const char* const nullStr = NULL;
+    FORMAT(out, "%s", nullStr);
+    TEST_ASSERT_EQUAL_STRING("(null)", out);
+
+    char small[8];
+    TEST_ASSERT_EQUAL(7, deflog_format(small, sizeof(small), "0123456789", NULL, 0));
+    TEST_ASSERT_EQUAL_STRING("0123456", small);
+
+    FORMAT(small, "ab%scd", "0123456789");
+    TEST_ASSERT_EQUAL_STRING("ab01234", small);
+}
@@ -0,0 +1,206 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "deflog_ring.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#define RING_SIZE 4096
+#define PRODUCERS 4
+#define HEADER_SIZE (sizeof(deflog_record_t) + 2 * sizeof(deflog_arg_t))
+
+static uint64_t ringMem[RING_SIZE / sizeof(uint64_t)];
+static uint64_t slot[DEFLOG_MAX_RECORD_SIZE / sizeof(uint64_t)];
+
+static uint8_t fillByte(const uint32_t producer, const uint32_t seq, const size_t i) {
+    return (uint8_t)(producer * 31 + seq * 7 + i);
+}
+
+/*
+    Records of the tests carry the producer in args[0], a sequence number in
+    args[1] and a pattern derived from both in the bytes after that.
+*/
+static void fillRecord(deflog_record_t* const rec, const uint32_t producer, const uint32_t seq) {
+    rec->argc = 2;
+    rec->args[0].u32 = producer;
+    rec->args[1].u32 = seq;
+    uint8_t* const data = (uint8_t*)rec + HEADER_SIZE;
+    for (size_t i = 0; i < rec->size - HEADER_SIZE; ++i) {
+        data[i] = fillByte(producer, seq, i);
+    }
+}
+
+static bool recordIntact(const deflog_record_t* const rec) {
+    const uint8_t* const data = (const uint8_t*)rec + HEADER_SIZE;
+    for (size_t i = 0; i < rec->size - HEADER_SIZE; ++i) {
+        if (data[i] != fillByte(rec->args[0].u32, rec->args[1].u32, i)) {
+            return false;
+        }
+    }
+    return rec->argc == 2;
+}
+
+static size_t recordSize(const uint32_t seq) {
+    return DEFLOG_ALIGN(HEADER_SIZE + (seq * 37) % 300);
+}
+
+TEST_CASE("Deferred log ring hands out committed records only", "[deflog]")
+{
+    deflog_ring_t ring;
+    deflog_ring_init(&ring, (uint8_t*)ringMem, RING_SIZE);
+    deflog_record_t* const out = (deflog_record_t*)slot;
+    bool wasEmpty;
+    bool pending;
+
+    TEST_ASSERT_FALSE(deflog_ring_take(&ring, out, &pending));
+    TEST_ASSERT_FALSE(pending);
+
+    deflog_record_t* const first = deflog_ring_reserve(&ring, recordSize(1), &wasEmpty);
+    TEST_ASSERT_NOT_NULL(first);
+    TEST_ASSERT_TRUE(wasEmpty);
+    deflog_record_t* const second = deflog_ring_reserve(&ring, recordSize(2), &wasEmpty);
+    TEST_ASSERT_NOT_NULL(second);
+    TEST_ASSERT_FALSE(wasEmpty);
+
+    // The second one is done first, but the first one is still in the way.
+    fillRecord(second, 0, 2);
+    deflog_ring_commit(second);
+    TEST_ASSERT_FALSE(deflog_ring_take(&ring, out, &pending));
+    TEST_ASSERT_TRUE(pending);
+
+    fillRecord(first, 0, 1);
+    deflog_ring_commit(first);
+    TEST_ASSERT_TRUE(deflog_ring_take(&ring, out, &pending));
+    TEST_ASSERT_EQUAL_UINT32(1, out->args[1].u32);
+    TEST_ASSERT_TRUE(recordIntact(out));
+    TEST_ASSERT_TRUE(deflog_ring_take(&ring, out, &pending));
+    TEST_ASSERT_EQUAL_UINT32(2, out->args[1].u32);
+    TEST_ASSERT_TRUE(recordIntact(out));
+    TEST_ASSERT_FALSE(deflog_ring_take(&ring, out, &pending));
+    TEST_ASSERT_FALSE(pending);
+}
+
+TEST_CASE("Deferred log ring wraps and drops when full", "[deflog]")
+{
+    deflog_ring_t ring;
+    deflog_ring_init(&ring, (uint8_t*)ringMem, RING_SIZE);
+    deflog_record_t* const out = (deflog_record_t*)slot;
+    bool wasEmpty;
+    bool pending;
+
+    // Fill the ring, then keep it full while reading, so the head wraps around.
+    uint32_t written = 0;
+    uint32_t read = 0;
+    for (unsigned round = 0; round < 100; ++round) {
+        deflog_record_t* rec;
+        while ((rec = deflog_ring_reserve(&ring, recordSize(written), &wasEmpty)) != NULL) {
+            fillRecord(rec, 0, written++);
+            deflog_ring_commit(rec);
+        }
+        TEST_ASSERT_TRUE(deflog_ring_take(&ring, out, &pending));
+        TEST_ASSERT_EQUAL_UINT32(read++, out->args[1].u32);
+        TEST_ASSERT_TRUE(recordIntact(out));
+    }
+    TEST_ASSERT_EQUAL_UINT32(100, ring.dropped);
+
+    while (deflog_ring_take(&ring, out, &pending)) {
+        TEST_ASSERT_EQUAL_UINT32(read++, out->args[1].u32);
+        TEST_ASSERT_TRUE(recordIntact(out));
+    }
+    TEST_ASSERT_FALSE(pending);
+    TEST_ASSERT_EQUAL_UINT32(written, read);
+    TEST_ASSERT_EQUAL_UINT32(written, ring.records);
+    TEST_ASSERT_EQUAL_UINT32(0, ring.used);
+}
+
+typedef struct stress_ctx {
+    deflog_ring_t ring;
+    uint32_t iterations;
+    uint32_t written[PRODUCERS];
+    volatile uint32_t running;
+    SemaphoreHandle_t done;
+} stress_ctx_t;
+
+static stress_ctx_t stress;
+
+static void producerTask(void* pv) {
+    const uint32_t producer = (uint32_t)(uintptr_t)pv;
+    bool wasEmpty;
+    for (uint32_t seq = 0; seq < stress.iterations; ++seq) {
+        deflog_record_t* const rec = deflog_ring_reserve(&stress.ring, recordSize(seq + producer), &wasEmpty);
+        if (rec != NULL) {
+            if ((seq & 0xf) == 0) {
+                taskYIELD(); // As if preempted before filling in the record.
+            }
+            fillRecord(rec, producer, seq);
+            deflog_ring_commit(rec);
+            stress.written[producer] += 1;
+        } else {
+            taskYIELD();
+        }
+        if ((seq & 0xff) == 0) {
+            vTaskDelay(1); // Let the reader catch up and keep the watchdog fed.
+        }
+    }
+    __atomic_fetch_sub(&stress.running, 1, __ATOMIC_RELEASE);
+    xSemaphoreGive(stress.done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("Deferred log ring stress with producers on both cores", "[deflog]")
+{
+    deflog_ring_init(&stress.ring, (uint8_t*)ringMem, RING_SIZE);
+    stress.iterations = 20000;
+    memset(stress.written, 0, sizeof(stress.written));
+    stress.running = PRODUCERS;
+    stress.done = xSemaphoreCreateCounting(PRODUCERS, 0);
+
+    for (uint32_t p = 0; p < PRODUCERS; ++p) {
+        xTaskCreatePinnedToCore(producerTask, "deflog stress", 3072, (void*)(uintptr_t)p, 5, NULL, p % portNUM_PROCESSORS);
+    }
+
+    // Read on this task like the log task does: every record exactly once,
+    // intact, and in order per producer.
+    deflog_record_t* const out = (deflog_record_t*)slot;
+    uint32_t read[PRODUCERS] = {0};
+    uint32_t next[PRODUCERS] = {0};
+    uint32_t pendingCnt = 0;
+    while (true) {
+        const bool stopped = __atomic_load_n(&stress.running, __ATOMIC_ACQUIRE) == 0;
+        bool pending;
+        if (deflog_ring_take(&stress.ring, out, &pending)) {
+            const uint32_t producer = out->args[0].u32;
+            TEST_ASSERT_LESS_THAN(PRODUCERS, producer);
+            TEST_ASSERT_TRUE(out->args[1].u32 >= next[producer]);
+            TEST_ASSERT_TRUE(recordIntact(out));
+            next[producer] = out->args[1].u32 + 1;
+            read[producer] += 1;
+        } else if (stopped) {
+            TEST_ASSERT_FALSE(pending);
+            break;
+        } else {
+            pendingCnt += pending;
+            vTaskDelay(1);
+        }
+    }
+
+    for (uint32_t p = 0; p < PRODUCERS; ++p) {
+        xSemaphoreTake(stress.done, portMAX_DELAY);
+    }
+    vSemaphoreDelete(stress.done);
+
+    uint32_t total = 0;
+    for (uint32_t p = 0; p < PRODUCERS; ++p) {
+        TEST_ASSERT_EQUAL_UINT32(stress.written[p], read[p]);
+        total += read[p];
+    }
+    TEST_ASSERT_EQUAL_UINT32(total, stress.ring.records);
+    TEST_ASSERT_EQUAL_UINT32(PRODUCERS * stress.iterations, stress.ring.records + stress.ring.dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, stress.ring.used);
+
+    printf("%" PRIu32 " records read, %" PRIu32 " dropped, %" PRIu32 " times waiting for a writer\n",
+        total, stress.ring.dropped, pendingCnt);
+}
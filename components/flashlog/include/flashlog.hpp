@@ -0,0 +1,312 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+/*
+    Append-only log of fixed-size records in a ring of flash sectors.
+
+    Layout: Every sector starts with a header slot holding a magic number, a
+    sequence number which increases by one every time a sector is (re)started,
+    and the layout version of the records. The remaining slots hold one record
+    each, followed by a CRC32.
+    Slots are written strictly in order; an erased (all 0xff) slot marks the end
+    of the data in a sector.
+
+    Wear leveling: When the current sector is full, the next sector in the ring is
+    erased and becomes current. So every sector is erased exactly once per pass
+    over the ring, and every record is written exactly once: the write
+    amplification is bounded by one header slot per sector plus erasing
+    whole sectors.
+
+    Power loss: A record torn by a reset fails its CRC and is skipped on reading;
+    writing continues behind it. A sector torn while being restarted has no valid
+    header and is ignored until it is reused.
+
+    Versions: Sectors whose header carries another layout version than the
+    log's VERSION are ignored like foreign data. If no sector has the current
+    version, init() formats the flash and getReplacedVersion() tells which
+    version was found, so a layout change never passes for a CRC failure.
+
+    The Flash type must provide:
+        static constexpr std::size_t SECTOR_SIZE;
+        std::size_t size(void) const;
+        bool read(std::size_t offset, void* dst, std::size_t len);
+        bool write(std::size_t offset, const void* src, std::size_t len);
+        bool erase(std::size_t offset, std::size_t len);
+*/
+namespace flashlog {
+
+    namespace detail {
+
+        static constexpr uint32_t crc32(const void* const data, const std::size_t len, uint32_t crc = 0) {
+            const uint8_t* p = (const uint8_t*)data;
+            crc = ~crc;
+            for(std::size_t i = 0; i < len; ++i) {
+                crc ^= p[i];
+                for(unsigned b = 0; b < 8; ++b) {
+                    crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+                }
+            }
+            return ~crc;
+        }
+
+        static constexpr bool isErased(const void* const data, const std::size_t len) {
+            const uint8_t* p = (const uint8_t*)data;
+            for(std::size_t i = 0; i < len; ++i) {
+                if(p[i] != 0xff) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    }
+
+    template<typename Flash, typename Record, uint32_t Version>
+    requires std::is_trivially_copyable_v<Record>
+    class FlashLog {
+        public:
+
+            static constexpr uint32_t MAGIC = 0x474c5346; // "FSLG"
+
+            /**
+             * @brief Layout version of Record; bump it whenever Record changes.
+             */
+            static constexpr uint32_t VERSION = Version;
+
+            static_assert(VERSION != 0 && VERSION != UINT32_MAX, "0 and all ones are reserved.");
+
+            static constexpr std::size_t SECTOR_SIZE = Flash::SECTOR_SIZE;
+
+            struct Slot {
+                Record rec;
+                uint32_t crc;
+            };
+
+            static constexpr std::size_t SLOT_SIZE = (sizeof(Slot) + 3) & ~(std::size_t)3;
+
+        private:
+
+            struct Header {
+                uint32_t magic;
+                uint32_t seq;
+                uint32_t version;
+            };
+
+            static constexpr std::size_t HEADER_SIZE = (sizeof(Header) > SLOT_SIZE) ? sizeof(Header) : SLOT_SIZE;
+
+        public:
+
+            static constexpr std::size_t SLOTS_PER_SECTOR = (SECTOR_SIZE - HEADER_SIZE) / SLOT_SIZE;
+
+            static_assert(SLOTS_PER_SECTOR >= 1, "Record too big for a sector.");
+
+            constexpr FlashLog(Flash& flash) : flash {flash} {
+
+            }
+
+            /**
+             * @brief Scans the flash to find where to continue; formats it if
+             * it does not contain a log.
+             *
+             * @return false if the flash is too small or cannot be accessed
+             */
+            bool init(void) {
+                sectorCnt = flash.size() / SECTOR_SIZE;
+                if(sectorCnt < 2) {
+                    return false;
+                }
+
+                bool found = false;
+                uint32_t maxSeq = 0;
+                replacedVersion = 0;
+                for(std::size_t s = 0; s < sectorCnt; ++s) {
+                    uint32_t seq;
+                    uint32_t version;
+                    if(!readHeader(s, seq, version)) {
+                        continue;
+                    }
+                    if(version != VERSION) {
+                        replacedVersion = version;
+                    } else
+                    if(!found || (int32_t)(seq - maxSeq) > 0) {
+                        found = true;
+                        maxSeq = seq;
+                        head = s;
+                    }
+                }
+
+                if(found) {
+                    replacedVersion = 0;
+                } else {
+                    head = 0;
+                    seq = 0;
+                    return startSector(0, 1);
+                }
+
+                seq = maxSeq;
+                slot = SLOTS_PER_SECTOR;
+                for(std::size_t i = 0; i < SLOTS_PER_SECTOR; ++i) {
+                    uint8_t buf[SLOT_SIZE];
+                    if(!flash.read(slotOffset(head, i), buf, SLOT_SIZE)) {
+                        return false;
+                    }
+                    if(detail::isErased(buf, SLOT_SIZE)) {
+                        slot = i;
+                        break;
+                    }
+                }
+                return true;
+            }
+
+            /**
+             * @brief Appends a record, moving on to the next sector if the current
+             * one is full.
+             */
+            bool append(const Record& rec) {
+                if(sectorCnt == 0) {
+                    return false;
+                }
+                if(slot >= SLOTS_PER_SECTOR) {
+                    const std::size_t next = (head + 1) % sectorCnt;
+                    if(!startSector(next, seq + 1)) {
+                        return false;
+                    }
+                }
+
+                uint8_t buf[SLOT_SIZE];
+                std::memset(buf, 0xff, SLOT_SIZE);
+                Slot s;
+                std::memset(&s, 0, sizeof(s));
+                s.rec = rec;
+                s.crc = detail::crc32(&s.rec, sizeof(Record));
+                std::memcpy(buf, &s, sizeof(s));
+
+                const std::size_t offset = slotOffset(head, slot);
+                // Consume the slot even if writing fails; it may be partially written.
+                slot += 1;
+                return flash.write(offset, buf, SLOT_SIZE);
+            }
+
+            /**
+             * @brief Calls \p fn with every valid record, oldest first.
+             *
+             * @return the number of records passed to \p fn
+             */
+            template<typename F>
+            std::size_t forEach(F&& fn) {
+                if(sectorCnt == 0) {
+                    return 0;
+                }
+                std::size_t cnt = 0;
+                // The oldest sector is the one after head, unless it's unused.
+                for(std::size_t i = 1; i <= sectorCnt; ++i) {
+                    const std::size_t s = (head + i) % sectorCnt;
+                    uint32_t sseq;
+                    if(!readHeader(s, sseq) || (int32_t)(seq - sseq) < 0 || (seq - sseq) >= sectorCnt) {
+                        continue;
+                    }
+                    const std::size_t slots = (s == head) ? slot : SLOTS_PER_SECTOR;
+                    for(std::size_t j = 0; j < slots; ++j) {
+                        Slot sl;
+                        if(!flash.read(slotOffset(s, j), &sl, sizeof(sl))) {
+                            break;
+                        }
+                        if(detail::isErased(&sl, sizeof(sl))) {
+                            break;
+                        }
+                        if(sl.crc == detail::crc32(&sl.rec, sizeof(Record))) {
+                            fn(sl.rec);
+                            ++cnt;
+                        }
+                    }
+                }
+                return cnt;
+            }
+
+            /**
+             * @brief Discards all records.
+             */
+            bool clear(void) {
+                if(sectorCnt == 0) {
+                    return false;
+                }
+                for(std::size_t s = 0; s < sectorCnt; ++s) {
+                    if(!flash.erase(s * SECTOR_SIZE, SECTOR_SIZE)) {
+                        return false;
+                    }
+                }
+                return startSector(0, seq + 1);
+            }
+
+            std::size_t getCapacity(void) const {
+                // The sector being restarted always loses its old records.
+                return (sectorCnt - 1) * SLOTS_PER_SECTOR;
+            }
+
+            uint32_t getSeq(void) const {
+                return seq;
+            }
+
+            /**
+             * @brief The layout version of a log init() found instead of one
+             * with VERSION, and formatted over; UINT32_MAX for a log written
+             * before there were versions.
+             *
+             * @return 0 if init() found a log of this version or none at all
+             */
+            uint32_t getReplacedVersion(void) const {
+                return replacedVersion;
+            }
+
+        private:
+
+            Flash& flash;
+            std::size_t sectorCnt {0};
+            std::size_t head {0};
+            std::size_t slot {0};
+            uint32_t seq {0};
+            uint32_t replacedVersion {0};
+
+            static constexpr std::size_t slotOffset(const std::size_t sector, const std::size_t slot) {
+                return sector * SECTOR_SIZE + HEADER_SIZE + slot * SLOT_SIZE;
+            }
+
+            bool readHeader(const std::size_t sector, uint32_t& outSeq, uint32_t& outVersion) {
+                Header h;
+                if(flash.read(sector * SECTOR_SIZE, &h, sizeof(h)) && h.magic == MAGIC) {
+                    outSeq = h.seq;
+                    outVersion = h.version;
+                    return true;
+                }
+                return false;
+            }
+
+            /**
+             * @brief Reads the header of \p sector if it belongs to this log,
+             * i.e. has the current VERSION.
+             */
+            bool readHeader(const std::size_t sector, uint32_t& outSeq) {
+                uint32_t version;
+                return readHeader(sector, outSeq, version) && version == VERSION;
+            }
+
+            bool startSector(const std::size_t sector, const uint32_t newSeq) {
+                if(!flash.erase(sector * SECTOR_SIZE, SECTOR_SIZE)) {
+                    return false;
+                }
+                const Header h {MAGIC, newSeq, VERSION};
+                if(!flash.write(sector * SECTOR_SIZE, &h, sizeof(h))) {
+                    return false;
+                }
+                head = sector;
+                seq = newSeq;
+                slot = 0;
+                return true;
+            }
+
+    };
+
+}
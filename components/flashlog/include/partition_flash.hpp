@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "esp_partition.h"
+
+namespace flashlog {
+
+    /**
+     * @brief Flash access for FlashLog via a data partition.
+     */
+    class PartitionFlash {
+        public:
+            static constexpr std::size_t SECTOR_SIZE = 4096;
+
+            constexpr PartitionFlash(const esp_partition_t* const part = nullptr) : part {part} {
+
+            }
+
+            static PartitionFlash find(const esp_partition_subtype_t subtype, const char* const label) {
+                return PartitionFlash {esp_partition_find_first(ESP_PARTITION_TYPE_DATA, subtype, label)};
+            }
+
+            constexpr bool valid(void) const {
+                return part != nullptr;
+            }
+
+            std::size_t size(void) const {
+                return part ? part->size : 0;
+            }
+
+            bool read(const std::size_t offset, void* const dst, const std::size_t len) {
+                return part && esp_partition_read(part, offset, dst, len) == ESP_OK;
+            }
+
+            bool write(const std::size_t offset, const void* const src, const std::size_t len) {
+                return part && esp_partition_write(part, offset, src, len) == ESP_OK;
+            }
+
+            bool erase(const std::size_t offset, const std::size_t len) {
+                return part && esp_partition_erase_range(part, offset, len) == ESP_OK;
+            }
+
+        private:
+            const esp_partition_t* part;
+    };
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace flashlog {
+
+    /**
+     * @brief RAM-backed stand-in for a flash partition, e.g. for testing.
+     * Behaves like NOR flash: erasing sets whole sectors to 0xff, writing can
+     * only clear bits.
+     */
+    template<std::size_t SIZE, std::size_t SECTOR = 4096>
+    class RamFlash {
+        public:
+            static constexpr std::size_t SECTOR_SIZE = SECTOR;
+
+            static_assert(SIZE % SECTOR_SIZE == 0);
+
+            RamFlash(void) {
+                std::memset(mem, 0xff, SIZE);
+            }
+
+            std::size_t size(void) const {
+                return SIZE;
+            }
+
+            bool read(const std::size_t offset, void* const dst, const std::size_t len) {
+                if(offset + len > SIZE) {
+                    return false;
+                }
+                std::memcpy(dst, mem + offset, len);
+                return true;
+            }
+
+            bool write(const std::size_t offset, const void* const src, const std::size_t len) {
+                if(offset + len > SIZE || failWrites) {
+                    return false;
+                }
+                // Allow tests to simulate a reset in the middle of a write.
+                const std::size_t n = (tearAfter < len) ? tearAfter : len;
+                const uint8_t* const s = (const uint8_t*)src;
+                for(std::size_t i = 0; i < n; ++i) {
+                    mem[offset + i] &= s[i];
+                }
+                writeCnt += 1;
+                return n == len;
+            }
+
+            bool erase(const std::size_t offset, const std::size_t len) {
+                if((offset % SECTOR_SIZE) != 0 || (len % SECTOR_SIZE) != 0 || offset + len > SIZE) {
+                    return false;
+                }
+                std::memset(mem + offset, 0xff, len);
+                for(std::size_t s = offset / SECTOR_SIZE; s < (offset + len) / SECTOR_SIZE; ++s) {
+                    eraseCnt[s] += 1;
+                }
+                return true;
+            }
+
+            uint32_t getEraseCnt(const std::size_t sector) const {
+                return eraseCnt[sector];
+            }
+
+            uint32_t writeCnt {0};
+            std::size_t tearAfter {SIZE};
+            bool failWrites {false};
+
+        private:
+            uint8_t mem[SIZE];
+            uint32_t eraseCnt[SIZE / SECTOR_SIZE] {};
+    };
+
+}
@@ -0,0 +1,186 @@
+#include "unity.h"
+#include "flashlog.hpp"
+#include "ram_flash.hpp"
+
+#include <algorithm>
+#include <vector>
+
+using namespace flashlog;
+
+namespace {
+    struct Rec {
+        uint32_t id;
+        float value;
+        uint16_t a;
+        int8_t b;
+    };
+
+    // 4 sectors of 256 bytes each.
+    using Flash = RamFlash<1024, 256>;
+    using Log = FlashLog<Flash, Rec, 1>;
+
+    Rec mkRec(const uint32_t id) {
+        return Rec {.id = id, .value = id * 0.5f, .a = (uint16_t)id, .b = (int8_t)-id};
+    }
+
+    std::vector<uint32_t> readIds(Log& log) {
+        std::vector<uint32_t> ids;
+        log.forEach([&ids](const Rec& r) {
+            TEST_ASSERT_EQUAL_FLOAT(r.id * 0.5f, r.value);
+            ids.push_back(r.id);
+        });
+        return ids;
+    }
+}
+
+TEST_CASE("Flash log formats and appends", "[flashlog]")
+{
+    static Flash flash;
+    Log log {flash};
+
+    TEST_ASSERT_TRUE(log.init());
+    TEST_ASSERT_EQUAL(0, readIds(log).size());
+
+    for(uint32_t i = 0; i < 5; ++i) {
+        TEST_ASSERT_TRUE(log.append(mkRec(i)));
+    }
+
+    const std::vector<uint32_t> ids = readIds(log);
+    TEST_ASSERT_EQUAL(5, ids.size());
+    for(uint32_t i = 0; i < 5; ++i) {
+        TEST_ASSERT_EQUAL(i, ids[i]);
+    }
+}
+
+TEST_CASE("Flash log resumes after reopening", "[flashlog]")
+{
+    static Flash flash;
+    {
+        Log log {flash};
+        TEST_ASSERT_TRUE(log.init());
+        for(uint32_t i = 0; i < 7; ++i) {
+            log.append(mkRec(i));
+        }
+    }
+    {
+        Log log {flash};
+        TEST_ASSERT_TRUE(log.init());
+        log.append(mkRec(7));
+        const std::vector<uint32_t> ids = readIds(log);
+        TEST_ASSERT_EQUAL(8, ids.size());
+        for(uint32_t i = 0; i < 8; ++i) {
+            TEST_ASSERT_EQUAL(i, ids[i]);
+        }
+    }
+}
+
+TEST_CASE("Flash log wraps around and levels wear", "[flashlog]")
+{
+    static Flash flash;
+    Log log {flash};
+    TEST_ASSERT_TRUE(log.init());
+
+    const uint32_t total = Log::SLOTS_PER_SECTOR * 4 * 10 + 3;
+    for(uint32_t i = 0; i < total; ++i) {
+        TEST_ASSERT_TRUE(log.append(mkRec(i)));
+    }
+
+    // Oldest records were dropped, the rest is in order and complete.
+    const std::vector<uint32_t> ids = readIds(log);
+    TEST_ASSERT_GREATER_OR_EQUAL(log.getCapacity(), ids.size());
+    TEST_ASSERT_EQUAL(total - 1, ids.back());
+    for(std::size_t i = 1; i < ids.size(); ++i) {
+        TEST_ASSERT_EQUAL(ids[i-1] + 1, ids[i]);
+    }
+
+    // Every record was written exactly once, plus one header per sector start.
+    const uint32_t starts = (total + Log::SLOTS_PER_SECTOR - 1) / Log::SLOTS_PER_SECTOR;
+    TEST_ASSERT_EQUAL(total + starts, flash.writeCnt);
+
+    // All sectors were erased about equally often.
+    uint32_t minErase = UINT32_MAX;
+    uint32_t maxErase = 0;
+    for(unsigned s = 0; s < 4; ++s) {
+        minErase = std::min(minErase, flash.getEraseCnt(s));
+        maxErase = std::max(maxErase, flash.getEraseCnt(s));
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(1, maxErase - minErase);
+
+    // ... and reopening finds the same data.
+    Log log2 {flash};
+    TEST_ASSERT_TRUE(log2.init());
+    TEST_ASSERT_TRUE(ids == readIds(log2));
+}
+
+TEST_CASE("Flash log skips torn records", "[flashlog]")
+{
+    static Flash flash;
+    {
+        Log log {flash};
+        TEST_ASSERT_TRUE(log.init());
+        log.append(mkRec(0));
+        log.append(mkRec(1));
+        // Simulate a reset in the middle of writing the next record:
+        flash.tearAfter = 5;
+        TEST_ASSERT_FALSE(log.append(mkRec(2)));
+        flash.tearAfter = SIZE_MAX;
+    }
+    {
+        Log log {flash};
+        TEST_ASSERT_TRUE(log.init());
+        log.append(mkRec(3));
+        const std::vector<uint32_t> ids = readIds(log);
+        TEST_ASSERT_EQUAL(3, ids.size());
+        TEST_ASSERT_EQUAL(0, ids[0]);
+        TEST_ASSERT_EQUAL(1, ids[1]);
+        TEST_ASSERT_EQUAL(3, ids[2]);
+    }
+}
+
+TEST_CASE("Flash log clear", "[flashlog]")
+{
+    static Flash flash;
+    Log log {flash};
+    TEST_ASSERT_TRUE(log.init());
+    for(uint32_t i = 0; i < 20; ++i) {
+        log.append(mkRec(i));
+    }
+    TEST_ASSERT_TRUE(log.clear());
+    TEST_ASSERT_EQUAL(0, readIds(log).size());
+    log.append(mkRec(42));
+    const std::vector<uint32_t> ids = readIds(log);
+    TEST_ASSERT_EQUAL(1, ids.size());
+    TEST_ASSERT_EQUAL(42, ids[0]);
+}
+
+TEST_CASE("Flash log starts over on another layout version", "[flashlog]")
+{
+    static Flash flash;
+    {
+        Log log {flash};
+        TEST_ASSERT_TRUE(log.init());
+        TEST_ASSERT_EQUAL(0, log.getReplacedVersion());
+        for(uint32_t i = 0; i < Log::SLOTS_PER_SECTOR + 2; ++i) {
+            log.append(mkRec(i));
+        }
+    }
+    {
+        // Same records, but the layout is declared to have changed.
+        FlashLog<Flash, Rec, 2> log {flash};
+        TEST_ASSERT_TRUE(log.init());
+        TEST_ASSERT_EQUAL(1, log.getReplacedVersion());
+        std::size_t cnt = 0;
+        log.forEach([&cnt](const Rec&) { ++cnt; });
+        TEST_ASSERT_EQUAL(0, cnt);
+        TEST_ASSERT_TRUE(log.append(mkRec(100)));
+    }
+    {
+        FlashLog<Flash, Rec, 2> log {flash};
+        TEST_ASSERT_TRUE(log.init());
+        TEST_ASSERT_EQUAL(0, log.getReplacedVersion());
+        std::vector<uint32_t> ids;
+        log.forEach([&ids](const Rec& r) { ids.push_back(r.id); });
+        TEST_ASSERT_EQUAL(1, ids.size());
+        TEST_ASSERT_EQUAL(100, ids[0]);
+    }
+}
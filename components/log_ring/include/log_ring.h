@@ -0,0 +1,58 @@
+#ifndef LOG_RING_H_
+#define LOG_RING_H_
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Byte ring of '\n'-terminated text lines. Lines are formatted directly into
+    the ring and are always stored contiguously; if there is not enough room,
+    the oldest lines are dropped.
+    Not thread-safe; the caller must serialize access.
+*/
+
+typedef struct log_ring {
+    char* buf;
+    size_t size;
+    size_t head; // Where the next line goes
+    size_t tail; // Start of the oldest line
+    size_t end; // End of the data before the wrap, if wrapped
+    bool wrapped; // Data is [tail, end) + [0, head)
+    uint32_t dropped; // Lines dropped since the last call of log_ring_read()
+} log_ring_t;
+
+void log_ring_init(log_ring_t* ring, char* buf, size_t size);
+
+static inline bool log_ring_is_empty(const log_ring_t* const ring) {
+    return !ring->wrapped && ring->head == ring->tail;
+}
+
+/**
+ * @brief Formats a line into the ring, appending a '\n' if there is none.
+ * Lines longer than \p maxLen (including the '\n') are truncated.
+ * 
+ * @param line if not NULL, receives a pointer to the stored line
+ * @return the length of the stored line, or -1 on formatting errors.
+ * If the return value is less than \p fullLen, the line was truncated.
+ */
+int log_ring_vprintf(log_ring_t* ring, size_t maxLen, const char** line, int* fullLen, const char* format, va_list args);
+
+/**
+ * @brief Moves up to \p len bytes of complete lines, oldest first, to \p out.
+ * If lines were dropped since the last read, a notice goes first.
+ * 
+ * @return the number of bytes copied
+ */
+size_t log_ring_read(log_ring_t* ring, char* out, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LOG_RING_H_
@@ -0,0 +1,124 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "log_ring.h"
+
+void log_ring_init(log_ring_t* const ring, char* const buf, const size_t size) {
+    memset(ring, 0, sizeof(*ring));
+    ring->buf = buf;
+    ring->size = size;
+}
+
+static void dropOldest(log_ring_t* const ring) {
+    const size_t limit = ring->wrapped ? ring->end : ring->head;
+    const char* const nl = memchr(ring->buf + ring->tail, '\n', limit - ring->tail);
+    ring->tail = nl ? (size_t)(nl - ring->buf) + 1 : limit;
+    ring->dropped += 1;
+    if(ring->wrapped && ring->tail >= ring->end) {
+        ring->tail = 0;
+        ring->wrapped = false;
+    }
+}
+
+/*
+    Makes room for a line of up to len bytes at head, wrapping around and
+    dropping old lines as needed.
+*/
+static void reserve(log_ring_t* const ring, const size_t len) {
+    while(true) {
+        if(!ring->wrapped) {
+            if(ring->size - ring->head >= len) {
+                return;
+            }
+            if(ring->head == ring->tail) {
+                ring->head = 0;
+                ring->tail = 0;
+            } else {
+                ring->end = ring->head;
+                ring->head = 0;
+                ring->wrapped = true;
+            }
+        } else {
+            // Keep head != tail while wrapped, so that full and empty can be told apart.
+            if(ring->tail - ring->head > len) {
+                return;
+            }
+            dropOldest(ring);
+        }
+    }
+}
+
+int log_ring_vprintf(log_ring_t* const ring, size_t maxLen, const char** const line, int* const fullLen, const char* const format, va_list args) {
+    if(maxLen >= ring->size) {
+        maxLen = ring->size - 1;
+    }
+
+    reserve(ring, maxLen);
+
+    char* const dst = ring->buf + ring->head;
+    // Leave room for the '\n'.
+    int len = vsnprintf(dst, maxLen, format, args);
+    if(len < 0) {
+        return -1;
+    }
+    if(fullLen) {
+        *fullLen = len;
+    }
+
+    size_t n = ((size_t)len < maxLen) ? (size_t)len : maxLen - 1;
+    if(n == 0 || dst[n-1] != '\n') {
+        dst[n] = '\n';
+        n += 1;
+        if(fullLen) {
+            *fullLen += 1;
+        }
+    }
+
+    ring->head += n;
+    if(line) {
+        *line = dst;
+    }
+    return n;
+}
+
+static size_t copyLines(log_ring_t* const ring, const size_t limit, char* const out, const size_t len) {
+    size_t n = limit - ring->tail;
+    if(n > len) {
+        // Only complete lines.
+        const char* const src = ring->buf + ring->tail;
+        n = len;
+        while(n > 0 && src[n-1] != '\n') {
+            --n;
+        }
+    }
+    memcpy(out, ring->buf + ring->tail, n);
+    ring->tail += n;
+    return n;
+}
+
+size_t log_ring_read(log_ring_t* const ring, char* const out, const size_t len) {
+    size_t n = 0;
+    if(ring->dropped != 0) {
+        const int r = snprintf(out, len, "... %" PRIu32 " log messages dropped ...\n", ring->dropped);
+        if(r > 0 && (size_t)r < len) {
+            n = r;
+            ring->dropped = 0;
+        }
+    }
+
+    if(ring->wrapped) {
+        n += copyLines(ring, ring->end, out + n, len - n);
+        if(ring->tail < ring->end) {
+            return n;
+        }
+        ring->tail = 0;
+        ring->wrapped = false;
+    }
+    n += copyLines(ring, ring->head, out + n, len - n);
+    if(ring->tail == ring->head) {
+        ring->head = 0;
+        ring->tail = 0;
+    }
+    return n;
+}
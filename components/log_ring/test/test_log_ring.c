@@ -0,0 +1,209 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "log_ring.h"
+
+#define RING_SIZE 1024
+#define LINE_MAX 200
+#define OUT_MAX 700
+
+static char ringMem[RING_SIZE];
+static char out[OUT_MAX + 1];
+
+static int ring_printf(log_ring_t* const ring, const size_t maxLen, const char** const line, int* const fullLen, const char* const format, ...) {
+    va_list args;
+    va_start(args, format);
+    const int r = log_ring_vprintf(ring, maxLen, line, fullLen, format, args);
+    va_end(args);
+    return r;
+}
+
+static uint32_t rnd(void) {
+    static uint32_t x = 0x12345678;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+static char fillChar(const uint32_t seq) {
+    return 'a' + (seq % 26);
+}
+
+/*
+    Checks what the reader sees: whole lines, oldest first, each intact
+    (or cut to LINE_MAX), and every line missing in between accounted for
+    by a "dropped" notice or the ring's pending drop count.
+*/
+typedef struct model {
+    uint32_t written; // Lines written so far, i.e. the next sequence number
+    uint32_t nextRead; // Sequence number after the last line read
+    uint32_t gaps; // Lines skipped by the reader
+    uint32_t announced; // Sum of the dropped notices read
+} model_t;
+
+static void checkRead(model_t* const m, const log_ring_t* const ring, const char* const data, const size_t len) {
+    const char* p = data;
+    const char* const end = data + len;
+    while(p < end) {
+        const char* const nl = memchr(p, '\n', end - p);
+        TEST_ASSERT_NOT_NULL(nl);
+        unsigned n;
+        if(sscanf(p, "... %u log messages dropped ...", &n) == 1) {
+            TEST_ASSERT_TRUE(p == data);
+            m->announced += n;
+        } else {
+            unsigned seq;
+            int pos = 0;
+            TEST_ASSERT_EQUAL_INT(1, sscanf(p, "%u %n", &seq, &pos));
+            // All drops happened before this read, and only ever hit the
+            // oldest lines, so exactly the ones not seen as a gap yet are skipped.
+            const uint32_t pending = m->announced + ring->dropped - m->gaps;
+            TEST_ASSERT_EQUAL_UINT32(m->nextRead + pending, seq);
+            TEST_ASSERT_TRUE(seq < m->written);
+            m->gaps += seq - m->nextRead;
+            m->nextRead = seq + 1;
+            for(const char* c = p + pos; c < nl; ++c) {
+                TEST_ASSERT_EQUAL_INT(fillChar(seq), *c);
+            }
+            TEST_ASSERT_TRUE(nl - p < LINE_MAX);
+        }
+        p = nl + 1;
+    }
+    // A notice may come before the reader gets to the gap.
+    TEST_ASSERT_TRUE(m->gaps <= m->announced + ring->dropped);
+}
+
+TEST_CASE("Log ring keeps whole lines in order", "[log_ring]")
+{
+    log_ring_t ring;
+    log_ring_init(&ring, ringMem, RING_SIZE);
+    TEST_ASSERT_TRUE(log_ring_is_empty(&ring));
+
+    const char* line;
+    int fullLen;
+    TEST_ASSERT_EQUAL_INT(6, ring_printf(&ring, LINE_MAX, &line, &fullLen, "hello\n"));
+    TEST_ASSERT_EQUAL_INT(6, fullLen);
+    TEST_ASSERT_EQUAL_MEMORY("hello\n", line, 6);
+    // A '\n' is appended if missing.
+    TEST_ASSERT_EQUAL_INT(6, ring_printf(&ring, LINE_MAX, &line, &fullLen, "w%drld", 0));
+    TEST_ASSERT_EQUAL_MEMORY("w0rld\n", line, 6);
+    TEST_ASSERT_FALSE(log_ring_is_empty(&ring));
+
+    // Only whole lines are read.
+    TEST_ASSERT_EQUAL_UINT32(6, log_ring_read(&ring, out, 11));
+    TEST_ASSERT_EQUAL_MEMORY("hello\n", out, 6);
+    TEST_ASSERT_EQUAL_UINT32(6, log_ring_read(&ring, out, OUT_MAX));
+    TEST_ASSERT_EQUAL_MEMORY("w0rld\n", out, 6);
+    TEST_ASSERT_TRUE(log_ring_is_empty(&ring));
+    TEST_ASSERT_EQUAL_UINT32(0, log_ring_read(&ring, out, OUT_MAX));
+}
+
+TEST_CASE("Log ring truncates long lines", "[log_ring]")
+{
+    log_ring_t ring;
+    log_ring_init(&ring, ringMem, RING_SIZE);
+
+    char longStr[LINE_MAX * 2];
+    memset(longStr, 'x', sizeof(longStr) - 1);
+    longStr[sizeof(longStr) - 1] = '\0';
+
+    const char* line;
+    int fullLen;
+    const int len = ring_printf(&ring, LINE_MAX, &line, &fullLen, "%s", longStr);
+    TEST_ASSERT_EQUAL_INT(LINE_MAX, len);
+    TEST_ASSERT_EQUAL_INT(sizeof(longStr), fullLen);
+    TEST_ASSERT_EQUAL_INT('\n', line[len - 1]);
+
+    TEST_ASSERT_EQUAL_UINT32(LINE_MAX, log_ring_read(&ring, out, OUT_MAX));
+    TEST_ASSERT_EQUAL_MEMORY(longStr, out, LINE_MAX - 1);
+}
+
+TEST_CASE("Log ring drops the oldest lines when full", "[log_ring]")
+{
+    log_ring_t ring;
+    log_ring_init(&ring, ringMem, RING_SIZE);
+
+    // 100 lines of 16 bytes don't fit into 1024 bytes.
+    for(unsigned i = 0; i < 100; ++i) {
+        TEST_ASSERT_EQUAL_INT(16, ring_printf(&ring, LINE_MAX, NULL, NULL, "line %010u\n", i));
+    }
+    TEST_ASSERT_TRUE(ring.dropped > 0);
+    const uint32_t dropped = ring.dropped;
+
+    size_t len = log_ring_read(&ring, out, OUT_MAX);
+    out[len] = '\0';
+    unsigned n;
+    TEST_ASSERT_EQUAL_INT(1, sscanf(out, "... %u log messages dropped ...", &n));
+    TEST_ASSERT_EQUAL_UINT32(dropped, n);
+    TEST_ASSERT_EQUAL_UINT32(0, ring.dropped);
+
+    // The rest is the newest lines, in order.
+    unsigned expected = dropped;
+    const char* p = strchr(out, '\n') + 1;
+    do {
+        for(; *p != '\0'; p += 16) {
+            TEST_ASSERT_EQUAL_INT(1, sscanf(p, "line %u", &n));
+            TEST_ASSERT_EQUAL_UINT32(expected, n);
+            expected += 1;
+        }
+        len = log_ring_read(&ring, out, OUT_MAX);
+        out[len] = '\0';
+        p = out;
+    } while(len != 0);
+    TEST_ASSERT_EQUAL_UINT32(100, expected);
+}
+
+TEST_CASE("Log ring stress against a model", "[log_ring]")
+{
+    static const unsigned OPS = 200000;
+
+    log_ring_t ring;
+    log_ring_init(&ring, ringMem, RING_SIZE);
+    model_t m = {0};
+
+    char fill[LINE_MAX * 2];
+
+    for(unsigned op = 0; op < OPS; ++op) {
+        if((rnd() % 3) != 0) {
+            // Write a line, sometimes longer than LINE_MAX, sometimes without '\n'.
+            const uint32_t seq = m.written;
+            const size_t fillLen = rnd() % (sizeof(fill) - 1);
+            memset(fill, fillChar(seq), fillLen);
+            fill[fillLen] = '\0';
+
+            const char* line;
+            int fullLen;
+            const int len = (rnd() & 1) ?
+                ring_printf(&ring, LINE_MAX, &line, &fullLen, "%u %s\n", (unsigned)seq, fill) :
+                ring_printf(&ring, LINE_MAX, &line, &fullLen, "%u %s", (unsigned)seq, fill);
+            TEST_ASSERT_TRUE(len > 0 && len <= LINE_MAX);
+            TEST_ASSERT_TRUE(len <= fullLen);
+            TEST_ASSERT_EQUAL_INT('\n', line[len - 1]);
+            TEST_ASSERT_TRUE(line >= ringMem && line + len <= ringMem + RING_SIZE);
+            m.written += 1;
+        } else {
+            // Read into buffers of random size; some are too small for a line.
+            const size_t outLen = 16 + rnd() % (OUT_MAX - 16);
+            const size_t len = log_ring_read(&ring, out, outLen);
+            TEST_ASSERT_TRUE(len <= outLen);
+            checkRead(&m, &ring, out, len);
+        }
+    }
+
+    // Drain.
+    size_t len;
+    while((len = log_ring_read(&ring, out, OUT_MAX)) != 0) {
+        checkRead(&m, &ring, out, len);
+    }
+    TEST_ASSERT_TRUE(log_ring_is_empty(&ring));
+    TEST_ASSERT_EQUAL_UINT32(0, ring.dropped);
+    // The newest line is never dropped, so everything has been seen.
+    TEST_ASSERT_EQUAL_UINT32(m.written, m.nextRead);
+    TEST_ASSERT_EQUAL_UINT32(m.gaps, m.announced);
+    TEST_ASSERT_TRUE(m.announced > 0);
+
+    printf("%u lines written, %u dropped\n", (unsigned)m.written, (unsigned)m.announced);
+}
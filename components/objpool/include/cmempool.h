@@ -1,7 +1,10 @@
 #pragma once
 #include <stdint.h>
+#include <stdalign.h>
 #include <stdatomic.h>
-#ifdef __cpluspluc
+#include <stdbool.h>
+#include <stddef.h>
+#ifdef __cplusplus
 extern "C" {
 #endif
 
@@ -11,15 +14,41 @@ extern "C" {
 //     uint32_t maxInUseCnt;
 // } ObjPoolStats_t;
 
+#define MEMPOOL_MAX_SEGS 128
+
+/**
+ * @brief Memory for one object of a pool; see mempool::detail::Node
+ */
+typedef struct mempool_node {
+    uintptr_t obj;
+    uint16_t dummySelf;
+    uint16_t dummyNext;
+} mempool_node_t;
+
 typedef struct mempool_pool {
-    _Atomic (void*) dummy;
+    // Head index and tag, see mempool::MemPoolBase
+    uint32_t dummyHead;
+    uint32_t dummyCasRetries;
+    uint32_t dummyTakesInFlight;
+    void* dummySegs[MEMPOOL_MAX_SEGS];
 } mempool_pool_t;
 
 void mempool_init(mempool_pool_t* pool);
+
+/**
+ * @brief Adds the objects of \p nodes to the pool.
+ *
+ * @return false if the pool cannot take any more memory
+ */
+bool mempool_add_mem(mempool_pool_t* pool, mempool_node_t* nodes, size_t cnt);
+
+/**
+ * @return the \c obj member of a node, or NULL if the pool is empty
+ */
 void* mempool_take(mempool_pool_t* pool);
 void mempool_put(mempool_pool_t* pool, void* obj);
 void mempool_deinit(mempool_pool_t* pool);
 
-#ifdef __cpluspluc
+#ifdef __cplusplus
 }
 #endif
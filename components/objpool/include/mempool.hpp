@@ -1,95 +1,338 @@
 #pragma once
 #include <cstdint>
+#include <cstdlib>
+#include <algorithm>
 #include <atomic>
 #include <type_traits>
 #include <functional>
+#include <new>
 #include <span>
+#include <cinttypes>
+#include "esp_log.h"
 #include "obj_pool_stats.h"
+#include "mempool_magazine.hpp"
+#include "mempool_registry.hpp"
 
 namespace mempool {
 
     namespace detail {
 
         /**
-         * @brief This union give us a pointer member which matches the alignment of \c T.
-         * Specifically when alignof(T) < alignof(T*) the compiler sill generates valid
-         * accesses to \c next because the packed pointer 'inherits' the alignment of \c U<T> 
-         * which 'inherits' its alignment from \c T .
-         * 
-         * @tparam T 
+         * @brief An object of a MemPoolBase with the pool's bookkeeping behind it.
          */
         template<typename T>
-        union U {
+        struct Node {
             T item;
-            struct __attribute__((packed)) {
-                U<T>* next;
-            };
+            uint16_t self; // Index of this node in its pool, constant while registered
+            std::atomic<uint16_t> next; // Index of the next free node while in the pool
         };
     } // namespace detail
 
-    template<typename T>
-    requires (!std::is_const_v<T> && sizeof(T) >= sizeof(detail::U<T>))
-    class MemPoolBase {
+    /**
+     * @brief Hooks of a MemPoolBase which do nothing. Tests pass their own to
+     * interleave other operations with a take() deterministically.
+     */
+    struct NoHooks {
+        // Called by take() between reading the head and swapping it.
+        static void beforeTakeCas(void) {}
+    };
 
-        using item_t = detail::U<T>;
+    /**
+     * @brief Lock-free stack of free objects (Treiber stack).
+     * 
+     * Objects live in \c Node s, which the pool knows by a 16 bit index: the
+     * upper \c SEG_BITS select one of the memory segments registered via
+     * registerMem(), the lower ones the node in it. That keeps the head, which
+     * holds the index of the top node and a tag, in one 32 bit word, and every
+     * take() and put() a single-word CAS, which the ESP32 targets have natively.
+     * 
+     * The tag changes with every modification. Without it, take() could
+     * install a stale \c next when, between reading the head and swapping it,
+     * other tasks take the head object, take its successor and put the first
+     * one back (ABA problem). With 16 bits, that only goes unnoticed if the
+     * pool is modified a multiple of 65536 times while one take() is stalled
+     * between reading the head and its CAS.
+     * 
+     * take() may still read \c next from a node it lost the race for. So
+     * memory may only be returned to the heap after removing its objects from
+     * the pool, unregistering it, and then seeing quiescent() return true:
+     * every take() counts itself as in flight while it may read a node.
+     * For the same reason, an unregistered segment is only handed out again
+     * once the pool was quiescent after unregistering: a stalled take() would
+     * otherwise look up its old index in other, maybe smaller, memory.
+     */
+    template<typename T, typename HOOKS = NoHooks>
+    requires (!std::is_const_v<T>)
+    class MemPoolBase {
 
         public:
+            using Node = detail::Node<T>;
+
+            static constexpr unsigned SEG_BITS = 7;
+            static constexpr unsigned SLOT_BITS = 16 - SEG_BITS;
+            static constexpr uint32_t MAX_SEGS = 1u << SEG_BITS;
+            // Nodes per segment. The last slot is left out, so no index is NIL.
+            static constexpr uint32_t SEG_SIZE = (1u << SLOT_BITS) - 1;
+            static constexpr uint16_t NIL = 0xffff;
+
             MemPoolBase() = default;
             MemPoolBase(const MemPoolBase&) = delete;
             MemPoolBase(MemPoolBase&&) = default;
 
             T* take() {
-                item_t* ip = items.load(std::memory_order::acquire);
-                while( ip != nullptr && !items.compare_exchange_strong(ip,ip->next)) {
+                // Before looking up any node, see quiescent().
+                takesInFlight.fetch_add(1, std::memory_order::seq_cst);
+                T* obj = nullptr;
+                uint32_t h = head.load(std::memory_order::acquire);
+                while(idxOf(h) != NIL) {
+                    Node* const n = nodeAt(idxOf(h));
+                    if(n == nullptr) [[unlikely]] {
+                        // Unregistered meanwhile, so the head has changed too.
+                        h = head.load(std::memory_order::acquire);
+                        continue;
+                    }
+                    const uint32_t next = withIdx(h, n->next.load(std::memory_order::relaxed));
+                    HOOKS::beforeTakeCas();
+                    if(head.compare_exchange_weak(h, next, std::memory_order::acq_rel, std::memory_order::acquire)) [[likely]] {
+                        obj = &(n->item);
+                        break;
+                    }
+                    countRetry();
+                }
+                takesInFlight.fetch_sub(1, std::memory_order::release);
+                return obj;
+            }
 
+            /**
+             * @param obj must have been taken from this pool, or be part of
+             * memory registered with it
+             */
+            void put(T* const obj) {
+                if(obj) [[likely]] {
+                    Node* const n = nodeOf(obj);
+                    push(n->self, n);
                 }
-                if(ip != nullptr) [[likely]] {
-                    ip->next = nullptr;
-                    return &(ip->item);
-                } else {
-                    return nullptr;
+            }
+
+            /**
+             * @brief Puts all of \p objs with a single CAS.
+             */
+            void putAll(const std::span<T* const> objs) {
+                if(!objs.empty()) {
+                    Node* last = nodeOf(objs[0]);
+                    for(T* const obj : objs.subspan(1)) {
+                        Node* const n = nodeOf(obj);
+                        last->next.store(n->self, std::memory_order::relaxed);
+                        last = n;
+                    }
+                    push(nodeOf(objs[0])->self, last);
                 }
+            }
 
+            /**
+             * @brief Removes all objects at once and calls \p fn with each of them.
+             * \p fn owns the object it is called with.
+             */
+            template<typename F>
+            void takeAll(F&& fn) {
+                uint32_t h = head.load(std::memory_order::relaxed);
+                while(!head.compare_exchange_weak(h, withIdx(h, NIL), std::memory_order::acquire, std::memory_order::relaxed)) {
+
+                }
+                uint16_t idx = idxOf(h);
+                while(idx != NIL) {
+                    Node* const n = nodeAt(idx);
+                    idx = n->next.load(std::memory_order::relaxed);
+                    fn(&(n->item));
+                }
             }
 
-            void put(T* const obj) {
-                if(obj) [[likely]] {
-                    item_t* const ip = (item_t*)obj;
-                    item_t* i = items.load(std::memory_order::relaxed);
-                    do {
-                        ip->next = i;
-                    } while (!items.compare_exchange_strong(i,ip));
+            /**
+             * @brief Registers \p mem with the pool, without adding its objects.
+             * Memory of more than \c SEG_SIZE nodes takes several segments.
+             *
+             * @return false if there are not enough free segments
+             */
+            bool registerMem(const std::span<Node> mem) {
+                for(size_t i = 0; i < mem.size(); i += SEG_SIZE) {
+                    const std::span<Node> part = mem.subspan(i, std::min<size_t>(SEG_SIZE, mem.size() - i));
+                    if(!registerSeg(part)) [[unlikely]] {
+                        unregisterMem(mem.first(i));
+                        return false;
+                    }
+                }
+                return true;
+            }
 
+            /**
+             * @brief Unregisters \p mem, none of whose objects may be in the pool.
+             * A take() which started before may still read it, see quiescent().
+             * Its segments are reused only once the pool was quiescent.
+             */
+            void unregisterMem(const std::span<Node> mem) {
+                for(size_t i = 0; i < mem.size(); i += SEG_SIZE) {
+                    segs[mem[i].self >> SLOT_BITS].store(retiredSeg(), std::memory_order::seq_cst);
                 }
             }
 
-            template<std::size_t X>
-            void addMem(const std::span<T,X>& mem) {
-                if(!mem.empty()) {
-                    item_t* const first = (item_t*)(&mem[0]);
-                    item_t* last = first;
+            /**
+             * @return true if no take() is running right now. Memory unregistered
+             * before a call which returns true is not read by any take() anymore
+             * and may be freed.
+             */
+            bool quiescent(void) const {
+                return takesInFlight.load(std::memory_order::seq_cst) == 0;
+            }
 
+            /**
+             * @brief Adds all objects of \p mem, which must be registered, with
+             * a single CAS.
+             */
+            void putMem(const std::span<Node> mem) {
+                if(!mem.empty()) {
                     // 1) Link up the chain of all new objects:
-                    for(T& t : mem.subspan(1)) {
-                        item_t* next = (item_t*)(&t);
-                        last->next = next;
-                        last = next;
+                    for(size_t i = 1; i < mem.size(); ++i) {
+                        mem[i - 1].next.store(mem[i].self, std::memory_order::relaxed);
                     }
-
                     // 2) Insert the whole chain like a single item:
-                    item_t* i = items.load(std::memory_order::relaxed);
-                    do {
-                        last->next = i;
-                    } while (!items.compare_exchange_strong(i, first));
+                    push(mem.front().self, &mem.back());
                 }
             }
 
+            /**
+             * @brief Registers \p mem and adds all its objects.
+             *
+             * @return false if there are not enough free segments
+             */
+            bool addMem(const std::span<Node> mem) {
+                if(!registerMem(mem)) {
+                    return false;
+                }
+                putMem(mem);
+                return true;
+            }
+
             void reset(void) {
-                items.store(nullptr);
+                uint32_t h = head.load(std::memory_order::relaxed);
+                while(!head.compare_exchange_weak(h, withIdx(h, NIL), std::memory_order::release, std::memory_order::relaxed)) {
+
+                }
+            }
+
+            /**
+             * @return how often take() and put() had to retry because another
+             * task modified the pool at the same time
+             */
+            uint32_t getCasRetries(void) const {
+                return casRetries.load(std::memory_order::relaxed);
+            }
+
+            /**
+             * @return the node at \p idx , or \c nullptr if its segment is not
+             * registered
+             */
+            Node* nodeAt(const uint16_t idx) const {
+                // seq_cst: take() must see unregisterMem() or quiescent() see the take().
+                Node* const seg = segs[idx >> SLOT_BITS].load(std::memory_order::seq_cst);
+                return (seg != nullptr && seg != retiredSeg()) ? seg + (idx & SEG_SIZE) : nullptr;
+            }
+
+            static Node* nodeOf(T* const obj) {
+                // item is the first member.
+                return reinterpret_cast<Node*>(obj);
             }
 
         private:
-            std::atomic<item_t*> items {nullptr};
+            static constexpr uint32_t TAG_ONE = 1u << 16;
+
+            // Tag in the upper, index of the top node in the lower 16 bits
+            std::atomic<uint32_t> head {NIL};
+            std::atomic<uint32_t> casRetries {0};
+            std::atomic<uint32_t> takesInFlight {0};
+            std::atomic<Node*> segs[MAX_SEGS] {};
+
+            static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+            static uint16_t idxOf(const uint32_t h) {
+                return h & 0xffff;
+            }
+
+            /**
+             * @return \p h with the next tag and \p idx
+             */
+            static uint32_t withIdx(const uint32_t h, const uint16_t idx) {
+                return ((h & ~(uint32_t)0xffff) + TAG_ONE) | idx;
+            }
+
+            /**
+             * @brief Marks a segment which was unregistered, but may still be
+             * looked up by a take(). Never dereferenced.
+             */
+            static Node* retiredSeg(void) {
+                static constinit uint8_t mark {};
+                return reinterpret_cast<Node*>(&mark);
+            }
+
+            bool registerSeg(const std::span<Node> part) {
+                return claimSeg(part) || (reclaimSegs() && claimSeg(part));
+            }
+
+            /**
+             * @brief Makes segments unregistered before now free for reuse, if
+             * no take() can still look them up.
+             *
+             * @return true if any segment was freed
+             */
+            bool reclaimSegs(void) {
+                uint32_t retired[MAX_SEGS / 32] {};
+                bool any = false;
+                for(uint32_t s = 0; s < MAX_SEGS; ++s) {
+                    if(segs[s].load(std::memory_order::seq_cst) == retiredSeg()) {
+                        retired[s / 32] |= 1u << (s % 32);
+                        any = true;
+                    }
+                }
+                // Segments unregistered after the check above stay retired.
+                if(!any || !quiescent()) {
+                    return false;
+                }
+                for(uint32_t s = 0; s < MAX_SEGS; ++s) {
+                    Node* expected = retiredSeg();
+                    if(retired[s / 32] & (1u << (s % 32))) {
+                        segs[s].compare_exchange_strong(expected, nullptr, std::memory_order::relaxed);
+                    }
+                }
+                return true;
+            }
+
+            bool claimSeg(const std::span<Node> part) {
+                for(uint32_t s = 0; s < MAX_SEGS; ++s) {
+                    Node* expected = nullptr;
+                    if(segs[s].load(std::memory_order::relaxed) == nullptr &&
+                       segs[s].compare_exchange_strong(expected, part.data(), std::memory_order::release, std::memory_order::relaxed)) {
+                        // None of the nodes is in the pool yet, so nobody reads these before the put.
+                        for(uint32_t i = 0; i < part.size(); ++i) {
+                            part[i].self = (s << SLOT_BITS) | i;
+                            new (&part[i].next) std::atomic<uint16_t> {NIL};
+                        }
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            void push(const uint16_t first, Node* const last) {
+                uint32_t h = head.load(std::memory_order::relaxed);
+                last->next.store(idxOf(h), std::memory_order::relaxed);
+                while (!head.compare_exchange_weak(h, withIdx(h, first), std::memory_order::release, std::memory_order::relaxed)) {
+                    countRetry();
+                    last->next.store(idxOf(h), std::memory_order::relaxed);
+                }
+            }
+
+            void countRetry(void) {
+                casRetries.fetch_add(1, std::memory_order::relaxed);
+            }
 
     };
 
@@ -102,6 +345,10 @@ namespace mempool {
             static void* allocate(const size_t align, const size_t sz) {
                 return std::invoke(ALLOC_FN,align,sz);
             }
+            static void deallocate(void* const mem) {
+                // All ALLOC_FNs allocate from the heap (heap_caps_free() == free()).
+                std::free(mem);
+            }
         };
 
         template<typename T, auto ALLOC_FN>
@@ -119,21 +366,104 @@ namespace mempool {
         };
     }
 
-    template<typename T, size_t GROWCNT, auto ALLOC_FN> 
+    namespace detail {
+
+        /**
+         * @brief Magazines<> or, for \c SIZE 0, nothing.
+         */
+        template<typename T, size_t SIZE>
+        struct OptMagazines {
+            using type = Magazines<T,SIZE>;
+        };
+
+        template<typename T>
+        struct OptMagazines<T,0> {
+            struct type {};
+        };
+    } // namespace detail
+
+    /**
+     * @brief A pool which allocates \p GROWCNT more objects via \p ALLOC_FN
+     * whenever it runs empty.
+     *
+     * Every allocation is a "chunk" with a small header, so that trim() can
+     * tell which chunks are entirely free and return them to the heap.
+     *
+     * Each chunk of up to \c SEG_SIZE objects takes one of the \c MAX_SEGS
+     * segments of the underlying MemPoolBase, which caps the pool at
+     * \c MAX_SEGS chunks, i.e. \c MAX_SEGS * \p GROWCNT objects if it only
+     * grows by itself. Beyond that, growing fails (and logs an error), and
+     * take() returns \c nullptr.
+     *
+     * With \p MAGSIZE != 0, each core gets a magazine of up to \p MAGSIZE free
+     * objects in front of the shared stack (see Magazines). Objects are then
+     * moved between a magazine and the shared stack \c MAGSIZE/2 at a time.
+     * Only worth it for pools which both cores take from and put to at a high
+     * rate, see Magazines.
+     */
+    template<typename T, size_t GROWCNT, auto ALLOC_FN, size_t MAGSIZE = 0, typename HOOKS = NoHooks> 
     class GrowingMemPool {
-        using alloctr = alloc::Allocator<T,ALLOC_FN>;
+        using alloctr = alloc::AllocatorBase<ALLOC_FN>;
+        using mags_t = typename detail::OptMagazines<T,MAGSIZE>::type;
+        using pool_t = MemPoolBase<T,HOOKS>;
+        using node_t = typename pool_t::Node;
+
+        struct Chunk {
+            Chunk* next;
+            uint32_t cnt;
+            // Only used by trim():
+            uint32_t freeCnt;
+            uint16_t freeList;
+        };
+
+        static constexpr size_t CHUNK_ALIGN = std::max(alignof(node_t), alignof(Chunk));
+        // Nodes start right after the header.
+        static constexpr size_t OBJS_OFFSET = (sizeof(Chunk) + alignof(node_t) - 1) / alignof(node_t) * alignof(node_t);
+
         public:
 
             T* take(void) {
-                T* obj = pool.take();
-                if(obj == nullptr) {
-                    obj = grow();
+                if constexpr (MAGSIZE != 0) {
+                    T* const obj = mags.take();
+                    if(obj) [[likely]] {
+                        return obj;
+                    }
+                    return refill();
+                } else {
+                    T* obj = pool.take();
+                    if(obj == nullptr) {
+                        obj = grow();
+                    }
+                    return obj;
                 }
-                return obj;
             }
 
             void put(T* obj) {
-                pool.put(obj);
+                if constexpr (MAGSIZE != 0) {
+                    if(obj) [[likely]] {
+                        T* out[mags_t::BATCH];
+                        const size_t cnt = mags.put(obj, out);
+                        if(cnt != 0) {
+                            pool.putAll(std::span<T* const> {out, cnt});
+                        }
+                    }
+                } else {
+                    pool.put(obj);
+                }
+            }
+
+            /**
+             * @brief Returns the objects cached in the magazines of all cores to
+             * the shared stack.
+             */
+            void flush(void) {
+                if constexpr (MAGSIZE != 0) {
+                    for(unsigned core = 0; core < mags_t::CORES; ++core) {
+                        T* objs[MAGSIZE];
+                        const size_t cnt = mags.drain(core, objs);
+                        pool.putAll(std::span<T* const> {objs, cnt});
+                    }
+                }
             }
 
             bool growBy(const size_t cnt) {
@@ -141,49 +471,235 @@ namespace mempool {
                     return true;
                 }
 
-                const std::span<T> mem = doAlloc(cnt);
+                const std::span<node_t> mem = doAlloc(cnt);
                 if(!mem.empty()) {
-                    pool.addMem(mem);
+                    pool.putMem(mem);
                     return true;
                 } else {
                     return false;
                 }
             }
 
+            /**
+             * @brief Returns chunks in which no object is in use to the heap, as
+             * long as at least \p keep objects remain allocated.
+             *
+             * All free objects are removed from the pool for the duration, so
+             * a concurrent take() may find it empty and grow it. Must not be
+             * called from more than one task at a time.
+             *
+             * A chunk is only freed once no take() which might still read its
+             * nodes is running. Until then it is kept on a list of retired
+             * chunks, which the next trim() tries again.
+             *
+             * @return the number of objects removed from the pool
+             */
+            uint32_t trim(const uint32_t keep) {
+                freeRetired();
+                flush();
+
+                Chunk* const chunks = chunkList.exchange(nullptr, std::memory_order::acquire);
+                for(Chunk* c = chunks; c != nullptr; c = c->next) {
+                    c->freeCnt = 0;
+                    c->freeList = pool_t::NIL;
+                }
+
+                // Sort all free objects by chunk.
+                uint16_t orphans = pool_t::NIL; // From chunks allocated after the exchange above
+                pool.takeAll([chunks, &orphans](T* const obj) {
+                    node_t* const n = pool_t::nodeOf(obj);
+                    Chunk* const c = findChunk(chunks, n);
+                    uint16_t& list = (c != nullptr) ? c->freeList : orphans;
+                    n->next.store(list, std::memory_order::relaxed);
+                    list = n->self;
+                    if(c != nullptr) [[likely]] {
+                        c->freeCnt += 1;
+                    }
+                });
+
+                uint32_t size = getSize();
+                uint32_t freed = 0;
+                uint32_t freedChunks = 0;
+                Chunk* kept = nullptr;
+                Chunk* keptLast = nullptr;
+                Chunk* c = chunks;
+                while(c != nullptr) {
+                    Chunk* const next = c->next;
+                    if(c->freeCnt == c->cnt && size >= keep + c->cnt) {
+                        size -= c->cnt;
+                        freed += c->cnt;
+                        freedChunks += 1;
+                        pool.unregisterMem(nodesOf(c));
+                        c->next = retired;
+                        retired = c;
+                    } else {
+                        putList(c->freeList);
+                        c->next = kept;
+                        kept = c;
+                        if(keptLast == nullptr) {
+                            keptLast = c;
+                        }
+                    }
+                    c = next;
+                }
+                putList(orphans);
+
+                if(kept != nullptr) {
+                    addChunks(kept, keptLast);
+                }
+                freeRetired();
+                allocCnt.fetch_sub(freed, std::memory_order::relaxed);
+                trimmedCnt.fetch_add(freed, std::memory_order::relaxed);
+                chunkCnt.fetch_sub(freedChunks, std::memory_order::relaxed);
+                return freed;
+            }
+
             uint32_t getSize() const {
                 return allocCnt.load(std::memory_order::relaxed);
             }
 
+            uint32_t getChunkCnt() const {
+                return chunkCnt.load(std::memory_order::relaxed);
+            }
+
+            /**
+             * @return how often the pool allocated a new chunk
+             */
+            uint32_t getGrowCnt() const {
+                return growCnt.load(std::memory_order::relaxed);
+            }
+
+            /**
+             * @return the number of objects trim() returned to the heap
+             */
+            uint32_t getTrimmedCnt() const {
+                return trimmedCnt.load(std::memory_order::relaxed);
+            }
+
+            uint32_t getCasRetries() const {
+                return pool.getCasRetries();
+            }
+
+            /**
+             * @return true if trim() still holds on to chunks it could not free yet
+             */
+            bool hasRetired() const {
+                return retired != nullptr;
+            }
+
         private:
-            MemPoolBase<T> pool {};
+            pool_t pool {};
             std::atomic<uint32_t> allocCnt {};
+            std::atomic<uint32_t> chunkCnt {};
+            std::atomic<uint32_t> growCnt {};
+            std::atomic<uint32_t> trimmedCnt {};
+            // Only ever pushed to or taken as a whole, so no ABA here.
+            std::atomic<Chunk*> chunkList {nullptr};
+            // Unregistered by trim(), to be freed once the pool is quiescent; only used by trim().
+            Chunk* retired {nullptr};
+            [[no_unique_address]] mags_t mags {};
+
+            /**
+             * @brief Takes up to one batch from the shared stack (growing it if
+             * empty), keeps one object for the caller and puts the rest into the
+             * current core's magazine.
+             */
+            T* refill(void) {
+                T* objs[mags_t::BATCH];
+                size_t cnt = 0;
+                // One by one: Only the head is safe to dereference, the other
+                // objects might get taken (and overwritten) concurrently.
+                while(cnt < mags_t::BATCH && (objs[cnt] = pool.take()) != nullptr) {
+                    ++cnt;
+                }
+                if(cnt == 0) {
+                    return grow();
+                }
+                const std::span<T* const> rest {objs + 1, cnt - 1};
+                const size_t stored = mags.fill(rest);
+                // Only if another task filled the magazine meanwhile:
+                pool.putAll(rest.subspan(stored));
+                return objs[0];
+            }
 
             T* grow(void) {
                 if constexpr (GROWCNT != 0) {
-                    const std::span<T> mem = doAlloc(GROWCNT);
+                    const std::span<node_t> mem = doAlloc(GROWCNT);
                     if(!mem.empty()) {
                         if constexpr (GROWCNT > 1) {
                             // Adding all except the first item to the pool:
-                            pool.addMem(mem.subspan(1));
+                            pool.putMem(mem.subspan(1));
                         }
                         // The first item is returned directly to the caller.
-                        return &mem[0];
+                        return &mem[0].item;
                     }
                 }
                 return nullptr;
             }
 
-            std::span<T> doAlloc(const size_t cnt) {
-                const std::span<T> mem = alloctr::allocate(cnt);
-                if(!mem.empty()) {
-                    addToAllocCnt(cnt);
+            /**
+             * @brief Allocates a chunk of \p cnt nodes and registers them with
+             * the pool, without adding them.
+             */
+            std::span<node_t> doAlloc(const size_t cnt) {
+                Chunk* const c = static_cast<Chunk*>(alloctr::allocate(CHUNK_ALIGN, OBJS_OFFSET + cnt * sizeof(node_t)));
+                if(c == nullptr) [[unlikely]] {
+                    return std::span<node_t> {};
+                }
+                c->cnt = cnt;
+                const std::span<node_t> mem = nodesOf(c);
+                if(!pool.registerMem(mem)) [[unlikely]] {
+                    ESP_LOGE("mempool", "No free segment for %u more objects of %u bytes, %" PRIu32 " allocated in %" PRIu32 " chunks",
+                        (unsigned)cnt, (unsigned)sizeof(T), getSize(), getChunkCnt());
+                    alloctr::deallocate(c);
+                    return std::span<node_t> {};
                 }
+                addChunks(c, c);
+                chunkCnt.fetch_add(1, std::memory_order::relaxed);
+                growCnt.fetch_add(1, std::memory_order::relaxed);
+                addToAllocCnt(cnt);
                 return mem;
             }
 
+            void addChunks(Chunk* const first, Chunk* const last) {
+                Chunk* head = chunkList.load(std::memory_order::relaxed);
+                do {
+                    last->next = head;
+                } while(!chunkList.compare_exchange_weak(head, first, std::memory_order::release, std::memory_order::relaxed));
+            }
+
+            void freeRetired(void) {
+                if(retired != nullptr && pool.quiescent()) {
+                    while(retired != nullptr) {
+                        Chunk* const next = retired->next;
+                        alloctr::deallocate(retired);
+                        retired = next;
+                    }
+                }
+            }
+
+            void putList(uint16_t idx) {
+                while(idx != pool_t::NIL) {
+                    node_t* const n = pool.nodeAt(idx);
+                    idx = n->next.load(std::memory_order::relaxed);
+                    pool.put(&(n->item));
+                }
+            }
+
             void addToAllocCnt(const int cnt) {
                 allocCnt.fetch_add(cnt,std::memory_order::relaxed);
             }
+
+            static std::span<node_t> nodesOf(Chunk* const c) {
+                return std::span<node_t> {reinterpret_cast<node_t*>(reinterpret_cast<uint8_t*>(c) + OBJS_OFFSET), c->cnt};
+            }
+
+            static Chunk* findChunk(Chunk* c, const node_t* const n) {
+                while(c != nullptr && !(n >= nodesOf(c).data() && n < nodesOf(c).data() + c->cnt)) {
+                    c = c->next;
+                }
+                return c;
+            }
     };
 
     // struct Stats {
@@ -199,12 +715,44 @@ namespace mempool {
     //     }
     // };
 
-    template<typename T, size_t GROWCNT, auto ALLOC_FN> 
-    class GrowingStatsMemPool : private GrowingMemPool<T,GROWCNT,ALLOC_FN> {
-        using base_t = GrowingMemPool<T,GROWCNT,ALLOC_FN>;
+    /**
+     * @brief When GrowingStatsMemPool::trimIfIdle() gives memory back.
+     */
+    struct TrimPolicy {
+        uint32_t minSize; // Never trim below this many objects.
+        uint32_t lowPercent; // Usage is low while its peak stays below this percentage of the pool size...
+        uint32_t holdTimeMs; // ... and the pool is trimmed after it was low for this long.
+    };
+
+    template<typename T, size_t GROWCNT, auto ALLOC_FN, size_t MAGSIZE = 0, typename HOOKS = NoHooks> 
+    class GrowingStatsMemPool : private GrowingMemPool<T,GROWCNT,ALLOC_FN,MAGSIZE,HOOKS> {
+        using base_t = GrowingMemPool<T,GROWCNT,ALLOC_FN,MAGSIZE,HOOKS>;
         public:
 
-            using base_t::base_t;
+            /**
+             * @brief Creates a pool which does not show up in the registry.
+             */
+            GrowingStatsMemPool() = default;
+
+            /**
+             * @brief Creates a pool and adds it to the registry under \p name ,
+             * see mempool_registry_get().
+             *
+             * @param name must outlive the pool
+             */
+            explicit GrowingStatsMemPool(const char* const name) :
+                entry {.name = name, .pool = this, .getInfo = &getInfo, .next = nullptr} {
+                registry::add(entry);
+            }
+
+            GrowingStatsMemPool(const GrowingStatsMemPool&) = delete;
+            GrowingStatsMemPool& operator=(const GrowingStatsMemPool&) = delete;
+
+            ~GrowingStatsMemPool() {
+                if(entry.name) {
+                    registry::remove(entry);
+                }
+            }
 
             ObjPoolStats_t getStats(void) const {
                 return 
@@ -227,10 +775,8 @@ namespace mempool {
                 T* obj = base_t::take();
                 if(obj) {
                     const uint32_t tcnt = takenCnt.fetch_add(1,std::memory_order::relaxed) + 1;
-                    uint32_t max = maxTakenCnt.load(std::memory_order::relaxed);
-                    do {
-                        // nothing.
-                    } while (tcnt > max && !maxTakenCnt.compare_exchange_strong(max,tcnt));
+                    raiseTo(maxTakenCnt, tcnt);
+                    raiseTo(windowMaxTakenCnt, tcnt);
                 }
                 return obj;
             }
@@ -242,12 +788,63 @@ namespace mempool {
                 }
             }
 
+            /**
+             * @brief Trims the pool if the peak usage stayed low per \p policy .
+             * Meant to be called periodically, from one task only.
+             *
+             * The peak is taken over the time since the previous call, and the
+             * pool is trimmed to keep that peak at \c lowPercent of its size.
+             *
+             * @param nowMs current time, e.g. from esp_timer_get_time()
+             * @return the number of objects freed
+             */
+            uint32_t trimIfIdle(const TrimPolicy& policy, const uint32_t nowMs) {
+                const uint32_t peak = windowMaxTakenCnt.exchange(getInUseCnt(), std::memory_order::relaxed);
+                if((uint64_t)peak * 100 >= (uint64_t)getSize() * policy.lowPercent) {
+                    lowSinceMs = nowMs;
+                    return 0;
+                }
+                if(nowMs - lowSinceMs < policy.holdTimeMs) {
+                    return 0;
+                }
+                lowSinceMs = nowMs;
+                const uint32_t keep = std::max(policy.minSize, (uint32_t)((uint64_t)peak * 100 / policy.lowPercent));
+                return base_t::trim(keep);
+            }
+
             using base_t::growBy;
             using base_t::getSize;
+            using base_t::getChunkCnt;
+            using base_t::flush;
+            using base_t::trim;
+            using base_t::getGrowCnt;
+            using base_t::getTrimmedCnt;
+            using base_t::getCasRetries;
+            using base_t::hasRetired;
 
         private:
             std::atomic<uint32_t> takenCnt {};
             std::atomic<uint32_t> maxTakenCnt {};
+            std::atomic<uint32_t> windowMaxTakenCnt {}; // Peak since the last trimIfIdle()
+            uint32_t lowSinceMs {};
+            RegistryEntry entry {};
+
+            static void getInfo(const void* const p, mempool_info_t& out) {
+                const GrowingStatsMemPool& pool = *(const GrowingStatsMemPool*)p;
+                out.objSize = sizeof(T);
+                out.stats = pool.getStats();
+                out.chunkCnt = pool.getChunkCnt();
+                out.growCnt = pool.getGrowCnt();
+                out.trimmedCnt = pool.getTrimmedCnt();
+                out.casRetries = pool.getCasRetries();
+            }
+
+            static void raiseTo(std::atomic<uint32_t>& max, const uint32_t val) {
+                uint32_t m = max.load(std::memory_order::relaxed);
+                while(val > m && !max.compare_exchange_weak(m, val, std::memory_order::relaxed)) {
+
+                }
+            }
     };
 
 } // namespace mempool
\ No newline at end of file
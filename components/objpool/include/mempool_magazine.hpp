@@ -0,0 +1,132 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+namespace mempool {
+
+    /**
+     * @brief A small stack of free objects ("magazine") per core, in front of
+     * a shared pool.
+     *
+     * The shared pool's head is a single word changed with a CAS. That is
+     * cheap, but both cores contend for it, and a CAS which loses has to
+     * retry. The magazines are only guarded by a lock of their own core
+     * (against other tasks and ISRs on it), so most take()s and put()s never
+     * touch anything the other core uses, and the head only sees one CAS per
+     * BATCH objects put.
+     *
+     * That lock is a critical section, which costs at least as much as an
+     * uncontended CAS. So magazines only help a pool both cores take from and
+     * put to at a high rate. A pool filled on one core and emptied on the
+     * other gains nothing: the taking core's magazine is always empty and is
+     * refilled one CAS per object. CONFIG_MEMPOOL_MAGAZINES has the numbers
+     * the "[objpool][bench]" test must show before they are switched on.
+     *
+     * A task may migrate to the other core between looking up the magazine
+     * and locking it; that is harmless, it then just uses the other core's
+     * magazine.
+     *
+     * @tparam T
+     * @tparam SIZE number of objects each magazine holds
+     */
+    template<typename T, std::size_t SIZE>
+    requires (SIZE >= 2)
+    class Magazines {
+        public:
+            /**
+             * @brief Number of objects moved to/from the shared pool at once.
+             */
+            static constexpr std::size_t BATCH = SIZE / 2;
+
+            Magazines() = default;
+            Magazines(const Magazines&) = delete;
+
+            /**
+             * @return an object from the current core's magazine, or \c nullptr if it is empty
+             */
+            T* take(void) {
+                Mag& m = current();
+                T* obj = nullptr;
+                taskENTER_CRITICAL(&m.lock);
+                if(m.cnt != 0) [[likely]] {
+                    obj = m.objs[--m.cnt];
+                }
+                taskEXIT_CRITICAL(&m.lock);
+                return obj;
+            }
+
+            /**
+             * @brief Stores \p obj in the current core's magazine. If that is
+             * full, \c BATCH objects are moved out to \p out_flush first.
+             *
+             * @return the number of objects in \p out_flush which the caller must
+             * return to the shared pool
+             */
+            std::size_t put(T* const obj, const std::span<T*,BATCH> out_flush) {
+                Mag& m = current();
+                std::size_t flushCnt = 0;
+                taskENTER_CRITICAL(&m.lock);
+                if(m.cnt == SIZE) [[unlikely]] {
+                    m.cnt -= BATCH;
+                    for(T*& o : out_flush) {
+                        o = m.objs[m.cnt + flushCnt++];
+                    }
+                }
+                m.objs[m.cnt++] = obj;
+                taskEXIT_CRITICAL(&m.lock);
+                return flushCnt;
+            }
+
+            /**
+             * @brief Adds as many of \p objs to the current core's magazine as
+             * fit.
+             *
+             * @return the number of objects added, always a prefix of \p objs
+             */
+            std::size_t fill(const std::span<T* const> objs) {
+                Mag& m = current();
+                std::size_t cnt = 0;
+                taskENTER_CRITICAL(&m.lock);
+                while(cnt < objs.size() && m.cnt < SIZE) {
+                    m.objs[m.cnt++] = objs[cnt++];
+                }
+                taskEXIT_CRITICAL(&m.lock);
+                return cnt;
+            }
+
+            /**
+             * @brief Removes all objects from the magazine of core \p core .
+             *
+             * @return the number of objects written to \p out
+             */
+            std::size_t drain(const unsigned core, const std::span<T*,SIZE> out) {
+                Mag& m = mags[core];
+                taskENTER_CRITICAL(&m.lock);
+                const std::size_t cnt = m.cnt;
+                for(std::size_t i = 0; i < cnt; ++i) {
+                    out[i] = m.objs[i];
+                }
+                m.cnt = 0;
+                taskEXIT_CRITICAL(&m.lock);
+                return cnt;
+            }
+
+            static constexpr unsigned CORES = portNUM_PROCESSORS;
+
+        private:
+            struct Mag {
+                portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+                std::size_t cnt {0};
+                T* objs[SIZE];
+            };
+
+            Mag mags[CORES] {};
+
+            Mag& current(void) {
+                return mags[xPortGetCoreID()];
+            }
+    };
+
+} // namespace mempool
@@ -0,0 +1,37 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "obj_pool_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Snapshot of one registered mem pool, see mempool_registry_get()
+ */
+typedef struct mempool_info {
+    const char* name;
+    uint32_t objSize;
+    ObjPoolStats_t stats;
+    uint32_t chunkCnt;
+    uint32_t growCnt;    // Chunks allocated since boot
+    uint32_t trimmedCnt; // Objects given back to the heap since boot
+    uint32_t casRetries; // Failed CAS attempts on the shared free list since boot
+} mempool_info_t;
+
+/**
+ * @brief Copies the current figures of up to \p max registered pools to \p out .
+ *
+ * @return the number of pools written to \p out
+ */
+size_t mempool_registry_get(mempool_info_t* out, size_t max);
+
+/**
+ * @return the number of registered pools
+ */
+size_t mempool_registry_count(void);
+
+#ifdef __cplusplus
+}
+#endif
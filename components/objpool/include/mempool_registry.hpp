@@ -0,0 +1,27 @@
+#pragma once
+#include "mempool_registry.h"
+
+namespace mempool {
+
+    /**
+     * @brief A pool's membership in the registry, see mempool_registry_get().
+     * Lives inside the pool; the registry just links the entries together.
+     */
+    struct RegistryEntry {
+        const char* name;
+        const void* pool;
+        void (*getInfo)(const void* pool, mempool_info_t& out);
+        RegistryEntry* next;
+    };
+
+    namespace registry {
+        /**
+         * @brief Adds \p entry to the registry. Safe to call from static
+         * constructors.
+         */
+        void add(RegistryEntry& entry);
+
+        void remove(RegistryEntry& entry);
+    }
+
+} // namespace mempool
@@ -7,6 +7,8 @@ using cpool_t = mempool::MemPoolBase<dummy_obj_t>;
 
 static_assert(sizeof(mempool_pool_t) == sizeof(cpool_t));
 static_assert(alignof(mempool_pool_t) >= alignof(cpool_t));
+static_assert(sizeof(mempool_node_t) == sizeof(cpool_t::Node));
+static_assert(MEMPOOL_MAX_SEGS == cpool_t::MAX_SEGS);
 
 void mempool_init(mempool_pool_t* pool) {
     new (pool) cpool_t();
@@ -18,6 +20,11 @@ void mempool_deinit(mempool_pool_t* pool) {
     // ((cpool_t*)pool)->~cpool_t();
 }
 
+bool mempool_add_mem(mempool_pool_t* pool, mempool_node_t* nodes, size_t cnt) {
+    cpool_t& p = *(cpool_t*)pool;
+    return p.addMem(std::span<cpool_t::Node> {(cpool_t::Node*)nodes, cnt});
+}
+
 void* mempool_take(mempool_pool_t* pool) {
     cpool_t& p = *(cpool_t*)pool;
     return p.take();
@@ -0,0 +1,50 @@
+#include "mempool_registry.hpp"
+#include "freertos/FreeRTOS.h"
+
+using mempool::RegistryEntry;
+
+// Both constant-initialized, so pools with static storage may register from
+// their constructors regardless of initialization order.
+static constinit portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static constinit RegistryEntry* head = nullptr;
+
+void mempool::registry::add(RegistryEntry& entry) {
+    taskENTER_CRITICAL(&lock);
+    entry.next = head;
+    head = &entry;
+    taskEXIT_CRITICAL(&lock);
+}
+
+void mempool::registry::remove(RegistryEntry& entry) {
+    taskENTER_CRITICAL(&lock);
+    RegistryEntry** e = &head;
+    while(*e != nullptr && *e != &entry) {
+        e = &(*e)->next;
+    }
+    if(*e != nullptr) {
+        *e = entry.next;
+    }
+    taskEXIT_CRITICAL(&lock);
+}
+
+size_t mempool_registry_get(mempool_info_t* out, size_t max) {
+    size_t cnt = 0;
+    taskENTER_CRITICAL(&lock);
+    for(const RegistryEntry* e = head; e != nullptr && cnt < max; e = e->next) {
+        e->getInfo(e->pool, out[cnt]);
+        out[cnt].name = e->name;
+        ++cnt;
+    }
+    taskEXIT_CRITICAL(&lock);
+    return cnt;
+}
+
+size_t mempool_registry_count(void) {
+    size_t cnt = 0;
+    taskENTER_CRITICAL(&lock);
+    for(const RegistryEntry* e = head; e != nullptr; e = e->next) {
+        ++cnt;
+    }
+    taskEXIT_CRITICAL(&lock);
+    return cnt;
+}
@@ -0,0 +1,198 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "mempool.hpp"
+#include "mempool_alloc_fn.hpp"
+
+/*
+    The object and growing pool the mem pool tests share, and tasks hammering
+    a pool from both cores.
+
+    Every task marks the objects it holds with an owner id, so an object handed
+    out twice shows up as an error. Works with any pool which has take() and
+    put(); mixTask() also needs putAll().
+*/
+namespace pool_stress {
+
+    struct Obj {
+        uint32_t value;
+        std::atomic<uint32_t> owner;
+    };
+
+    static constexpr unsigned GROW_CNT = 4;
+
+    template<size_t MAGSIZE = 0>
+    using GrowingPool = mempool::GrowingStatsMemPool<Obj,GROW_CNT,mempool::alloc::INTERNAL,MAGSIZE>;
+
+    // Owner ids carry this in the upper half. Objects fresh from the heap hold
+    // whatever was there before, which is unlikely to look like an owner id.
+    static constexpr uint32_t OWNER_TAG = 0x5a5a0000;
+    static constexpr uint32_t OWNER_MASK = 0xffff0000;
+
+    static constexpr unsigned RING_SIZE = 32;
+
+    template<typename Pool>
+    struct Ctx {
+        Pool* pool {};
+        uint32_t iterations {};
+        std::atomic<uint32_t> nextId {0};
+        std::atomic<uint32_t> errors {0};
+        // Hands objects from producerTask() to consumerTask() (single producer, single consumer).
+        std::atomic<Obj*> ring[RING_SIZE] {};
+        SemaphoreHandle_t done {};
+    };
+
+    inline void own(Obj* const o, const uint32_t id, std::atomic<uint32_t>& errors) {
+        if(o == nullptr || (o->owner.exchange(OWNER_TAG | id) & OWNER_MASK) == OWNER_TAG) {
+            errors.fetch_add(1);
+        }
+    }
+
+    inline void disown(Obj* const o) {
+        o->owner.store(0);
+    }
+
+    template<typename Pool>
+    uint32_t newId(Ctx<Pool>& ctx) {
+        return ctx.nextId.fetch_add(1) + 1;
+    }
+
+    template<typename Pool>
+    void finish(Ctx<Pool>& ctx) {
+        xSemaphoreGive(ctx.done);
+        vTaskDelete(NULL);
+    }
+
+    // Takes two objects and puts them back in reverse order.
+    template<typename Pool>
+    void pairTask(void* pv) {
+        Ctx<Pool>& ctx = *(Ctx<Pool>*)pv;
+        const uint32_t id = newId(ctx);
+        for(uint32_t i = 0; i < ctx.iterations; ++i) {
+            Obj* const objs[2] = {ctx.pool->take(), ctx.pool->take()};
+            for(Obj* const o : objs) {
+                own(o, id, ctx.errors);
+            }
+            for(Obj* const o : {objs[1], objs[0]}) {
+                if(o) {
+                    disown(o);
+                    ctx.pool->put(o);
+                }
+            }
+            if((i & 0x3fff) == 0) {
+                vTaskDelay(1); // Keep the watchdog fed.
+            }
+        }
+        finish(ctx);
+    }
+
+    // Takes 1 to 4 objects and puts them back one by one or all at once.
+    // Running dry is fine here, the pool may be smaller than all tasks need.
+    template<typename Pool>
+    void mixTask(void* pv) {
+        Ctx<Pool>& ctx = *(Ctx<Pool>*)pv;
+        const uint32_t id = newId(ctx);
+        uint32_t rnd = id * 0x9e3779b9u;
+        for(uint32_t i = 0; i < ctx.iterations; ++i) {
+            rnd ^= rnd << 13;
+            rnd ^= rnd >> 17;
+            rnd ^= rnd << 5;
+            Obj* objs[4];
+            std::size_t cnt = 0;
+            for(unsigned k = 0; k <= rnd % 4; ++k) {
+                Obj* const o = ctx.pool->take();
+                if(o) {
+                    own(o, id, ctx.errors);
+                    objs[cnt++] = o;
+                }
+            }
+            for(std::size_t k = 0; k < cnt; ++k) {
+                disown(objs[k]);
+            }
+            if(rnd & 0x100) {
+                ctx.pool->putAll(std::span<Obj* const> {objs, cnt});
+            } else {
+                for(std::size_t k = 0; k < cnt; ++k) {
+                    ctx.pool->put(objs[k]);
+                }
+            }
+            if((i & 0x3fff) == 0) {
+                vTaskDelay(1); // Keep the watchdog fed.
+            }
+        }
+        finish(ctx);
+    }
+
+    // Takes objects and passes them to consumerTask() on the other core, like
+    // the job and result tasks do.
+    template<typename Pool>
+    void producerTask(void* pv) {
+        Ctx<Pool>& ctx = *(Ctx<Pool>*)pv;
+        const uint32_t id = newId(ctx);
+        for(uint32_t i = 0; i < ctx.iterations; ++i) {
+            Obj* const o = ctx.pool->take();
+            own(o, id, ctx.errors);
+            std::atomic<Obj*>& slot = ctx.ring[i % RING_SIZE];
+            while(slot.load(std::memory_order::acquire) != nullptr) {
+                taskYIELD();
+            }
+            slot.store(o, std::memory_order::release);
+        }
+        finish(ctx);
+    }
+
+    template<typename Pool>
+    void consumerTask(void* pv) {
+        Ctx<Pool>& ctx = *(Ctx<Pool>*)pv;
+        for(uint32_t i = 0; i < ctx.iterations; ++i) {
+            std::atomic<Obj*>& slot = ctx.ring[i % RING_SIZE];
+            Obj* o;
+            while((o = slot.load(std::memory_order::acquire)) == nullptr) {
+                taskYIELD();
+            }
+            slot.store(nullptr, std::memory_order::relaxed);
+            disown(o);
+            ctx.pool->put(o);
+        }
+        finish(ctx);
+    }
+
+    /**
+     * @brief Runs \p fns , one task each, pinned to the cores in turn, and
+     * waits for all of them.
+     *
+     * @return the time taken in us
+     */
+    template<typename Pool>
+    uint32_t runTasks(Ctx<Pool>& ctx, const std::initializer_list<TaskFunction_t> fns) {
+        ctx.done = xSemaphoreCreateCounting(fns.size(), 0);
+        const int64_t start = esp_timer_get_time();
+        unsigned core = 0;
+        for(TaskFunction_t fn : fns) {
+            xTaskCreatePinnedToCore(fn, "pool stress", 3072, &ctx, 5, NULL, core++ % portNUM_PROCESSORS);
+        }
+        for(std::size_t i = 0; i < fns.size(); ++i) {
+            xSemaphoreTake(ctx.done, portMAX_DELAY);
+        }
+        const int64_t duration = esp_timer_get_time() - start;
+        vSemaphoreDelete(ctx.done);
+        return duration;
+    }
+
+    /**
+     * @brief Runs pairTask() on the first \p cores cores.
+     */
+    template<typename Pool>
+    uint32_t runPairs(Ctx<Pool>& ctx, const unsigned cores) {
+        return (cores == 1) ? runTasks(ctx, {pairTask<Pool>}) : runTasks(ctx, {pairTask<Pool>, pairTask<Pool>});
+    }
+
+} // namespace pool_stress
@@ -0,0 +1,228 @@
+#include <atomic>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include "unity.h"
+
+#include "mempool.hpp"
+#include "mempool_alloc_fn.hpp"
+
+#include "pool_stress.hpp"
+
+namespace {
+    // What "another task" does in the middle of a take(), see TakeHook.
+    void (*hookFn)(void);
+    bool hookArmed;
+
+    struct TakeHook {
+        static void beforeTakeCas(void) {
+            if(hookArmed) {
+                hookArmed = false;
+                hookFn();
+            }
+        }
+    };
+
+    using pool_stress::Obj;
+    using Pool = mempool::MemPoolBase<Obj,TakeHook>;
+    using Ctx = pool_stress::Ctx<Pool>;
+
+    Pool* abaPool;
+    Obj* abaTaken[2];
+
+    // Takes the head and its successor, then puts the head back: The head
+    // is the same object again, but its successor is gone.
+    void abaHook() {
+        abaTaken[0] = abaPool->take();
+        abaTaken[1] = abaPool->take();
+        abaPool->put(abaTaken[0]);
+    }
+
+    using GrowingPool = mempool::GrowingStatsMemPool<Obj,2,mempool::alloc::INTERNAL,0,TakeHook>;
+
+    GrowingPool* trimPool;
+    uint32_t trimmed;
+    bool retiredInTake;
+
+    void trimHook() {
+        trimmed = trimPool->trim(0);
+        retiredInTake = trimPool->hasRetired();
+    }
+
+    Pool* reusePool;
+    std::span<Pool::Node> reuseOld;
+    std::span<Pool::Node> reuseNew;
+    bool reusedInTake;
+
+    // Takes the stalled take()'s node out of the pool and unregisters it,
+    // then wants a segment for other memory.
+    void reuseHook() {
+        reusePool->takeAll([](Obj*) {});
+        reusePool->unregisterMem(reuseOld);
+        reusedInTake = reusePool->registerMem(reuseNew);
+    }
+}
+
+TEST_CASE("Mem pool take survives ABA", "[objpool]")
+{
+    static Pool pool;
+    static Pool::Node nodes[3];
+    // Stacked in order, nodes[0] on top.
+    TEST_ASSERT_TRUE(pool.addMem(nodes));
+
+    abaPool = &pool;
+    hookFn = abaHook;
+    hookArmed = true;
+    TEST_ASSERT_EQUAL_PTR(&nodes[0].item, pool.take());
+    TEST_ASSERT_FALSE(hookArmed);
+    TEST_ASSERT_EQUAL_PTR(&nodes[1].item, abaTaken[1]);
+
+    // nodes[1] is still taken, so only nodes[2] may be left.
+    TEST_ASSERT_EQUAL_PTR(&nodes[2].item, pool.take());
+    TEST_ASSERT_NULL(pool.take());
+}
+
+TEST_CASE("Mem pool trim keeps chunks a take() may still read", "[objpool]")
+{
+    GrowingPool pool {};
+    // One chunk of two, both free.
+    pool.put(pool.take());
+    TEST_ASSERT_EQUAL_UINT32(1, pool.getChunkCnt());
+
+    // Trim while a take() holds a node of that chunk: The chunk leaves the
+    // pool, but its memory stays until the take() is done.
+    trimPool = &pool;
+    hookFn = trimHook;
+    hookArmed = true;
+    Obj* const obj = pool.take();
+    TEST_ASSERT_FALSE(hookArmed);
+    TEST_ASSERT_EQUAL_UINT32(2, trimmed);
+    TEST_ASSERT_TRUE(retiredInTake);
+    // The take() had to grow the pool again.
+    TEST_ASSERT_NOT_NULL(obj);
+    TEST_ASSERT_EQUAL_UINT32(1, pool.getChunkCnt());
+    TEST_ASSERT_TRUE(pool.hasRetired());
+
+    pool.put(obj);
+    TEST_ASSERT_EQUAL_UINT32(2, pool.trim(0));
+    TEST_ASSERT_FALSE(pool.hasRetired());
+    TEST_ASSERT_EQUAL_UINT32(0, pool.getSize());
+}
+
+TEST_CASE("Mem pool reuses a segment only once no take() may look it up", "[objpool]")
+{
+    static Pool pool;
+    static Pool::Node nodes[2];
+    static Pool::Node others[Pool::MAX_SEGS - 1][1];
+    static Pool::Node single[1];
+    TEST_ASSERT_TRUE(pool.addMem(nodes));
+    // No other segment is free.
+    for(auto& o : others) {
+        TEST_ASSERT_TRUE(pool.registerMem(o));
+    }
+
+    reusePool = &pool;
+    reuseOld = nodes;
+    reuseNew = single;
+    hookFn = reuseHook;
+    hookArmed = true;
+    TEST_ASSERT_NULL(pool.take());
+    TEST_ASSERT_FALSE(hookArmed);
+    TEST_ASSERT_FALSE(reusedInTake);
+
+    // Now nothing can look up the old nodes anymore.
+    TEST_ASSERT_TRUE(pool.registerMem(single));
+    TEST_ASSERT_EQUAL_UINT32(nodes[0].self >> Pool::SLOT_BITS, single[0].self >> Pool::SLOT_BITS);
+    TEST_ASSERT_EQUAL_PTR(&single[0], pool.nodeAt(single[0].self));
+}
+
+TEST_CASE("Mem pool stress on both cores", "[objpool]")
+{
+    static Pool pool;
+    static Pool::Node nodes[4];
+    TEST_ASSERT_TRUE(pool.addMem(nodes));
+
+    Ctx ctx {.pool = &pool, .iterations = 200000};
+    pool_stress::runPairs(ctx, portNUM_PROCESSORS);
+
+    TEST_ASSERT_EQUAL_UINT32(0, ctx.errors.load());
+
+    // All objects made it back exactly once.
+    unsigned cnt = 0;
+    while(pool.take() != nullptr) {
+        TEST_ASSERT_LESS_OR_EQUAL(4, ++cnt);
+    }
+    TEST_ASSERT_EQUAL(4, cnt);
+}
+
+TEST_CASE("Mem pool stress with two tasks per core", "[objpool]")
+{
+    static Pool pool;
+    // Two segments, so indices from both are in use.
+    static Pool::Node nodes[2][4];
+    TEST_ASSERT_TRUE(pool.addMem(nodes[0]));
+    TEST_ASSERT_TRUE(pool.addMem(nodes[1]));
+
+    Ctx ctx {.pool = &pool, .iterations = 100000};
+    // Pinned to the cores in turn.
+    pool_stress::runTasks(ctx, {pool_stress::mixTask<Pool>, pool_stress::mixTask<Pool>,
+                                pool_stress::mixTask<Pool>, pool_stress::mixTask<Pool>});
+
+    TEST_ASSERT_EQUAL_UINT32(0, ctx.errors.load());
+
+    unsigned cnt = 0;
+    while(pool.take() != nullptr) {
+        TEST_ASSERT_LESS_OR_EQUAL(8, ++cnt);
+    }
+    TEST_ASSERT_EQUAL(8, cnt);
+    printf("%" PRIu32 " CAS retries\n", pool.getCasRetries());
+}
+
+TEST_CASE("Mem pool segments", "[objpool]")
+{
+    static Pool pool;
+    static Pool::Node nodes[Pool::SEG_SIZE + 2];
+
+    // More than one segment's worth takes two.
+    TEST_ASSERT_TRUE(pool.registerMem(nodes));
+    TEST_ASSERT_EQUAL_UINT32(0, nodes[0].self >> Pool::SLOT_BITS);
+    TEST_ASSERT_EQUAL_UINT32(1, nodes[Pool::SEG_SIZE].self >> Pool::SLOT_BITS);
+    TEST_ASSERT_EQUAL_PTR(&nodes[Pool::SEG_SIZE + 1], pool.nodeAt(nodes[Pool::SEG_SIZE + 1].self));
+    pool.putMem(nodes);
+    unsigned cnt = 0;
+    while(pool.take() != nullptr) {
+        ++cnt;
+    }
+    TEST_ASSERT_EQUAL(Pool::SEG_SIZE + 2, cnt);
+
+    pool.unregisterMem(nodes);
+    TEST_ASSERT_NULL(pool.nodeAt(nodes[0].self));
+
+    // Segments are reused, and running out of them is reported.
+    static Pool::Node single[Pool::MAX_SEGS + 1][1];
+    for(unsigned i = 0; i < Pool::MAX_SEGS; ++i) {
+        TEST_ASSERT_TRUE(pool.addMem(single[i]));
+    }
+    TEST_ASSERT_FALSE(pool.addMem(single[Pool::MAX_SEGS]));
+    pool.reset();
+    pool.unregisterMem(single[0]);
+    TEST_ASSERT_TRUE(pool.addMem(single[Pool::MAX_SEGS]));
+    TEST_ASSERT_EQUAL_PTR(&single[Pool::MAX_SEGS][0].item, pool.take());
+}
+
+TEST_CASE("Mem pool throughput", "[objpool][bench]")
+{
+    static Pool pool;
+    static Pool::Node nodes[4];
+    TEST_ASSERT_TRUE(pool.addMem(nodes));
+
+    for(unsigned cores = 1; cores <= portNUM_PROCESSORS; ++cores) {
+        Ctx ctx {.pool = &pool, .iterations = 100000};
+        const uint32_t us = pool_stress::runPairs(ctx, cores);
+        // Every iteration takes and puts two objects.
+        printf("%u core(s): %" PRIu32 " take/put pairs in %" PRIu32 " us, %.0f pairs/s\n",
+            cores, cores * ctx.iterations * 2, us, cores * ctx.iterations * 2 * 1e6 / us);
+        TEST_ASSERT_EQUAL_UINT32(0, ctx.errors.load());
+    }
+}
@@ -0,0 +1,122 @@
+#include <atomic>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include "unity.h"
+#include "mempool.hpp"
+#include "pool_stress.hpp"
+
+namespace {
+    using pool_stress::Obj;
+    using pool_stress::Ctx;
+    using pool_stress::producerTask;
+    using pool_stress::consumerTask;
+
+    static constexpr unsigned MAG_SIZE = 16;
+
+    using PlainPool = pool_stress::GrowingPool<>;
+    using MagPool = pool_stress::GrowingPool<MAG_SIZE>;
+
+    // Returns all objects the pool has cached and checks none is missing.
+    template<typename Pool>
+    void checkAllReturned(Pool& pool) {
+        pool.flush();
+        TEST_ASSERT_EQUAL_UINT32(0, pool.getInUseCnt());
+        const uint32_t size = pool.getSize();
+        uint32_t cnt = 0;
+        while(cnt < size && pool.take() != nullptr) {
+            ++cnt;
+        }
+        TEST_ASSERT_EQUAL_UINT32(size, cnt);
+    }
+
+    struct Rates {
+        double oneCore;
+        double bothCores;
+        double crossCore;
+    };
+
+    // Take/put pairs per second, each on a fresh pool.
+    template<typename Pool>
+    Rates bench(const char* const name) {
+        static constexpr uint32_t ITERATIONS = 100000;
+        Rates r;
+        {
+            Pool* const pool = new Pool {};
+            Ctx<Pool> ctx {.pool = pool, .iterations = ITERATIONS};
+            const uint32_t us = pool_stress::runPairs(ctx, 1);
+            r.oneCore = ITERATIONS * 2 * 1e6 / us;
+            TEST_ASSERT_EQUAL_UINT32(0, ctx.errors.load());
+            delete pool; // Leaks the pool's objects; fine for a test.
+        }
+        {
+            Pool* const pool = new Pool {};
+            Ctx<Pool> ctx {.pool = pool, .iterations = ITERATIONS};
+            const uint32_t us = pool_stress::runPairs(ctx, portNUM_PROCESSORS);
+            r.bothCores = portNUM_PROCESSORS * ITERATIONS * 2 * 1e6 / us;
+            TEST_ASSERT_EQUAL_UINT32(0, ctx.errors.load());
+            delete pool;
+        }
+        {
+            Pool* const pool = new Pool {};
+            Ctx<Pool> ctx {.pool = pool, .iterations = ITERATIONS};
+            const uint32_t us = pool_stress::runTasks(ctx, {producerTask<Pool>, consumerTask<Pool>});
+            r.crossCore = ITERATIONS * 1e6 / us;
+            TEST_ASSERT_EQUAL_UINT32(0, ctx.errors.load());
+            delete pool;
+        }
+        printf("%s: one core %.0f, both cores %.0f, cross-core %.0f take/put pairs/s\n",
+            name, r.oneCore, r.bothCores, r.crossCore);
+        return r;
+    }
+}
+
+TEST_CASE("Mem pool magazine refills and flushes in batches", "[objpool]")
+{
+    static MagPool pool;
+    Obj* objs[3 * MAG_SIZE];
+
+    for(Obj*& o : objs) {
+        o = pool.take();
+        TEST_ASSERT_NOT_NULL(o);
+    }
+    const uint32_t size = pool.getSize();
+    TEST_ASSERT_EQUAL_UINT32(3 * MAG_SIZE, pool.getInUseCnt());
+
+    // Putting more than fits into the magazine must spill to the shared stack...
+    for(Obj* const o : objs) {
+        pool.put(o);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, pool.getInUseCnt());
+
+    // ...so taking them all again does not need to grow the pool.
+    for(Obj*& o : objs) {
+        o = pool.take();
+        TEST_ASSERT_NOT_NULL(o);
+    }
+    TEST_ASSERT_EQUAL_UINT32(size, pool.getSize());
+    for(Obj* const o : objs) {
+        pool.put(o);
+    }
+
+    checkAllReturned(pool);
+}
+
+TEST_CASE("Mem pool magazine cross-core handoff", "[objpool]")
+{
+    MagPool* const pool = new MagPool {};
+    Ctx<MagPool> ctx {.pool = pool, .iterations = 200000};
+    pool_stress::runTasks(ctx, {producerTask<MagPool>, consumerTask<MagPool>});
+    TEST_ASSERT_EQUAL_UINT32(0, ctx.errors.load());
+    checkAllReturned(*pool);
+    delete pool;
+}
+
+TEST_CASE("Mem pool magazine throughput", "[objpool][bench]")
+{
+    const Rates plain = bench<PlainPool>("No magazine");
+    const Rates mag = bench<MagPool>("Magazine of 16");
+    // See CONFIG_MEMPOOL_MAGAZINES for what these need to be for magazines to pay off.
+    printf("Magazine vs. none: both cores %.2fx, cross-core %.2fx\n",
+        mag.bothCores / plain.bothCores, mag.crossCore / plain.crossCore);
+}
@@ -0,0 +1,69 @@
+#include <cstdint>
+#include <cstring>
+#include "unity.h"
+#include "mempool.hpp"
+#include "pool_stress.hpp"
+
+namespace {
+    using pool_stress::Obj;
+    using pool_stress::GROW_CNT;
+    using Pool = pool_stress::GrowingPool<>;
+
+    static constexpr size_t MAX_POOLS = 16;
+
+    const mempool_info_t* find(const mempool_info_t* const infos, const size_t cnt, const char* const name) {
+        for(size_t i = 0; i < cnt; ++i) {
+            if(strcmp(infos[i].name, name) == 0) {
+                return &infos[i];
+            }
+        }
+        return nullptr;
+    }
+}
+
+TEST_CASE("Mem pool registry lists named pools", "[objpool]")
+{
+    static mempool_info_t infos[MAX_POOLS];
+    const size_t before = mempool_registry_count();
+
+    {
+        Pool unnamed {};
+        TEST_ASSERT_EQUAL(before, mempool_registry_count());
+
+        Pool pool {"test"};
+        TEST_ASSERT_EQUAL(before + 1, mempool_registry_count());
+
+        Obj* objs[GROW_CNT + 1];
+        for(Obj*& o : objs) {
+            o = pool.take();
+        }
+        for(unsigned i = 1; i < GROW_CNT + 1; ++i) {
+            pool.put(objs[i]);
+        }
+
+        size_t cnt = mempool_registry_get(infos, MAX_POOLS);
+        const mempool_info_t* info = find(infos, cnt, "test");
+        TEST_ASSERT_NOT_NULL(info);
+        TEST_ASSERT_EQUAL_UINT32(sizeof(Obj), info->objSize);
+        TEST_ASSERT_EQUAL_UINT32(2 * GROW_CNT, info->stats.allocCnt);
+        TEST_ASSERT_EQUAL_UINT32(1, info->stats.inUseCnt);
+        TEST_ASSERT_EQUAL_UINT32(GROW_CNT + 1, info->stats.maxInUseCnt);
+        TEST_ASSERT_EQUAL_UINT32(2, info->chunkCnt);
+        TEST_ASSERT_EQUAL_UINT32(2, info->growCnt);
+        TEST_ASSERT_EQUAL_UINT32(0, info->trimmedCnt);
+
+        pool.put(objs[0]);
+        pool.trim(0);
+
+        cnt = mempool_registry_get(infos, MAX_POOLS);
+        info = find(infos, cnt, "test");
+        TEST_ASSERT_NOT_NULL(info);
+        TEST_ASSERT_EQUAL_UINT32(0, info->chunkCnt);
+        TEST_ASSERT_EQUAL_UINT32(2 * GROW_CNT, info->trimmedCnt);
+    }
+
+    // Destroyed pools leave the registry.
+    TEST_ASSERT_EQUAL(before, mempool_registry_count());
+    const size_t cnt = mempool_registry_get(infos, MAX_POOLS);
+    TEST_ASSERT_NULL(find(infos, cnt, "test"));
+}
@@ -0,0 +1,104 @@
+#include <cstdint>
+#include "unity.h"
+#include "mempool.hpp"
+#include "pool_stress.hpp"
+
+namespace {
+    using pool_stress::Obj;
+    using pool_stress::GROW_CNT;
+    using Pool = pool_stress::GrowingPool<>;
+    using MagPool = pool_stress::GrowingPool<8>;
+
+    template<typename P>
+    void trimOnlyFreeChunks(void) {
+        P pool {};
+        Obj* objs[10 * GROW_CNT];
+        for(Obj*& o : objs) {
+            o = pool.take();
+            TEST_ASSERT_NOT_NULL(o);
+        }
+        TEST_ASSERT_EQUAL_UINT32(10, pool.getChunkCnt());
+
+        // One object in use keeps every chunk.
+        for(unsigned i = 0; i < 10 * GROW_CNT; i += 2) {
+            pool.put(objs[i]);
+            objs[i] = nullptr;
+        }
+        TEST_ASSERT_EQUAL_UINT32(0, pool.trim(0));
+        TEST_ASSERT_EQUAL_UINT32(10, pool.getChunkCnt());
+
+        for(Obj*& o : objs) {
+            pool.put(o);
+            o = nullptr;
+        }
+        TEST_ASSERT_EQUAL_UINT32(8 * GROW_CNT, pool.trim(2 * GROW_CNT));
+        TEST_ASSERT_EQUAL_UINT32(2 * GROW_CNT, pool.getSize());
+        TEST_ASSERT_EQUAL_UINT32(2, pool.getChunkCnt());
+
+        // What is left must still be usable without growing.
+        for(unsigned i = 0; i < 2 * GROW_CNT; ++i) {
+            objs[i] = pool.take();
+            TEST_ASSERT_NOT_NULL(objs[i]);
+        }
+        TEST_ASSERT_EQUAL_UINT32(2 * GROW_CNT, pool.getSize());
+        for(unsigned i = 0; i < 2 * GROW_CNT; ++i) {
+            pool.put(objs[i]);
+        }
+
+        TEST_ASSERT_EQUAL_UINT32(2 * GROW_CNT, pool.trim(0));
+        TEST_ASSERT_EQUAL_UINT32(0, pool.getSize());
+        TEST_ASSERT_EQUAL_UINT32(0, pool.getChunkCnt());
+    }
+}
+
+TEST_CASE("Mem pool trim frees only unused chunks", "[objpool]")
+{
+    trimOnlyFreeChunks<Pool>();
+    trimOnlyFreeChunks<MagPool>();
+}
+
+TEST_CASE("Mem pool trims after low usage for the hold time", "[objpool]")
+{
+    static constexpr mempool::TrimPolicy POLICY {
+        .minSize = GROW_CNT,
+        .lowPercent = 50,
+        .holdTimeMs = 1000
+    };
+
+    Pool pool {};
+    Obj* objs[8 * GROW_CNT];
+    for(Obj*& o : objs) {
+        o = pool.take();
+    }
+    for(Obj*& o : objs) {
+        pool.put(o);
+    }
+
+    // The burst above counts as high usage.
+    TEST_ASSERT_EQUAL_UINT32(0, pool.trimIfIdle(POLICY, 0));
+
+    // Usage peaks at 2 objects from now on: low, but not for long enough yet.
+    objs[0] = pool.take();
+    objs[1] = pool.take();
+    pool.put(objs[0]);
+    pool.put(objs[1]);
+    TEST_ASSERT_EQUAL_UINT32(0, pool.trimIfIdle(POLICY, 500));
+    TEST_ASSERT_EQUAL_UINT32(0, pool.trimIfIdle(POLICY, 999));
+
+    // Trimmed to keep the peak at 50%, but not below minSize.
+    TEST_ASSERT_EQUAL_UINT32(7 * GROW_CNT, pool.trimIfIdle(POLICY, 1000));
+    TEST_ASSERT_EQUAL_UINT32(GROW_CNT, pool.getSize());
+
+    // A peak above the watermark restarts the hold time.
+    for(unsigned i = 0; i < 3; ++i) {
+        objs[i] = pool.take();
+    }
+    for(unsigned i = 0; i < 3; ++i) {
+        pool.put(objs[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, pool.trimIfIdle(POLICY, 5000));
+    TEST_ASSERT_EQUAL_UINT32(0, pool.trimIfIdle(POLICY, 5500));
+    TEST_ASSERT_EQUAL_UINT32(GROW_CNT, pool.getSize());
+
+    pool.trim(0);
+}
@@ -0,0 +1,249 @@
+#include "hex_conv.h"
+#include "mem_cpy.h"
+
+static constexpr char HEXCHARS[] =
+    {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
+
+static inline constexpr uint32_t min(const uint32_t a, const uint32_t b) {
+    return (a<b) ? a : b;
+}
+
+// 0...15, or 0xff if ch is not a hex digit.
+static inline uint32_t hexval(const uint32_t ch) {
+    const uint32_t d = ch - '0';
+    if(d < 10) {
+        return d;
+    }
+    const uint32_t l = (ch | 0x20) - 'a'; // Turns upper into lower case
+    if(l < 6) {
+        return l + 10;
+    }
+    return 0xff;
+}
+
+void hex_encode_scalar(const uint8_t* bin, const uint32_t len, char* hex) {
+    const uint8_t* const end = bin + len;
+    while(bin < end) {
+        const uint32_t b = bin[0];
+        hex[0] = HEXCHARS[b >> 4];
+        hex[1] = HEXCHARS[b & 0xf];
+        hex += 2;
+        bin += 1;
+    }
+}
+
+uint32_t hex_decode_scalar(const char* hex, const uint32_t len, uint8_t* bin) {
+    for(uint32_t i = 0; i < len; ++i) {
+        const uint32_t h = hexval(hex[0]);
+        if(h > 0xf) [[unlikely]] {
+            return i;
+        }
+        const uint32_t l = hexval(hex[1]);
+        if(l > 0xf) [[unlikely]] {
+            return i;
+        }
+        bin[i] = (h << 4) | l;
+        hex += 2;
+    }
+    return len;
+}
+
+#if CONFIG_SIMD_UTILS_HEX_PIE
+
+// Bytes per chunk; unaligned output goes through a buffer of this size on the stack.
+static constexpr uint32_t CHUNK = 64;
+
+/* Nibble n becomes n + '0' + ((n > 9) & ('a'-'0'-10)). */
+alignas(16)
+static const int8_t ENC_K[4][16] = {
+    { 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f },
+    {    9,    9,    9,    9,    9,    9,    9,    9,    9,    9,    9,    9,    9,    9,    9,    9 },
+    {  '0',  '0',  '0',  '0',  '0',  '0',  '0',  '0',  '0',  '0',  '0',  '0',  '0',  '0',  '0',  '0' },
+    {   39,   39,   39,   39,   39,   39,   39,   39,   39,   39,   39,   39,   39,   39,   39,   39 }
+};
+
+/* A digit d becomes (d & 0x0f) + (isLetter(d) & 9).
+   The first 3 vectors stay in q5...q7, the other 4 are bounds which get
+   re-loaded in every iteration because we run out of registers. */
+alignas(16)
+static const int8_t DEC_K[7][16] = {
+    { 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20 },
+    { 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f },
+    {    9,    9,    9,    9,    9,    9,    9,    9,    9,    9,    9,    9,    9,    9,    9,    9 },
+    {  '/',  '/',  '/',  '/',  '/',  '/',  '/',  '/',  '/',  '/',  '/',  '/',  '/',  '/',  '/',  '/' },
+    {  ':',  ':',  ':',  ':',  ':',  ':',  ':',  ':',  ':',  ':',  ':',  ':',  ':',  ':',  ':',  ':' },
+    {  '`',  '`',  '`',  '`',  '`',  '`',  '`',  '`',  '`',  '`',  '`',  '`',  '`',  '`',  '`',  '`' },
+    {  'g',  'g',  'g',  'g',  'g',  'g',  'g',  'g',  'g',  'g',  'g',  'g',  'g',  'g',  'g',  'g' }
+};
+
+/*
+    The vector loops below read their input in aligned 16-byte blocks, and one
+    block ahead: Besides the blocks holding the cnt*16 input bytes they use,
+    they also load the block after that. This is harmless if that block holds
+    input too, as no load then leaves the aligned blocks the input lies in.
+    vecCnt() makes sure of that by leaving the last vector to the scalar code
+    where it does not.
+*/
+
+/**
+ * @return how many vectors of 16 bytes of the \p size bytes at \p in the
+ * vector loops may process
+ */
+static inline uint32_t vecCnt(const void* const in, const uint32_t size) {
+    uint32_t cnt = size / 16;
+    // Only if the input is aligned and ends with the last vector does the
+    // block read ahead lie entirely outside of it.
+    if(cnt != 0 && cnt * 16 == size && ((uintptr_t)in & 0xf) == 0) {
+        cnt -= 1;
+    }
+    return cnt;
+}
+
+/**
+ * @brief Encodes \p cnt times 16 bytes from \p bin to \p hex.
+ * \p hex must be 16-byte aligned. Reads ahead, see vecCnt().
+ */
+static void encodeVecs(const uint8_t* bin, const uint32_t cnt, char* hex) {
+    const int8_t* k = &ENC_K[0][0];
+    asm (
+        "SSAI 4" "\n" // for EE.VSR.32
+
+        "EE.VLD.128.IP q5, %[k], 16" "\n"
+        "EE.VLD.128.IP q6, %[k], 16" "\n"
+        "EE.VLD.128.IP q7, %[k], 16" "\n"
+        "EE.VLD.128.IP q4, %[k], 16" "\n"
+
+        "EE.LD.128.USAR.IP q0, %[bin], 16" "\n"
+
+        "LOOPNEZ %[cnt], .Lend_%=" "\n"
+            "EE.VLD.128.IP q1, %[bin], 16" "\n"
+            "EE.SRC.Q.QUP q2, q0, q1" "\n" // q2 := next 16 bytes
+
+            "EE.VSR.32 q3, q2" "\n"
+            "EE.ANDQ q2, q2, q5" "\n" // q2 := low nibbles
+            "EE.ANDQ q3, q3, q5" "\n" // q3 := high nibbles
+
+            "EE.VCMP.GT.S8 q1, q2, q6" "\n"
+            "EE.ANDQ q1, q1, q4" "\n"
+            "EE.VADDS.S8 q2, q2, q1" "\n"
+            "EE.VADDS.S8 q2, q2, q7" "\n" // q2 := low digits
+
+            "EE.VCMP.GT.S8 q1, q3, q6" "\n"
+            "EE.ANDQ q1, q1, q4" "\n"
+            "EE.VADDS.S8 q3, q3, q1" "\n"
+            "EE.VADDS.S8 q3, q3, q7" "\n" // q3 := high digits
+
+            "EE.VZIP.8 q3, q2" "\n" // high, low, high, low,...
+            "EE.VST.128.IP q3, %[hex], 16" "\n"
+            "EE.VST.128.IP q2, %[hex], 16" "\n"
+        ".Lend_%=:" "\n"
+        : [bin] "+r" (bin), [hex] "+r" (hex), [k] "+r" (k),
+          "=m" (*(char(*)[cnt*32])hex)
+        : [cnt] "r" (cnt),
+          "m" (ENC_K), "m" (*(const uint8_t(*)[cnt*16])bin)
+    );
+}
+
+/**
+ * @brief Decodes \p cnt times 16 digits from \p hex to \p bin.
+ * \p bin must be 8-byte aligned. Reads ahead, see vecCnt().
+ *
+ * @return true if all digits were valid.
+ */
+static bool decodeVecs(const char* hex, const uint32_t cnt, uint8_t* bin) {
+    const int8_t* k = &DEC_K[0][0];
+    uint32_t valid;
+    asm (
+        "SSAI 4" "\n" // for EE.VSL.32
+
+        "EE.VLD.128.IP q5, %[k], 16" "\n"
+        "EE.VLD.128.IP q6, %[k], 16" "\n"
+        "EE.VLD.128.IP q7, %[k], 16" "\n"
+
+        "EE.ZERO.ACCX" "\n"
+        "EE.LD.128.USAR.IP q0, %[hex], 16" "\n"
+
+        "LOOPNEZ %[cnt], .Lend_%=" "\n"
+            "EE.VLD.128.IP q1, %[hex], 16" "\n"
+            "EE.SRC.Q.QUP q2, q0, q1" "\n" // q2 := next 16 digits
+
+            "EE.VLD.128.IP q3, %[k], 16" "\n"
+            "EE.VCMP.GT.S8 q3, q2, q3" "\n"
+            "EE.VLD.128.IP q4, %[k], 16" "\n"
+            "EE.VCMP.LT.S8 q4, q2, q4" "\n"
+            "EE.ANDQ q3, q3, q4" "\n" // q3[n] := '0' <= q2[n] <= '9'
+            "EE.VMULAS.S8.ACCX q3, q3" "\n" // Count them
+
+            "EE.ORQ q1, q2, q5" "\n" // To lower case
+            "EE.VLD.128.IP q3, %[k], 16" "\n"
+            "EE.VCMP.GT.S8 q3, q1, q3" "\n"
+            "EE.VLD.128.IP q4, %[k], -(3*16)" "\n"
+            "EE.VCMP.LT.S8 q4, q1, q4" "\n"
+            "EE.ANDQ q3, q3, q4" "\n" // q3[n] := 'a' <= q1[n] <= 'f'
+            "EE.VMULAS.S8.ACCX q3, q3" "\n" // Count them
+
+            "EE.ANDQ q3, q3, q7" "\n"
+            "EE.ANDQ q2, q2, q6" "\n"
+            "EE.VADDS.S8 q2, q2, q3" "\n" // q2 := nibbles
+
+            "EE.VUNZIP.8 q2, q1" "\n" // q2[0...7] := high nibbles, q1[0...7] := low nibbles
+            "EE.VSL.32 q2, q2" "\n"
+            "EE.ORQ q2, q2, q1" "\n"
+            "EE.VST.L.64.IP q2, %[bin], 8" "\n"
+        ".Lend_%=:" "\n"
+
+        "RUR.ACCX_0 %[valid]" "\n"
+        : [hex] "+r" (hex), [bin] "+r" (bin), [k] "+r" (k), [valid] "=r" (valid),
+          "=m" (*(uint8_t(*)[cnt*8])bin)
+        : [cnt] "r" (cnt),
+          "m" (DEC_K), "m" (*(const char(*)[cnt*16])hex)
+    );
+    // Every valid digit was counted exactly once.
+    return valid == cnt * 16;
+}
+
+void hex_encode(const uint8_t* bin, uint32_t len, char* hex) {
+    alignas(16) char buf[CHUNK*2];
+    uint32_t vecs = vecCnt(bin,len);
+    while(vecs != 0) {
+        const uint32_t cnt = min(vecs,CHUNK/16);
+        if(((uintptr_t)hex & 0xf) == 0) {
+            encodeVecs(bin,cnt,hex);
+        } else {
+            encodeVecs(bin,cnt,buf);
+            cpy_mem(buf,hex,cnt*32);
+        }
+        bin += cnt*16;
+        hex += cnt*32;
+        len -= cnt*16;
+        vecs -= cnt;
+    }
+    hex_encode_scalar(bin,len,hex);
+}
+
+uint32_t hex_decode(const char* hex, const uint32_t len, uint8_t* bin) {
+    alignas(16) uint8_t buf[CHUNK];
+    uint32_t done = 0;
+    uint32_t vecs = vecCnt(hex,len*2);
+    while(vecs != 0) {
+        const uint32_t cnt = min(vecs,CHUNK/8);
+        if(((uintptr_t)bin & 0x7) == 0) {
+            if(!decodeVecs(hex,cnt,bin)) [[unlikely]] {
+                break;
+            }
+        } else {
+            if(!decodeVecs(hex,cnt,buf)) [[unlikely]] {
+                break;
+            }
+            cpy_mem(buf,bin,cnt*8);
+        }
+        hex += cnt*16;
+        bin += cnt*8;
+        done += cnt*8;
+        vecs -= cnt;
+    }
+    // The rest, or the chunk with the invalid digit to find out where it is.
+    return done + hex_decode_scalar(hex,len - done,bin);
+}
+
+#endif // CONFIG_SIMD_UTILS_HEX_PIE
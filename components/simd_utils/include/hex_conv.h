@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include <sdkconfig.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Writes the \p len bytes at \p bin as \c 2*len lower-case hex digits
+ * to \p hex. No terminating \c '\0' is written.
+ */
+void hex_encode_scalar(const uint8_t* bin, uint32_t len, char* hex);
+
+/**
+ * @brief Decodes the \c 2*len hex digits (upper or lower case) at \p hex into
+ * \p len bytes at \p bin.
+ *
+ * @return the number of bytes decoded before the first pair which contains
+ * something other than a hex digit; \p len if there is none. The bytes in
+ * \p bin from there on are unspecified.
+ */
+uint32_t hex_decode_scalar(const char* hex, uint32_t len, uint8_t* bin);
+
+#if CONFIG_SIMD_UTILS_HEX_PIE
+
+/**
+ * @brief Same as hex_encode_scalar(), 16 bytes at a time.
+ */
+void hex_encode(const uint8_t* bin, uint32_t len, char* hex);
+
+/**
+ * @brief Same as hex_decode_scalar(), 16 digits at a time.
+ */
+uint32_t hex_decode(const char* hex, uint32_t len, uint8_t* bin);
+
+#else
+
+static inline void hex_encode(const uint8_t* bin, const uint32_t len, char* hex) {
+    hex_encode_scalar(bin,len,hex);
+}
+
+static inline uint32_t hex_decode(const char* hex, const uint32_t len, uint8_t* bin) {
+    return hex_decode_scalar(hex,len,bin);
+}
+
+#endif // !CONFIG_SIMD_UTILS_HEX_PIE
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,23 +1,67 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdalign.h>
 #include <sdkconfig.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define MEM_PREFIX_MAX_LEN 32
+
+/**
+ * @brief A literal for mem_matchPrefixes(), zero-padded to 32 bytes.
+ * Use MEM_PREFIX() or MEM_PREFIX_STR() to initialize; C++ also wants room
+ * for the literal's '\0' in \c str, so 31 characters at most there.
+ */
+typedef struct mem_prefix {
+    alignas(16) char str[MEM_PREFIX_MAX_LEN];
+    uint32_t len; // Number of bytes of str to compare, 0...MEM_PREFIX_MAX_LEN
+} mem_prefix_t;
+
+/** Matches any string which starts with \p lit. */
+#define MEM_PREFIX(lit) { .str = lit, .len = sizeof(lit) - 1 }
+/** Includes the terminating '\0', i.e. only matches the string \p lit itself. */
+#define MEM_PREFIX_STR(lit) { .str = lit, .len = sizeof(lit) }
+
 #if CONFIG_IDF_TARGET_ESP32S3
 void* mem_find_u8(const void* mem, uint32_t maxLen, const uint8_t value);
 char* mem_findStrEnd(const char* str, uint32_t maxLen);
 char* mem_findLineEnd(const char* str, uint32_t maxLen);
 
+/**
+ * @brief Finds the first byte in \p mem which is one of the \p setLen bytes
+ * in \p set.
+ *
+ * @return pointer to the byte found, or <tt>mem + maxLen</tt>.
+ */
+void* mem_findAnyOf(const void* mem, uint32_t maxLen, const uint8_t* set, uint32_t setLen);
+
+/**
+ * @brief Finds the first occurrence of the \p needleLen bytes at \p needle in
+ * \p mem, like memmem().
+ *
+ * @return pointer to the start of the match, or <tt>mem + maxLen</tt>.
+ */
+void* mem_findMem(const void* mem, uint32_t maxLen, const void* needle, uint32_t needleLen);
+
+/**
+ * @brief Checks which of the \p cnt literals in \p prefixes the \p len bytes at
+ * \p str start with. A literal longer than \p len never matches.
+ * All literals are compared in full, so the time taken does not depend on
+ * the contents of \p str.
+ *
+ * @return bit \c i set iff <tt>prefixes[i]</tt> matches. \p cnt must be <= 32.
+ */
+uint32_t mem_matchPrefixes(const mem_prefix_t* prefixes, uint32_t cnt, const char* str, uint32_t len);
+
 #else
 
 #include <string.h>
 
 static inline void* mem_find_u8(const void* mem, const uint32_t maxLen, const uint8_t value) {
-    void* const p = memchr(mem,value,maxLen);
+    void* const p = (void*)memchr(mem,value,maxLen);
     if(p != NULL) {
         return p;
     } else {
@@ -50,8 +94,72 @@ static inline char* mem_findLineEnd(const char* str, uint32_t maxLen) {
     return (char*)ptr;
 }
 
+static inline void* mem_findAnyOf(const void* mem, const uint32_t maxLen, const uint8_t* set, const uint32_t setLen) {
+    uint32_t bits[256/32] = {0};
+    for(uint32_t i = 0; i < setLen; ++i) {
+        bits[set[i] / 32] |= 1u << (set[i] % 32);
+    }
+    const uint8_t* ptr = (const uint8_t*)mem;
+    const uint8_t* const end = ptr+maxLen;
+    while(ptr < end && (bits[*ptr / 32] & (1u << (*ptr % 32))) == 0) {
+        ++ptr;
+    }
+    return (void*)ptr;
+}
+
+static inline void* mem_findMem(const void* mem, const uint32_t maxLen, const void* needle, const uint32_t needleLen) {
+    const uint8_t* ptr = (const uint8_t*)mem;
+    const uint8_t* const end = ptr+maxLen;
+    if(needleLen == 0) {
+        return (void*)ptr;
+    }
+    while((uint32_t)(end-ptr) >= needleLen) {
+        ptr = (const uint8_t*)memchr(ptr,*(const uint8_t*)needle,(end-ptr) - needleLen + 1);
+        if(ptr == NULL) {
+            break;
+        }
+        if(memcmp(ptr,needle,needleLen) == 0) {
+            return (void*)ptr;
+        }
+        ++ptr;
+    }
+    return (void*)end;
+}
+
+static inline uint32_t mem_matchPrefixes(const mem_prefix_t* prefixes, const uint32_t cnt, const char* str, const uint32_t len) {
+    uint32_t result = 0;
+    for(uint32_t i = 0; i < cnt; ++i) {
+        const uint32_t n = prefixes[i].len;
+        uint32_t diff = (n > len);
+        for(uint32_t j = 0; j < n && j < len; ++j) {
+            diff |= (uint8_t)(str[j] ^ prefixes[i].str[j]);
+        }
+        result |= (uint32_t)(diff == 0) << i;
+    }
+    return result;
+}
+
 #endif // !ESP32-S3
 
+/**
+ * @brief Finds the first '"', '\\' or '\0' in \p str, i.e. the end of the plain
+ * part of a JSON string.
+ *
+ * @return pointer to the character found, or <tt>str + maxLen</tt>.
+ */
+#if CONFIG_SIMD_UTILS_JSON_SCAN_PIE
+char* mem_findQuoteOrEscape(const char* str, uint32_t maxLen);
+#else
+static inline char* mem_findQuoteOrEscape(const char* str, const uint32_t maxLen) {
+    const char* ptr = str;
+    const char* const end = str+maxLen;
+    while(ptr < end && *ptr != '"' && *ptr != '\\' && *ptr != '\0') {
+        ++ptr;
+    }
+    return (char*)ptr;
+}
+#endif // !CONFIG_SIMD_UTILS_JSON_SCAN_PIE
+
 static inline uint32_t mem_strlen(const char* const str) {
     return (const char*)mem_findStrEnd(str,0x7ffffffful) - str;
 }
@@ -1,6 +1,8 @@
 #include "mem_search.h"
 
 // #include <type_traits>
+#include <cstddef>
+#include <cstring>
 #include <limits>
 
 static constexpr bool known(const bool cond) noexcept {
@@ -121,6 +123,7 @@ void* mem_find_u8_(const void* mem, uint32_t maxLen, const uint8_t value) {
                         "ADDI %[mem], %[mem], 1" "\n"
                         "BEQZ %[tmp], .Lfound_%=" "\n"
                     ".Lend_%=:" "\n"
+                    "ADDI %[mem], %[mem], 1" "\n" // No match: point to the end
                     ".Lfound_%=:" "\n"
                     "ADDI %[mem], %[mem], -1" "\n"
                     : [mem] "+r" (mem), [tmp] "=r" (tmp)
@@ -133,6 +136,7 @@ void* mem_find_u8_(const void* mem, uint32_t maxLen, const uint8_t value) {
                         "ADDI %[mem], %[mem], 1" "\n"
                         "BEQ %[tmp], %[val], .Lfound_%=" "\n"
                     ".Lend_%=:" "\n"
+                    "ADDI %[mem], %[mem], 1" "\n" // No match: point to the end
                     ".Lfound_%=:" "\n"
                     "ADDI %[mem], %[mem], -1" "\n"
                     : [mem] "+r" (mem), [tmp] "=r" (tmp)
@@ -220,6 +224,7 @@ void* mem_find_u8(const void* mem, uint32_t maxLen, const uint8_t value) {
                         "ADDI %[mem], %[mem], 1" "\n"
                         "BEQZ %[tmp], .Lfound_%=" "\n"
                     ".Lend_%=:" "\n"
+                    "ADDI %[mem], %[mem], 1" "\n" // No match: point to the end
                     ".Lfound_%=:" "\n"
                     : [mem] "+r" (mem), [tmp] "=r" (tmp)
                     : [cnt] "r" (pd(end,mem))
@@ -232,6 +237,7 @@ void* mem_find_u8(const void* mem, uint32_t maxLen, const uint8_t value) {
                         "ADDI %[mem], %[mem], 1" "\n"
                         "BEQ %[tmp], %[val], .Lfound_%=" "\n"
                     ".Lend_%=:" "\n"
+                    "ADDI %[mem], %[mem], 1" "\n" // No match: point to the end
                     ".Lfound_%=:" "\n"
                     : [mem] "+r" (mem), [tmp] "=r" (tmp)
                     : [cnt] "r" (pd(end,mem)),
@@ -320,6 +326,7 @@ char* mem_findInStr(const char* str, const char ch, uint32_t maxLen) {
                     "BEQ %[tmp], %[ch], .Lfound_%=" "\n"
                     "BEQZ %[tmp], .Lfound_%=" "\n"
                 ".Lend_%=:" "\n"
+                "ADDI %[str], %[str], 1" "\n" // No match: point to the end
                 ".Lfound_%=:" "\n"
                 : [str] "+r" (str), [tmp] "=r" (tmp)
                 : [ch] "r" (ch), [cnt] "r" (pd(end,str))
@@ -329,8 +336,278 @@ char* mem_findInStr(const char* str, const char ch, uint32_t maxLen) {
     return const_cast<char*>(str);
 }
 
+#if CONFIG_SIMD_UTILS_JSON_SCAN_PIE
+char* mem_findQuoteOrEscape(const char* str, uint32_t maxLen) {
+    static const char QUOTE = '"';
+    static const char ESC = '\\';
+    if(maxLen > 0) {
+        maxLen = min(maxLen, headroom(str));
+        uintptr_t end = (uintptr_t)str + maxLen;
+
+        if(maxLen > 8) {
+            uint32_t dummy;
+
+            // q5 = POS_VEC
+            // q7[n] = '"'
+            // q3[n] = '\\'
+            // q6[n] = 0x00
+            asm (
+                "LD.QR q5, %[pos], 0" "\n"
+                : "=m" (dummy)
+                : [pos] "r" (&POS_VEC), "m" (POS_VEC)
+            );
+
+            asm (
+                "EE.VLDBC.8 q7, %[quote]" "\n"
+                "EE.VLDBC.8 q3, %[esc]" "\n"
+                "EE.ZERO.Q q6"
+                : "+m" (dummy)
+                : [quote] "r" (&QUOTE), "m" (QUOTE),
+                  [esc] "r" (&ESC), "m" (ESC),
+                  "m" (*(const char(*)[maxLen])str)
+            );
+
+            uint32_t tmp = ((maxLen+15)/16);
+            asm (
+                "EE.LD.128.USAR.IP q0, %[str], 16" "\n"
+                "EE.VLD.128.IP q1, %[str], 16" "\n"
+
+                "EE.ZERO.ACCX" "\n"
+
+                "EE.SRC.Q.QUP q2, q0, q1" "\n"
+
+                "LOOPNEZ %[tmp], .Lend_%=" "\n"
+
+                    "EE.VCMP.EQ.S8 q4, q2, q6" "\n" // q4[n] := q2[n] == 0
+                    "EE.VMULAS.S8.ACCX.LD.IP q1, %[str], 16, q4, q5" "\n" // MAC
+
+                    "EE.VCMP.EQ.S8 q4, q2, q7" "\n" // q4[n] := q2[n] == '"'
+                    "EE.VMULAS.S8.ACCX q4, q5" "\n" // MAC
+
+                    "EE.VCMP.EQ.S8 q4, q2, q3" "\n" // q4[n] := q2[n] == '\\'
+                    "EE.VMULAS.S8.ACCX q4, q5" "\n" // MAC
+
+                    "EE.SRC.Q.QUP q2, q0, q1" "\n"
+
+                    "RUR.ACCX_0 %[tmp]" "\n" // Extract result
+                    "BNEZ %[tmp], .Lfound_%=" "\n" // Exit loop if any matches.
+
+                ".Lend_%=:"
+                    "ADDI %[str], %[end], (3*16)" "\n" // Make str point to end
+                ".Lfound_%=:"
+                    "ADDI %[str], %[str], -(3*16)" "\n"
+                : [str] "+r" (str),
+                  [tmp] "+r" (tmp),
+                  "+m" (dummy)
+                : [end] "r" (end)
+            );
+
+            // A character matches at most one of the three, so the 2nd half
+            // still contributes at most 8*(-1).
+            if((int32_t)tmp < 0) {
+                incptr(str,8);
+                str = min(str,end);
+            }
+
+        }
+
+        if(pd(end,str) > 0) {
+            uint32_t tmp;
+            asm (
+                "ADDI %[str], %[str], -1" "\n"
+                "LOOPNEZ %[cnt], .Lend_%=" "\n"
+                    "L8UI %[tmp], %[str], 1" "\n"
+                    "ADDI %[str], %[str], 1" "\n"
+                    "BEQ %[tmp], %[quote], .Lfound_%=" "\n"
+                    "BEQ %[tmp], %[esc], .Lfound_%=" "\n"
+                    "BEQZ %[tmp], .Lfound_%=" "\n"
+                ".Lend_%=:" "\n"
+                "ADDI %[str], %[str], 1" "\n" // No match: point to the end
+                ".Lfound_%=:" "\n"
+                : [str] "+r" (str), [tmp] "=r" (tmp)
+                : [quote] "r" (QUOTE), [esc] "r" (ESC), [cnt] "r" (pd(end,str))
+            );
+        }
+    }
+    return const_cast<char*>(str);
+}
+#endif // CONFIG_SIMD_UTILS_JSON_SCAN_PIE
+
 char* mem_findLineEnd(const char* str, unsigned maxLen) {
     return mem_findInStr(str, '\n', maxLen);
 }
 
+void* mem_findAnyOf(const void* mem, uint32_t maxLen, const uint8_t* set, const uint32_t setLen) {
+    if(setLen <= 1) {
+        if(setLen == 0) {
+            return static_cast<uint8_t*>(const_cast<void*>(mem)) + min(maxLen, headroom(mem));
+        }
+        return mem_find_u8(mem,maxLen,set[0]);
+    }
+    if(maxLen > 0) [[likely]] {
+        maxLen = min(maxLen, headroom(mem));
+        uintptr_t end = (uintptr_t)mem + maxLen;
+
+        if(maxLen > 8) {
+            uint32_t dummy;
+
+            // q5 = POS_VEC
+            asm (
+                "LD.QR q5, %[pos], 0" "\n"
+                : "=m" (dummy)
+                : [pos] "r" (&POS_VEC), "m" (POS_VEC)
+            );
+
+            uint32_t cnt = ((maxLen+15)/16);
+            uint32_t tmp;
+            const uint8_t* s;
+            // Can't nest zero-overhead loops, so the outer one branches.
+            asm (
+                "EE.LD.128.USAR.IP q0, %[mem], 16" "\n"
+                "EE.VLD.128.IP q1, %[mem], 16" "\n"
+
+                "EE.ZERO.ACCX" "\n"
+
+                ".Lvec_%=:" "\n"
+                    "EE.SRC.Q.QUP q2, q0, q1" "\n"
+                    "EE.VLD.128.IP q1, %[mem], 16" "\n"
+
+                    "EE.ZERO.Q q6" "\n"
+                    "MOV %[s], %[set]" "\n"
+                    "LOOPNEZ %[n], .Lset_%=" "\n"
+                        "EE.VLDBC.8 q3, %[s]" "\n"
+                        "ADDI %[s], %[s], 1" "\n"
+                        "EE.VCMP.EQ.S8 q4, q2, q3" "\n" // q4[n] := q2[n] == *s
+                        "EE.ORQ q6, q6, q4" "\n"
+                    ".Lset_%=:" "\n"
+
+                    "EE.VMULAS.S8.ACCX q6, q5" "\n" // MAC
+                    "RUR.ACCX_0 %[tmp]" "\n" // Extract result
+                    "BNEZ %[tmp], .Lfound_%=" "\n" // Exit loop if any matches.
+
+                    "ADDI %[cnt], %[cnt], -1" "\n"
+                    "BNEZ %[cnt], .Lvec_%=" "\n"
+
+                    "ADDI %[mem], %[end], (3*16)" "\n" // Make mem point to end
+                ".Lfound_%=:" "\n"
+                    "ADDI %[mem], %[mem], -(3*16)" "\n"
+                : [mem] "+r" (mem),
+                  [cnt] "+r" (cnt),
+                  [tmp] "=&r" (tmp),
+                  [s] "=&r" (s),
+                  "+m" (dummy)
+                : [set] "r" (set), [n] "r" (setLen), [end] "r" (end),
+                  "m" (*(const uint8_t(*)[maxLen])mem),
+                  "m" (*(const uint8_t(*)[setLen])set)
+            );
+
+            // q6 holds each match only once, so the 2nd half still
+            // contributes at most 8*(-1).
+            if((int32_t)tmp < 0) {
+                incptr(mem,8);
+                mem = min(mem,end);
+            }
+        }
+
+        const uint8_t* ptr = static_cast<const uint8_t*>(mem);
+        while(pd(end,ptr) > 0 && std::memchr(set,*ptr,setLen) == nullptr) {
+            ++ptr;
+        }
+        mem = ptr;
+    }
+    return const_cast<void*>(mem);
+}
+
+void* mem_findMem(const void* mem, uint32_t maxLen, const void* needle, const uint32_t needleLen) {
+    maxLen = min(maxLen, headroom(mem));
+    const uint8_t* ptr = static_cast<const uint8_t*>(mem);
+    const uint8_t* const end = ptr + maxLen;
+    if(needleLen == 0) {
+        return const_cast<uint8_t*>(ptr);
+    }
+    const uint8_t* const ndl = static_cast<const uint8_t*>(needle);
+    // Let the vector search skip ahead to the candidates, i.e. where the first
+    // byte matches and the whole needle still fits in, and compare the rest there.
+    while((uint32_t)pd(end,ptr) >= needleLen) {
+        ptr = static_cast<const uint8_t*>(mem_find_u8(ptr, pd(end,ptr) - needleLen + 1, ndl[0]));
+        if((uint32_t)pd(end,ptr) < needleLen) {
+            break;
+        }
+        if(std::memcmp(ptr+1, ndl+1, needleLen-1) == 0) {
+            return const_cast<uint8_t*>(ptr);
+        }
+        ++ptr;
+    }
+    return const_cast<uint8_t*>(end);
+}
+
+/* Byte positions of the two halves of a mem_prefix_t::str, compared against
+   the literal's length to mask out the bytes after it. */
+alignas(16)
+static const int8_t PREFIX_IDX[2][16] = {
+    {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+    { 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31 }
+};
+
+static_assert(MEM_PREFIX_MAX_LEN == 2*16);
+static_assert(offsetof(mem_prefix_t,len) == MEM_PREFIX_MAX_LEN);
+static_assert(sizeof(mem_prefix_t) == 3*16);
+
+uint32_t mem_matchPrefixes(const mem_prefix_t* prefixes, const uint32_t cnt, const char* str, const uint32_t len) {
+    // Zero-padded copy so we can always load 32 aligned bytes.
+    alignas(16) char buf[MEM_PREFIX_MAX_LEN] {};
+    std::memcpy(buf, str, min(len, MEM_PREFIX_MAX_LEN));
+
+    const char* b = buf;
+    const int8_t* idx = &PREFIX_IDX[0][0];
+    const mem_prefix_t* p = prefixes;
+    uint32_t result = 0;
+    uint32_t bit = 1;
+    uint32_t tmp;
+    uint32_t match;
+    asm (
+        "EE.VLD.128.IP q0, %[b], 16" "\n"
+        "EE.VLD.128.IP q1, %[b], 0" "\n"
+        "EE.VLD.128.IP q6, %[idx], 16" "\n"
+        "EE.VLD.128.IP q7, %[idx], 0" "\n"
+
+        "LOOPNEZ %[cnt], .Lend_%=" "\n"
+            "EE.VLD.128.IP q2, %[p], 16" "\n"
+            "EE.VLD.128.IP q3, %[p], 16" "\n"
+            "EE.VLDBC.8 q4, %[p]" "\n" // q4[n] := len (< 256)
+            "ADDI %[p], %[p], 16" "\n"
+
+            "EE.VCMP.LT.S8 q5, q6, q4" "\n" // q5[n] := n < len
+            "EE.VCMP.LT.S8 q4, q7, q4" "\n" // q4[n] := 16+n < len
+
+            "EE.XORQ q2, q2, q0" "\n"
+            "EE.XORQ q3, q3, q1" "\n"
+            "EE.ANDQ q2, q2, q5" "\n"
+            "EE.ANDQ q3, q3, q4" "\n" // Differences within len
+
+            "EE.ZERO.ACCX" "\n"
+            "EE.VMULAS.S8.ACCX q2, q2" "\n" // Sum of squares, 0 iff equal
+            "EE.VMULAS.S8.ACCX q3, q3" "\n"
+            "RUR.ACCX_0 %[tmp]" "\n"
+
+            "MOVI %[match], 0" "\n"
+            "MOVEQZ %[match], %[bit], %[tmp]" "\n"
+            "OR %[result], %[result], %[match]" "\n"
+            "SLLI %[bit], %[bit], 1" "\n"
+        ".Lend_%=:" "\n"
+        : [b] "+r" (b), [idx] "+r" (idx), [p] "+r" (p),
+          [result] "+r" (result), [bit] "+r" (bit),
+          [tmp] "=&r" (tmp), [match] "=&r" (match)
+        : [cnt] "r" (cnt),
+          "m" (buf), "m" (PREFIX_IDX),
+          "m" (*(const mem_prefix_t(*)[cnt])prefixes)
+    );
+
+    // The padding in buf would match a literal's '\0's beyond len.
+    for(uint32_t i = 0; i < cnt; ++i) {
+        result &= ~((uint32_t)(prefixes[i].len > len) << i);
+    }
+    return result;
+}
+
 #endif // ESP32-S3
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "esp_timer.h"
+#include "hex_conv.h"
+
+#define MAX_LEN 300
+
+static uint8_t bin[MAX_LEN + 16];
+static char hex[2 * MAX_LEN + 16];
+static char hexRef[2 * MAX_LEN + 16];
+static uint8_t out[MAX_LEN + 16];
+static uint8_t outRef[MAX_LEN + 16];
+
+static void fill(void) {
+    for (unsigned i = 0; i < sizeof(bin); ++i) {
+        bin[i] = (uint8_t)(i * 167 + 13);
+    }
+}
+
+TEST_CASE("Hex encoding of known values", "[simd]")
+{
+    static const uint8_t data[] = {0x00, 0x01, 0x9a, 0xbf, 0xff};
+    char str[sizeof(data) * 2 + 1] = {0};
+    hex_encode(data, sizeof(data), str);
+    TEST_ASSERT_EQUAL_STRING("00019abfff", str);
+}
+
+TEST_CASE("Hex decoding of known values", "[simd]")
+{
+    static const uint8_t expected[] = {0x00, 0x01, 0x9a, 0xbf, 0xff, 0xab};
+    uint8_t data[sizeof(expected)];
+    TEST_ASSERT_EQUAL_UINT32(sizeof(expected), hex_decode("00019AbFffaB", sizeof(expected), data));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, data, sizeof(expected));
+}
+
+TEST_CASE("Hex encoding is the same as the scalar version", "[simd]")
+{
+    fill();
+    for (unsigned len = 0; len <= MAX_LEN; len += (len < 80) ? 1 : 37) {
+        for (unsigned srcOff = 0; srcOff < 16; srcOff += 3) {
+            for (unsigned dstOff = 0; dstOff < 16; ++dstOff) {
+                memset(hex, '#', sizeof(hex));
+                memset(hexRef, '#', sizeof(hexRef));
+                hex_encode(bin + srcOff, len, hex + dstOff);
+                hex_encode_scalar(bin + srcOff, len, hexRef + dstOff);
+                // Also checks that nothing after the output is overwritten.
+                TEST_ASSERT_EQUAL_MEMORY(hexRef, hex, sizeof(hex));
+            }
+        }
+    }
+}
+
+TEST_CASE("Hex decoding is the same as the scalar version", "[simd]")
+{
+    fill();
+    hex_encode_scalar(bin, MAX_LEN, hex);
+    // Mix in some upper case
+    for (unsigned i = 0; i < 2 * MAX_LEN; i += 3) {
+        if (hex[i] >= 'a') {
+            hex[i] -= 'a' - 'A';
+        }
+    }
+    for (unsigned len = 0; len <= MAX_LEN - 16; len += (len < 80) ? 1 : 37) {
+        for (unsigned srcOff = 0; srcOff < 16; srcOff += 3) {
+            for (unsigned dstOff = 0; dstOff < 16; ++dstOff) {
+                memset(out, 0x5a, sizeof(out));
+                memset(outRef, 0x5a, sizeof(outRef));
+                TEST_ASSERT_EQUAL_UINT32(len, hex_decode(hex + 2 * srcOff, len, out + dstOff));
+                TEST_ASSERT_EQUAL_UINT32(len, hex_decode_scalar(hex + 2 * srcOff, len, outRef + dstOff));
+                TEST_ASSERT_EQUAL_HEX8_ARRAY(outRef, out, sizeof(out));
+                if (len != 0) {
+                    TEST_ASSERT_EQUAL_HEX8_ARRAY(bin + srcOff, out + dstOff, len);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Hex decoding stops at the first non-hex character", "[simd]")
+{
+    static const unsigned LEN = 40;
+    fill();
+    for (unsigned ch = 0; ch < 256; ++ch) {
+        const bool isHex = (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F');
+        for (unsigned pos = 0; pos < 2 * LEN; pos += 7) {
+            hex_encode_scalar(bin, LEN, hex);
+            hex[pos] = (char)ch;
+            const uint32_t expected = isHex ? LEN : pos / 2;
+            TEST_ASSERT_EQUAL_UINT32(expected, hex_decode_scalar(hex, LEN, outRef));
+            TEST_ASSERT_EQUAL_UINT32(expected, hex_decode(hex, LEN, out));
+            if (expected != 0) {
+                TEST_ASSERT_EQUAL_HEX8_ARRAY(outRef, out, expected);
+            }
+        }
+    }
+}
+
+static void bench(const char* const name,
+        void (*enc)(const uint8_t*, uint32_t, char*),
+        uint32_t (*dec)(const char*, uint32_t, uint8_t*)) {
+    static const unsigned ROUNDS = 1000;
+    // About the size of a coinbase transaction, at an odd offset like most of them.
+    static const uint32_t LEN = 256;
+
+    fill();
+    int64_t start = esp_timer_get_time();
+    for (unsigned i = 0; i < ROUNDS; ++i) {
+        enc(bin + 1, LEN, hex + 1);
+    }
+    const int64_t encUs = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (unsigned i = 0; i < ROUNDS; ++i) {
+        dec(hex + 1, LEN, out + 1);
+    }
+    const int64_t decUs = esp_timer_get_time() - start;
+
+    printf("%s: encode %.2f us, decode %.2f us for %u bytes\n",
+        name, (double)encUs / ROUNDS, (double)decUs / ROUNDS, (unsigned)LEN);
+}
+
+TEST_CASE("Hex conversion throughput", "[simd][bench]")
+{
+    bench("Scalar", hex_encode_scalar, hex_decode_scalar);
+    bench("SIMD", hex_encode, hex_decode);
+}
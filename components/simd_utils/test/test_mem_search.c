@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "esp_timer.h"
+#include "mem_search.h"
+
+static const char* find_ref(const char* str, const uint32_t maxLen) {
+    for (uint32_t i = 0; i < maxLen; ++i) {
+        if (str[i] == '"' || str[i] == '\\' || str[i] == '\0') {
+            return str + i;
+        }
+    }
+    return str + maxLen;
+}
+
+TEST_CASE("Find the next quote, backslash or end of string", "[simd]")
+{
+    static const char SPECIAL[] = {'"', '\\', '\0'};
+    static char buf[128 + 16];
+
+    for (unsigned off = 0; off < 16; ++off) {
+        for (unsigned len = 0; len <= 64; ++len) {
+            char* const str = buf + off;
+            // Nothing to find
+            memset(buf, 'a', sizeof(buf));
+            TEST_ASSERT_EQUAL_PTR(str + len, mem_findQuoteOrEscape(str, len));
+
+            for (unsigned s = 0; s < sizeof(SPECIAL); ++s) {
+                for (unsigned pos = 0; pos < len + 2; ++pos) {
+                    memset(buf, 'a', sizeof(buf));
+                    str[pos] = SPECIAL[s];
+                    // A 2nd match later on must not matter.
+                    str[pos + 9] = '"';
+                    TEST_ASSERT_EQUAL_PTR(find_ref(str, len), mem_findQuoteOrEscape(str, len));
+                }
+            }
+        }
+    }
+}
+
+static const char* find_line_end_ref(const char* str, const uint32_t maxLen) {
+    for (uint32_t i = 0; i < maxLen; ++i) {
+        if (str[i] == '\n' || str[i] == '\0') {
+            return str + i;
+        }
+    }
+    return str + maxLen;
+}
+
+TEST_CASE("Find a byte or the end of a line", "[simd]")
+{
+    static char buf[128 + 16];
+
+    for (unsigned off = 0; off < 16; ++off) {
+        for (unsigned len = 0; len <= 64; ++len) {
+            char* const str = buf + off;
+            // Nothing to find, also not right behind the end.
+            memset(buf, 'a', sizeof(buf));
+            TEST_ASSERT_EQUAL_PTR(str + len, mem_find_u8(str, len, 'x'));
+            TEST_ASSERT_EQUAL_PTR(str + len, mem_find_u8(str, len, 0));
+            TEST_ASSERT_EQUAL_PTR(str + len, mem_findLineEnd(str, len));
+
+            for (unsigned pos = 0; pos < len + 2; ++pos) {
+                memset(buf, 'a', sizeof(buf));
+                str[pos] = 'x';
+                str[pos + 9] = 'x';
+                TEST_ASSERT_EQUAL_PTR(str + (pos < len ? pos : len), mem_find_u8(str, len, 'x'));
+
+                memset(buf, 'a', sizeof(buf));
+                str[pos] = (pos & 1) ? '\n' : '\0';
+                str[pos + 9] = '\n';
+                TEST_ASSERT_EQUAL_PTR(find_line_end_ref(str, len), mem_findLineEnd(str, len));
+            }
+        }
+    }
+}
+
+static const uint8_t* find_any_ref(const uint8_t* mem, const uint32_t maxLen, const uint8_t* set, const uint32_t setLen) {
+    for (uint32_t i = 0; i < maxLen; ++i) {
+        for (uint32_t j = 0; j < setLen; ++j) {
+            if (mem[i] == set[j]) {
+                return mem + i;
+            }
+        }
+    }
+    return mem + maxLen;
+}
+
+static const uint8_t* find_mem_ref(const uint8_t* mem, const uint32_t maxLen, const uint8_t* needle, const uint32_t needleLen) {
+    for (uint32_t i = 0; i + needleLen <= maxLen; ++i) {
+        if (memcmp(mem + i, needle, needleLen) == 0) {
+            return mem + i;
+        }
+    }
+    return mem + maxLen;
+}
+
+TEST_CASE("Find any of a set of bytes", "[simd]")
+{
+    static const uint8_t SET[] = {',', ']', '}', 0x80, 0xff};
+    static uint8_t buf[128 + 16];
+
+    for (unsigned setLen = 0; setLen <= sizeof(SET); ++setLen) {
+        for (unsigned off = 0; off < 16; ++off) {
+            for (unsigned len = 0; len <= 64; ++len) {
+                uint8_t* const mem = buf + off;
+                memset(buf, 'a', sizeof(buf));
+                TEST_ASSERT_EQUAL_PTR(mem + len, mem_findAnyOf(mem, len, SET, setLen));
+
+                for (unsigned s = 0; s < sizeof(SET); ++s) {
+                    for (unsigned pos = 0; pos < len + 2; ++pos) {
+                        memset(buf, 'a', sizeof(buf));
+                        mem[pos] = SET[s];
+                        mem[pos + 3] = SET[sizeof(SET) - 1 - s];
+                        TEST_ASSERT_EQUAL_PTR(find_any_ref(mem, len, SET, setLen), mem_findAnyOf(mem, len, SET, setLen));
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Find a byte sequence", "[simd]")
+{
+    static const char NEEDLE[] = "mining.notify";
+    static uint8_t buf[128 + 32];
+
+    for (unsigned needleLen = 0; needleLen < sizeof(NEEDLE); needleLen += (needleLen < 3) ? 1 : 5) {
+        for (unsigned off = 0; off < 16; ++off) {
+            for (unsigned len = 0; len <= 80; ++len) {
+                uint8_t* const mem = buf + off;
+                // Lots of partial matches
+                for (unsigned i = 0; i < sizeof(buf); ++i) {
+                    buf[i] = (i % 5 < 2) ? NEEDLE[i % 5] : 'x';
+                }
+                TEST_ASSERT_EQUAL_PTR(find_mem_ref(mem, len, (const uint8_t*)NEEDLE, needleLen),
+                    mem_findMem(mem, len, NEEDLE, needleLen));
+
+                for (unsigned pos = 0; pos < len + 2; pos += 3) {
+                    memcpy(mem + pos, NEEDLE, needleLen);
+                    TEST_ASSERT_EQUAL_PTR(find_mem_ref(mem, len, (const uint8_t*)NEEDLE, needleLen),
+                        mem_findMem(mem, len, NEEDLE, needleLen));
+                }
+
+                // All but the first byte match, right where the last candidate would be.
+                if (needleLen > 1 && len >= needleLen) {
+                    memset(buf, 'x', sizeof(buf));
+                    memcpy(mem + len - needleLen + 1, NEEDLE + 1, needleLen - 1);
+                    TEST_ASSERT_EQUAL_PTR(mem + len, mem_findMem(mem, len, NEEDLE, needleLen));
+                }
+            }
+        }
+    }
+}
+
+static const mem_prefix_t METHODS[] = {
+    MEM_PREFIX_STR("mining.notify"),
+    MEM_PREFIX_STR("mining.set_difficulty"),
+    MEM_PREFIX("mining."),
+    MEM_PREFIX("client."),
+    MEM_PREFIX(""),
+    MEM_PREFIX("0123456789abcdef0123456789abcdef"),
+};
+static const uint32_t N_METHODS = sizeof(METHODS) / sizeof(METHODS[0]);
+
+static uint32_t match_ref(const char* str, const uint32_t len) {
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < N_METHODS; ++i) {
+        if (METHODS[i].len <= len && memcmp(str, METHODS[i].str, METHODS[i].len) == 0) {
+            result |= 1u << i;
+        }
+    }
+    return result;
+}
+
+TEST_CASE("Match method prefixes", "[simd]")
+{
+    static const char* const STRS[] = {
+        "mining.notify", "mining.notifyx", "mining.notif", "mining.set_difficulty",
+        "mining.set_version_mask", "client.reconnect", "client", "", "Mining.notify",
+        "0123456789abcdef0123456789abcdef", "0123456789abcdef0123456789abcdeF",
+        "0123456789abcdef0123456789abcdef and more",
+    };
+    static char buf[64 + 16];
+
+    TEST_ASSERT_EQUAL_HEX32(0x15, mem_matchPrefixes(METHODS, N_METHODS, "mining.notify", sizeof("mining.notify")));
+    // Without the '\0' it is only a prefix.
+    TEST_ASSERT_EQUAL_HEX32(0x14, mem_matchPrefixes(METHODS, N_METHODS, "mining.notify", strlen("mining.notify")));
+    TEST_ASSERT_EQUAL_HEX32(0x18, mem_matchPrefixes(METHODS, N_METHODS, "client.reconnect", sizeof("client.reconnect")));
+    TEST_ASSERT_EQUAL_HEX32(0x00, mem_matchPrefixes(METHODS, 0, "mining.notify", sizeof("mining.notify")));
+
+    for (unsigned s = 0; s < sizeof(STRS) / sizeof(STRS[0]); ++s) {
+        for (unsigned off = 0; off < 16; ++off) {
+            char* const str = buf + off;
+            memset(buf, 'x', sizeof(buf));
+            strcpy(str, STRS[s]);
+            for (unsigned len = 0; len <= strlen(STRS[s]) + 1; ++len) {
+                TEST_ASSERT_EQUAL_HEX32(match_ref(str, len), mem_matchPrefixes(METHODS, N_METHODS, str, len));
+            }
+        }
+    }
+}
+
+TEST_CASE("Multi-byte search throughput", "[simd][bench]")
+{
+    static const unsigned ROUNDS = 1000;
+    static const uint8_t SET[] = {',', ']', '}'};
+    // A notify's merkle branches: hex digits and quotes only, until the very end.
+    static char buf[1024 + 1];
+    for (unsigned i = 0; i < sizeof(buf) - 1; ++i) {
+        buf[i] = (i % 67 == 0) ? '"' : "0123456789abcdef"[i % 16];
+    }
+    buf[sizeof(buf) - 8] = ']';
+    memcpy(buf + sizeof(buf) - 7, "\"ntime", 6);
+    buf[sizeof(buf) - 1] = '\0';
+    const uint32_t len = sizeof(buf) - 1;
+    const void* volatile found;
+    int64_t start;
+
+    start = esp_timer_get_time();
+    for (unsigned i = 0; i < ROUNDS; ++i) {
+        found = strpbrk(buf + 1, ",]}");
+    }
+    const int64_t pbrkUs = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (unsigned i = 0; i < ROUNDS; ++i) {
+        found = mem_findAnyOf(buf + 1, len - 1, SET, sizeof(SET));
+    }
+    const int64_t anyUs = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (unsigned i = 0; i < ROUNDS; ++i) {
+        found = strstr(buf + 1, "\"ntime");
+    }
+    const int64_t strstrUs = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (unsigned i = 0; i < ROUNDS; ++i) {
+        found = mem_findMem(buf + 1, len - 1, "\"ntime", 6);
+    }
+    const int64_t memUs = esp_timer_get_time() - start;
+    (void)found;
+
+    printf("Any of 3 in %u bytes: strpbrk %.2f us, mem_findAnyOf %.2f us\n",
+        (unsigned)len, (double)pbrkUs / ROUNDS, (double)anyUs / ROUNDS);
+    printf("Substring in %u bytes: strstr %.2f us, mem_findMem %.2f us\n",
+        (unsigned)len, (double)strstrUs / ROUNDS, (double)memUs / ROUNDS);
+
+    static const char* const NAMES[] = {
+        "mining.notify", "mining.set_difficulty", "client.reconnect", "mining.unknown_method"
+    };
+    static const unsigned N_NAMES = sizeof(NAMES) / sizeof(NAMES[0]);
+    volatile uint32_t result = 0;
+
+    start = esp_timer_get_time();
+    for (unsigned i = 0; i < ROUNDS; ++i) {
+        const char* const name = NAMES[i % N_NAMES];
+        for (uint32_t m = 0; m < N_METHODS; ++m) {
+            if (strcmp(name, METHODS[m].str) == 0) {
+                result = m;
+                break;
+            }
+        }
+    }
+    const int64_t cmpUs = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (unsigned i = 0; i < ROUNDS; ++i) {
+        const char* const name = NAMES[i % N_NAMES];
+        result = mem_matchPrefixes(METHODS, N_METHODS, name, mem_strlen(name) + 1);
+    }
+    const int64_t matchUs = esp_timer_get_time() - start;
+    (void)result;
+
+    printf("Method of %u: strcmp chain %.2f us, mem_matchPrefixes %.2f us\n",
+        (unsigned)N_METHODS, (double)cmpUs / ROUNDS, (double)matchUs / ROUNDS);
+}
@@ -0,0 +1,94 @@
+#ifndef STATS_HISTORY_H_
+#define STATS_HISTORY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct StatisticsData * StatisticsNodePtr;
+typedef struct StatisticsData * StatisticsNextNodePtr;
+
+struct StatisticsData
+{
+    // Members orderered by size (alignment) to minimize padding.
+    // int64_t timestamp;
+    uint32_t timestamp; // Resolution: 100ms
+    // double hashrate;
+    uint32_t hashrate_MHz;
+    StatisticsNextNodePtr next;
+    uint32_t freeHeap;
+    float chipTemperature;
+    float vrTemperature;
+    float power;
+    float voltage;
+    float current;
+    int16_t coreVoltageActual;
+    uint16_t fanSpeed;
+    uint16_t fanRPM;
+    int8_t wifiRSSI;
+};
+
+/**
+ * @brief Creates the lock protecting the history. Must be called before any
+ * other statisticData*() function.
+ */
+void statisticDataInit(void);
+
+/**
+ * @brief Appends a copy of \p data to the history, recycling the oldest
+ * sample once the history is full. Timestamps must not decrease.
+ *
+ * @return the node holding the copy, or NULL if no memory is available
+ */
+StatisticsNodePtr addStatisticData(StatisticsNodePtr data);
+
+/**
+ * @brief Drops all samples and frees the memory of the history.
+ */
+void statisticDataRelease(void);
+
+bool statisticDataNext(StatisticsNodePtr prevNode, StatisticsNodePtr dataOut);
+
+/**
+ * @brief Copies the most recent sample to \p dataOut.
+ *
+ * @return false if there is no data
+ */
+bool statisticDataLatest(StatisticsNodePtr dataOut);
+
+/**
+ * @brief Read position for statisticDataGetBatch().
+ * Initialize via statistics_cursor_init().
+ */
+typedef struct StatisticsCursor {
+    const struct StatisticsData* node; // Hint only, re-validated on every use.
+    uint32_t timestamp; // Timestamp of the last sample returned (or the 'since' value)
+} StatisticsCursor_t;
+
+static inline void statistics_cursor_init(StatisticsCursor_t* const cursor, const uint32_t since) {
+    cursor->node = NULL;
+    cursor->timestamp = since;
+}
+
+/**
+ * @brief Copies up to \p maxCnt samples newer than \p cursor into \p dataOut,
+ * taking the lock only once per batch, and advances the cursor.
+ * A cursor at or past the newest sample yields nothing; it is up to the
+ * caller to tell a stale cursor from another time base (e.g. after a reboot).
+ *
+ * @param cursor position to continue from
+ * @param dataOut destination for the samples
+ * @param maxCnt capacity of \p dataOut
+ * @return number of samples copied; \c 0 when there is no more data.
+ */
+size_t statisticDataGetBatch(StatisticsCursor_t* const cursor, struct StatisticsData* const dataOut, const size_t maxCnt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STATS_HISTORY_H_
@@ -0,0 +1,247 @@
+#include <stdint.h>
+#include <stdalign.h>
+#include <stdlib.h>
+#include "esp_log.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "stats_history.h"
+
+#include <esp_heap_caps.h>
+#include "sdkconfig.h"
+
+static const char* const TAG = "stats_history";
+
+static StatisticsNodePtr statisticsDataStart = NULL;
+static StatisticsNodePtr statisticsDataEnd = NULL;
+
+static StaticSemaphore_t muxMem;
+static SemaphoreHandle_t mux;
+
+static void inline stats_lock(void) {
+    if(mux) {
+        xSemaphoreTake(mux,portMAX_DELAY);
+    }
+}
+
+static void inline stats_unlock(void) {
+    if(mux) {
+        xSemaphoreGive(mux);
+    }
+}
+
+
+static const uint16_t maxDataCount = 720;
+static uint16_t currentDataCount;
+
+static struct StatisticsData* statsBuffer;
+
+#if CONFIG_STATISTICS_BUFFER_PREFER_INTERNAL
+static const uint32_t STATS_BUFFER_CAPS = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+#else
+static const uint32_t STATS_BUFFER_CAPS = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+#endif
+
+static inline struct StatisticsData* allocStatNodes(const size_t cnt) {
+    static const size_t ALIGN = alignof(struct StatisticsData);
+    static const size_t SIZE = sizeof(struct StatisticsData);
+    if(cnt == 0) {
+        return NULL;
+    } else {
+        struct StatisticsData* mem;
+        mem = heap_caps_aligned_alloc(ALIGN, cnt * SIZE, STATS_BUFFER_CAPS);
+        if(!mem) {
+            // ESP_LOGI(TAG, "Allocating stats buffer in internal RAM.");
+            mem = heap_caps_aligned_alloc(ALIGN, cnt * SIZE, MALLOC_CAP_8BIT);
+        }
+        return mem;
+    }
+}
+
+static inline struct StatisticsData* getStatsBuffer(void) {
+
+    struct StatisticsData* mem = statsBuffer;
+
+    {
+        if(!mem) {
+            currentDataCount = 0;
+            mem = allocStatNodes(maxDataCount);
+            statsBuffer = mem;
+            if(!mem) {
+                ESP_LOGE(TAG, "Failed to allocate stats buffer.");
+            }
+        }
+    }
+
+    return mem;
+}
+
+void statisticDataInit(void) {
+    if(mux == NULL) {
+        mux = xSemaphoreCreateMutexStatic(&muxMem);
+    }
+}
+
+void statisticDataRelease(void) {
+    stats_lock();
+    {
+        if(statsBuffer != NULL) {
+            ESP_LOGI(TAG, "Releasing stats buffer.");
+            statisticsDataStart = NULL;
+            statisticsDataEnd = NULL;
+            currentDataCount = 0;
+
+            free(statsBuffer);
+            statsBuffer = NULL;
+        }
+    }
+    stats_unlock();
+}
+
+static inline StatisticsNodePtr getNewNode(void) {
+    if(currentDataCount < maxDataCount) {
+        struct StatisticsData* const buffer = getStatsBuffer();
+        if(buffer) {
+            StatisticsNodePtr node = buffer + currentDataCount;
+            currentDataCount += 1;
+            return node;
+        }
+    }
+    return NULL;
+}
+
+StatisticsNodePtr addStatisticData(StatisticsNodePtr data)
+{
+    if (NULL == data) {
+        return NULL;
+    }
+
+    StatisticsNodePtr newData = NULL;
+
+    stats_lock();
+    {
+        if(currentDataCount < maxDataCount) {
+            newData = getNewNode();
+            if(newData != NULL && statisticsDataStart == NULL) {
+                statisticsDataStart = newData;
+                statisticsDataEnd = newData;
+            }
+        } else {
+            newData = statisticsDataStart;
+            statisticsDataStart = statisticsDataStart->next;
+        }
+        if(newData != NULL) {
+            statisticsDataEnd->next = newData;
+            statisticsDataEnd = newData;
+            *newData = *data;
+            newData->next = NULL;
+        }
+    }
+    stats_unlock();
+
+    return newData;
+}
+
+bool statisticDataNext(StatisticsNodePtr prevNode, StatisticsNodePtr dataOut)
+{
+
+    if(NULL == dataOut) {
+        return false;
+    }
+
+    StatisticsNodePtr data = NULL;
+
+    stats_lock();
+    {
+
+        if(NULL == prevNode) {
+            data = statisticsDataStart;
+        } else {
+            data = prevNode->next;
+        }
+
+        if(NULL != data) {
+            *dataOut = *data;
+        }
+
+    }
+    stats_unlock();
+
+    return NULL != data;
+}
+
+bool statisticDataLatest(StatisticsNodePtr dataOut)
+{
+    if(NULL == dataOut) {
+        return false;
+    }
+
+    bool found = false;
+
+    stats_lock();
+    {
+        if(NULL != statisticsDataEnd) {
+            *dataOut = *statisticsDataEnd;
+            dataOut->next = NULL;
+            found = true;
+        }
+    }
+    stats_unlock();
+
+    return found;
+}
+
+static inline bool isLiveNode(const struct StatisticsData* const node) {
+    return node != NULL &&
+           statsBuffer != NULL &&
+           node >= statsBuffer &&
+           node < (statsBuffer + currentDataCount);
+}
+
+size_t statisticDataGetBatch(StatisticsCursor_t* const cursor, struct StatisticsData* const dataOut, const size_t maxCnt) {
+
+    if(cursor == NULL || dataOut == NULL || maxCnt == 0) {
+        return 0;
+    }
+
+    size_t cnt = 0;
+
+    stats_lock();
+    {
+        const uint32_t since = cursor->timestamp;
+        const struct StatisticsData* data;
+
+        if(isLiveNode(cursor->node) && cursor->node->timestamp == since) {
+            // Node was not recycled since the last batch; continue right after it.
+            data = cursor->node->next;
+        } else {
+            data = statisticsDataStart;
+            if(data != NULL && statisticsDataEnd->timestamp <= since) {
+                // Nothing newer; don't walk the whole list to find out.
+                data = NULL;
+            } else {
+                while(data != NULL && data->timestamp <= since) {
+                    data = data->next;
+                }
+            }
+        }
+
+        const struct StatisticsData* last = NULL;
+        while(data != NULL && cnt < maxCnt) {
+            dataOut[cnt] = *data;
+            dataOut[cnt].next = NULL;
+            ++cnt;
+            last = data;
+            data = data->next;
+        }
+
+        if(last != NULL) {
+            cursor->node = last;
+            cursor->timestamp = last->timestamp;
+        }
+    }
+    stats_unlock();
+
+    return cnt;
+}
@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "esp_timer.h"
+#include "stats_history.h"
+
+// Capacity of the history.
+#define HISTORY_CNT 720
+#define BATCH_CNT 16
+
+static struct StatisticsData batch[BATCH_CNT];
+
+// Sample n has timestamp 10*(n+1).
+static uint32_t ts(const uint32_t n) {
+    return 10 * (n + 1);
+}
+
+static void fill(const uint32_t first, const uint32_t cnt) {
+    for (uint32_t n = first; n < first + cnt; ++n) {
+        struct StatisticsData data = {
+            .timestamp = ts(n),
+            .hashrate_MHz = n,
+        };
+        TEST_ASSERT_NOT_NULL(addStatisticData(&data));
+    }
+}
+
+static void reset(void) {
+    statisticDataInit();
+    statisticDataRelease();
+}
+
+/**
+ * @brief Reads everything after \p cursor and checks that it is exactly the
+ * samples \p first ... <tt>first+cnt-1</tt>.
+ */
+static void expectSamples(StatisticsCursor_t* const cursor, const uint32_t first, const uint32_t cnt) {
+    uint32_t n = first;
+    size_t got;
+    while ((got = statisticDataGetBatch(cursor, batch, BATCH_CNT)) != 0) {
+        TEST_ASSERT_TRUE(got <= BATCH_CNT);
+        for (size_t i = 0; i < got; ++i) {
+            TEST_ASSERT_EQUAL_UINT32(ts(n), batch[i].timestamp);
+            TEST_ASSERT_EQUAL_UINT32(n, batch[i].hashrate_MHz);
+            TEST_ASSERT_NULL(batch[i].next);
+            ++n;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(first + cnt, n);
+}
+
+TEST_CASE("Stats batches of an empty history", "[stats]")
+{
+    reset();
+    StatisticsCursor_t cursor;
+    statistics_cursor_init(&cursor, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, statisticDataGetBatch(&cursor, batch, BATCH_CNT));
+    TEST_ASSERT_EQUAL_UINT32(0, cursor.timestamp);
+}
+
+TEST_CASE("Stats batches from a timestamp", "[stats]")
+{
+    reset();
+    fill(0, 100);
+
+    StatisticsCursor_t cursor;
+
+    statistics_cursor_init(&cursor, 0);
+    expectSamples(&cursor, 0, 100);
+    TEST_ASSERT_EQUAL_UINT32(ts(99), cursor.timestamp);
+
+    // Between two samples and right on one
+    statistics_cursor_init(&cursor, ts(41) + 5);
+    expectSamples(&cursor, 42, 58);
+    statistics_cursor_init(&cursor, ts(41));
+    expectSamples(&cursor, 42, 58);
+
+    // At and past the newest sample, e.g. a client polling with the last
+    // currentTimestamp: nothing, and the cursor stays where it is.
+    statistics_cursor_init(&cursor, ts(99));
+    TEST_ASSERT_EQUAL_UINT32(0, statisticDataGetBatch(&cursor, batch, BATCH_CNT));
+    statistics_cursor_init(&cursor, ts(99) + 1000);
+    TEST_ASSERT_EQUAL_UINT32(0, statisticDataGetBatch(&cursor, batch, BATCH_CNT));
+    TEST_ASSERT_EQUAL_UINT32(ts(99) + 1000, cursor.timestamp);
+    // ... until there is a newer one.
+    fill(100, 1);
+    statistics_cursor_init(&cursor, ts(99));
+    expectSamples(&cursor, 100, 1);
+}
+
+TEST_CASE("Stats cursor continues with new samples", "[stats]")
+{
+    reset();
+    fill(0, 10);
+
+    StatisticsCursor_t cursor;
+    statistics_cursor_init(&cursor, 0);
+    expectSamples(&cursor, 0, 10);
+
+    fill(10, 3);
+    expectSamples(&cursor, 10, 3);
+    TEST_ASSERT_EQUAL_UINT32(0, statisticDataGetBatch(&cursor, batch, BATCH_CNT));
+}
+
+TEST_CASE("Stats cursor after the history wrapped around", "[stats]")
+{
+    reset();
+    fill(0, HISTORY_CNT + 50);
+
+    StatisticsCursor_t cursor;
+
+    // Older than the oldest sample left
+    statistics_cursor_init(&cursor, ts(10));
+    expectSamples(&cursor, 50, HISTORY_CNT);
+
+    // Stop half way; the node the cursor points to gets recycled.
+    statistics_cursor_init(&cursor, 0);
+    TEST_ASSERT_EQUAL_UINT32(BATCH_CNT, statisticDataGetBatch(&cursor, batch, BATCH_CNT));
+    TEST_ASSERT_EQUAL_UINT32(ts(50 + BATCH_CNT - 1), cursor.timestamp);
+    fill(HISTORY_CNT + 50, 100);
+    // Samples 66...149 were dropped meanwhile; no duplicates, no others missing.
+    expectSamples(&cursor, 150, HISTORY_CNT);
+
+    // Continuing from the newest sample
+    statistics_cursor_init(&cursor, 0);
+    expectSamples(&cursor, 150, HISTORY_CNT);
+    fill(HISTORY_CNT + 150, 1);
+    expectSamples(&cursor, HISTORY_CNT + 150, 1);
+}
+
+TEST_CASE("Stats batches after release", "[stats]")
+{
+    reset();
+    fill(0, 20);
+
+    StatisticsCursor_t cursor;
+    statistics_cursor_init(&cursor, 0);
+    TEST_ASSERT_EQUAL_UINT32(BATCH_CNT, statisticDataGetBatch(&cursor, batch, BATCH_CNT));
+
+    statisticDataRelease();
+    TEST_ASSERT_EQUAL_UINT32(0, statisticDataGetBatch(&cursor, batch, BATCH_CNT));
+
+    fill(20, 5);
+    expectSamples(&cursor, 20, 5);
+    reset();
+}
+
+TEST_CASE("Stats history read throughput", "[stats][bench]")
+{
+    static const unsigned ROUNDS = 20;
+    reset();
+    fill(0, HISTORY_CNT);
+
+    int64_t start = esp_timer_get_time();
+    for (unsigned i = 0; i < ROUNDS; ++i) {
+        // One lock per sample, like walking the list with statisticDataNext().
+        StatisticsCursor_t cursor;
+        statistics_cursor_init(&cursor, 0);
+        while (statisticDataGetBatch(&cursor, batch, 1) != 0) {
+        }
+    }
+    const int64_t singleUs = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (unsigned i = 0; i < ROUNDS; ++i) {
+        StatisticsCursor_t cursor;
+        statistics_cursor_init(&cursor, 0);
+        while (statisticDataGetBatch(&cursor, batch, BATCH_CNT) != 0) {
+        }
+    }
+    const int64_t batchUs = esp_timer_get_time() - start;
+
+    printf("%u samples: one by one %.1f us, batches of %u %.1f us\n",
+        HISTORY_CNT, (double)singleUs / ROUNDS, BATCH_CNT, (double)batchUs / ROUNDS);
+    reset();
+}
@@ -4,17 +4,41 @@
 #include <esp_heap_caps.h>
 #include <esp_log.h>
 #include "mempool_alloc_fn.hpp"
+#include "sdkconfig.h"
 
 static constexpr const char* TAG = "bmjobpool";
 
+// Chunks take one of the pool's MemPoolBase::MAX_SEGS (128) segments each,
+// so the pool holds at most 128 * 4 = 512 jobs.
 static constexpr uint32_t GROW_CNT = 4;
 
-using pool_t = mempool::GrowingMemPool<bm_job,GROW_CNT,mempool::alloc::PREFER_PSRAM>;
+// Trimming never goes below this
+static constexpr uint32_t MIN_SIZE = 8;
 
-static pool_t pool {};
+// Per-core cache, see mempool::Magazines
+#if CONFIG_MEMPOOL_MAGAZINES
+static constexpr uint32_t MAG_SIZE = 8;
+#else
+static constexpr uint32_t MAG_SIZE = 0;
+#endif
 
-static std::atomic<uint32_t> takenCnt {};
-static std::atomic<uint32_t> maxInUse {};
+#if CONFIG_MEMPOOL_BM_JOB_PREFER_INTERNAL
+static constexpr auto ALLOC_FN = mempool::alloc::PREFER_INTERNAL;
+#else
+static constexpr auto ALLOC_FN = mempool::alloc::PREFER_PSRAM;
+#endif
+
+using pool_t = mempool::GrowingStatsMemPool<bm_job,GROW_CNT,ALLOC_FN,MAG_SIZE>;
+
+static pool_t pool {"bm_job"};
+
+#if CONFIG_MEMPOOL_TRIM_ENABLED
+static constexpr mempool::TrimPolicy TRIM_POLICY {
+    .minSize = MIN_SIZE,
+    .lowPercent = CONFIG_MEMPOOL_TRIM_LOW_PERCENT,
+    .holdTimeMs = CONFIG_MEMPOOL_TRIM_HOLD_TIME * 1000
+};
+#endif
 
 bool bmjobpool_grow_by(const size_t cnt) {
     return pool.growBy(cnt);
@@ -27,20 +51,13 @@ uint32_t bmjobpool_get_size(void) {
 void bmjobpool_put(bm_job* const obj) {
     if(obj) [[likely]] {
         pool.put(obj);
-        takenCnt.fetch_sub(1,std::memory_order::relaxed);
     }
 }
 
 bm_job* bmjobpool_take() {
     bm_job* h = pool.take();
 
-    if(h != nullptr) [[likely]] {
-        uint32_t tcnt = takenCnt.fetch_add(1,std::memory_order::relaxed) + 1;
-        uint32_t mx = maxInUse.load(std::memory_order::relaxed);
-        while(tcnt > mx && !maxInUse.compare_exchange_strong(mx,tcnt)) {
-
-        }
-    } else {
+    if(h == nullptr) [[unlikely]] {
         ESP_LOGE(TAG, "Failed to allocate!");
     }
     return h;
@@ -48,13 +65,23 @@ bm_job* bmjobpool_take() {
 
 
 uint32_t bmjobpool_getMaxUse() {
-    return maxInUse.load(std::memory_order::relaxed);
+    return pool.getMaxInUseCnt();
 }
 
 void bmjobpool_get_stats(ObjPoolStats_t* const out_stats) {
-    out_stats->allocCnt = pool.getSize();
-    out_stats->inUseCnt = takenCnt.load(std::memory_order::relaxed);
-    out_stats->maxInUseCnt = maxInUse.load(std::memory_order::relaxed);
+    *out_stats = pool.getStats();
+}
+
+uint32_t bmjobpool_trim(const uint32_t nowMs) {
+#if CONFIG_MEMPOOL_TRIM_ENABLED
+    const uint32_t freed = pool.trimIfIdle(TRIM_POLICY, nowMs);
+    if(freed != 0) {
+        ESP_LOGI(TAG, "Trimmed %" PRIu32 " objects, %" PRIu32 " left in %" PRIu32 " chunks.", freed, pool.getSize(), pool.getChunkCnt());
+    }
+    return freed;
+#else
+    return 0;
+#endif
 }
 
 void bmjobpool_log_stats(void) {
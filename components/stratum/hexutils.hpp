@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <string_view>
 #include <span>
+#include "hex_conv.h"
 
 namespace hex {
 
@@ -58,9 +59,12 @@ namespace hex {
     inline std::size_t hex2bin(const std::string_view& hex, uint8_t* const out_bin, const std::size_t maxBytes) {
         const std::size_t byteLen = (maxBytes < (hex.size()/2)) ? maxBytes : (hex.size()/2);
 
-        uint8_t* pout = out_bin;
-        uint8_t* const end = pout + byteLen;
-        const char* hx = hex.data();
+        // Stops at the first pair which isn't hex; the rest is decoded below as before.
+        const std::size_t valid = hex_decode(hex.data(), byteLen, out_bin);
+
+        uint8_t* pout = out_bin + valid;
+        uint8_t* const end = out_bin + byteLen;
+        const char* hx = hex.data() + 2 * valid;
 
         while(pout < end) {
             *pout = hex2u8(hx);
@@ -19,6 +19,14 @@ uint32_t bmjobpool_getMaxUse(void);
 
 void bmjobpool_get_stats(ObjPoolStats_t* const out_stats);
 
+/**
+ * @brief Returns memory to the heap if the pool was hardly used for a while
+ * (see CONFIG_MEMPOOL_TRIM_HOLD_TIME). Call periodically from one task.
+ *
+ * @return the number of objects freed
+ */
+uint32_t bmjobpool_trim(uint32_t nowMs);
+
 void bmjobpool_log_stats(void);
 
 #ifdef __cplusplus
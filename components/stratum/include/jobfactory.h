@@ -12,6 +12,12 @@ void bldwrk( const mining_notify* mn,
 
 void setXn2(const char* xn2);
 void cmpcb(const MemSpan_t cb);
+
+/**
+ * @brief Lets the pool of work objects return memory to the heap after a
+ * while of low usage, see bmjobpool_trim().
+ */
+uint32_t jobfactory_trim(uint32_t nowMs);
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -41,12 +41,12 @@ char *construct_coinbase_tx(const char *coinbase_1, const char *coinbase_2,
                             const char *extranonce, const char *extranonce_2);
 
 MemSpan_t construct_coinbase_tx_bin(
-                    const char* const coinbase_1, const char* const coinbase_2,
+                    const MemSpan_t coinbase_1, const MemSpan_t coinbase_2,
                     const char* const extranonce, const char* const extranonce_2,
                     const MemSpan_t out_cb);
 
 void calculate_merkle_root_hash_bin(const MemSpan_t coinbase_tx,
-     const HashLink_t* merkles, Hash_t* const out_hash);
+     const Hash_t* const merkles, const size_t n_merkles, Hash_t* const out_hash);
 
 void calculate_merkle_root_hash(const char *coinbase_tx, const uint8_t merkle_branches[][32], const int num_merkle_branches, Hash_t* out_hash);
 
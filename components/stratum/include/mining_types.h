@@ -21,12 +21,6 @@ typedef struct Hash Hash_t;
 static_assert(sizeof(Hash_t) == 32);
 
 
-typedef struct HashLink {
-    struct HashLink* next;
-    Hash_t hash;
-} HashLink_t;
-
-
 
 
 typedef struct Nonce {
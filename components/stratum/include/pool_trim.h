@@ -0,0 +1,17 @@
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Starts a low priority task which periodically lets the job and work
+ * pools return memory to the heap (see CONFIG_MEMPOOL_TRIM_ENABLED).
+ */
+esp_err_t pool_trim_init(void);
+
+#ifdef __cplusplus
+}
+#endif
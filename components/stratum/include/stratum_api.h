@@ -41,13 +41,19 @@ typedef enum
 } stratum_method;
 
 
+/**
+ * @brief A parsed mining.notify, with the hex fields decoded.
+ * The struct and everything it points to live in a single heap block, see
+ * STRATUM_V1_free_mining_notify().
+ */
 typedef struct
 {
     char *job_id;
-    char *prev_block_hash;
-    char *coinbase_1;
-    char *coinbase_2;
-    HashLink_t* merkle__branches;
+    Hash_t prev_block_hash; // As sent, i.e. not word-swapped yet
+    MemSpan_t coinbase_1;
+    MemSpan_t coinbase_2;
+    Hash_t* merkle_branches;
+    uint32_t n_merkle_branches;
     uint32_t version;
     uint32_t target;
     uint32_t ntime;
@@ -1,6 +1,7 @@
 #include "jobfactory.h"
 #include "jobfactory.hpp"
 #include "esp_log.h"
+#include "sdkconfig.h"
 #include <cstdio>
 // #include "global_state.h"
 
@@ -197,32 +198,39 @@ static constexpr const char* TAG = "jobfact";
 
 jobfact::Work wrk {};
 
-void work_release_merkles(void) {
-    wrk.release();
+uint32_t jobfactory_trim(const uint32_t nowMs) {
+#if CONFIG_MEMPOOL_TRIM_ENABLED
+    static constexpr mempool::TrimPolicy TRIM_POLICY {
+        .minSize = jobfact::JobFactory::POOL_GROW_CNT,
+        .lowPercent = CONFIG_MEMPOOL_TRIM_LOW_PERCENT,
+        .holdTimeMs = CONFIG_MEMPOOL_TRIM_HOLD_TIME * 1000
+    };
+    return jobfact::JobFactory::workPool.trimIfIdle(TRIM_POLICY, nowMs);
+#else
+    return 0;
+#endif
 }
-void bldwrk( mining_notify* mn,
+void bldwrk( const mining_notify* mn,
     const char* xn1,
     uint32_t xn2len
 ) {
-    wrk.release();
     wrk.reset();
 
     wrk.jobId.fromStr(mn->job_id);
     wrk.setPrevBlockHash(mn->prev_block_hash);
 
-    wrk.setMerkleBranches(mn->merkle__branches);
-    mn->merkle__branches = nullptr;
+    wrk.setMerkleBranches(std::span {mn->merkle_branches, mn->n_merkle_branches});
 
     wrk.target = mn->target;
     wrk.version = mn->version;
     wrk.ntime = mn->ntime;
-    wrk.appendToCb(mn->coinbase_1);
+    wrk.appendToCb(mn->coinbase_1.start_u8, mn->coinbase_1.size);
     // Nonce n {GLOBAL_STATE.extranonce_str};
     // n.fromStr(GLOBAL_STATE.extranonce_str);
     wrk.appendToCb(jobfact::Nonce {xn1});
     // wrk.appendToCb(*xn1);
     wrk.appendXn2Space(xn2len);
-    wrk.appendToCb(mn->coinbase_2);
+    wrk.appendToCb(mn->coinbase_2.start_u8, mn->coinbase_2.size);
 
     ESP_LOGW(TAG, "Wrk built.");
     printf("Coinbase: %" PRIu32 " bytes, xn2 @ %" PRIu16 "-%" PRIu16 "\n",(uint32_t)wrk.coinbase.size(), wrk.coinbase.xn2Pos, (uint16_t)(wrk.coinbase.xn2Pos+wrk.coinbase.xn2Len));
@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <string_view>
@@ -7,13 +8,13 @@
 // #include "coinbase.hpp"
 #include "utils.h"
 #include "hexutils.hpp"
-#include "hashpool.h"
 #include "mem_cpy.h"
 #include "coinbase.h"
 #include "mining.h"
 
 #include "mempool.hpp"
 #include "mempool_alloc_fn.hpp"
+#include "sdkconfig.h"
 
 #include "mining.h"
 
@@ -443,11 +444,78 @@ namespace jobfact {
     static_assert(sizeof(CB_t) == sizeof(struct CB_mem));
 
 
+    /**
+     * @brief The merkle branches of a job, back to back in one array.
+     *
+     * Room for \c MAX_MERKLE_BRANCHES, the limit the notify parsers already
+     * enforce: one branch per level of the merkle tree, so 32 cover 2^32
+     * transactions, more than any block holds (mainnet blocks need about 12).
+     * That is 1 KiB in every Work, pooled ones included.
+     */
+    class Merkles {
+        public:
+            static constexpr std::size_t MAX_CNT = MAX_MERKLE_BRANCHES;
+
+            constexpr Merkles() = default;
+
+            // Only the branches in use are copied, not all of MAX_CNT.
+            constexpr Merkles(const Merkles& other) {
+                set(other.span());
+            }
+
+            constexpr Merkles& operator =(const Merkles& other) {
+                if(this != &other) {
+                    set(other.span());
+                }
+                return *this;
+            }
+
+            constexpr Merkles& reset(void) {
+                cnt = 0;
+                return *this;
+            }
+
+            /**
+             * @brief Appends the branch decoded from \p hex .
+             * @return false if there is no room for another branch
+             */
+            bool add(const std::string_view& hex) {
+                if(cnt >= MAX_CNT) [[unlikely]] {
+                    return false;
+                }
+                hex::hex2bin(hex, hashes[cnt].u8, sizeof(hashes[cnt].u8));
+                cnt += 1;
+                return true;
+            }
+
+            /**
+             * @brief Replaces the branches with \p merkles , of which at most
+             * \c MAX_CNT are used.
+             */
+            constexpr Merkles& set(const std::span<const Hash_t> merkles) {
+                cnt = std::min(merkles.size(), MAX_CNT);
+                std::copy_n(merkles.begin(), cnt, hashes);
+                return *this;
+            }
+
+            constexpr std::span<const Hash_t> span(void) const {
+                return std::span {hashes, cnt};
+            }
+
+            constexpr std::size_t size(void) const {
+                return cnt;
+            }
+
+        private:
+            std::size_t cnt {0};
+            Hash_t hashes[MAX_CNT];
+    };
+
     struct Work {
         uint32_t version {0};
         Hash_t prevBlockHash {};
         Hash_t merkleRoot {};
-        HashLink_t* merkles {nullptr};
+        Merkles merkles {};
         uint32_t target {0};
         uint32_t ntime {0};
         bool merkleValid {false};
@@ -457,13 +525,12 @@ namespace jobfact {
 
         constexpr Work() = default;
         constexpr Work(const Work&) = delete;
-        constexpr Work(Work&& other) {
+        // merkles in the initializer list, so its default initializer does not
+        // zero all MAX_CNT branches first.
+        constexpr Work(Work&& other) : merkles {other.merkles} {
             this->version = other.version;
             this->prevBlockHash = other.prevBlockHash;
 
-            this->merkles = other.merkles;
-            other.merkles = nullptr;
-
             this->target = other.target;
             this->ntime = other.ntime;
             this->jobId = other.jobId;
@@ -476,9 +543,8 @@ namespace jobfact {
 
         }
 
-        Work& setMerkleBranches(HashLink_t* merkles) {
-            this->releaseMerkles();
-            this->merkles = merkles;
+        Work& setMerkleBranches(const std::span<const Hash_t> merkles) {
+            this->merkles.set(merkles);
             this->merkleValid = false;
             return *this;
         }
@@ -523,19 +589,12 @@ namespace jobfact {
 */
         }
 
-
-        ~Work(void) {
-            this->release();
-        }
-
         Work& operator =(Work&& other) {
             if(this != &other) {
                 this->version = other.version;
                 this->prevBlockHash = other.prevBlockHash;
 
-                this->releaseMerkles();
                 this->merkles = other.merkles;
-                other.merkles = nullptr;
 
                 this->target = other.target;
                 this->ntime = other.ntime;
@@ -552,7 +611,7 @@ namespace jobfact {
 
         constexpr Work& reset(void) {
             version = 0;
-            merkles = nullptr;
+            merkles.reset();
             target = 0;
             ntime = 0;
             merkleValid = false;
@@ -563,12 +622,6 @@ namespace jobfact {
             return *this;
         }
 
-        Work& release(void) {
-            releaseMerkles();
-            merkles = nullptr;
-            return *this;
-        }
-
         bool appendToCb(const char* hex) {
             this->merkleValid = false;
             std::size_t cnt = hex::hex2bin(hex, coinbase.tail(), coinbase.space());
@@ -580,6 +633,11 @@ namespace jobfact {
             return hex::hex2bin(hex,prevBlockHash.u8,sizeof(prevBlockHash.u8)) == sizeof(prevBlockHash.u8);
         }
 
+        bool setPrevBlockHash(const Hash_t& hash) {
+            this->prevBlockHash = hash;
+            return true;
+        }
+
         Work& setXn2(const uint64_t xn2) {
             this->coinbase.setXn2(xn2);
             this->merkleValid = false;
@@ -588,10 +646,10 @@ namespace jobfact {
 
 
 
-        // bool appendToCb(const void* data, std::size_t len) {
-        //     const uint8_t* p = (const uint8_t*)data;
-        //     return coinbase.append(std::span {p,len}) == len;
-        // }
+        bool appendToCb(const uint8_t* data, std::size_t len) {
+            this->merkleValid = false;
+            return coinbase.append(std::span {data,len}) == len;
+        }
 
         bool appendToCb(const Nonce_t& nonceVal) {
             this->merkleValid = false;
@@ -629,74 +687,16 @@ namespace jobfact {
         }
 
         void calcMerkleRoot(Hash_t* const out_hash) const {
-            // Hash_t both_merkles[2];
-
-            // static_assert(sizeof(both_merkles) == 64);
-
-            // double_sha256_bin(coinbase.data(), coinbase.size(), &both_merkles[0]);
-
-            // const HashLink_t* hl = merkles;
-            // while(hl != NULL) {
-            //     cpyToHash(hl->hash.u32,&both_merkles[1]);
-            //     double_sha256_bin(both_merkles[0].u8, sizeof(both_merkles), &both_merkles[0]);
-            //     hl = hl->next;
-            // }
-
-            // cpyHashTo(&both_merkles[0],out_hash);
             *out_hash = calcMerkleRoot();
         }
 
         Hash_t calcMerkleRoot(void) const {
-            Hash_t both_merkles[2];
-
-            static_assert(sizeof(both_merkles) == 64);
-
-            double_sha256_bin(coinbase.data(), coinbase.size(), &both_merkles[0]);
-
-            const HashLink_t* hl = merkles;
-            while(hl != NULL) {
-                cpyToHash(hl->hash.u32,&both_merkles[1]);
-                double_sha256_bin(both_merkles[0].u8, sizeof(both_merkles), &both_merkles[0]);
-                hl = hl->next;
-            }
-
-            // cpyHashTo(&both_merkles[0],out_hash);
-            return both_merkles[0];
+            Hash_t root;
+            const std::span<const Hash_t> m = merkles.span();
+            calculate_merkle_root_hash_bin(memspan_get(coinbase.data(), coinbase.size()), m.data(), m.size(), &root);
+            return root;
         }
 
-        private:
-            void releaseMerkles(void) const {
-                HashLink_t* hl = merkles;
-                while(hl) {
-                    HashLink_t* const nxt = hl->next;
-                    hashpool_put(hl);
-                    hl = nxt;
-                }
-            }
-
-    };
-
-    struct HashList {
-        private:
-            HashLink_t* first {nullptr};
-            // HashLink_t* last {nullptr};
-            HashLink_t** pnext {&first};
-        public:
-
-        HashList& reset(void) {
-            first = nullptr;
-            pnext = &first;
-            return *this;
-        }
-        HashList& add(HashLink_t* const hl) {
-            *pnext = hl;
-            pnext = &(hl->next);
-            return *this;
-        }
-        HashLink_t* finish(void) const {
-            *pnext = nullptr;
-            return first;
-        }
     };
 
     struct WorkOrder {
@@ -704,21 +704,34 @@ namespace jobfact {
         std::string_view prevBlockHash {};
         std::string_view coinbase1 {};
         std::string_view coinbase2 {};
-        HashLink_t* merkles {};
+        std::span<const Hash_t> merkles {};
         std::string_view versionHex {};
         std::string_view targetHex {};
         std::string_view ntimeHex {};
     };
 
     struct JobFactory {
+        // Chunks take one of the pool's MemPoolBase::MAX_SEGS (128) segments
+        // each, so the pool holds at most 128 * 2 = 256 Works.
         static constexpr unsigned POOL_GROW_CNT = 2;
+#if CONFIG_MEMPOOL_MAGAZINES
+        static constexpr unsigned POOL_MAG_SIZE = 4;
+#else
+        static constexpr unsigned POOL_MAG_SIZE = 0;
+#endif
+#if CONFIG_MEMPOOL_WORK_PREFER_INTERNAL
+        static constexpr auto POOL_ALLOC_FN = mempool::alloc::PREFER_INTERNAL;
+#else
+        static constexpr auto POOL_ALLOC_FN = mempool::alloc::PREFER_PSRAM;
+#endif
         using pool_t = mempool::GrowingStatsMemPool<
                             Work,
                             POOL_GROW_CNT,
-                            mempool::alloc::PREFER_PSRAM
+                            POOL_ALLOC_FN,
+                            POOL_MAG_SIZE
                         >;
                         
-        static inline pool_t workPool {};
+        static inline pool_t workPool {"work"};
 
         Nonce extranonce1 {};
         uint8_t extranonce2Len {0};
@@ -761,7 +774,6 @@ namespace jobfact {
 
         void returnWork(Work* const wrk) {
             if(wrk) {
-                wrk->release();
                 workPool.put(wrk);
             }
         }
@@ -792,7 +804,7 @@ namespace jobfact {
                 out_work.coinbase.appendXn2Space(this->extranonce2Len);
                 out_work.coinbase += order.coinbase2;
 
-                out_work.merkles = order.merkles;
+                out_work.merkles.set(order.merkles);
 
                 out_work.version = hex::hex2u32(order.versionHex);
                 out_work.target = hex::hex2u32(order.targetHex);
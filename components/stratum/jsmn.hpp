@@ -29,6 +29,8 @@
 #include <string_view>
 #include <compare>
 
+#include "mem_search.h"
+
 #ifdef JSMN_STATIC
 	#define JSMN_API static
 #else
@@ -494,8 +496,13 @@ namespace jsmn {
 
 				char ch;
 
-				for (; this->pos < json.size() && (ch = json[this->pos]) != '\0'; this->pos += 1) {
-				// char c = js[parser->pos];
+				for (; this->pos < json.size(); this->pos += 1) {
+				// Skip over everything up to the next '\"', '\\' or '\0' at once;
+				// most strings are long runs of hex.
+				this->pos = mem_findQuoteOrEscape(json.data() + this->pos, json.size() - this->pos) - json.data();
+				if (this->pos >= json.size() || (ch = json[this->pos]) == '\0') {
+					break;
+				}
 
 				/* Quote: end of string */
 				if (ch == '\"') {
@@ -92,7 +92,7 @@ static inline uint32_t min(const uint32_t a, const uint32_t b) {
 }
 
 
-MemSpan_t construct_coinbase_tx_bin(const char* const coinbase_1, const char* const coinbase_2,
+MemSpan_t construct_coinbase_tx_bin(const MemSpan_t coinbase_1, const MemSpan_t coinbase_2,
                             const char* const extranonce, const char* const extranonce_2, const MemSpan_t out_cb) {
     MemSpan_t result;
     memspan_clear(&result);
@@ -101,7 +101,8 @@ MemSpan_t construct_coinbase_tx_bin(const char* const coinbase_1, const char* co
     uint32_t max_out = out_cb.size;
     
     if(max_out > 0) {
-        const uint32_t l = hex2bin(coinbase_1,out,max_out);
+        const uint32_t l = min(coinbase_1.size,max_out);
+        memcpy(out,coinbase_1.start,l);
         max_out -= l;
         out += l;
     } else {
@@ -129,7 +130,8 @@ MemSpan_t construct_coinbase_tx_bin(const char* const coinbase_1, const char* co
     }
 
     if(max_out > 0) {
-        uint32_t l = hex2bin(coinbase_2,out,max_out);
+        const uint32_t l = min(coinbase_2.size,max_out);
+        memcpy(out,coinbase_2.start,l);
         max_out -= l;
         out += l;
     } else {
@@ -149,7 +151,7 @@ MemSpan_t construct_coinbase_tx_bin(const char* const coinbase_1, const char* co
 }
 
 void calculate_merkle_root_hash_bin(const MemSpan_t coinbase_tx,
-     const HashLink_t* merkles, Hash_t* const out_hash) {
+     const Hash_t* const merkles, const size_t n_merkles, Hash_t* const out_hash) {
 
     Hash_t both_merkles[2];
 
@@ -157,11 +159,9 @@ void calculate_merkle_root_hash_bin(const MemSpan_t coinbase_tx,
 
     double_sha256_bin(coinbase_tx.start_u8, coinbase_tx.size, &both_merkles[0]);
 
-    const HashLink_t* hl = merkles;
-    while(hl != NULL) {
-        cpyToHash(hl->hash.u32,&both_merkles[1]);
+    for(size_t i = 0; i < n_merkles; ++i) {
+        cpyToHash(merkles[i].u32,&both_merkles[1]);
         double_sha256_bin(both_merkles[0].u8, sizeof(both_merkles), &both_merkles[0]);
-        hl = hl->next;
     }
 
     cpyHashTo(&both_merkles[0],out_hash);
@@ -192,7 +192,7 @@ void calculate_merkle_root_hash(const char *coinbase_tx, const uint8_t merkle_br
     cpyHashTo(&both_merkles[0],out_hash);
 }
 
-// take a mining_notify struct with ascii hex strings and convert it to a bm_job struct
+// take a mining_notify struct and convert it to a bm_job struct
 void construct_bm_job(mining_notify *params, const Hash_t* const merkle_root, const uint32_t version_mask, const uint32_t difficulty, bool build_midstates, bm_job* const out_job)
 {
     out_job->version = params->version;
@@ -203,7 +203,11 @@ void construct_bm_job(mining_notify *params, const Hash_t* const merkle_root, co
 
     cpyHashTo(merkle_root,out_job->merkle_root);
 
-    swap_endian_words(params->prev_block_hash, out_job->prev_block_hash);
+    // Same as swap_endian_words() on the hex string
+    for(unsigned i = 0; i < 8; ++i) {
+        const uint32_t w = __builtin_bswap32(params->prev_block_hash.u32[i]);
+        memcpy(out_job->prev_block_hash + 4*i, &w, 4);
+    }
 
 // TODO: This is unnecessary when the ASIC doesn't need a midstate:
 
@@ -0,0 +1,45 @@
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#include "pool_trim.h"
+#include "bm_job_pool.h"
+#include "jobfactory.h"
+
+#define TRIM_CHECK_PERIOD_MS 10000
+
+#if CONFIG_MEMPOOL_TRIM_ENABLED
+
+static const char* const TAG = "pool_trim";
+
+/*
+    A task of its own rather than a timer callback: trimming walks all free
+    objects and frees memory, which should neither hold up the timer task nor
+    run above the priority of the tasks using the pools.
+*/
+static void trimTask(void* pvParameters) {
+    while (true) {
+        vTaskDelay(TRIM_CHECK_PERIOD_MS / portTICK_PERIOD_MS);
+        const uint32_t nowMs = esp_timer_get_time() / 1000;
+        bmjobpool_trim(nowMs);
+        jobfactory_trim(nowMs);
+    }
+}
+
+esp_err_t pool_trim_init(void) {
+    if (xTaskCreate(trimTask, "pool trim", 3072, NULL, 1, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create task.");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+#else
+
+esp_err_t pool_trim_init(void) {
+    return ESP_OK;
+}
+
+#endif
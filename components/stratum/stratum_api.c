@@ -7,21 +7,24 @@
 #include "stratum_api.h"
 #include "cJSON.h"
 #include "esp_log.h"
+#include "deflog.h"
 #include "esp_ota_ops.h"
 #include "lwip/sockets.h"
 #include "utils.h"
 #include "esp_timer.h"
+#include "esp_heap_caps.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdalign.h>
+#include <assert.h>
 #include <stdint.h>
 
 #include "mem_cpy.h"
 #include "mem_search.h"
 #include "strbuf.h"
 
-#include "hashpool.h"
 
 #include "json_rpc.h"
 #include "stratum_rpc.h"
@@ -39,7 +42,6 @@
 #define MAX_EXTRANONCE_2_LEN 32
 static const char* const TAG = "stratum_api";
 
-static const uint32_t HASHPOOL_INIT_SIZE = 24;
 
 static const unsigned JSON_RPC_MIN_CHUNK_SIZE = 512;
 static const unsigned JSON_RPC_MAX_MSG_SIZE = 16384-JSON_RPC_MIN_CHUNK_SIZE-1;
@@ -78,6 +80,27 @@ static StrBuf_t strBuf = {};
 // static uint32_t json_rpc_buffer_size = 0;
 static int last_parsed_request_id = -1;
 
+#if CONFIG_STRATUM_METHOD_MATCH_SIMD
+// Exact matches, '\0' included; METHOD_IDS[i] belongs to METHODS[i].
+static const mem_prefix_t METHODS[] = {
+    MEM_PREFIX_STR("mining.notify"),
+    MEM_PREFIX_STR("mining.set_difficulty"),
+    MEM_PREFIX_STR("mining.set_version_mask"),
+    MEM_PREFIX_STR("mining.set_extranonce"),
+    MEM_PREFIX_STR("client.reconnect"),
+};
+
+static const stratum_method METHOD_IDS[] = {
+    MINING_NOTIFY,
+    MINING_SET_DIFFICULTY,
+    MINING_SET_VERSION_MASK,
+    MINING_SET_EXTRANONCE,
+    CLIENT_RECONNECT,
+};
+
+static_assert(sizeof(METHODS) / sizeof(METHODS[0]) == sizeof(METHOD_IDS) / sizeof(METHOD_IDS[0]));
+#endif
+
 static RequestTiming request_timings[MAX_REQUEST_IDS];
 static bool initialized = false;
 
@@ -98,9 +121,6 @@ static RequestTiming* get_request_timing(int request_id) {
 }
 
 void STRATUM_V1_init(void) {
-    if(hashpool_get_size() == 0) {
-        hashpool_grow_by(HASHPOOL_INIT_SIZE);
-    }
 }
 
 void STRATUM_V1_stamp_tx(int request_id)
@@ -328,9 +348,81 @@ const char* STRATUM_V1_receive_jsonrpc_line(int sockfd)
 //     return line;
 // }
 
+static inline size_t align_up(const size_t n, const size_t alignment) {
+    return (n + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * @brief Decodes the params of a mining.notify into one heap block:
+ *
+ *   mining_notify | merkle branches | coinbase_1 | coinbase_2 | job_id
+ *
+ * so a notify costs one malloc() and one free(), and the hashing code finds
+ * all of it in one place.
+ *
+ * @return the new notify, or NULL if out of memory
+ */
+static mining_notify* decode_mining_notify(const cJSON* const params) {
+    const char* const job_id = cJSON_GetArrayItem(params, 0)->valuestring;
+    const char* const prev_block_hash = cJSON_GetArrayItem(params, 1)->valuestring;
+    const char* const coinbase_1 = cJSON_GetArrayItem(params, 2)->valuestring;
+    const char* const coinbase_2 = cJSON_GetArrayItem(params, 3)->valuestring;
+
+    const cJSON* const merkle_branch = cJSON_GetArrayItem(params, 4);
+    const int n_merkle_branches = cJSON_GetArraySize(merkle_branch);
+    if (n_merkle_branches > MAX_MERKLE_BRANCHES) {
+        printf("Too many Merkle branches.\n");
+        abort();
+        __builtin_unreachable();
+    }
+
+    const size_t job_id_size = strlen(job_id) + 1;
+    const size_t coinbase_1_size = strlen(coinbase_1) / 2;
+    const size_t coinbase_2_size = strlen(coinbase_2) / 2;
+
+    const size_t merkles_offs = align_up(sizeof(mining_notify), alignof(Hash_t));
+    const size_t coinbase_1_offs = merkles_offs + n_merkle_branches * sizeof(Hash_t);
+    const size_t coinbase_2_offs = coinbase_1_offs + coinbase_1_size;
+    const size_t job_id_offs = coinbase_2_offs + coinbase_2_size;
+
+    // Internal RAM if possible; the merkle branches are read for every job.
+    uint8_t* block = heap_caps_malloc(job_id_offs + job_id_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (block == NULL) {
+        block = malloc(job_id_offs + job_id_size);
+    }
+    if (block == NULL) {
+        ESP_LOGE(TAG, "Out of memory for mining.notify (%u bytes)", (unsigned)(job_id_offs + job_id_size));
+        return NULL;
+    }
+
+    mining_notify* const new_work = (mining_notify*)block;
+
+    new_work->job_id = (char*)(block + job_id_offs);
+    memcpy(new_work->job_id, job_id, job_id_size);
+
+    hex2bin(prev_block_hash, new_work->prev_block_hash.u8, HASH_SIZE);
+
+    new_work->coinbase_1 = memspan_get(block + coinbase_1_offs, coinbase_1_size);
+    hex2bin(coinbase_1, new_work->coinbase_1.start_u8, coinbase_1_size);
+    new_work->coinbase_2 = memspan_get(block + coinbase_2_offs, coinbase_2_size);
+    hex2bin(coinbase_2, new_work->coinbase_2.start_u8, coinbase_2_size);
+
+    new_work->merkle_branches = (Hash_t*)(block + merkles_offs);
+    new_work->n_merkle_branches = n_merkle_branches;
+    for (int i = 0; i < n_merkle_branches; i++) {
+        hex2bin(cJSON_GetArrayItem(merkle_branch, i)->valuestring, new_work->merkle_branches[i].u8, HASH_SIZE);
+    }
+
+    new_work->version = strtoul(cJSON_GetArrayItem(params, 5)->valuestring, NULL, 16);
+    new_work->target = strtoul(cJSON_GetArrayItem(params, 6)->valuestring, NULL, 16);
+    new_work->ntime = strtoul(cJSON_GetArrayItem(params, 7)->valuestring, NULL, 16);
+
+    return new_work;
+}
+
 void STRATUM_V1_parse(StratumApiV1Message * message, const char * stratum_json)
 {
-    ESP_LOGI(TAG, "rx: %s", stratum_json); // debug incoming stratum messages
+    DEFLOG_I(TAG, "rx: %s", stratum_json); // debug incoming stratum messages
 
 // {
 //     size_t len = mem_findStrEnd(stratum_json, 8192) - stratum_json;
@@ -351,6 +443,15 @@ void STRATUM_V1_parse(StratumApiV1Message * message, const char * stratum_json)
 
     //if there is a method, then use that to decide what to do
     if (method_json != NULL && cJSON_IsString(method_json)) {
+#if CONFIG_STRATUM_METHOD_MATCH_SIMD
+        const char* const method = method_json->valuestring;
+        const uint32_t match = mem_matchPrefixes(METHODS, sizeof(METHODS) / sizeof(METHODS[0]), method, mem_strlen(method) + 1);
+        if (match != 0) {
+            result = METHOD_IDS[__builtin_ctz(match)];
+        } else {
+            ESP_LOGI(TAG, "unhandled method in stratum message: %s", stratum_json);
+        }
+#else
         if (strcmp("mining.notify", method_json->valuestring) == 0) {
             result = MINING_NOTIFY;
         } else if (strcmp("mining.set_difficulty", method_json->valuestring) == 0) {
@@ -364,6 +465,7 @@ void STRATUM_V1_parse(StratumApiV1Message * message, const char * stratum_json)
         } else {
             ESP_LOGI(TAG, "unhandled method in stratum message: %s", stratum_json);
         }
+#endif
 
     //if there is no method, then it is a result
     } else {
@@ -465,45 +567,12 @@ void STRATUM_V1_parse(StratumApiV1Message * message, const char * stratum_json)
 
     if (message->method == MINING_NOTIFY) {
 
-        mining_notify * new_work = malloc(sizeof(mining_notify));
-        // new_work->difficulty = difficulty;
         cJSON * params = cJSON_GetObjectItem(json, "params");
-        new_work->job_id = strdup(cJSON_GetArrayItem(params, 0)->valuestring);
-        new_work->prev_block_hash = strdup(cJSON_GetArrayItem(params, 1)->valuestring);
-        new_work->coinbase_1 = strdup(cJSON_GetArrayItem(params, 2)->valuestring);
-        new_work->coinbase_2 = strdup(cJSON_GetArrayItem(params, 3)->valuestring);
-
-        cJSON * merkle_branch = cJSON_GetArrayItem(params, 4);
-        int n_merkle_branches = cJSON_GetArraySize(merkle_branch);
-        if (n_merkle_branches > MAX_MERKLE_BRANCHES) {
-            printf("Too many Merkle branches.\n");
-            abort();
-            __builtin_unreachable();
+        mining_notify * new_work = decode_mining_notify(params);
+        if (new_work == NULL) {
+            message->method = STRATUM_UNKNOWN;
+            goto done;
         }
-        
-        if(LIKELY(n_merkle_branches > 0)) {
-            HashLink_t* prev = hashpool_take();
-            new_work->merkle__branches = prev;
-            hex2bin(cJSON_GetArrayItem(merkle_branch, 0)->valuestring, prev->hash.u8, HASH_SIZE);
-
-            for (size_t i = 1; i < n_merkle_branches; i++) {
-                HashLink_t* hl = hashpool_take();
-                hex2bin(cJSON_GetArrayItem(merkle_branch, i)->valuestring, hl->hash.u8, HASH_SIZE);
-                prev->next = hl;
-                prev = hl;
-            }
-
-            prev->next = NULL; // end of the chain.
-
-            if(false) {
-                hashpool_log_stats();
-            }
-            
-        }
-
-        new_work->version = strtoul(cJSON_GetArrayItem(params, 5)->valuestring, NULL, 16);
-        new_work->target = strtoul(cJSON_GetArrayItem(params, 6)->valuestring, NULL, 16);
-        new_work->ntime = strtoul(cJSON_GetArrayItem(params, 7)->valuestring, NULL, 16);
 
         message->mining_notification = new_work;
 
@@ -535,23 +604,9 @@ void STRATUM_V1_parse(StratumApiV1Message * message, const char * stratum_json)
     cJSON_Delete(json);
 }
 
-static inline void releaseHashLinks(HashLink_t* hl) {
-    while (hl != NULL) {
-        HashLink_t* const n = hl->next;
-        hashpool_put(hl);
-        hl = n;
-    }
-}
-
 void STRATUM_V1_free_mining_notify(mining_notify * params)
 {
-    free(params->job_id);
-    free(params->prev_block_hash);
-    free(params->coinbase_1);
-    free(params->coinbase_2);
-
-    releaseHashLinks(params->merkle__branches);
-
+    // Everything the notify points to is in the same block, see decode_mining_notify().
     free(params);
 }
 
@@ -679,7 +734,7 @@ static void debug_stratum_tx(const char * msg, const unsigned len)
     if (newline != NULL) {
         *newline = '\0';
     }
-    ESP_LOGI(TAG, "tx: %s", msg);
+    DEFLOG_I(TAG, "tx: %s", msg);
 
     //put it back!
     if (newline != NULL) {
@@ -4,7 +4,6 @@
 #include "json_rpc.hpp"
 #include "jobfactory.hpp"
 #include "hexutils.hpp"
-#include "hashpool.h"
 #include "esp_log.h"
 #include "mem_search.h"
 
@@ -38,12 +37,6 @@ namespace stratum {
         return str;
     }
 
-    static inline HashLink_t* hashFrom(const jsmn::Tkn& tkn) {
-        HashLink_t* const hl = hashpool_take();
-        hex::hex2bin(tkn.str(),hl->hash.u8, sizeof(hl->hash.u8));
-        return hl;
-    }
-
 
     Work* make_work(jsmn::Tkn p, bool& out_cleanJobs) {
         WorkOrder wo {};
@@ -67,16 +60,13 @@ namespace stratum {
         // 5: array of merkle branches
         p.next();
         {
-            HashList list {};
+            static Merkles merkles {};
+            merkles.reset();
             const unsigned end = p.token().end;
             while(p.next() && (p.token().start < end)) {
-                // HashLink_t* const hl = hashpool_take();
-                // hex::hex2bin(p.str(),hl->hash.u8, sizeof(hl->hash.u8));
-                list.add(hashFrom(p));
-                // *pnext = hl; // Link up this one.
-                // pnext = &hl->next; // The next one will be linked via the current one's 'next'.
+                merkles.add(p.str());
             }
-            wo.merkles = list.finish();
+            wo.merkles = merkles.span();
         }
 
         // 6: version
@@ -102,7 +92,6 @@ namespace stratum {
     }
 
     void make_work(const RpcMsg& rpc, const jobfact::Nonce& xn1, std::size_t xn2Len, Work& wrk, bool& out_cleanJobs) {
-        wrk.release();
         wrk.reset();
         jsmn::Tkn p = rpc.getParams(); // points to the params array token
 
@@ -128,16 +117,11 @@ namespace stratum {
         // 5: array of merkle branches
         p.next();
         {
-            HashList list {};
+            wrk.merkles.reset();
             const unsigned end = p.token().end;
             while(p.next() && (p.token().start < end)) {
-                // HashLink_t* const hl = hashpool_take();
-                // hex::hex2bin(p.str(),hl->hash.u8, sizeof(hl->hash.u8));
-                list.add(hashFrom(p));
-                // *pnext = hl; // Link up this one.
-                // pnext = &hl->next; // The next one will be linked via the current one's 'next'.
+                wrk.merkles.add(p.str());
             }
-            wrk.merkles = list.finish();
         }
 
         // 6: version
@@ -192,12 +176,7 @@ namespace stratum {
     static inline void handleMiningNotify(const RpcMsg& rpc, bool& out_clean) {
         Work* const wrk = make_work(rpc.getParams(),out_clean);
 
-        uint32_t mc = 0;
-        const HashLink_t* p = wrk->merkles;
-        while(p) {
-            ++mc;
-            p = p->next;
-        }
+        const uint32_t mc = wrk->merkles.size();
 
         ESP_LOGW(TAG, "Wrk: %" PRIu32 "b cb; %" PRIu32 " merkles, clean: %" PRIu32, wrk->coinbase.size(), mc, (uint32_t)(out_clean));
 
@@ -0,0 +1,84 @@
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include "unity.h"
+#include "esp_timer.h"
+#include "jsmn.hpp"
+
+namespace {
+    std::array<jsmn::jsmntok_t,64> tkns {};
+
+    std::string_view tokStr(const std::string_view json, const jsmn::jsmntok_t& t) {
+        return json.substr(t.start, t.end - t.start);
+    }
+
+    // Synthetic mining.notify in the shapes different kinds of pools send.
+    // Not recorded from live pools, so the bench below only says so much
+    // about the gain on real traffic.
+    std::string notify(const unsigned cb2Outputs, const unsigned merkleCnt) {
+        static constexpr std::string_view OUTPUT {"c817a804000000001976a914536ffa992491508dca0354e52f32a3a7a679a53a88ac"};
+        static constexpr std::string_view BRANCH {"ae23055e00f0f697cc3640124812d96d4fe8bdfa03484c1c638ce5a1c0e9aa81"};
+        std::string s {
+            "{\"id\":null,\"method\":\"mining.notify\",\"params\":[\"662ede\","
+            "\"a80f3e7fd2a6ce7b8c1c2e8d69ae3dd7e6ea5ebf9b4b0b1e0000000000000000\","
+            "\"02000000010000000000000000000000000000000000000000000000000000000000000000ffffffff3503e6a40d0004a6ea72660447d5c32d0c\",\""
+        };
+        s += "0a636b706f6f6c0a2f736c7573682fffffffff";
+        for(unsigned i = 0; i < cb2Outputs; ++i) {
+            s += OUTPUT;
+        }
+        s += "0000000000000000266a24aa21a9ed5caa249f1af9fbf71c986fea8e076ca34ae3514fb2f86400561b28c7b15949bf00000000\",[";
+        for(unsigned i = 0; i < merkleCnt; ++i) {
+            s += (i == 0) ? "\"" : ",\"";
+            s += BRANCH;
+            s += "\"";
+        }
+        s += "],\"20000000\",\"1703255b\",\"6672eaa6\",true]}";
+        return s;
+    }
+}
+
+TEST_CASE("jsmn parses strings with escapes", "[stratum]")
+{
+    static constexpr std::string_view json {R"(["0123456789abcdef0123\"4567","a\\b\u00e4c",""])"};
+    jsmn::Parser parser {tkns};
+    TEST_ASSERT_EQUAL_INT(4, parser.parse(json).result);
+    TEST_ASSERT_TRUE(tokStr(json, tkns[1]) == R"(0123456789abcdef0123\"4567)");
+    TEST_ASSERT_TRUE(tokStr(json, tkns[2]) == R"(a\\b\u00e4c)");
+    TEST_ASSERT_TRUE(tokStr(json, tkns[3]).empty());
+
+    TEST_ASSERT_EQUAL_INT(jsmn::JSMN_ERROR_INVAL, parser.parse(std::string_view {R"(["0123456789abcdef\q"])"}).result);
+    TEST_ASSERT_EQUAL_INT(jsmn::JSMN_ERROR_PART, parser.parse(std::string_view {R"(["0123456789abcdef0123456789)"}).result);
+}
+
+TEST_CASE("jsmn notify parsing throughput", "[stratum][bench]")
+{
+    static constexpr unsigned ROUNDS = 200;
+    static constexpr struct {
+        const char* name;
+        unsigned cb2Outputs;
+        unsigned merkleCnt;
+    } SHAPES[] = {
+        {"Solo pool, empty block", 1, 0},
+        {"Pool, few payouts", 2, 12},
+        {"Pool, many payouts", 24, 13},
+    };
+
+    for(const auto& shape : SHAPES) {
+        const std::string json = notify(shape.cb2Outputs, shape.merkleCnt);
+        jsmn::Parser parser {tkns};
+        int tokens = 0;
+        const int64_t start = esp_timer_get_time();
+        for(unsigned i = 0; i < ROUNDS; ++i) {
+            tokens = parser.parse(json).result;
+        }
+        const int64_t us = esp_timer_get_time() - start;
+        TEST_ASSERT_EQUAL_INT(16 + shape.merkleCnt, tokens);
+        printf("%s (%u bytes): %.0f tokens/s, %.0f kB/s\n",
+            shape.name, (unsigned)json.size(),
+            (double)tokens * ROUNDS * 1e6 / us,
+            (double)json.size() * ROUNDS * 1e3 / us);
+    }
+}
@@ -0,0 +1,84 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "mining.h"
+#include "utils.h"
+
+// Same coinbase and branches as "Validate merkle root calculation" in test_mining.c
+static const char* const COINBASE_TX = "01000000010000000000000000000000000000000000000000000000000000000000000000ffffffff20020862062f503253482f04b8864e5008e969579199999999072f736c7573682f000000000100f2052a010000001976a914d23fcdf86f7e756a64a7a9688ef9903327048ed988ac00000000";
+
+static const char* const MERKLES[12] = {
+    "ae23055e00f0f697cc3640124812d96d4fe8bdfa03484c1c638ce5a1c0e9aa81",
+    "980fb87cb61021dd7afd314fcb0dabd096f3d56a7377f6f320684652e7410a21",
+    "a52e9868343c55ce405be8971ff340f562ae9ab6353f07140d01666180e19b52",
+    "7435bdfa004e603953b2ed39f118803934d9cf17b06d979ceb682f2251bafac2",
+    "2a91f061a22d27cb8f44eea79938fb241ebeb359891aa907f05ffde7ed44e52e",
+    "302401f80eb5e958155135e25200bb8ea181ad2d05e804a531c7314d86403cdc",
+    "318ecb6161eb9b4cfd802bd730e2d36c167ddf102e70aa7b4158e2870dd47392",
+    "1114332a9858e0cf84b2425bb1e59eaabf91dd102d114aa443d57fc1b3beb0c9",
+    "f43f38095c810613ed795a44d9fab02ff25269706f454885db9be05cdf9c06e1",
+    "3e2fc26b27fddc39668b59099cd9635761bb72ed92404204e12bdff08b16fb75",
+    "463c19427286342120039a83218fa87ce45448e246895abac11fff0036076758",
+    "03d287f655813e540ddb9c4e7aeb922478662b0f5d8e9d0cbd564b20146bab76"
+};
+
+static uint8_t coinbase[128];
+
+static MemSpan_t load(Hash_t* const merkles) {
+    for (unsigned i = 0; i < 12; ++i) {
+        hex2bin(MERKLES[i], merkles[i].u8, sizeof(merkles[i].u8));
+    }
+    const size_t len = hex2bin(COINBASE_TX, coinbase, sizeof(coinbase));
+    return memspan_get(coinbase, len);
+}
+
+static void check_root(const MemSpan_t cb, const Hash_t* const merkles, const size_t n, const char* const expected_hex) {
+    uint8_t expected[32];
+    Hash_t root;
+    hex2bin(expected_hex, expected, sizeof(expected));
+    calculate_merkle_root_hash_bin(cb, merkles, n, &root);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, root.u8, sizeof(expected));
+}
+
+TEST_CASE("Merkle root from a branch array", "[mining]")
+{
+    static Hash_t merkles[12];
+    const MemSpan_t cb = load(merkles);
+
+    check_root(cb, merkles, 0, "5e3ed56048b29b7247b1f6eb1bfe762b0550adab59151904e9560871b2462edb");
+    check_root(cb, merkles, 6, "fad3696c410bded07f0a013871eb84eccccbb9221acc8e792bca3a3db2ffdbfd");
+    check_root(cb, merkles, 12, "adbcbc21e20388422198a55957aedfa0e61be0b8f2b87d7c08510bb9f099a893");
+}
+
+static void bench(const char* const name, Hash_t* const merkles) {
+    static const unsigned ROUNDS = 1000;
+    static const size_t BRANCHES[] = {0, 6, 12};
+
+    const MemSpan_t cb = load(merkles);
+    for (unsigned b = 0; b < sizeof(BRANCHES) / sizeof(BRANCHES[0]); ++b) {
+        Hash_t root;
+        const int64_t start = esp_timer_get_time();
+        for (unsigned i = 0; i < ROUNDS; ++i) {
+            calculate_merkle_root_hash_bin(cb, merkles, BRANCHES[b], &root);
+        }
+        const int64_t us = esp_timer_get_time() - start;
+        printf("%s, %2u branches: %.1f us per merkle root\n", name, (unsigned)BRANCHES[b], (double)us / ROUNDS);
+    }
+}
+
+TEST_CASE("Merkle root throughput", "[mining][bench]")
+{
+    Hash_t* merkles = heap_caps_malloc(12 * sizeof(Hash_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(merkles);
+    bench("Internal RAM", merkles);
+    heap_caps_free(merkles);
+
+    merkles = heap_caps_malloc(12 * sizeof(Hash_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (merkles != NULL) {
+        bench("PSRAM", merkles);
+        heap_caps_free(merkles);
+    }
+}
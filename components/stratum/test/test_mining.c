@@ -61,7 +61,7 @@ TEST_CASE("Validate another merkle root calculation", "[mining]")
 TEST_CASE("Validate bm job construction", "[mining]")
 {
     mining_notify notify_message;
-    notify_message.prev_block_hash = "bf44fd3513dc7b837d60e5c628b572b448d204a8000007490000000000000000";
+    hex2bin("bf44fd3513dc7b837d60e5c628b572b448d204a8000007490000000000000000", notify_message.prev_block_hash.u8, 32);
     notify_message.version = 0x20000004;
     notify_message.target = 0x1705dd01;
     notify_message.ntime = 0x64658bd8;
@@ -141,7 +141,7 @@ TEST_CASE("Test extranonce 2 generation", "[mining extranonce2]")
 TEST_CASE("Test nonce diff checking", "[mining test_nonce][not-on-qemu]")
 {
     mining_notify notify_message;
-    notify_message.prev_block_hash = "d02b10fc0d4711eae1a805af50a8a83312a2215e00017f2b0000000000000000";
+    hex2bin("d02b10fc0d4711eae1a805af50a8a83312a2215e00017f2b0000000000000000", notify_message.prev_block_hash.u8, 32);
     notify_message.version = 0x20000004;
     notify_message.target = 0x1705ae3a;
     notify_message.ntime = 0x646ff1a9;
@@ -156,7 +156,7 @@ TEST_CASE("Test nonce diff checking", "[mining test_nonce][not-on-qemu]")
 TEST_CASE("Test nonce diff checking 2", "[mining test_nonce][not-on-qemu]")
 {
     mining_notify notify_message;
-    notify_message.prev_block_hash = "0c859545a3498373a57452fac22eb7113df2a465000543520000000000000000";
+    hex2bin("0c859545a3498373a57452fac22eb7113df2a465000543520000000000000000", notify_message.prev_block_hash.u8, 32);
     notify_message.version = 0x20000004;
     notify_message.target = 0x1705ae3a;
     notify_message.ntime = 0x647025b5;
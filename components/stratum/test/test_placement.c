@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "mining.h"
+
+// Everything the job task and the nonce check touch for one job, so that it
+// can be put into one memory region or the other as a whole.
+typedef struct {
+    mining_notify notify;
+    Hash_t merkles[MAX_MERKLE_BRANCHES];
+    uint8_t coinbase[256];
+    bm_job job;
+} hot_data_t;
+
+static const unsigned N_MERKLES = 12;
+static const size_t COINBASE_LEN = 200;
+static const uint32_t VERSION_MASK = 0x1fffe000;
+
+static void fill(hot_data_t* const d) {
+    memset(d, 0, sizeof(*d));
+    for (unsigned i = 0; i < sizeof(d->merkles); ++i) {
+        ((uint8_t*)d->merkles)[i] = (uint8_t)(i * 7 + 1);
+    }
+    for (unsigned i = 0; i < sizeof(d->coinbase); ++i) {
+        d->coinbase[i] = (uint8_t)(i * 13 + 5);
+    }
+    for (unsigned i = 0; i < 32; ++i) {
+        d->notify.prev_block_hash.u8[i] = (uint8_t)i;
+    }
+    d->notify.merkle_branches = d->merkles;
+    d->notify.n_merkle_branches = N_MERKLES;
+    d->notify.version = 0x20000000;
+    d->notify.target = 0x17034219;
+    d->notify.ntime = 0x66a1c9d2;
+}
+
+static void bench(const char* const name, const uint32_t caps) {
+    static const unsigned ROUNDS = 1000;
+
+    hot_data_t* const d = heap_caps_malloc(sizeof(hot_data_t), caps);
+    if (d == NULL) {
+        printf("%s: not available\n", name);
+        return;
+    }
+    fill(d);
+
+    // The merkle root by placement is timed in test_merkle.c.
+    Hash_t root;
+    calculate_merkle_root_hash_bin(memspan_get(d->coinbase, COINBASE_LEN), d->notify.merkle_branches, d->notify.n_merkle_branches, &root);
+    int64_t start;
+
+    start = esp_timer_get_time();
+    for (unsigned i = 0; i < ROUNDS; ++i) {
+        construct_bm_job(&d->notify, &root, VERSION_MASK, 1024, true, &d->job);
+    }
+    const int64_t jobUs = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (unsigned i = 0; i < ROUNDS; ++i) {
+        test_nonce_value(&d->job, 0x1234 + i, d->job.version);
+    }
+    const int64_t nonceUs = esp_timer_get_time() - start;
+
+    printf("%s: job build %.1f us, nonce check %.1f us\n",
+        name, (double)jobUs / ROUNDS, (double)nonceUs / ROUNDS);
+
+    heap_caps_free(d);
+}
+
+TEST_CASE("Job path throughput by memory placement", "[mining][bench]")
+{
+    bench("Internal RAM", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    bench("PSRAM", MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+}
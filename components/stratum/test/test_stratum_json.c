@@ -1,5 +1,22 @@
 #include "unity.h"
 #include "stratum_api.h"
+#include "utils.h"
+#include <string.h>
+
+// Compares decoded binary data with the hex string it came from.
+static void assert_hex_equal(const char* const hex, const uint8_t* const data, const size_t size)
+{
+    uint8_t expected[256];
+    TEST_ASSERT_EQUAL(strlen(hex) / 2, size);
+    TEST_ASSERT_LESS_OR_EQUAL(sizeof(expected), size);
+    hex2bin(hex, expected, size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, data, size);
+}
+
+static void assert_hex_span_equal(const char* const hex, const MemSpan_t span)
+{
+    assert_hex_equal(hex, span.start_u8, span.size);
+}
 
 TEST_CASE("Parse stratum method", "[stratum]")
 {
@@ -80,12 +97,19 @@ TEST_CASE("Parse stratum notify params", "[mining.notify]")
                               "\"20000004\",\"1705c739\",\"64495522\",false]}";
     STRATUM_V1_parse(&stratum_api_v1_message, json_string);
     TEST_ASSERT_EQUAL_STRING("1d2e0c4d3d", stratum_api_v1_message.mining_notification->job_id);
-    TEST_ASSERT_EQUAL_STRING("ef4b9a48c7986466de4adc002f7337a6e121bc43000376ea0000000000000000", stratum_api_v1_message.mining_notification->prev_block_hash);
-    TEST_ASSERT_EQUAL_STRING("01000000010000000000000000000000000000000000000000000000000000000000000000ffffffff4b03a5020cfabe6d6d379ae882651f6469f2ed6b8b40a4f9a4b41fd838a3ad6de8cba775f4e8f1d3080100000000000000", stratum_api_v1_message.mining_notification->coinbase_1);
-    TEST_ASSERT_EQUAL_STRING("41903d4c1b2f736c7573682f0000000003ca890d27000000001976a9147c154ed1dc59609e3d26abb2df2ea3d587cd8c4188ac00000000000000002c6a4c2952534b424c4f434b3a4cb4cb2ddfc37c41baf5ef6b6b4899e3253a8f1dfc7e5dd68a5b5b27005014ef0000000000000000266a24aa21a9ed5caa249f1af9fbf71c986fea8e076ca34ae3514fb2f86400561b28c7b15949bf00000000", stratum_api_v1_message.mining_notification->coinbase_2);
+    assert_hex_equal("ef4b9a48c7986466de4adc002f7337a6e121bc43000376ea0000000000000000", stratum_api_v1_message.mining_notification->prev_block_hash.u8, 32);
+    assert_hex_span_equal("01000000010000000000000000000000000000000000000000000000000000000000000000ffffffff4b03a5020cfabe6d6d379ae882651f6469f2ed6b8b40a4f9a4b41fd838a3ad6de8cba775f4e8f1d3080100000000000000", stratum_api_v1_message.mining_notification->coinbase_1);
+    assert_hex_span_equal("41903d4c1b2f736c7573682f0000000003ca890d27000000001976a9147c154ed1dc59609e3d26abb2df2ea3d587cd8c4188ac00000000000000002c6a4c2952534b424c4f434b3a4cb4cb2ddfc37c41baf5ef6b6b4899e3253a8f1dfc7e5dd68a5b5b27005014ef0000000000000000266a24aa21a9ed5caa249f1af9fbf71c986fea8e076ca34ae3514fb2f86400561b28c7b15949bf00000000", stratum_api_v1_message.mining_notification->coinbase_2);
     TEST_ASSERT_EQUAL_UINT32(0x20000004, stratum_api_v1_message.mining_notification->version);
     TEST_ASSERT_EQUAL_UINT32(0x1705c739, stratum_api_v1_message.mining_notification->target);
     TEST_ASSERT_EQUAL_UINT32(0x64495522, stratum_api_v1_message.mining_notification->ntime);
+
+    const Hash_t* const merkles = stratum_api_v1_message.mining_notification->merkle_branches;
+    TEST_ASSERT_EQUAL(12, stratum_api_v1_message.mining_notification->n_merkle_branches);
+    assert_hex_equal("ae23055e00f0f697cc3640124812d96d4fe8bdfa03484c1c638ce5a1c0e9aa81", merkles[0].u8, 32);
+    assert_hex_equal("03d287f655813e540ddb9c4e7aeb922478662b0f5d8e9d0cbd564b20146bab76", merkles[11].u8, 32);
+
+    STRATUM_V1_free_mining_notify(stratum_api_v1_message.mining_notification);
 }
 
 // 'private' function
@@ -6,16 +6,13 @@
 #include "mbedtls/sha256.h"
 
 #include "mem_search.h"
+#include "hex_conv.h"
 
 #include "esp_log.h"
 
 
 // static const char* const TAG = "mining_utils";
 
-static const char HEXCHARS[] = 
-    {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
-
-
 #ifndef bswap_16
 #define bswap_16(a) ((((uint16_t)(a) << 8) & 0xff00) | (((uint16_t)(a) >> 8) & 0xff))
 #endif
@@ -168,15 +165,7 @@ size_t nonce_from_hex(const char* const hex, Nonce_t* const out_nonce) {
 
 
 size_t nonce_to_hex(const Nonce_t* const nonce, char* out_hex) {
-    const uint8_t* ptr = nonce->u8;
-    const uint8_t* const end = ptr + nonce->size;
-    while(ptr < end) {
-        uint32_t b = ptr[0];
-        out_hex[0] = HEXCHARS[b >> 4];
-        out_hex[1] = HEXCHARS[b & 0xf];
-        out_hex += 2;
-        ptr += 1;
-    }
+    hex_encode(nonce->u8,nonce->size,out_hex);
     return nonce->size * 2;
 }
 
@@ -218,16 +207,8 @@ size_t bin2hex(const uint8_t *buf, size_t buflen, char *hex, size_t hexlen)
         return 0;
     }
 
-    for (size_t i = 0; i < buflen; i++)
-    {
-        uint32_t b = buf[0];
-        hex[0] = HEXCHARS[b >> 4];
-        hex[1] = HEXCHARS[b & 0xf];
-        hex += 2;
-        buf += 1;
-    }
-
-    hex[0] = '\0';
+    hex_encode(buf,buflen,hex);
+    hex[2 * buflen] = '\0';
 
     return 2 * buflen;
 }
@@ -303,7 +284,12 @@ size_t hex2bin(const char *hex, uint8_t* bin, size_t bin_len)
     const unsigned hex_len = mem_findStrEnd(hex,bin_len*2) - hex;
     const unsigned byteCnt = min((hex_len/2),bin_len);
 
-    uint8_t* const end = bin + byteCnt;
+    // Stops at the first pair which isn't hex; the rest is decoded below as before.
+    const unsigned valid = hex_decode(hex,byteCnt,bin);
+    hex += 2 * valid;
+    bin += valid;
+
+    uint8_t* const end = bin + (byteCnt - valid);
     while(bin < end) {
         *bin = hex2u8(hex);
         bin += 1;
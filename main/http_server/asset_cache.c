@@ -0,0 +1,228 @@
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "mbedtls/sha256.h"
+
+#include "asset_cache.h"
+#include "www_archive.h"
+
+// Total amount of PSRAM to use for file contents.
+#define ASSET_CACHE_MAX_RAM (2 * 1024 * 1024)
+// Bigger files are always read from the file system.
+#define ASSET_CACHE_MAX_FILE (1024 * 1024)
+// Min. number of hex digits in a file name to consider it content-hashed.
+#define HASH_NAME_MIN_DIGITS 8
+
+static const char* const TAG = "asset_cache";
+
+static asset_t* assets = NULL;
+static asset_cache_stats_t stats;
+
+/*
+    Build tools put a content hash into the file names, like "main.1a2b3c4d5e6f7a8b.js";
+    such files never change and may be cached by the client forever.
+    Detects a '.' or '-' separated run of hex digits which is neither the
+    first part of the name nor the extension.
+*/
+static bool has_hashed_name(const char* const path) {
+    const char* name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+    const char* const ext = strrchr(name, '.');
+    if(ext == NULL) {
+        return false;
+    }
+    const char* p = name;
+    // Skip the first part.
+    while(p < ext && *p != '.' && *p != '-') {
+        ++p;
+    }
+    while(p < ext) {
+        ++p; // skip the separator
+        const char* const start = p;
+        while(p < ext && isxdigit((unsigned char)*p)) {
+            ++p;
+        }
+        if((p - start) >= HASH_NAME_MIN_DIGITS && (*p == '.' || *p == '-')) {
+            return true;
+        }
+        while(p < ext && *p != '.' && *p != '-') {
+            ++p;
+        }
+    }
+    return false;
+}
+
+static void make_etag(const uint8_t* const hash, char* const etag) {
+    // 64 bits of the SHA-256 are plenty to tell versions of a file apart.
+    snprintf(etag, sizeof(((asset_t*)0)->etag), "\"%02x%02x%02x%02x%02x%02x%02x%02x\"",
+        hash[0], hash[1], hash[2], hash[3], hash[4], hash[5], hash[6], hash[7]);
+}
+
+static asset_t* new_asset(const char* const path) {
+    const size_t pathLen = strlen(path);
+    const size_t size = sizeof(asset_t) + pathLen + 1;
+    asset_t* asset = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if(!asset) {
+        // No PSRAM; the entry is small enough for internal RAM.
+        asset = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+    if(asset) {
+        memset(asset, 0, sizeof(asset_t));
+        memcpy(asset->path, path, pathLen + 1);
+        asset->immutable = has_hashed_name(path);
+    }
+    return asset;
+}
+
+static asset_t* load_archived_asset(const char* const path) {
+    www_file_t file;
+    if(!www_archive_find(path, &file)) {
+        return NULL;
+    }
+    asset_t* const asset = new_asset(path);
+    if(asset) {
+        asset->data = file.data;
+        asset->size = file.size;
+        asset->mapped = true;
+        asset->gzip = file.gzip;
+        make_etag(file.hash, asset->etag);
+    }
+    return asset;
+}
+
+static asset_t* load_asset(const char* const path, char* const buf, const size_t bufSize) {
+    if(www_archive_is_open()) {
+        return load_archived_asset(path);
+    }
+
+    const size_t pathLen = strlen(path);
+    char gzPath[pathLen + 4];
+    memcpy(gzPath, path, pathLen);
+    memcpy(gzPath + pathLen, ".gz", 4);
+
+    bool gzip = true;
+    int fd = open(gzPath, O_RDONLY, 0);
+    if(fd == -1) {
+        gzip = false;
+        fd = open(path, O_RDONLY, 0);
+    }
+    if(fd == -1) {
+        return NULL;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    asset_t* const asset = new_asset(path);
+    if(asset == NULL) {
+        close(fd);
+        return NULL;
+    }
+    asset->gzip = gzip;
+
+    // Only ever use PSRAM for the content; internal RAM is too precious.
+    // Without it, the content is streamed from the file system on every request.
+    uint8_t* data = NULL;
+    if(st.st_size <= ASSET_CACHE_MAX_FILE && (stats.ramBytes + st.st_size) <= ASSET_CACHE_MAX_RAM) {
+        data = heap_caps_malloc(st.st_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+
+    size_t size = 0;
+    ssize_t rd = 0;
+    if(data) {
+        while(size < st.st_size && (rd = read(fd, data + size, st.st_size - size)) > 0) {
+            size += rd;
+        }
+        mbedtls_sha256_update(&ctx, data, size);
+    } else {
+        while((rd = read(fd, buf, bufSize)) > 0) {
+            mbedtls_sha256_update(&ctx, (const uint8_t*)buf, rd);
+            size += rd;
+        }
+    }
+    close(fd);
+
+    uint8_t hash[32];
+    mbedtls_sha256_finish(&ctx, hash);
+    mbedtls_sha256_free(&ctx);
+
+    if(rd < 0 || (data && size != st.st_size)) {
+        ESP_LOGE(TAG, "Failed to read file: %s", path);
+        free(data);
+        free(asset);
+        return NULL;
+    }
+
+    make_etag(hash, asset->etag);
+    asset->size = size;
+    asset->data = data;
+    if(data) {
+        stats.ramBytes += size;
+    }
+
+    ESP_LOGD(TAG, "Loaded %s%s: %u bytes%s, ETag %s", path, gzip ? ".gz" : "", (unsigned)size,
+        data ? " (in PSRAM)" : "", asset->etag);
+
+    return asset;
+}
+
+const asset_t* asset_cache_get(const char* const path, char* const buf, const size_t bufSize) {
+    for(const asset_t* a = assets; a != NULL; a = a->next) {
+        if(strcmp(a->path, path) == 0) {
+            return a;
+        }
+    }
+    asset_t* const asset = load_asset(path, buf, bufSize);
+    if(asset) {
+        asset->next = assets;
+        assets = asset;
+        stats.assetCnt += 1;
+    }
+    return asset;
+}
+
+void asset_cache_clear(void) {
+    asset_t* a = assets;
+    assets = NULL;
+    while(a != NULL) {
+        asset_t* const next = a->next;
+        if(!a->mapped) {
+            free((void*)a->data);
+        }
+        free(a);
+        a = next;
+    }
+    stats.ramBytes = 0;
+    stats.assetCnt = 0;
+}
+
+void asset_cache_count_request(const asset_t* const asset, const bool notModified, const size_t bytesSent, const int64_t handlerTimeUs) {
+    stats.requests += 1;
+    if(notModified) {
+        stats.notModified += 1;
+    } else if(asset && asset->mapped) {
+        stats.mappedHits += 1;
+    } else if(asset && asset->data) {
+        stats.ramHits += 1;
+    }
+    stats.bytesSent += bytesSent;
+    stats.handlerTimeUs += handlerTimeUs;
+}
+
+void asset_cache_get_stats(asset_cache_stats_t* const out) {
+    *out = stats;
+}
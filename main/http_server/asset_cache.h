@@ -0,0 +1,68 @@
+#ifndef ASSET_CACHE_H_
+#define ASSET_CACHE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief A static file from the www partition, as served to clients.
+ */
+typedef struct asset {
+    struct asset* next;
+    const uint8_t* data; // Content in PSRAM or mapped flash, or NULL if it must be read from the file system.
+    size_t size;
+    bool mapped; // data points into the www archive
+    bool gzip; // Content is <path>.gz
+    bool immutable; // File name contains a content hash
+    char etag[20]; // Quoted, as sent in the ETag header
+    char path[];
+} asset_t;
+
+typedef struct asset_cache_stats {
+    uint32_t requests;
+    uint32_t notModified; // Requests answered with 304
+    uint32_t ramHits; // Requests served from PSRAM
+    uint32_t mappedHits; // Requests served from the www archive
+    uint64_t bytesSent;
+    uint64_t handlerTimeUs; // Total time spent in the file handler
+    size_t ramBytes; // Content held in PSRAM
+    uint16_t assetCnt;
+} asset_cache_stats_t;
+
+/**
+ * @brief Looks up the asset for \p path, loading it on first use: Files from the
+ * www archive are served from where they are mapped. Otherwise, the content hash
+ * is computed and, if there is PSRAM to spare, the content is kept in memory.
+ * 
+ * Not thread-safe; only call from the HTTP server task.
+ * 
+ * @param path file path without ".gz"; the gzipped file is preferred if it exists.
+ * @param buf scratch buffer to read the file through
+ * @param bufSize size of \p buf
+ * @return the asset, or NULL if there is no such file
+ */
+const asset_t* asset_cache_get(const char* path, char* buf, size_t bufSize);
+
+/**
+ * @brief Drops all cached assets; must be called before the www partition is
+ * rewritten or the archive is unmapped.
+ */
+void asset_cache_clear(void);
+
+/**
+ * @brief Accounts for a served request.
+ */
+void asset_cache_count_request(const asset_t* asset, bool notModified, size_t bytesSent, int64_t handlerTimeUs);
+
+void asset_cache_get_stats(asset_cache_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ASSET_CACHE_H_
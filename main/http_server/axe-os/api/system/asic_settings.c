@@ -33,8 +33,6 @@ esp_err_t GET_system_asic(httpd_req_t *req)
         return httpd_resp_send_err(req, HTTPD_401_UNAUTHORIZED, "Unauthorized");
     }
 
-    httpd_resp_set_type(req, "application/json");
-
     // Set CORS headers
     if (set_cors_headers(req) != ESP_OK) {
         httpd_resp_send_500(req);
@@ -43,7 +41,7 @@ esp_err_t GET_system_asic(httpd_req_t *req)
 
     http_writer_t wrtr;
     http_writer_t* const w = &wrtr;
-    http_writer_init(w,req);
+    http_json_init(w,req);
 
     http_json_start_obj(w,NULL);
 
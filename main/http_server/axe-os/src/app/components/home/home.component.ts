@@ -1,10 +1,11 @@
 import { Component, OnInit, ViewChild, OnDestroy } from '@angular/core';
-import { interval, map, Observable, shareReplay, startWith, switchMap, tap, first, Subject, takeUntil } from 'rxjs';
+import { catchError, interval, map, Observable, scan, shareReplay, startWith, switchMap, tap, first, Subject, takeUntil, withLatestFrom } from 'rxjs';
 import { HashSuffixPipe } from 'src/app/pipes/hash-suffix.pipe';
 import { QuicklinkService } from 'src/app/services/quicklink.service';
 import { ShareRejectionExplanationService } from 'src/app/services/share-rejection-explanation.service';
 import { LoadingService } from 'src/app/services/loading.service';
 import { SystemService } from 'src/app/services/system.service';
+import { ITelemetry, TelemetryService } from 'src/app/services/telemetry.service';
 import { ThemeService } from 'src/app/services/theme.service';
 import { ISystemInfo } from 'src/models/ISystemInfo';
 import { ISystemStatistics } from 'src/models/ISystemStatistics';
@@ -12,6 +13,9 @@ import { Title } from '@angular/platform-browser';
 import { UIChart } from 'primeng/chart';
 import { ISystemInfoDash } from 'src/models/ISystemInfoDash';
 
+// How often the fields not covered by the telemetry are refreshed.
+const INFO_REFRESH_MS = 60000;
+
 @Component({
   selector: 'app-home',
   templateUrl: './home.component.html',
@@ -51,6 +55,7 @@ export class HomeComponent implements OnInit, OnDestroy {
 
   constructor(
     private systemService: SystemService,
+    private telemetryService: TelemetryService,
     private themeService: ThemeService,
     private quickLinkService: QuicklinkService,
     private titleService: Title,
@@ -249,12 +254,30 @@ export class HomeComponent implements OnInit, OnDestroy {
 
   private startGetLiveData()
   {
-     // live data
-    this.info$ = interval(5000).pipe(
+    const polling$ = interval(5000).pipe(
       startWith(() => this.systemService.getInfo()),
       switchMap(() => {
         return this.systemService.getInfo()
+      })
+    );
+
+    // live data: fetch the full info, then apply the deltas pushed by the
+    // telemetry websocket. Fields the telemetry doesn't cover (uptime, heap,
+    // RSSI, ...) come from a full info fetched once a minute. Falls back to
+    // polling if the socket fails, closes or goes quiet.
+    this.info$ = this.systemService.getInfo().pipe(
+      switchMap(info => {
+        const fullInfo$ = interval(INFO_REFRESH_MS).pipe(
+          switchMap(() => this.systemService.getInfo()),
+          startWith(info)
+        );
+        return this.telemetryService.connect(5000).pipe(
+          scan((acc: ITelemetry, delta) => ({ ...acc, ...delta })),
+          withLatestFrom(fullInfo$),
+          map(([telemetry, full]): ISystemInfo => ({ ...full, ...telemetry }))
+        );
       }),
+      catchError(() => polling$),
       tap(info => {
         // Only collect and update chart data if there's no power fault
         if (!info.power_fault) {
@@ -285,7 +308,8 @@ export class HomeComponent implements OnInit, OnDestroy {
         this.activePoolPort = isFallback ? info.fallbackStratumPort : info.stratumPort;
         this.responseTime = info.responseTime;
       }),
-      map(info => {
+      map(data => {
+        const info = { ...data };
         info.power = parseFloat(info.power.toFixed(1))
         info.voltage = parseFloat((info.voltage / 1000).toFixed(1));
         info.current = parseFloat((info.current / 1000).toFixed(1));
@@ -0,0 +1,26 @@
+import { Injectable } from '@angular/core';
+import { concatWith, Observable, throwError, timeout } from 'rxjs';
+import { webSocket } from 'rxjs/webSocket';
+import { ISystemInfo } from 'src/models/ISystemInfo';
+
+export type ITelemetry = Partial<ISystemInfo> & { t: number };
+
+@Injectable({
+  providedIn: 'root'
+})
+export class TelemetryService {
+
+  // Opens /api/ws/telemetry; the device pushes the live values every
+  // intervalMs, sending only the fields that changed since the last frame
+  // (just "t" if none did).
+  // Errors if the socket closes or no frame arrives for three intervals, so
+  // that callers can fall back to polling.
+  public connect(intervalMs: number): Observable<ITelemetry> {
+    return webSocket<ITelemetry>({
+      url: `ws://${window.location.host}/api/ws/telemetry?interval=${intervalMs}`
+    }).pipe(
+      concatWith(throwError(() => new Error('Telemetry socket closed'))),
+      timeout({ each: intervalMs * 3 })
+    );
+  }
+}
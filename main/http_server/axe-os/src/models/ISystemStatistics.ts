@@ -1,5 +1,6 @@
 export interface ISystemStatistics {
     currentTimestamp: number;
+    bootId?: number;
     labels : string[];
     statistics: number[][];
 }
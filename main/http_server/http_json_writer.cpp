@@ -1,8 +1,100 @@
 #include "http_json_writer.hpp"
 #include "http_json_writer.h"
+#include <string_view>
 
 using namespace http;
 
+static constexpr const char* MIME_JSON = "application/json";
+static constexpr const char* MIME_CBOR = "application/cbor";
+
+static bool acceptsCbor(httpd_req_t* const req) {
+    char accept[96];
+    if(httpd_req_get_hdr_value_str(req, "Accept", accept, sizeof(accept)) == ESP_OK) {
+        return std::string_view {accept}.find(MIME_CBOR) != std::string_view::npos;
+    }
+    return false;
+}
+
+void http_json_set_type(httpd_req_t* const req, const bool cbor) {
+    httpd_resp_set_type(req, cbor ? MIME_CBOR : MIME_JSON);
+    // Responses differ by Accept header; tell caches.
+    httpd_resp_set_hdr(req, "Vary", "Accept");
+}
+
+bool http_json_init(http_writer_t* const w, httpd_req_t* const req) {
+    http_writer_init(w,req);
+    const bool cbor = acceptsCbor(req);
+    json::JsonWriter::of(*w).setCbor(cbor);
+    http_json_set_type(req, cbor);
+    return cbor;
+}
+
+bool http_json_accepts_cbor(httpd_req_t* const req) {
+    return acceptsCbor(req);
+}
+
+void http_json_init_mem(http_writer_t* const w, const bool cbor) {
+    http_writer_init_mem(w);
+    json::JsonWriter::of(*w).setCbor(cbor);
+}
+
+static constexpr const char* STATS_LABELS[STATS_FIELD_CNT] {
+    "hashRate",
+    "temp",
+    "vrTemp",
+    "power",
+    "voltage",
+    "current",
+    "coreVoltageActual",
+    "fanspeed",
+    "fanrpm",
+    "wifiRSSI",
+    "freeHeap",
+    "timestamp"
+};
+
+static constexpr bool isLabelChar(const char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+uint32_t http_json_parse_stats_fields(const char* const list) {
+    uint32_t fields = 0;
+    if(list) {
+        // Any non-alphanumeric char separates labels, so that a URL-encoded
+        // comma ("%2C") just yields an unknown "2C" label which gets ignored.
+        const char* p = list;
+        while(*p != '\0') {
+            const char* const start = p;
+            while(isLabelChar(*p)) {
+                ++p;
+            }
+            const std::string_view label {start, (std::size_t)(p - start)};
+            for(unsigned i = 0; i < STATS_FIELD_CNT; ++i) {
+                if(label == STATS_LABELS[i]) {
+                    fields |= (1u << i);
+                    break;
+                }
+            }
+            if(*p != '\0') {
+                ++p;
+            }
+        }
+    }
+    return fields;
+}
+
+esp_err_t http_json_write_stats_labels(http_writer_t* const pw, const uint32_t fields) {
+    json::JsonWriter& w = json::JsonWriter::of(*pw);
+    w.startArr("labels");
+    for(unsigned i = 0; i < STATS_FIELD_CNT; ++i) {
+        if(fields & (1u << i)) {
+            w.writeValue(STATS_LABELS[i]);
+        }
+    }
+    w.endArr();
+    return w;
+}
+
 esp_err_t http_json_write_stats(http_writer_t* const pw, const struct StatisticsData* const stats) {
     json::JsonWriter& w = json::JsonWriter::of(*pw);
 
@@ -24,6 +116,36 @@ esp_err_t http_json_write_stats(http_writer_t* const pw, const struct Statistics
     return w;
 }
 
+esp_err_t http_json_write_stats_fields(http_writer_t* const pw, const struct StatisticsData* const stats, const uint32_t fields) {
+    if(fields == STATS_FIELDS_ALL) {
+        return http_json_write_stats(pw,stats);
+    }
+
+    json::JsonWriter& w = json::JsonWriter::of(*pw);
+
+    const struct StatisticsData& statsData = *stats;
+
+    const auto has = [fields](const stats_field_t f) {
+        return (fields & (1u << f)) != 0;
+    };
+
+    w.startArr();
+    if(has(STATS_FIELD_HASHRATE)) w.writeValue(statsData.hashrate_MHz * 0.001f);
+    if(has(STATS_FIELD_TEMP)) w.writeValue(statsData.chipTemperature);
+    if(has(STATS_FIELD_VR_TEMP)) w.writeValue(statsData.vrTemperature);
+    if(has(STATS_FIELD_POWER)) w.writeValue(statsData.power);
+    if(has(STATS_FIELD_VOLTAGE)) w.writeValue(statsData.voltage);
+    if(has(STATS_FIELD_CURRENT)) w.writeValue(statsData.current);
+    if(has(STATS_FIELD_CORE_VOLTAGE_ACTUAL)) w.writeValue(statsData.coreVoltageActual);
+    if(has(STATS_FIELD_FANSPEED)) w.writeValue(statsData.fanSpeed);
+    if(has(STATS_FIELD_FANRPM)) w.writeValue(statsData.fanRPM);
+    if(has(STATS_FIELD_WIFI_RSSI)) w.writeValue(statsData.wifiRSSI);
+    if(has(STATS_FIELD_FREE_HEAP)) w.writeValue(statsData.freeHeap);
+    if(has(STATS_FIELD_TIMESTAMP)) w.writeValue(statsData.timestamp);
+    w.endArr();
+    return w;
+}
+
 esp_err_t http_json_start_obj(http_writer_t* const w, const char* const name) {
     return json::JsonWriter::of(*w).startObj(name).result;
 }
@@ -57,6 +179,12 @@ esp_err_t http_json_write_bool_item(http_writer_t* const w, const char* const na
     return json::JsonWriter::of(*w).writeItem(name,value).result;
 }
 
+esp_err_t http_json_write_raw_item(http_writer_t* const w, const char* const name, const char* const json) {
+    json::JsonWriter& jw = json::JsonWriter::of(*w);
+    jw.startItem(name);
+    return jw.writeRawValue(json).result;
+}
+
 esp_err_t http_json_write_str(http_writer_t* const w, const char* const str) {
     return json::JsonWriter::of(*w).writeValue(str).result;
 }
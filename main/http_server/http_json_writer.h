@@ -4,12 +4,73 @@
 #include <esp_err.h>
 #include "http_writer.h"
 #include "statistics_task.h"
+#include "stats_history.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Initializes \p w for \p req and selects the output format:
+ * CBOR if the client's Accept header asks for application/cbor, JSON otherwise.
+ * Also sets the response's content type accordingly.
+ * 
+ * @return true if CBOR was selected
+ */
+bool http_json_init(http_writer_t* const w, httpd_req_t* const req);
+
+/**
+ * @brief Returns true if the client's Accept header asks for application/cbor.
+ */
+bool http_json_accepts_cbor(httpd_req_t* const req);
+
+/**
+ * @brief Sets the content type of the response to CBOR or JSON.
+ */
+void http_json_set_type(httpd_req_t* const req, const bool cbor);
+
+/**
+ * @brief Initializes \p w to render into memory (see http_writer_init_mem())
+ * in the given format.
+ */
+void http_json_init_mem(http_writer_t* const w, const bool cbor);
+
+/**
+ * @brief Columns of the /api/system/statistics data, in output order.
+ */
+typedef enum stats_field {
+    STATS_FIELD_HASHRATE = 0,
+    STATS_FIELD_TEMP,
+    STATS_FIELD_VR_TEMP,
+    STATS_FIELD_POWER,
+    STATS_FIELD_VOLTAGE,
+    STATS_FIELD_CURRENT,
+    STATS_FIELD_CORE_VOLTAGE_ACTUAL,
+    STATS_FIELD_FANSPEED,
+    STATS_FIELD_FANRPM,
+    STATS_FIELD_WIFI_RSSI,
+    STATS_FIELD_FREE_HEAP,
+    STATS_FIELD_TIMESTAMP,
+    STATS_FIELD_CNT
+} stats_field_t;
+
+#define STATS_FIELDS_ALL ((uint32_t)((1u << STATS_FIELD_CNT) - 1))
+
+/**
+ * @brief Parses a comma-separated list of stats labels (e.g. "hashRate,temp,timestamp")
+ * into a bit set of (1 << stats_field_t). Unknown labels are ignored.
+ * 
+ * @return the bit set; \c 0 if no known label was found.
+ */
+uint32_t http_json_parse_stats_fields(const char* const list);
+
+/**
+ * @brief Writes the "labels" array for the given set of fields.
+ */
+esp_err_t http_json_write_stats_labels(http_writer_t* const w, const uint32_t fields);
+
 esp_err_t http_json_write_stats(http_writer_t* const w, const struct StatisticsData* const stats);
+esp_err_t http_json_write_stats_fields(http_writer_t* const w, const struct StatisticsData* const stats, const uint32_t fields);
 
 // I hate C.
 #define http_json_write_item(w,name,value) \
@@ -62,6 +123,7 @@ esp_err_t http_json_write_float_item(http_writer_t* const w, const char* const n
 esp_err_t http_json_write_double_item(http_writer_t* const w, const char* const name, const double value);
 esp_err_t http_json_write_str_item(http_writer_t* const w, const char* const name, const char* const value);
 esp_err_t http_json_write_bool_item(http_writer_t* const w, const char* const name, const bool value);
+esp_err_t http_json_write_raw_item(http_writer_t* const w, const char* const name, const char* const json);
 
 esp_err_t http_json_write_int(http_writer_t* const w, const int32_t value);
 esp_err_t http_json_write_long_int(http_writer_t* const w, const int64_t value);
@@ -1,9 +1,16 @@
 #pragma once
 #include "http_writer.hpp"
 #include <string_view>
+#include "cbor.hpp"
 
 namespace http::json {
 
+    /**
+     * @brief Writes JSON, or - if \c cbor is set - the equivalent CBOR, so that
+     * the same handler code can serve both formats.
+     * In CBOR mode objects and arrays are encoded with indefinite length, so
+     * nothing needs to be known in advance.
+     */
     class JsonWriter : public http::Writer {
         public:
 
@@ -17,7 +24,19 @@ namespace http::json {
 
         using http::Writer::Writer;
 
+        constexpr bool isCbor(void) const {
+            return this->cbor;
+        }
+
+        JsonWriter& setCbor(const bool cbor) {
+            this->cbor = cbor;
+            return *this;
+        }
+
         JsonWriter& startObj(void) {
+            if(isCbor()) {
+                return writeByte(cbor::INDEF_MAP);
+            }
             doCont(false);
             return of(this->write('{'));
         }
@@ -29,11 +48,17 @@ namespace http::json {
         }
 
         JsonWriter& endObj(void) {
+            if(isCbor()) {
+                return writeByte(cbor::BREAK);
+            }
             this->cont = true;
             return of(this->write('}'));
         }
 
         JsonWriter& startArr(void) {
+            if(isCbor()) {
+                return writeByte(cbor::INDEF_ARRAY);
+            }
             doCont(false);
             return of(this->write('['));
         }
@@ -45,19 +70,29 @@ namespace http::json {
         }
 
         JsonWriter& endArr(void) {
+            if(isCbor()) {
+                return writeByte(cbor::BREAK);
+            }
             this->cont = true;
             return of(this->write(']'));
         }
 
         JsonWriter& startItem(const char* const name) {
             if(name) {
-                this->writeValues('"', name, '"', ':');
-                this->cont = false;
+                if(isCbor()) {
+                    writeText(name);
+                } else {
+                    this->writeValues('"', name, '"', ':');
+                    this->cont = false;
+                }
             }
             return *this;
         }
 
         JsonWriter& writeNullValue(void) {
+            if(isCbor()) {
+                return writeByte(cbor::SIMPLE_NULL);
+            }
             constexpr std::string_view NLL {"null"};
             doCont(true);
             this->write(NLL);
@@ -66,7 +101,11 @@ namespace http::json {
 
         JsonWriter& writeValue(const char* const value) {
             if(value) {
-                writeValues('"',value,'"');
+                if(isCbor()) {
+                    writeText(value);
+                } else {
+                    writeValues('"',value,'"');
+                }
             } else {
                 writeNullValue();
             }
@@ -75,15 +114,45 @@ namespace http::json {
 
         template<http::number_t T>
         JsonWriter& writeValue(T value) {
+            if(isCbor()) {
+                this->encode(cbor::MAX_HEAD_SIZE, [value](uint8_t* const out) {
+                    return cbor::encodeNumber(value, out);
+                });
+                return *this;
+            }
             return writeValues(value);
-        } 
+        }
 
         JsonWriter& writeValue(const bool value) {
+            if(isCbor()) {
+                return writeByte(value ? cbor::SIMPLE_TRUE : cbor::SIMPLE_FALSE);
+            }
             constexpr std::string_view T {"true"};
             constexpr std::string_view F {"false"};
             return writeValues(value ? T : F);
         }
 
+        /**
+         * @brief Writes \p json verbatim as a value; the caller must make sure
+         * it is valid JSON.
+         * In CBOR mode, the text is sent as a string tagged as embedded JSON.
+         */
+        JsonWriter& writeRawValue(const char* const json) {
+            if(json) {
+                if(isCbor()) {
+                    this->encode(cbor::MAX_HEAD_SIZE, [](uint8_t* const out) {
+                        return cbor::tag(cbor::TAG_JSON, out);
+                    });
+                    writeText(json);
+                } else {
+                    writeValues(json);
+                }
+            } else {
+                writeNullValue();
+            }
+            return *this;
+        }
+
         template<typename ... Args>
         JsonWriter& writeValues(Args...args) {
             doCont(true);
@@ -120,10 +189,27 @@ namespace http::json {
             return *this;
         }
 
+        JsonWriter& writeByte(const uint8_t b) {
+            return of(this->write((char)b));
+        }
+
+        JsonWriter& writeText(const char* const str) {
+            const std::size_t len = std::strlen(str);
+            this->encode(cbor::MAX_HEAD_SIZE, [len](uint8_t* const out) {
+                return cbor::textHead(len, out);
+            });
+            this->write(str, len);
+            return *this;
+        }
+
         template<typename T, typename...Args>
         JsonWriter& writeValueList(const T& a, const Args&...args) {
-            doCont(true);
-            this->write(a);
+            if(isCbor()) {
+                writeValue(a);
+            } else {
+                doCont(true);
+                this->write(a);
+            }
             if constexpr (sizeof...(Args) != 0) {
                 if(ok()) {
                     writeValueList(args...);
@@ -134,4 +220,4 @@ namespace http::json {
 
     };
 
-}
\ No newline at end of file
+}
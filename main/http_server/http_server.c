@@ -1,5 +1,6 @@
 #include <pthread.h>
 #include <fcntl.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/param.h>
 #include <sys/stat.h>
@@ -38,19 +39,30 @@
 #include "asic.h"
 #include "TPS546.h"
 #include "statistics_task.h"
+#include "stats_history.h"
 #include "theme_api.h"  // Add theme API include
 #include "axe-os/api/system/asic_settings.h"
+#include "metrics_api.h"
+#include "asset_cache.h"
+#include "www_archive.h"
+#include "upload_pipeline.h"
 #include "http_server.h"
 #include "system.h"
 #include "websocket.h"
+#include "telemetry_ws.h"
 
 #include "http_writer.h"
 #include "http_json_writer.h"
+#include "mempool_registry.h"
 
 // #include "wifi_event_listener.h"
 
-#define JSON_ALL_STATS_ELEMENT_SIZE 120
-#define JSON_DASHBOARD_STATS_ELEMENT_SIZE 60
+// Columns sent by /api/system/statistics/dashboard
+#define DASHBOARD_STATS_FIELDS ( \
+    (1u << STATS_FIELD_HASHRATE) | \
+    (1u << STATS_FIELD_TEMP) | \
+    (1u << STATS_FIELD_POWER) | \
+    (1u << STATS_FIELD_TIMESTAMP) )
 
 static const char * const TAG = "http_server";
 static const char * const CORS_TAG = "CORS";
@@ -93,8 +105,6 @@ static inline void* allocPrefPSRAM(size_t sz) {
 /* Handler for WiFi scan endpoint */
 static esp_err_t GET_wifi_scan(httpd_req_t *req)
 {
-    httpd_resp_set_type(req, "application/json");
-    
     // Give some time for the connected flag to take effect
     vTaskDelay(100 / portTICK_PERIOD_MS);
     
@@ -111,7 +121,7 @@ static esp_err_t GET_wifi_scan(httpd_req_t *req)
 
     http_writer_t wrtr;
     http_writer_t* const w = &wrtr;
-    http_writer_init(w,req);
+    http_json_init(w,req);
 
     http_json_start_obj(w,NULL);
     http_json_start_arr(w, "networks");
@@ -257,27 +267,52 @@ esp_err_t is_network_allowed(httpd_req_t * req)
 }
 
 static void readAxeOSVersion(void) {
-    FILE* f = fopen("/version.txt", "r");
-    if (f != NULL) {
+    www_file_t file;
+    FILE* f = NULL;
+    if (www_archive_find("/version.txt", &file) && !file.gzip) {
+        const size_t n = MIN(file.size, sizeof(axeOSVersion) - 1);
+        memcpy(axeOSVersion, file.data, n);
+        axeOSVersion[n] = '\0';
+    } else if ((f = fopen("/version.txt", "r")) != NULL) {
         size_t n = fread(axeOSVersion, 1, sizeof(axeOSVersion) - 1, f);
         axeOSVersion[n] = '\0';
         fclose(f);
-
-        ESP_LOGI(TAG, "AxeOS version: %s", axeOSVersion);
-
-        if (strcmp(axeOSVersion, esp_app_get_description()->version) != 0) {
-            ESP_LOGW(TAG, "Firmware (%s) and AxeOS (%s) versions do not match. Please make sure to update both www.bin and esp-miner.bin.", esp_app_get_description()->version, axeOSVersion);
-        }
     } else {
         strcpy(axeOSVersion, "unknown");
         ESP_LOGI(TAG, "Failed to open AxeOS version.txt");
+        return;
+    }
+
+    ESP_LOGI(TAG, "AxeOS version: %s", axeOSVersion);
+
+    if (strcmp(axeOSVersion, esp_app_get_description()->version) != 0) {
+        ESP_LOGW(TAG, "Firmware (%s) and AxeOS (%s) versions do not match. Please make sure to update both www.bin and esp-miner.bin.", esp_app_get_description()->version, axeOSVersion);
     }
 }
 
+static bool spiffsMounted = false;
+
+/* Unmap/unmount whatever is in the www partition, so that it can be rewritten */
+static void release_fs(void)
+{
+    asset_cache_clear();
+    www_archive_close();
+    if (spiffsMounted) {
+        esp_vfs_spiffs_unregister(SPIFFS_CONF.partition_label);
+        spiffsMounted = false;
+    }
+}
 
 esp_err_t init_fs(void)
 {
-    esp_err_t ret = esp_vfs_spiffs_register(&SPIFFS_CONF);
+    // Prefer the archive; fall back to SPIFFS for www.bin images built as such.
+    esp_err_t ret = www_archive_open();
+    if (ret == ESP_OK) {
+        readAxeOSVersion();
+        return ESP_OK;
+    }
+
+    ret = esp_vfs_spiffs_register(&SPIFFS_CONF);
 
     if (ret != ESP_OK) {
         if (ret == ESP_FAIL) {
@@ -289,6 +324,7 @@ esp_err_t init_fs(void)
         }
         return ESP_FAIL;
     }
+    spiffsMounted = true;
 
     size_t total = 0, used = 0;
     ret = esp_spiffs_info(NULL, &total, &used);
@@ -415,11 +451,50 @@ static esp_err_t redirectToRoot(httpd_req_t* const req) {
     return httpd_resp_send(req, RSP, sizeof(RSP)-1);
 }
 
+/* Check if the client's If-None-Match header matches the ETag */
+static bool client_has_etag(httpd_req_t* const req, const char* const etag, char* const buf, const size_t bufSize) {
+    const size_t len = httpd_req_get_hdr_value_len(req, "If-None-Match");
+    if(len == 0 || len >= bufSize ||
+       httpd_req_get_hdr_value_str(req, "If-None-Match", buf, bufSize) != ESP_OK) {
+        return false;
+    }
+    // May be "*", or a list of (weak) tags like W/"abc", "def"
+    if(strcmp(buf, "*") == 0) {
+        return true;
+    }
+    const size_t etagLen = strlen(etag);
+    const char* p = buf;
+    while(*p != '\0') {
+        while(*p == ' ' || *p == '\t' || *p == ',') {
+            ++p;
+        }
+        // If-None-Match uses the weak comparison, so W/ makes no difference.
+        if(p[0] == 'W' && p[1] == '/') {
+            p += 2;
+        }
+        const char* const tag = p;
+        if(*p == '"') {
+            const char* const end = strchr(p + 1, '"');
+            p = end ? end + 1 : p + strlen(p);
+        }
+        // Skip anything malformed up to the next tag.
+        const char* const tagEnd = p;
+        while(*p != '\0' && *p != ',') {
+            ++p;
+        }
+        if((size_t)(tagEnd - tag) == etagLen && memcmp(tag, etag, etagLen) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /* Send HTTP response with the contents of the requested file */
 static esp_err_t file_serve_handler(httpd_req_t * req)
 {
+    const int64_t startTime = esp_timer_get_time();
+
     char filepath[FILE_PATH_MAX];
-    // char gz_file[FILE_PATH_MAX];
     const size_t MAX_FP = sizeof(filepath)-3-1; // leave room for ".gz\0" at the end.
     filepath[MAX_FP] = '\0';
 
@@ -439,70 +514,92 @@ static esp_err_t file_serve_handler(httpd_req_t * req)
     }
 
     const bool uri_is_dir = filepath[fplen-1] == '/';
-    //req->uri[strlen(req->uri) - 1] == '/';
     if (uri_is_dir) {
         fplen += strlcpy(filepath + fplen, "index.html", MAX_FP - fplen);
-        // strlcat(filepath, "/index.html", filePathLength);
         if(fplen >= MAX_FP) {
             return redirectToRoot(req);
         }
     } 
 
-    // Append ".gz\0" to the filepath.
-    filepath[fplen+0] = '.';
-    filepath[fplen+1] = 'g';
-    filepath[fplen+2] = 'z';
-    filepath[fplen+3] = '\0';
-
-    // Try opening <filepath>.gz first:
-    bool serve_gz = true;
-    int fd = open(filepath, O_RDONLY, 0);
-
-    filepath[fplen] = '\0'; // cut off ".gz" again.
+    char* const chunk = rest_context->scratch;
 
-    if(fd == -1) {
-        // <filepath>.gz not found. Try again with the original <filepath>.
-        serve_gz = false;
-        fd = open(filepath, O_RDONLY, 0);
-    }
+    const asset_t* const asset = asset_cache_get(filepath, chunk, SCRATCH_BUFSIZE);
 
-    if (fd == -1) {
+    if (asset == NULL) {
         ESP_LOGI(TAG, "File not found: \"%s\"",filepath);
+        if (uri_is_dir) {
+            // Redirecting to "/" would only bring the client back here.
+            return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "File not found");
+        }
         return redirectToRoot(req);
     }
 
-    if (!uri_is_dir) {
+    httpd_resp_set_hdr(req, "ETag", asset->etag);
+    if (asset->immutable) {
+        httpd_resp_set_hdr(req, "Cache-Control", "public, max-age=31536000, immutable");
+    } else if (uri_is_dir) {
+        // Always revalidate the entry page, so that a www update takes effect immediately.
+        httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    } else {
         httpd_resp_set_hdr(req, "Cache-Control", "max-age=2592000");
     }
 
-    if (serve_gz) {
+    if (client_has_etag(req, asset->etag, chunk, SCRATCH_BUFSIZE)) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        const esp_err_t r = httpd_resp_send(req, NULL, 0);
+        asset_cache_count_request(asset, true, 0, esp_timer_get_time() - startTime);
+        return r;
+    }
+
+    if (asset->gzip) {
         httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
     }
 
     set_content_type_from_file(req, filepath);
 
-    char* const chunk = rest_context->scratch;
+    esp_err_t r = ESP_OK;
+    size_t sent = 0;
 
-    ssize_t read_bytes;
-    esp_err_t r;
-    /* Read file in chunks into the scratch buffer */
-    /* Send the buffer contents as HTTP response chunk */
-    while(
-        ((read_bytes = read(fd, chunk, SCRATCH_BUFSIZE)) > 0) &&
-        ((r = httpd_resp_send_chunk(req, chunk, read_bytes)) == ESP_OK)) {
+    if (asset->data) {
+        r = httpd_resp_send(req, (const char*)asset->data, asset->size);
+        sent = asset->size;
+    } else {
+        if (asset->gzip) {
+            strlcpy(filepath + fplen, ".gz", sizeof(filepath) - fplen);
+        }
+        const int fd = open(filepath, O_RDONLY, 0);
+        filepath[fplen] = '\0';
+        if (fd == -1) {
+            ESP_LOGE(TAG, "Failed to open file : %s", filepath);
+            return httpd_resp_send_500(req);
+        }
 
-    }
+        ssize_t read_bytes;
+        /* Read file in chunks into the scratch buffer */
+        /* Send the buffer contents as HTTP response chunk */
+        while(
+            ((read_bytes = read(fd, chunk, SCRATCH_BUFSIZE)) > 0) &&
+            ((r = httpd_resp_send_chunk(req, chunk, read_bytes)) == ESP_OK)) {
+            sent += read_bytes;
+        }
 
-    /* Close file after sending complete */
-    close(fd);
+        /* Close file after sending complete */
+        close(fd);
 
-    if (read_bytes < 0) {
-        ESP_LOGE(TAG, "Failed to read file : %s", filepath);
-    }
+        if (read_bytes < 0) {
+            ESP_LOGE(TAG, "Failed to read file : %s", filepath);
+        }
 
-    if(r == ESP_OK) {
-        r =  httpd_resp_send_chunk(req, NULL, 0);
+        if(r == ESP_OK) {
+            r =  httpd_resp_send_chunk(req, NULL, 0);
+        }
     }
+
+    const int64_t duration = esp_timer_get_time() - startTime;
+    asset_cache_count_request(asset, false, sent, duration);
+    ESP_LOGD(TAG, "Served %s: %u bytes from %s in %" PRIi32 "us", filepath, (unsigned)sent,
+        asset->mapped ? "archive" : asset->data ? "PSRAM" : "SPIFFS", (int32_t)duration);
+
     return r;
 }
 
@@ -563,96 +660,112 @@ static esp_err_t PATCH_update_settings(httpd_req_t * req)
         return ESP_OK;
     }
 
+    // Write all settings at once, so listening tasks see only one modification.
+    nvs_config_txn_t * const txn = nvs_config_txn_begin();
+    bool statsFrequencyChanged = false;
+    uint16_t statsFrequency = 0;
+
     if (cJSON_IsString(item = cJSON_GetObjectItem(root, "stratumURL"))) {
-        nvs_config_set_string(NVS_CONFIG_STRATUM_URL, item->valuestring);
+        nvs_config_txn_set_string(txn, NVS_CONFIG_STRATUM_URL, item->valuestring);
     }
     if (cJSON_IsString(item = cJSON_GetObjectItem(root, "fallbackStratumURL"))) {
-        nvs_config_set_string(NVS_CONFIG_FALLBACK_STRATUM_URL, item->valuestring);
+        nvs_config_txn_set_string(txn, NVS_CONFIG_FALLBACK_STRATUM_URL, item->valuestring);
     }
     if ((item = cJSON_GetObjectItem(root, "stratumExtranonceSubscribe")) != NULL) {
-        nvs_config_set_u16(NVS_CONFIG_STRATUM_EXTRANONCE_SUBSCRIBE, item->valueint);
+        nvs_config_txn_set_u16(txn, NVS_CONFIG_STRATUM_EXTRANONCE_SUBSCRIBE, item->valueint);
     }
     if ((item = cJSON_GetObjectItem(root, "stratumSuggestedDifficulty")) != NULL) {
-        nvs_config_set_u16(NVS_CONFIG_STRATUM_DIFFICULTY, item->valueint);
+        nvs_config_txn_set_u16(txn, NVS_CONFIG_STRATUM_DIFFICULTY, item->valueint);
     }
     if (cJSON_IsString(item = cJSON_GetObjectItem(root, "stratumUser"))) {
-        nvs_config_set_string(NVS_CONFIG_STRATUM_USER, item->valuestring);
+        nvs_config_txn_set_string(txn, NVS_CONFIG_STRATUM_USER, item->valuestring);
     }
     if (cJSON_IsString(item = cJSON_GetObjectItem(root, "stratumPassword"))) {
-        nvs_config_set_string(NVS_CONFIG_STRATUM_PASS, item->valuestring);
+        nvs_config_txn_set_string(txn, NVS_CONFIG_STRATUM_PASS, item->valuestring);
     }
     if ((item = cJSON_GetObjectItem(root, "fallbackStratumExtranonceSubscribe")) != NULL) {
-        nvs_config_set_u16(NVS_CONFIG_FALLBACK_STRATUM_EXTRANONCE_SUBSCRIBE, item->valueint);
+        nvs_config_txn_set_u16(txn, NVS_CONFIG_FALLBACK_STRATUM_EXTRANONCE_SUBSCRIBE, item->valueint);
     }
     if ((item = cJSON_GetObjectItem(root, "fallbackStratumSuggestedDifficulty")) != NULL) {
-        nvs_config_set_u16(NVS_CONFIG_FALLBACK_STRATUM_DIFFICULTY, item->valueint);
+        nvs_config_txn_set_u16(txn, NVS_CONFIG_FALLBACK_STRATUM_DIFFICULTY, item->valueint);
     }
     if (cJSON_IsString(item = cJSON_GetObjectItem(root, "fallbackStratumUser"))) {
-        nvs_config_set_string(NVS_CONFIG_FALLBACK_STRATUM_USER, item->valuestring);
+        nvs_config_txn_set_string(txn, NVS_CONFIG_FALLBACK_STRATUM_USER, item->valuestring);
     }
     if (cJSON_IsString(item = cJSON_GetObjectItem(root, "fallbackStratumPassword"))) {
-        nvs_config_set_string(NVS_CONFIG_FALLBACK_STRATUM_PASS, item->valuestring);
+        nvs_config_txn_set_string(txn, NVS_CONFIG_FALLBACK_STRATUM_PASS, item->valuestring);
     }
     if ((item = cJSON_GetObjectItem(root, "stratumPort")) != NULL) {
-        nvs_config_set_u16(NVS_CONFIG_STRATUM_PORT, item->valueint);
+        nvs_config_txn_set_u16(txn, NVS_CONFIG_STRATUM_PORT, item->valueint);
     }
     if ((item = cJSON_GetObjectItem(root, "fallbackStratumPort")) != NULL) {
-        nvs_config_set_u16(NVS_CONFIG_FALLBACK_STRATUM_PORT, item->valueint);
+        nvs_config_txn_set_u16(txn, NVS_CONFIG_FALLBACK_STRATUM_PORT, item->valueint);
     }
     if (cJSON_IsString(item = cJSON_GetObjectItem(root, "ssid"))) {
-        nvs_config_set_string(NVS_CONFIG_WIFI_SSID, item->valuestring);
+        nvs_config_txn_set_string(txn, NVS_CONFIG_WIFI_SSID, item->valuestring);
     }
     if (cJSON_IsString(item = cJSON_GetObjectItem(root, "wifiPass"))) {
-        nvs_config_set_string(NVS_CONFIG_WIFI_PASS, item->valuestring);
+        nvs_config_txn_set_string(txn, NVS_CONFIG_WIFI_PASS, item->valuestring);
     }
     if (cJSON_IsString(item = cJSON_GetObjectItem(root, "hostname"))) {
-        nvs_config_set_string(NVS_CONFIG_HOSTNAME, item->valuestring);
+        nvs_config_txn_set_string(txn, NVS_CONFIG_HOSTNAME, item->valuestring);
     }
     if ((item = cJSON_GetObjectItem(root, "coreVoltage")) != NULL && item->valueint > 0) {
-        nvs_config_set_u16(NVS_CONFIG_ASIC_VOLTAGE, item->valueint);
+        nvs_config_txn_set_u16(txn, NVS_CONFIG_ASIC_VOLTAGE, item->valueint);
     }
     if ((item = cJSON_GetObjectItem(root, "frequency")) != NULL && item->valuedouble > 0) {
         float frequency = item->valuedouble;
-        nvs_config_set_float(NVS_CONFIG_ASIC_FREQUENCY_FLOAT, frequency);
+        nvs_config_txn_set_float(txn, NVS_CONFIG_ASIC_FREQUENCY_FLOAT, frequency);
         // also store as u16 for backwards compatibility
-        nvs_config_set_u16(NVS_CONFIG_ASIC_FREQUENCY, (int) frequency);
+        nvs_config_txn_set_u16(txn, NVS_CONFIG_ASIC_FREQUENCY, (int) frequency);
     }
     if ((item = cJSON_GetObjectItem(root, "overheat_mode")) != NULL) {
-        nvs_config_set_u16(NVS_CONFIG_OVERHEAT_MODE, 0);
+        nvs_config_txn_set_u16(txn, NVS_CONFIG_OVERHEAT_MODE, 0);
     }
     if (cJSON_IsString(item = cJSON_GetObjectItem(root, "display"))) {
-        nvs_config_set_string(NVS_CONFIG_DISPLAY, item->valuestring);
+        nvs_config_txn_set_string(txn, NVS_CONFIG_DISPLAY, item->valuestring);
     }
     if ((item = cJSON_GetObjectItem(root, "rotation")) != NULL) {
-        nvs_config_set_u16(NVS_CONFIG_ROTATION, item->valueint);
+        nvs_config_txn_set_u16(txn, NVS_CONFIG_ROTATION, item->valueint);
     }
     if ((item = cJSON_GetObjectItem(root, "invertscreen")) != NULL) {
-        nvs_config_set_u16(NVS_CONFIG_INVERT_SCREEN, item->valueint);
+        nvs_config_txn_set_u16(txn, NVS_CONFIG_INVERT_SCREEN, item->valueint);
     }
     if ((item = cJSON_GetObjectItem(root, "displayTimeout")) != NULL) {
-        nvs_config_set_i32(NVS_CONFIG_DISPLAY_TIMEOUT, item->valueint);
+        nvs_config_txn_set_i32(txn, NVS_CONFIG_DISPLAY_TIMEOUT, item->valueint);
     }
     if ((item = cJSON_GetObjectItem(root, "autofanspeed")) != NULL) {
-        nvs_config_set_u16(NVS_CONFIG_AUTO_FAN_SPEED, item->valueint);
+        nvs_config_txn_set_u16(txn, NVS_CONFIG_AUTO_FAN_SPEED, item->valueint);
     }
     if ((item = cJSON_GetObjectItem(root, "fanspeed")) != NULL) {
-        nvs_config_set_u16(NVS_CONFIG_FAN_SPEED, item->valueint);
+        nvs_config_txn_set_u16(txn, NVS_CONFIG_FAN_SPEED, item->valueint);
     }
     if ((item = cJSON_GetObjectItem(root, "minFanSpeed")) != NULL) {
-        nvs_config_set_u16(NVS_CONFIG_MIN_FAN_SPEED, item->valueint);
+        nvs_config_txn_set_u16(txn, NVS_CONFIG_MIN_FAN_SPEED, item->valueint);
     }
     if ((item = cJSON_GetObjectItem(root, "temptarget")) != NULL) {
-        nvs_config_set_u16(NVS_CONFIG_TEMP_TARGET, item->valueint);
+        nvs_config_txn_set_u16(txn, NVS_CONFIG_TEMP_TARGET, item->valueint);
     }
     if ((item = cJSON_GetObjectItem(root, "statsFrequency")) != NULL) {
-        nvs_config_set_u16(NVS_CONFIG_STATISTICS_FREQUENCY, item->valueint);
-        statistics_set_collection_interval(item->valueint);
+        nvs_config_txn_set_u16(txn, NVS_CONFIG_STATISTICS_FREQUENCY, item->valueint);
+        statsFrequency = item->valueint;
+        statsFrequencyChanged = true;
     }
     if ((item = cJSON_GetObjectItem(root, "overclockEnabled")) != NULL) {
-        nvs_config_set_u16(NVS_CONFIG_OVERCLOCK_ENABLED, item->valueint);
+        nvs_config_txn_set_u16(txn, NVS_CONFIG_OVERCLOCK_ENABLED, item->valueint);
     }
 
     cJSON_Delete(root);
+
+    if (nvs_config_txn_commit(txn) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to save settings");
+        return ESP_OK;
+    }
+
+    if (statsFrequencyChanged) {
+        statistics_set_collection_interval(statsFrequency);
+    }
+
     httpd_resp_send_chunk(req, NULL, 0);
     return ESP_OK;
 }
@@ -692,6 +805,7 @@ static void sendHeapInfo(http_writer_t* const w, const char* const heapName, con
     const size_t size = heap_caps_get_total_size(caps);
     const size_t unused = heap_caps_get_free_size(caps);
     const size_t minUnused = heap_caps_get_minimum_free_size(caps);
+    const size_t largestBlock = heap_caps_get_largest_free_block(caps);
 
     http_json_start_obj(w,NULL);
 
@@ -700,6 +814,7 @@ static void sendHeapInfo(http_writer_t* const w, const char* const heapName, con
         http_json_write_item(w, "size", size);
         http_json_write_item(w, "free", unused);
         http_json_write_item(w, "minFree", minUnused);
+        http_json_write_item(w, "largestFreeBlock", largestBlock);
         http_json_write_item(w, "used", size-unused);
         http_json_write_item(w, "usedPercent", (100*(size-unused))/size);
 
@@ -722,12 +837,78 @@ static void http_json_write_nvss(http_writer_t* const w, const char* const name,
     free(str);
 }
 
-static esp_err_t GET_system_info_dash(httpd_req_t* const req) {
+// More pools than the firmware creates are simply not reported.
+#define MAX_REPORTED_POOLS 8
+
+/**
+ * @brief GET /api/system/memory
+ *
+ * Free memory per heap and the figures of all registered object pools, see
+ * mempool_registry_get().
+ */
+static esp_err_t GET_system_memory(httpd_req_t* const req) {
     if (is_network_allowed(req) != ESP_OK) {
         return httpd_resp_send_err(req, HTTPD_401_UNAUTHORIZED, "Unauthorized");
     }
 
-    httpd_resp_set_type(req, "application/json");
+    // Set CORS headers
+    if (set_cors_headers(req) != ESP_OK) {
+        httpd_resp_send_500(req);
+        return ESP_OK;
+    }
+
+    mempool_info_t pools[MAX_REPORTED_POOLS];
+    const size_t poolCnt = mempool_registry_get(pools, MAX_REPORTED_POOLS);
+
+    http_writer_t wrtr;
+    http_writer_t* const w = &wrtr;
+    http_json_init(w,req);
+
+    http_json_start_obj(w,NULL);
+
+    http_json_start_arr(w, "heaps");
+
+    sendHeapInfo(w, "internal", MALLOC_CAP_INTERNAL);
+
+    if(GLOBAL_STATE.psram_is_available)
+    {
+        sendHeapInfo(w, "psram", MALLOC_CAP_SPIRAM);
+    }
+
+    sendHeapInfo(w, "dma", MALLOC_CAP_DMA);
+
+    http_json_end_arr(w);
+
+    http_json_start_arr(w, "pools");
+
+    for(size_t i = 0; i < poolCnt; ++i) {
+        const mempool_info_t* const p = &pools[i];
+        http_json_start_obj(w,NULL);
+
+            http_json_write_item(w, "name", p->name);
+            http_json_write_item(w, "objSize", p->objSize);
+            http_json_write_item(w, "allocated", p->stats.allocCnt);
+            http_json_write_item(w, "inUse", p->stats.inUseCnt);
+            http_json_write_item(w, "maxInUse", p->stats.maxInUseCnt);
+            http_json_write_item(w, "chunks", p->chunkCnt);
+            http_json_write_item(w, "growEvents", p->growCnt);
+            http_json_write_item(w, "trimmed", p->trimmedCnt);
+            http_json_write_item(w, "casRetries", p->casRetries);
+
+        http_json_end_obj(w);
+    }
+
+    http_json_end_arr(w);
+
+    http_json_end_obj(w);
+
+    return http_writer_finish(w);
+}
+
+static esp_err_t GET_system_info_dash(httpd_req_t* const req) {
+    if (is_network_allowed(req) != ESP_OK) {
+        return httpd_resp_send_err(req, HTTPD_401_UNAUTHORIZED, "Unauthorized");
+    }
 
     // Set CORS headers
     if (set_cors_headers(req) != ESP_OK) {
@@ -737,7 +918,7 @@ static esp_err_t GET_system_info_dash(httpd_req_t* const req) {
 
     http_writer_t wrtr;
     http_writer_t* const w = &wrtr;
-    http_writer_init(w,req);
+    http_json_init(w,req);
 
     http_json_start_obj(w,NULL);
     
@@ -775,21 +956,9 @@ static esp_err_t GET_system_info_dash(httpd_req_t* const req) {
     return http_writer_finish(w);
 }
 
-/* Simple handler for getting system handler */
-static esp_err_t GET_system_info(httpd_req_t * req)
+/* Renders the system info into w */
+static void render_system_info(http_writer_t* const w)
 {
-    if (is_network_allowed(req) != ESP_OK) {
-        return httpd_resp_send_err(req, HTTPD_401_UNAUTHORIZED, "Unauthorized");
-    }
-
-    httpd_resp_set_type(req, "application/json");
-
-    // Set CORS headers
-    if (set_cors_headers(req) != ESP_OK) {
-        httpd_resp_send_500(req);
-        return ESP_OK;
-    }
-
     // char * ssid = nvs_config_get_string(NVS_CONFIG_WIFI_SSID, CONFIG_ESP_WIFI_SSID);
     // char * hostname = nvs_config_get_string(NVS_CONFIG_HOSTNAME, CONFIG_LWIP_LOCAL_HOSTNAME);
     // char * stratumURL = nvs_config_get_string(NVS_CONFIG_STRATUM_URL, CONFIG_STRATUM_URL);
@@ -808,10 +977,6 @@ static esp_err_t GET_system_info(httpd_req_t * req)
     int8_t wifi_rssi = -128;
     get_wifi_current_rssi(&wifi_rssi);
 
-    http_writer_t wrtr;
-    http_writer_t* const w = &wrtr;
-    http_writer_init(w,req);
-
     http_json_start_obj(w,NULL);
 
     http_json_write_item(w, "power", GLOBAL_STATE.POWER_MANAGEMENT_MODULE.power);
@@ -908,100 +1073,233 @@ static esp_err_t GET_system_info(httpd_req_t * req)
     
     http_json_end_obj(w);
     http_writer_finish(w);
+}
 
-    return w->result;
+/*
+    The system info is rendered at most once per version, for all clients, and
+    clients which already have the current version get a 304.
+    The version changes with the config and whenever the power management task
+    took a new sample or a share was submitted, so values which are only
+    sampled while rendering (uptime, RSSI, free heap) are at most one sample
+    period (~2s) old.
+    Only the httpd task accesses the cache, so no locking is needed.
+*/
+typedef struct system_info_cache {
+    char etag[32];
+    uint8_t* body;
+    size_t len;
+} system_info_cache_t;
+
+// One entry each for JSON and CBOR.
+static system_info_cache_t systemInfoCache[2];
+static system_info_stats_t systemInfoStats;
+
+static void get_system_info_etag(char* const etag, const size_t size, const bool cbor)
+{
+    const uint32_t liveSeq = GLOBAL_STATE.POWER_MANAGEMENT_MODULE.sample_count +
+                             (uint32_t)GLOBAL_STATE.SYSTEM_MODULE.shares_accepted +
+                             (uint32_t)GLOBAL_STATE.SYSTEM_MODULE.shares_rejected;
+    snprintf(etag, size, "\"%" PRIx32 "-%" PRIx32 "-%c\"", nvs_config_get_modcount(), liveSeq, cbor ? 'c' : 'j');
+}
+
+void http_server_get_system_info_stats(system_info_stats_t* const stats)
+{
+    *stats = systemInfoStats;
 }
 
-static int create_json_statistics_dashboard(cJSON * root)
+/* Simple handler for getting system handler */
+static esp_err_t GET_system_info(httpd_req_t * req)
 {
-    int prebuffer = 0;
+    if (is_network_allowed(req) != ESP_OK) {
+        return httpd_resp_send_err(req, HTTPD_401_UNAUTHORIZED, "Unauthorized");
+    }
+
+    // Set CORS headers
+    if (set_cors_headers(req) != ESP_OK) {
+        httpd_resp_send_500(req);
+        return ESP_OK;
+    }
 
-    if (root) {
-        // create array for dashboard statistics
-        cJSON * statsArray = cJSON_AddArrayToObject(root, "statistics");
+    const int64_t startTime = esp_timer_get_time();
 
-        struct StatisticsData statsData;
-        // StatisticsNodePtr node = NULL;// *GLOBAL_STATE.STATISTICS_MODULE.statisticsList; // double pointer
+    const bool cbor = http_json_accepts_cbor(req);
+    system_info_cache_t* const cache = &systemInfoCache[cbor ? 1 : 0];
 
-        if(statisticDataNext(NULL,&statsData)) {
-            do {
-                cJSON *valueArray = cJSON_CreateArray();
-                cJSON_AddItemToArray(valueArray, cJSON_CreateNumber(statsData.hashrate_MHz * 0.001f));
-                cJSON_AddItemToArray(valueArray, cJSON_CreateNumber(statsData.chipTemperature));
-                cJSON_AddItemToArray(valueArray, cJSON_CreateNumber(statsData.power));
-                cJSON_AddItemToArray(valueArray, cJSON_CreateNumber(statsData.timestamp));
+    char etag[sizeof(cache->etag)];
+    get_system_info_etag(etag, sizeof(etag), cbor);
 
-                cJSON_AddItemToArray(statsArray, valueArray);
-                prebuffer++;
-            } while(statisticDataNext(&statsData,&statsData));
+    http_json_set_type(req, cbor);
+    httpd_resp_set_hdr(req, "ETag", etag);
+    // Clients may keep the response, but must check if it's still current.
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
 
+    char inm[64];
+    if (client_has_etag(req, etag, inm, sizeof(inm))) {
+        systemInfoStats.notModified += 1;
+        httpd_resp_set_status(req, "304 Not Modified");
+        const esp_err_t r = httpd_resp_send(req, NULL, 0);
+        systemInfoStats.handlerTimeUs += esp_timer_get_time() - startTime;
+        return r;
+    }
+
+    if (cache->body != NULL && strcmp(cache->etag, etag) == 0) {
+        systemInfoStats.cacheHits += 1;
+    } else {
+        http_writer_t wrtr;
+        http_writer_t* const w = &wrtr;
+        http_json_init_mem(w, cbor);
+        render_system_info(w);
+
+        free(cache->body);
+        cache->body = NULL;
+        cache->etag[0] = '\0';
+
+        if (w->result != ESP_OK) {
+            free(w->mem);
+            httpd_resp_send_500(req);
+            return ESP_OK;
         }
-        // struct StatisticsData statsData;
-        // StatisticsNodePtr node = statisticData(NULL,&statsData)
-        // if (NULL != GLOBAL_STATE.STATISTICS_MODULE.statisticsList) {
-        //     StatisticsNodePtr node = *GLOBAL_STATE.STATISTICS_MODULE.statisticsList; // double pointer
 
+        cache->body = w->mem;
+        cache->len = w->sent;
+        strlcpy(cache->etag, etag, sizeof(cache->etag));
+        systemInfoStats.renders += 1;
+    }
 
-        //     while (NULL != node) {
-        //         node = statisticData(node, &statsData);
+    const esp_err_t r = httpd_resp_send(req, (const char*)cache->body, cache->len);
 
-        //         cJSON *valueArray = cJSON_CreateArray();
-        //         cJSON_AddItemToArray(valueArray, cJSON_CreateNumber(statsData.hashrate));
-        //         cJSON_AddItemToArray(valueArray, cJSON_CreateNumber(statsData.chipTemperature));
-        //         cJSON_AddItemToArray(valueArray, cJSON_CreateNumber(statsData.power));
-        //         cJSON_AddItemToArray(valueArray, cJSON_CreateNumber(statsData.timestamp));
+    const int64_t duration = esp_timer_get_time() - startTime;
+    systemInfoStats.handlerTimeUs += duration;
+    ESP_LOGD(TAG, "system/info: %u bytes in %" PRIi32 "us",
+        (unsigned)cache->len,
+        (int32_t)duration);
 
-        //         cJSON_AddItemToArray(statsArray, valueArray);
-        //         prebuffer++;
-        //     }
-        // }
+    return r;
+}
+
+// Number of samples copied out of the stats history per lock acquisition.
+#define STATS_BATCH_SIZE 16
 
+/**
+ * @brief Writes the "statistics" array, i.e. all samples newer than \p since,
+ * restricted to \p fields.
+ * 
+ * @return the number of samples written
+ */
+static size_t writeStatsArray(http_writer_t* const w, const uint32_t since, const uint32_t fields) {
+
+    http_json_start_arr(w,"statistics");
+
+    size_t sampleCnt = 0;
+    {
+        struct StatisticsData batch[STATS_BATCH_SIZE];
+        StatisticsCursor_t cursor;
+        statistics_cursor_init(&cursor,since);
+
+        size_t cnt;
+        while(w->result == ESP_OK && (cnt = statisticDataGetBatch(&cursor,batch,STATS_BATCH_SIZE)) != 0) {
+            for(size_t i = 0; i < cnt && w->result == ESP_OK; ++i) {
+                http_json_write_stats_fields(w,&batch[i],fields);
+            }
+            sampleCnt += cnt;
+        }
     }
 
-    return prebuffer;
+    http_json_end_arr(w);
+
+    return sampleCnt;
+}
+
+static void logStatsResponse(const char* const name, const http_writer_t* const w, const size_t sampleCnt, const int64_t startTime) {
+    ESP_LOGD(TAG, "%s: %u samples, %u bytes in %" PRIi32 "us",
+        name,
+        (unsigned)sampleCnt,
+        (unsigned)w->sent,
+        (int32_t)(esp_timer_get_time() - startTime));
+}
+
+static statistics_api_stats_t statisticsApiStats;
+
+void http_server_get_statistics_stats(statistics_api_stats_t* const stats)
+{
+    *stats = statisticsApiStats;
 }
 
-static const char LABELS[] = ",\"labels\":[\"hashRate\",\"temp\",\"vrTemp\",\"power\",\"voltage\",\"current\",\"coreVoltageActual\",\"fanspeed\",\"fanrpm\",\"wifiRSSI\",\"freeHeap\",\"timestamp\"]";
+static esp_err_t sendStats(httpd_req_t* const req, const uint32_t since, const uint32_t fields) {
 
-static esp_err_t sendStats(httpd_req_t* const req) {
+    const int64_t startTime = esp_timer_get_time();
 
     http_writer_t wrtr;
     http_writer_t* const w = &wrtr;    
-    http_writer_init(w,req);
+    http_json_init(w,req);
 
     http_json_start_obj(w,NULL);
 
-    http_json_write_item(w,"currentTimestamp", (esp_timer_get_time() / (1000*100)));
-
-    http_writer_write_data(w,LABELS,sizeof(LABELS)-1);
+    http_json_write_item(w,"currentTimestamp", statistics_get_timestamp());
+    http_json_write_item(w,"bootId", statistics_get_boot_id());
 
-    http_json_start_arr(w,"statistics");
+    http_json_write_stats_labels(w,fields);
 
-    {
-        struct StatisticsData statsData;
-        bool more = statisticDataNext(NULL,&statsData);
-        while(more) {
-            more = (http_json_write_stats(w,&statsData) == ESP_OK);
-            more = more && statisticDataNext(&statsData,&statsData); 
-        }
-    }
+    const size_t sampleCnt = writeStatsArray(w,since,fields);
 
-    http_json_end_arr(w);
     http_json_end_obj(w);
 
     http_writer_finish(w);
+
+    const uint32_t duration = esp_timer_get_time() - startTime;
+    statisticsApiStats.requests += 1;
+    statisticsApiStats.samples += sampleCnt;
+    statisticsApiStats.bytes += w->sent;
+    statisticsApiStats.handlerTimeUs += duration;
+    if (since == 0) {
+        statisticsApiStats.fullSamples = sampleCnt;
+        statisticsApiStats.fullBytes = w->sent;
+        statisticsApiStats.fullTimeUs = duration;
+    }
+
+    logStatsResponse("statistics", w, sampleCnt, startTime);
     
     return w->result;
 
 }
 
+/**
+ * @brief GET /api/system/statistics[?since=<timestamp>&boot=<bootId>][&fields=<label>,<label>,...]
+ * 
+ * \c since only returns samples with a timestamp (100ms units, as in "currentTimestamp")
+ * greater than the given value. If \c boot is given and is not the current "bootId",
+ * the device rebooted since and \c since is ignored. \c fields restricts the output
+ * to the given columns, using the names from "labels".
+ */
 static esp_err_t GET_system_statistics(httpd_req_t * req)
 {
     if (is_network_allowed(req) != ESP_OK) {
         return httpd_resp_send_err(req, HTTPD_401_UNAUTHORIZED, "Unauthorized");
     }
 
-    httpd_resp_set_type(req, "application/json");
+    uint32_t since = 0;
+    uint32_t fields = STATS_FIELDS_ALL;
+
+    {
+        char query[160];
+        if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+            char value[128];
+            if (httpd_query_key_value(query, "since", value, sizeof(value)) == ESP_OK) {
+                since = strtoul(value, NULL, 10);
+            }
+            if (httpd_query_key_value(query, "boot", value, sizeof(value)) == ESP_OK &&
+                strtoul(value, NULL, 10) != statistics_get_boot_id()) {
+                // Timestamps of an earlier boot; send everything.
+                since = 0;
+            }
+            if (httpd_query_key_value(query, "fields", value, sizeof(value)) == ESP_OK) {
+                fields = http_json_parse_stats_fields(value);
+                if (fields == 0) {
+                    return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid fields");
+                }
+            }
+        }
+    }
 
     // Set CORS headers
     if (set_cors_headers(req) != ESP_OK) {
@@ -1009,7 +1307,7 @@ static esp_err_t GET_system_statistics(httpd_req_t * req)
         return ESP_OK;
     }
 
-    return sendStats(req);
+    return sendStats(req, since, fields);
 }
 
 static esp_err_t GET_system_statistics_dashboard(httpd_req_t * req)
@@ -1018,27 +1316,75 @@ static esp_err_t GET_system_statistics_dashboard(httpd_req_t * req)
         return httpd_resp_send_err(req, HTTPD_401_UNAUTHORIZED, "Unauthorized");
     }
 
-    httpd_resp_set_type(req, "application/json");
-
     // Set CORS headers
     if (set_cors_headers(req) != ESP_OK) {
         httpd_resp_send_500(req);
         return ESP_OK;
     }
 
-    cJSON * root = cJSON_CreateObject();
-    cJSON_AddNumberToObject(root, "currentTimestamp", (esp_timer_get_time() / 1000));
-    int prebuffer = 1;
+    const int64_t startTime = esp_timer_get_time();
 
-    prebuffer += create_json_statistics_dashboard(root);
+    http_writer_t wrtr;
+    http_writer_t* const w = &wrtr;
+    http_json_init(w,req);
 
-    const char * response = cJSON_PrintBuffered(root, (JSON_DASHBOARD_STATS_ELEMENT_SIZE * prebuffer), 0); // unformatted
-    httpd_resp_sendstr(req, response);
-    free((void *)response);
+    http_json_start_obj(w,NULL);
 
-    cJSON_Delete(root);
+    http_json_write_item(w,"currentTimestamp", (uint64_t)statistics_get_timestamp() * 100);
 
-    return ESP_OK;
+    const size_t sampleCnt = writeStatsArray(w, 0, DASHBOARD_STATS_FIELDS);
+
+    http_json_end_obj(w);
+
+    http_writer_finish(w);
+
+    logStatsResponse("statistics/dashboard", w, sampleCnt, startTime);
+
+    return w->result;
+}
+
+static esp_err_t www_write(void * ctx, const void * data, size_t len)
+{
+    return www_update_write((www_update_t *) ctx, data, len);
+}
+
+static esp_err_t ota_write(void * ctx, const void * data, size_t len)
+{
+    return esp_ota_write(*(esp_ota_handle_t *) ctx, data, len);
+}
+
+static void update_progress(size_t received, size_t total)
+{
+    uint8_t percentage = total ? (received * 100 / total) : 100;
+    snprintf(GLOBAL_STATE.SYSTEM_MODULE.firmware_update_status, 20, "Working (%d%%)", percentage);
+}
+
+static void send_upload_error(httpd_req_t * req, const upload_result_t * result)
+{
+    if (result->writeFailed) {
+        snprintf(GLOBAL_STATE.SYSTEM_MODULE.firmware_update_status, 20, "Write Error");
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Write Error");
+    } else {
+        snprintf(GLOBAL_STATE.SYSTEM_MODULE.firmware_update_status, 20, "Protocol Error");
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Protocol Error");
+    }
+}
+
+static void log_upload_result(const char * name, const upload_result_t * result)
+{
+    const uint32_t ms = (uint32_t)(result->durationUs / 1000);
+    ESP_LOGI(TAG, "%s: %u bytes in %" PRIu32 " ms (%" PRIu32 " KiB/s), %" PRIu32 " ms writing flash",
+        name,
+        (unsigned)result->received,
+        ms,
+        ms ? (uint32_t)(result->received / ms * 1000 / 1024) : 0,
+        (uint32_t)(result->writeTimeUs / 1000));
+
+    char hex[UPLOAD_SHA256_SIZE * 2 + 1];
+    for (int i = 0; i < UPLOAD_SHA256_SIZE; i++) {
+        snprintf(hex + i * 2, 3, "%02x", result->sha256[i]);
+    }
+    ESP_LOGI(TAG, "%s: SHA-256 %s", name, hex);
 }
 
 esp_err_t POST_WWW_update(httpd_req_t * req)
@@ -1055,59 +1401,82 @@ esp_err_t POST_WWW_update(httpd_req_t * req)
         return ESP_OK;
     }
 
+    uint8_t expectedSha256[UPLOAD_SHA256_SIZE];
+    bool hasSha256;
+    if (upload_get_expected_sha256(req, expectedSha256, &hasSha256) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid " UPLOAD_SHA256_HEADER " header");
+        return ESP_OK;
+    }
+
     GLOBAL_STATE.SYSTEM_MODULE.is_firmware_update = true;
     snprintf(GLOBAL_STATE.SYSTEM_MODULE.firmware_update_filename, 20, "www.bin");
     snprintf(GLOBAL_STATE.SYSTEM_MODULE.firmware_update_status, 20, "Starting...");
 
-    char buf[1000];
     int remaining = req->content_len;
 
-    const esp_partition_t * www_partition =
-        esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, "www");
-    if (www_partition == NULL) {
+    // Files are about to change under the cache and the mapping. Every path
+    // from here on goes through 'done', which mounts whatever the partition
+    // then holds and ends the update.
+    release_fs();
+
+    bool committed = false;
+
+    www_update_t update;
+    const esp_err_t err = www_update_begin(&update, remaining);
+    if (err == ESP_ERR_NOT_FOUND) {
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "WWW partition not found");
-        return ESP_OK;
+        goto done;
     }
 
     // Don't attempt to write more than what can be stored in the partition
-    if (remaining > www_partition->size) {
+    if (err == ESP_ERR_INVALID_SIZE) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "File provided is too large for device");
-        return ESP_OK;
+        goto done;
     }
 
-    // Erase the entire www partition before writing
-    ESP_ERROR_CHECK(esp_partition_erase_range(www_partition, 0, www_partition->size));
-
-    while (remaining > 0) {
-        int recv_len = httpd_req_recv(req, buf, MIN(remaining, sizeof(buf)));
-
-        if (recv_len == HTTPD_SOCK_ERR_TIMEOUT) {
-            continue;
-        } else if (recv_len <= 0) {
-            snprintf(GLOBAL_STATE.SYSTEM_MODULE.firmware_update_status, 20, "Protocol Error");
-            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Protocol Error");
-            return ESP_OK;
-        }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to erase the www partition (%s)", esp_err_to_name(err));
+        snprintf(GLOBAL_STATE.SYSTEM_MODULE.firmware_update_status, 20, "Erase Error");
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Erase Error");
+        goto done;
+    }
 
-        if (esp_partition_write(www_partition, www_partition->size - remaining, (const void *) buf, recv_len) != ESP_OK) {
-            snprintf(GLOBAL_STATE.SYSTEM_MODULE.firmware_update_status, 20, "Write Error");
-            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Write Error");
-            return ESP_OK;
-        }
+    upload_result_t result;
+    if (upload_receive(req, www_write, &update, update_progress, &result) != ESP_OK) {
+        send_upload_error(req, &result);
+        goto done;
+    }
 
+    log_upload_result("WWW update", &result);
 
-        uint8_t percentage = 100 - ((remaining * 100 / req->content_len));
-        snprintf(GLOBAL_STATE.SYSTEM_MODULE.firmware_update_status, 20, "Working (%d%%)", percentage);
+    // The new image is only activated by www_update_end().
+    if (hasSha256 && memcmp(result.sha256, expectedSha256, UPLOAD_SHA256_SIZE) != 0) {
+        snprintf(GLOBAL_STATE.SYSTEM_MODULE.firmware_update_status, 20, "Checksum Error");
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "SHA-256 mismatch");
+        goto done;
+    }
 
-        remaining -= recv_len;
+    if (www_update_end(&update) != ESP_OK) {
+        snprintf(GLOBAL_STATE.SYSTEM_MODULE.firmware_update_status, 20, "Validation Error");
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid www image");
+        goto done;
     }
 
-    httpd_resp_sendstr(req, "WWW update complete\n");
+    committed = true;
 
-    readAxeOSVersion();
+done:
+    if (init_fs() != ESP_OK) {
+        ESP_LOGE(TAG, "No web UI to serve after the www update.");
+        if (committed) {
+            snprintf(GLOBAL_STATE.SYSTEM_MODULE.firmware_update_status, 20, "Mount Error");
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to load www image");
+        }
+    } else if (committed) {
+        httpd_resp_sendstr(req, "WWW update complete\n");
+        snprintf(GLOBAL_STATE.SYSTEM_MODULE.firmware_update_status, 20, "Finished...");
+        vTaskDelay(1000 / portTICK_PERIOD_MS);
+    }
 
-    snprintf(GLOBAL_STATE.SYSTEM_MODULE.firmware_update_status, 20, "Finished...");
-    vTaskDelay(1000 / portTICK_PERIOD_MS);
     GLOBAL_STATE.SYSTEM_MODULE.is_firmware_update = false;
 
     return ESP_OK;
@@ -1130,44 +1499,36 @@ esp_err_t POST_OTA_update(httpd_req_t * req)
         return ESP_OK;
     }
     
+    uint8_t expectedSha256[UPLOAD_SHA256_SIZE];
+    bool hasSha256;
+    if (upload_get_expected_sha256(req, expectedSha256, &hasSha256) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid " UPLOAD_SHA256_HEADER " header");
+        return ESP_OK;
+    }
+
     GLOBAL_STATE.SYSTEM_MODULE.is_firmware_update = true;
     snprintf(GLOBAL_STATE.SYSTEM_MODULE.firmware_update_filename, 20, "esp-miner.bin");
     snprintf(GLOBAL_STATE.SYSTEM_MODULE.firmware_update_status, 20, "Starting...");
 
-    char buf[1000];
     esp_ota_handle_t ota_handle;
-    int remaining = req->content_len;
 
     const esp_partition_t * ota_partition = esp_ota_get_next_update_partition(NULL);
     ESP_ERROR_CHECK(esp_ota_begin(ota_partition, OTA_SIZE_UNKNOWN, &ota_handle));
 
-    while (remaining > 0) {
-        int recv_len = httpd_req_recv(req, buf, MIN(remaining, sizeof(buf)));
-
-        // Timeout Error: Just retry
-        if (recv_len == HTTPD_SOCK_ERR_TIMEOUT) {
-            continue;
-
-            // Serious Error: Abort OTA
-        } else if (recv_len <= 0) {
-            snprintf(GLOBAL_STATE.SYSTEM_MODULE.firmware_update_status, 20, "Protocol Error");
-            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Protocol Error");
-            return ESP_OK;
-        }
-
-        // Successful Upload: Flash firmware chunk
-        if (esp_ota_write(ota_handle, (const void *) buf, recv_len) != ESP_OK) {
-            esp_ota_abort(ota_handle);
-            snprintf(GLOBAL_STATE.SYSTEM_MODULE.firmware_update_status, 20, "Write Error");
-            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Write Error");
-            return ESP_OK;
-        }
-
-        uint8_t percentage = 100 - ((remaining * 100 / req->content_len));
+    upload_result_t result;
+    if (upload_receive(req, ota_write, &ota_handle, update_progress, &result) != ESP_OK) {
+        esp_ota_abort(ota_handle);
+        send_upload_error(req, &result);
+        return ESP_OK;
+    }
 
-        snprintf(GLOBAL_STATE.SYSTEM_MODULE.firmware_update_status, 20, "Working (%d%%)", percentage);
+    log_upload_result("Firmware update", &result);
 
-        remaining -= recv_len;
+    if (hasSha256 && memcmp(result.sha256, expectedSha256, UPLOAD_SHA256_SIZE) != 0) {
+        esp_ota_abort(ota_handle);
+        snprintf(GLOBAL_STATE.SYSTEM_MODULE.firmware_update_status, 20, "Checksum Error");
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "SHA-256 mismatch");
+        return ESP_OK;
     }
 
     // Validate and switch to new OTA image and reboot
@@ -1220,7 +1581,7 @@ esp_err_t start_rest_server(void)
         config.uri_match_fn = httpd_uri_match_wildcard;
         config.stack_size = 8192;
         config.max_open_sockets = 20;
-        config.max_uri_handlers = 20;
+        config.max_uri_handlers = 24;
         config.close_fn = websocket_close_fn;
         config.lru_purge_enable = true;
 
@@ -1271,6 +1632,16 @@ esp_err_t start_rest_server(void)
         };
         httpd_register_uri_handler(server, &system_asic_get_uri);
     }
+    {
+        /* URI handler for fetching heap and object pool figures */
+        const httpd_uri_t system_memory_get_uri = {
+            .uri = "/api/system/memory",
+            .method = HTTP_GET,
+            .handler = GET_system_memory,
+            .user_ctx = rest_context
+        };
+        httpd_register_uri_handler(server, &system_memory_get_uri);
+    }
     {
         /* URI handler for fetching system statistic values */
         const httpd_uri_t system_statistics_get_uri = {
@@ -1292,6 +1663,16 @@ esp_err_t start_rest_server(void)
         httpd_register_uri_handler(server, &system_statistics_dashboard_get_uri);
     }
 
+    {
+        const httpd_uri_t metrics_get_uri = {
+            .uri = "/metrics",
+            .method = HTTP_GET,
+            .handler = GET_metrics,
+            .user_ctx = rest_context
+        };
+        httpd_register_uri_handler(server, &metrics_get_uri);
+    }
+
     {
         /* URI handler for WiFi scan */
         const httpd_uri_t wifi_scan_get_uri = {
@@ -1371,6 +1752,17 @@ esp_err_t start_rest_server(void)
         httpd_register_uri_handler(server, &ws);
     }
 
+    {
+        const httpd_uri_t telemetry_ws = {
+            .uri = "/api/ws/telemetry",
+            .method = HTTP_GET,
+            .handler = telemetry_ws_handler,
+            .user_ctx = NULL,
+            .is_websocket = true
+        };
+        httpd_register_uri_handler(server, &telemetry_ws);
+    }
+
     if (enter_recovery) {
         /* Make default route serve Recovery */
         const httpd_uri_t recovery_implicit_get_uri = {
@@ -1406,6 +1798,7 @@ esp_err_t start_rest_server(void)
     httpd_register_err_handler(server, HTTPD_404_NOT_FOUND, http_404_error_handler);
 
     websocket_task_start(server);
+    telemetry_task_start(server);
 
     {
         // Start the DNS server that will redirect all queries to the softAP IP
@@ -1,9 +1,46 @@
 #ifndef HTTP_SERVER_H_
 #define HTTP_SERVER_H_
 
+#include <stdint.h>
 #include <esp_http_server.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 esp_err_t is_network_allowed(httpd_req_t * req);
 esp_err_t start_rest_server(void);
 
+typedef struct system_info_stats {
+    uint32_t notModified; // answered with 304
+    uint32_t cacheHits; // answered with the body rendered for an earlier request
+    uint32_t renders;
+    int64_t handlerTimeUs;
+} system_info_stats_t;
+
+/**
+ * @brief Returns the counters of the /api/system/info handler.
+ */
+void http_server_get_system_info_stats(system_info_stats_t * stats);
+
+typedef struct statistics_api_stats {
+    uint32_t requests;
+    uint32_t samples; // samples sent, all requests
+    uint64_t bytes; // bytes sent, all requests
+    int64_t handlerTimeUs;
+    // The last response without 'since', i.e. with the whole history.
+    uint32_t fullSamples;
+    uint32_t fullBytes;
+    uint32_t fullTimeUs;
+} statistics_api_stats_t;
+
+/**
+ * @brief Returns the counters of the /api/system/statistics handler.
+ */
+void http_server_get_statistics_stats(statistics_api_stats_t * stats);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* HTTP_SERVER_H_ */
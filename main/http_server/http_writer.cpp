@@ -1,6 +1,7 @@
 #include "http_writer.hpp"
 #include "http_writer.h"
 #include "statistics_task.h"
+#include "stats_history.h"
 
 using namespace http;
 
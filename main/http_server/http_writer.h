@@ -14,7 +14,11 @@ typedef struct http_writer {
     httpd_req_t* req;
     esp_err_t result;
     size_t used;
+    size_t sent; // total number of bytes handed to the server so far
     bool cont; // used by json writer only.
+    bool cbor; // used by json writer only: emit CBOR instead of JSON.
+    uint8_t* mem; // output of a writer without req, see http_writer_init_mem()
+    size_t memSize;
     uint8_t buf[HTTP_WRITER_BUF_SIZE];
 } http_writer_t;
 
@@ -22,7 +26,20 @@ static inline void http_writer_init(http_writer_t* w, httpd_req_t* req) {
     w->req = req;
     w->result = ESP_OK;
     w->used = 0;
+    w->sent = 0;
     w->cont = false;
+    w->cbor = false;
+    w->mem = NULL;
+    w->memSize = 0;
+}
+
+/**
+ * @brief Initializes a writer which collects its output in memory instead of
+ * sending it. After http_writer_finish(), \c w->mem holds \c w->sent bytes;
+ * the caller takes ownership and must free() it, also on error.
+ */
+static inline void http_writer_init_mem(http_writer_t* w) {
+    http_writer_init(w, NULL);
 }
 
 esp_err_t http_writer_write_int(http_writer_t* w, int64_t value);
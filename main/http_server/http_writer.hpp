@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <type_traits>
 // #include <charconv>
@@ -30,7 +31,7 @@ namespace http {
         }
 
         constexpr Writer(httpd_req_t* const req) :
-            http_writer_t {.req = req, .result = ESP_OK, .used = 0, .cont = false, .buf = {}} 
+            http_writer_t {.req = req, .result = ESP_OK, .used = 0, .sent = 0, .cont = false, .cbor = false, .mem = nullptr, .memSize = 0, .buf = {}} 
         {
 
         }
@@ -93,18 +94,27 @@ namespace http {
         }
 
         template<number_t N>
-        [[gnu::noinline]]
         Writer& write(const N& number) {
+            return write(number, fmt_for<N>());
+        }
+
+        /**
+         * @brief Writes \p number formatted with the printf format \p fmt ,
+         * which must produce no more than MAX_NUMBER_LEN characters.
+         */
+        template<number_t N>
+        [[gnu::noinline]]
+        Writer& write(const N& number, const char* const fmt) {
             // constexpr bool IS_FLOAT = std::is_floating_point_v<N>;
             // if(ok()) {
-            if(requireSpace(16)) {
+            if(requireSpace(MAX_NUMBER_LEN)) {
                 // std::to_chars_result tcr;
                 // if constexpr (IS_FLOAT) {
                     // std::snprintf
                     // tcr = std::to_chars((char*)(head()),(char*)(bufend()),
                     // (float)number, std::chars_format::fixed);
-                    int c = std::snprintf((char*)head(),space(), fmt_for<N>(), number);
-                    if(c > 0) {
+                    int c = std::snprintf((char*)head(),space(), fmt, number);
+                    if(c > 0 && (std::size_t)c < space()) {
                         this->used += c;
                     } else {
                         this->result = ESP_FAIL;
@@ -167,6 +177,24 @@ namespace http {
         }
 
 
+        protected:
+
+            /**
+             * @brief Lets \p encode write up to \p maxLen bytes directly into the buffer.
+             * \p encode must return the number of bytes actually written.
+             */
+            template<typename F>
+            Writer& encode(const std::size_t maxLen, F&& fn) {
+                if(requireSpace(maxLen)) {
+                    this->used += fn(head());
+                }
+                return *this;
+            }
+
+            // Space reserved per number; a longer one fails the write instead of
+            // running past the buffer. Fits e.g. "-1.23456789012345e-308".
+            static constexpr std::size_t MAX_NUMBER_LEN = 24;
+
         private:
 
             static constexpr const char* FMT_FLOAT = "%.3f";
@@ -197,12 +225,36 @@ namespace http {
 
             Writer& send(const void* data, const std::size_t len) {
                 if(ok()) {
-                    this->result = httpd_resp_send_chunk(this->req,(const char*)data,len);
+                    if(this->req) {
+                        this->result = httpd_resp_send_chunk(this->req,(const char*)data,len);
+                    } else {
+                        this->result = store(data,len);
+                    }
+                    this->sent += len;
                     // ESP_LOGI(TAG, "sent %" PRIu32, (uint32_t)len);
                 }
                 return *this;
             }
 
+            esp_err_t store(const void* data, const std::size_t len) {
+                if(this->sent + len > this->memSize) {
+                    std::size_t size = this->memSize ? this->memSize : 1024;
+                    while(size < this->sent + len) {
+                        size *= 2;
+                    }
+                    uint8_t* const mem = (uint8_t*)std::realloc(this->mem,size);
+                    if(!mem) {
+                        return ESP_ERR_NO_MEM;
+                    }
+                    this->mem = mem;
+                    this->memSize = size;
+                }
+                if(len != 0) {
+                    std::memcpy(this->mem + this->sent,data,len);
+                }
+                return ESP_OK;
+            }
+
             uint8_t* bufend(void) {
                 return this->buf + BUF_SIZE;
             }
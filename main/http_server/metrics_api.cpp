@@ -0,0 +1,436 @@
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_app_desc.h"
+#include "esp_system.h"
+#include "esp_http_server.h"
+
+#include "global_state.h"
+#include "statistics_task.h"
+#include "stats_history.h"
+#include "mempool_registry.h"
+
+extern "C" {
+#include "connect.h"
+#include "vcore.h"
+#include "power.h"
+
+// Function declarations from http_server.c
+esp_err_t is_network_allowed(httpd_req_t *req);
+}
+
+#include "http_writer.hpp"
+#include "metrics_api.h"
+#include "asset_cache.h"
+#include "websocket.h"
+#include "telemetry_ws.h"
+#include "http_server.h"
+#include "deflog.h"
+
+static const char* const TAG = "metrics";
+
+static constexpr const char* CONTENT_TYPE = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+// A sample from the statistics history is considered current for this long (100ms units).
+static constexpr uint32_t MAX_SAMPLE_AGE = 600;
+
+// Hashrate averaging windows, in 100ms units.
+static constexpr uint32_t WINDOW_10M = 10 * 60 * 10;
+static constexpr uint32_t WINDOW_1H = 60 * 60 * 10;
+
+static std::atomic<uint32_t> scrapeCnt {0};
+static std::atomic<uint64_t> renderTimeUs {0};
+
+namespace {
+
+    /**
+     * @brief Writes OpenMetrics text exposition format.
+     */
+    class MetricsWriter : public http::Writer {
+        public:
+
+        using http::Writer::Writer;
+
+        MetricsWriter& family(const char* const name, const char* const type, const char* const help) {
+            writeValues("# TYPE ", name, ' ', type, '\n',
+                        "# HELP ", name, ' ', help, '\n');
+            return *this;
+        }
+
+        MetricsWriter& gauge(const char* const name, const char* const help) {
+            return family(name, "gauge", help);
+        }
+
+        MetricsWriter& counter(const char* const name, const char* const help) {
+            return family(name, "counter", help);
+        }
+
+        template<http::number_t N>
+        MetricsWriter& sample(const char* const name, const N value) {
+            writeValues(name, ' ');
+            return writeSampleValue(value).writeValues('\n');
+        }
+
+        template<http::number_t N>
+        MetricsWriter& sample(const char* const name, const char* const label, const char* const labelValue, const N value) {
+            writeValues(name, '{', label, '=', '"');
+            writeLabelValue(labelValue);
+            writeValues('"', '}', ' ');
+            return writeSampleValue(value).writeValues('\n');
+        }
+
+        /**
+         * @brief Writes floats with significant digits instead of the fixed
+         * decimals of the JSON API, so that e.g. sub-ms durations in the
+         * *_seconds metrics don't turn into 0.000.
+         */
+        template<http::number_t N>
+        MetricsWriter& writeSampleValue(const N value) {
+            if constexpr (std::is_floating_point_v<N>) {
+                write(value, (sizeof(N) <= sizeof(float)) ? "%.7g" : "%.15g");
+            } else {
+                write(value);
+            }
+            return *this;
+        }
+
+        template<http::number_t N>
+        MetricsWriter& gauge(const char* const name, const char* const help, const N value) {
+            return gauge(name, help).sample(name, value);
+        }
+
+        MetricsWriter& eof(void) {
+            write("# EOF\n");
+            return *this;
+        }
+
+        MetricsWriter& writeLabelValue(const char* str) {
+            if(str) {
+                while(*str != '\0' && ok()) {
+                    const char c = *str;
+                    if(c == '\\' || c == '"') {
+                        writeValues('\\', c);
+                    } else
+                    if(c == '\n') {
+                        writeValues('\\', 'n');
+                    } else {
+                        write(c);
+                    }
+                    ++str;
+                }
+            }
+            return *this;
+        }
+
+        template<typename ... Args>
+        MetricsWriter& writeValues(Args...args) {
+            Writer::writeValues(args...);
+            return *this;
+        }
+
+    };
+
+    struct HashrateWindows {
+        float avg10m;
+        float avg1h;
+    };
+
+    /**
+     * @brief Averages the hashrate over the last 10 minutes and the last hour
+     * from the statistics history.
+     */
+    bool getHashrateWindows(const uint32_t now, HashrateWindows& out) {
+        struct StatisticsData batch[16];
+        StatisticsCursor_t cursor;
+        statistics_cursor_init(&cursor, now > WINDOW_1H ? now - WINDOW_1H : 0);
+
+        uint64_t sum10m = 0;
+        uint32_t cnt10m = 0;
+        uint64_t sum1h = 0;
+        uint32_t cnt1h = 0;
+
+        std::size_t cnt;
+        while((cnt = statisticDataGetBatch(&cursor, batch, sizeof(batch)/sizeof(batch[0]))) != 0) {
+            for(std::size_t i = 0; i < cnt; ++i) {
+                sum1h += batch[i].hashrate_MHz;
+                cnt1h += 1;
+                if(batch[i].timestamp + WINDOW_10M > now) {
+                    sum10m += batch[i].hashrate_MHz;
+                    cnt10m += 1;
+                }
+            }
+        }
+
+        if(cnt1h == 0) {
+            return false;
+        }
+
+        // MH/s -> GH/s
+        out.avg1h = (float)sum1h / (cnt1h * 1000.0f);
+        out.avg10m = cnt10m != 0 ? (float)sum10m / (cnt10m * 1000.0f) : out.avg1h;
+        return true;
+    }
+
+    void writeHeap(MetricsWriter& w, const char* const heapName, const uint32_t caps) {
+        w.sample("espminer_heap_size_bytes", "heap", heapName, (uint32_t)heap_caps_get_total_size(caps));
+    }
+
+    void writeHeapFree(MetricsWriter& w, const char* const heapName, const uint32_t caps) {
+        w.sample("espminer_heap_free_bytes", "heap", heapName, (uint32_t)heap_caps_get_free_size(caps));
+    }
+
+    void writeHeapMinFree(MetricsWriter& w, const char* const heapName, const uint32_t caps) {
+        w.sample("espminer_heap_min_free_bytes", "heap", heapName, (uint32_t)heap_caps_get_minimum_free_size(caps));
+    }
+
+    void writeMetrics(MetricsWriter& w) {
+        const SystemModule& sys = GLOBAL_STATE.SYSTEM_MODULE;
+        const PowerManagementModule& pwr = GLOBAL_STATE.POWER_MANAGEMENT_MODULE;
+
+        const uint32_t now = statistics_get_timestamp();
+
+        // Prefer the statistics task's latest sample over querying the
+        // regulators and the WiFi driver on every scrape.
+        struct StatisticsData latest;
+        const bool haveLatest = statisticDataLatest(&latest) && (latest.timestamp + MAX_SAMPLE_AGE > now);
+
+        w.family("espminer_build", "info", "Firmware and hardware identification");
+        w.writeValues("espminer_build_info{version=\"");
+        w.writeLabelValue(esp_app_get_description()->version);
+        w.writeValues("\",asic=\"");
+        w.writeLabelValue(GLOBAL_STATE.DEVICE_CONFIG.family.asic.name);
+        w.writeValues("\",board=\"");
+        w.writeLabelValue(GLOBAL_STATE.DEVICE_CONFIG.board_version);
+        w.writeValues("\"} 1\n");
+
+        w.gauge("espminer_uptime_seconds", "Time since boot",
+            (uint32_t)((esp_timer_get_time() - sys.start_time) / 1000000));
+
+        w.gauge("espminer_hashrate_ghs", "Hashrate in GH/s over the given window");
+        w.sample("espminer_hashrate_ghs", "window", "current", sys.current_hashrate);
+        {
+            HashrateWindows windows;
+            if(getHashrateWindows(now, windows)) {
+                w.sample("espminer_hashrate_ghs", "window", "10m", windows.avg10m);
+                w.sample("espminer_hashrate_ghs", "window", "1h", windows.avg1h);
+            }
+        }
+
+        w.gauge("espminer_expected_hashrate_ghs", "Hashrate expected from frequency and core count",
+            pwr.frequency_value * GLOBAL_STATE.DEVICE_CONFIG.family.asic.small_core_count *
+                GLOBAL_STATE.DEVICE_CONFIG.family.asic_count / 1000.0f);
+
+        w.counter("espminer_shares_accepted", "Shares accepted by the pool");
+        w.sample("espminer_shares_accepted_total", sys.shares_accepted);
+
+        w.counter("espminer_shares_rejected", "Shares rejected by the pool");
+        w.sample("espminer_shares_rejected_total", sys.shares_rejected);
+
+        w.counter("espminer_shares_rejected_by_reason", "Shares rejected by the pool, by reason");
+        {
+            const int cnt = sys.rejected_reason_stats_count;
+            for(int i = 0; i < cnt; ++i) {
+                w.sample("espminer_shares_rejected_by_reason_total", "reason",
+                    sys.rejected_reason_stats[i].message,
+                    sys.rejected_reason_stats[i].count);
+            }
+        }
+
+        w.counter("espminer_work_received", "Jobs received from the pool");
+        w.sample("espminer_work_received_total", sys.work_received);
+
+        w.gauge("espminer_pool_difficulty", "Current pool difficulty", GLOBAL_STATE.pool_difficulty);
+        w.gauge("espminer_stratum_response_time_seconds", "Last stratum response time",
+            sys.response_time / 1000.0);
+        w.gauge("espminer_stratum_fallback", "1 if connected to the fallback pool",
+            (uint32_t)(sys.is_using_fallback ? 1 : 0));
+
+        w.gauge("espminer_temperature_celsius", "Temperatures");
+        w.sample("espminer_temperature_celsius", "sensor", "asic", pwr.chip_temp_avg);
+        w.sample("espminer_temperature_celsius", "sensor", "asic2", pwr.chip_temp2_avg);
+        w.sample("espminer_temperature_celsius", "sensor", "vr", pwr.vr_temp);
+
+        w.gauge("espminer_power_watts", "Power consumption", pwr.power);
+        w.gauge("espminer_input_voltage_volts", "Input voltage", pwr.voltage / 1000.0f);
+        w.gauge("espminer_input_current_amperes", "Input current",
+            (haveLatest ? latest.current : Power_get_current(&GLOBAL_STATE)) / 1000.0f);
+        w.gauge("espminer_core_voltage_volts", "Measured ASIC core voltage",
+            (haveLatest ? latest.coreVoltageActual : VCORE_get_voltage_mv(&GLOBAL_STATE)) / 1000.0f);
+        w.gauge("espminer_asic_frequency_mhz", "ASIC clock frequency", pwr.frequency_value);
+
+        w.gauge("espminer_fan_speed_percent", "Fan speed setting", pwr.fan_perc);
+        w.gauge("espminer_fan_rpm", "Measured fan speed", pwr.fan_rpm);
+
+        {
+            int8_t rssi = -90;
+            if(haveLatest) {
+                rssi = latest.wifiRSSI;
+            } else {
+                get_wifi_current_rssi(&rssi);
+            }
+            w.gauge("espminer_wifi_rssi_dbm", "WiFi signal strength", rssi);
+        }
+
+        w.gauge("espminer_heap_size_bytes", "Total heap size");
+        writeHeap(w, "internal", MALLOC_CAP_INTERNAL);
+        if(GLOBAL_STATE.psram_is_available) {
+            writeHeap(w, "psram", MALLOC_CAP_SPIRAM);
+        }
+        w.gauge("espminer_heap_free_bytes", "Free heap");
+        writeHeapFree(w, "internal", MALLOC_CAP_INTERNAL);
+        if(GLOBAL_STATE.psram_is_available) {
+            writeHeapFree(w, "psram", MALLOC_CAP_SPIRAM);
+        }
+        w.gauge("espminer_heap_min_free_bytes", "Lowest free heap since boot");
+        writeHeapMinFree(w, "internal", MALLOC_CAP_INTERNAL);
+        if(GLOBAL_STATE.psram_is_available) {
+            writeHeapMinFree(w, "psram", MALLOC_CAP_SPIRAM);
+        }
+
+        {
+            mempool_info_t pools[8];
+            const size_t cnt = mempool_registry_get(pools, std::size(pools));
+            w.gauge("espminer_objpool_allocated", "Objects allocated by the pool");
+            for(size_t i = 0; i < cnt; ++i) {
+                w.sample("espminer_objpool_allocated", "pool", pools[i].name, pools[i].stats.allocCnt);
+            }
+            w.gauge("espminer_objpool_in_use", "Objects currently taken from the pool");
+            for(size_t i = 0; i < cnt; ++i) {
+                w.sample("espminer_objpool_in_use", "pool", pools[i].name, pools[i].stats.inUseCnt);
+            }
+            w.gauge("espminer_objpool_max_in_use", "Most objects taken from the pool at once");
+            for(size_t i = 0; i < cnt; ++i) {
+                w.sample("espminer_objpool_max_in_use", "pool", pools[i].name, pools[i].stats.maxInUseCnt);
+            }
+            w.counter("espminer_objpool_grow_events", "Chunks allocated by the pool");
+            for(size_t i = 0; i < cnt; ++i) {
+                w.sample("espminer_objpool_grow_events_total", "pool", pools[i].name, pools[i].growCnt);
+            }
+            w.counter("espminer_objpool_cas_retries", "Contended updates of the pool's free list");
+            for(size_t i = 0; i < cnt; ++i) {
+                w.sample("espminer_objpool_cas_retries_total", "pool", pools[i].name, pools[i].casRetries);
+            }
+        }
+
+        {
+            asset_cache_stats_t stats;
+            asset_cache_get_stats(&stats);
+            w.counter("espminer_http_asset_requests", "Static file requests");
+            w.sample("espminer_http_asset_requests_total", "result", "ram", stats.ramHits);
+            w.sample("espminer_http_asset_requests_total", "result", "mapped", stats.mappedHits);
+            w.sample("espminer_http_asset_requests_total", "result", "flash",
+                stats.requests - stats.ramHits - stats.mappedHits - stats.notModified);
+            w.sample("espminer_http_asset_requests_total", "result", "not_modified", stats.notModified);
+            w.counter("espminer_http_asset_sent_bytes", "Static file bytes sent");
+            w.sample("espminer_http_asset_sent_bytes_total", stats.bytesSent);
+            w.counter("espminer_http_asset_handler_seconds", "Time spent serving static files");
+            w.sample("espminer_http_asset_handler_seconds_total", stats.handlerTimeUs / 1000000.0);
+            w.gauge("espminer_http_asset_cache_bytes", "Static file content held in PSRAM", (uint32_t)stats.ramBytes);
+        }
+
+        {
+            system_info_stats_t stats;
+            http_server_get_system_info_stats(&stats);
+            w.counter("espminer_http_system_info_requests", "Requests of /api/system/info");
+            w.sample("espminer_http_system_info_requests_total", "result", "not_modified", stats.notModified);
+            w.sample("espminer_http_system_info_requests_total", "result", "cached", stats.cacheHits);
+            w.sample("espminer_http_system_info_requests_total", "result", "rendered", stats.renders);
+            w.counter("espminer_http_system_info_handler_seconds", "Time spent serving /api/system/info");
+            w.sample("espminer_http_system_info_handler_seconds_total", stats.handlerTimeUs / 1000000.0);
+        }
+
+        {
+            statistics_api_stats_t stats;
+            http_server_get_statistics_stats(&stats);
+            w.counter("espminer_http_statistics_requests", "Requests of /api/system/statistics");
+            w.sample("espminer_http_statistics_requests_total", stats.requests);
+            w.counter("espminer_http_statistics_samples", "Samples sent by /api/system/statistics");
+            w.sample("espminer_http_statistics_samples_total", stats.samples);
+            w.counter("espminer_http_statistics_sent_bytes", "Bytes sent by /api/system/statistics");
+            w.sample("espminer_http_statistics_sent_bytes_total", stats.bytes);
+            w.counter("espminer_http_statistics_handler_seconds", "Time spent serving /api/system/statistics");
+            w.sample("espminer_http_statistics_handler_seconds_total", stats.handlerTimeUs / 1000000.0);
+            w.gauge("espminer_http_statistics_full_samples", "Samples in the last response with the whole history", stats.fullSamples);
+            w.gauge("espminer_http_statistics_full_bytes", "Size of the last response with the whole history", stats.fullBytes);
+            w.gauge("espminer_http_statistics_full_seconds", "Time taken by the last response with the whole history",
+                stats.fullTimeUs / 1000000.0);
+        }
+
+        {
+            ws_log_stats_t stats;
+            websocket_get_log_stats(&stats);
+            w.counter("espminer_ws_log_lines", "Log lines queued for websocket clients");
+            w.sample("espminer_ws_log_lines_total", stats.lines);
+            w.counter("espminer_ws_log_dropped", "Log lines dropped because the buffer was full");
+            w.sample("espminer_ws_log_dropped_total", stats.dropped);
+            w.counter("espminer_ws_log_frames", "Websocket frames sent with log lines");
+            w.sample("espminer_ws_log_frames_total", stats.frames);
+            w.counter("espminer_ws_log_enqueue_seconds", "Time spent by logging tasks queuing lines");
+            w.sample("espminer_ws_log_enqueue_seconds_total", stats.timeUs / 1000000.0);
+            w.gauge("espminer_ws_log_enqueue_max_seconds", "Longest time to queue one line", stats.maxTimeUs / 1000000.0);
+        }
+
+        {
+            deflog_stats_t stats;
+            deflog_get_stats(&stats);
+            w.counter("espminer_deflog_records", "Hot path log lines recorded for deferred printing");
+            w.sample("espminer_deflog_records_total", stats.records);
+            w.counter("espminer_deflog_dropped", "Deferred log lines dropped because the buffer was full");
+            w.sample("espminer_deflog_dropped_total", stats.dropped);
+            w.counter("espminer_deflog_write_seconds", "Time spent by hot paths recording log lines");
+            w.sample("espminer_deflog_write_seconds_total", stats.writeTimeUs / 1000000.0);
+            w.counter("espminer_deflog_print_seconds", "Time spent formatting and printing deferred log lines");
+            w.sample("espminer_deflog_print_seconds_total", stats.formatTimeUs / 1000000.0);
+        }
+
+        {
+            telemetry_stats_t stats;
+            telemetry_get_stats(&stats);
+            w.counter("espminer_telemetry_snapshots", "Telemetry snapshots taken");
+            w.sample("espminer_telemetry_snapshots_total", stats.snapshots);
+            w.counter("espminer_telemetry_frames", "Telemetry updates sent");
+            w.sample("espminer_telemetry_frames_total", stats.frames);
+            w.counter("espminer_telemetry_sent_bytes", "Telemetry bytes sent");
+            w.sample("espminer_telemetry_sent_bytes_total", stats.bytes);
+            w.counter("espminer_telemetry_cpu_seconds", "Time spent producing and sending telemetry");
+            w.sample("espminer_telemetry_cpu_seconds_total", stats.timeUs / 1000000.0);
+        }
+
+        // Cost of scraping, as of the previous scrape.
+        w.counter("espminer_metrics_scrapes", "Requests served by /metrics");
+        w.sample("espminer_metrics_scrapes_total", scrapeCnt.load(std::memory_order_relaxed));
+        w.counter("espminer_metrics_render_seconds", "Time spent rendering /metrics");
+        w.sample("espminer_metrics_render_seconds_total",
+            renderTimeUs.load(std::memory_order_relaxed) / 1000000.0);
+
+        w.eof();
+    }
+
+}
+
+esp_err_t GET_metrics(httpd_req_t *req)
+{
+    if (is_network_allowed(req) != ESP_OK) {
+        return httpd_resp_send_err(req, HTTPD_401_UNAUTHORIZED, "Unauthorized");
+    }
+
+    const int64_t startTime = esp_timer_get_time();
+
+    httpd_resp_set_type(req, CONTENT_TYPE);
+
+    MetricsWriter w {req};
+    writeMetrics(w);
+    w.finish();
+
+    const uint32_t duration = esp_timer_get_time() - startTime;
+    scrapeCnt.fetch_add(1, std::memory_order_relaxed);
+    renderTimeUs.fetch_add(duration, std::memory_order_relaxed);
+
+    ESP_LOGD(TAG, "%u bytes in %" PRIu32 "us", (unsigned)w.sent, duration);
+
+    return w.result;
+}
@@ -0,0 +1,20 @@
+#ifndef METRICS_API_H_
+#define METRICS_API_H_
+
+#include <esp_http_server.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Handler for GET /metrics; renders the current state in OpenMetrics
+ * text format for Prometheus-style scrapers.
+ */
+esp_err_t GET_metrics(httpd_req_t *req);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METRICS_API_H_
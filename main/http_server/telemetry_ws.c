@@ -0,0 +1,398 @@
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_http_server.h"
+
+#include "cJSON.h"
+#include "global_state.h"
+#include "power.h"
+
+#include "http_server.h"
+#include "telemetry_ws.h"
+
+static const char * const TAG = "telemetry";
+
+#define FRAME_SIZE (512)
+#define MAX_REQUEST_SIZE (128)
+
+typedef enum {
+    TF_HASHRATE,
+    TF_TEMP,
+    TF_TEMP2,
+    TF_VRTEMP,
+    TF_POWER,
+    TF_VOLTAGE,
+    TF_CURRENT,
+    TF_FANSPEED,
+    TF_FANRPM,
+    TF_SHARES_ACCEPTED,
+    TF_SHARES_REJECTED,
+    TF_BEST_DIFF,
+    TF_BEST_SESSION_DIFF,
+    TF_CNT
+} telemetry_field_t;
+
+typedef struct field_desc {
+    const char* name; // Same as in /api/system/info
+    uint8_t decimals; // Values are kept as fixed-point numbers with this many decimals.
+} field_desc_t;
+
+static const field_desc_t FIELDS[TF_CNT] = {
+    [TF_HASHRATE] = {"hashRate", 2},
+    [TF_TEMP] = {"temp", 1},
+    [TF_TEMP2] = {"temp2", 1},
+    [TF_VRTEMP] = {"vrTemp", 1},
+    [TF_POWER] = {"power", 2},
+    [TF_VOLTAGE] = {"voltage", 0},
+    [TF_CURRENT] = {"current", 0},
+    [TF_FANSPEED] = {"fanspeed", 0},
+    [TF_FANRPM] = {"fanrpm", 0},
+    [TF_SHARES_ACCEPTED] = {"sharesAccepted", 0},
+    [TF_SHARES_REJECTED] = {"sharesRejected", 0},
+    // Compared by value, sent as the formatted string:
+    [TF_BEST_DIFF] = {"bestDiff", 0},
+    [TF_BEST_SESSION_DIFF] = {"bestSessionDiff", 0},
+};
+
+typedef struct snapshot {
+    int64_t timeMs;
+    int64_t values[TF_CNT];
+    char bestDiff[DIFF_STRING_SIZE];
+    char bestSessionDiff[DIFF_STRING_SIZE];
+} snapshot_t;
+
+typedef struct client {
+    int fd; // -1 if unused
+    bool primed; // false if all values must be sent
+    uint32_t intervalMs;
+    int64_t nextDueMs;
+    int64_t sent[TF_CNT]; // Values as last sent to the client
+} client_t;
+
+static client_t clients[TELEMETRY_MAX_CLIENTS];
+static uint32_t clientCnt; // Guarded by clientsMutex
+static StaticSemaphore_t clientsMutexMem;
+static SemaphoreHandle_t clientsMutex;
+static TaskHandle_t telemetryTask;
+
+static telemetry_stats_t stats;
+
+static inline int64_t toFixed(const double value, const uint8_t decimals) {
+    static const double SCALE[] = {1.0, 10.0, 100.0, 1000.0};
+    return llround(value * SCALE[decimals]);
+}
+
+static void takeSnapshot(snapshot_t* const s) {
+    const SystemModule* const sys = &GLOBAL_STATE.SYSTEM_MODULE;
+    const PowerManagementModule* const pwr = &GLOBAL_STATE.POWER_MANAGEMENT_MODULE;
+
+    s->timeMs = esp_timer_get_time() / 1000;
+
+    int64_t* const v = s->values;
+    v[TF_HASHRATE] = toFixed(sys->current_hashrate, FIELDS[TF_HASHRATE].decimals);
+    v[TF_TEMP] = toFixed(pwr->chip_temp_avg, FIELDS[TF_TEMP].decimals);
+    v[TF_TEMP2] = toFixed(pwr->chip_temp2_avg, FIELDS[TF_TEMP2].decimals);
+    v[TF_VRTEMP] = toFixed(pwr->vr_temp, FIELDS[TF_VRTEMP].decimals);
+    v[TF_POWER] = toFixed(pwr->power, FIELDS[TF_POWER].decimals);
+    v[TF_VOLTAGE] = toFixed(pwr->voltage, FIELDS[TF_VOLTAGE].decimals);
+    v[TF_CURRENT] = toFixed(Power_get_current(&GLOBAL_STATE), FIELDS[TF_CURRENT].decimals);
+    v[TF_FANSPEED] = pwr->fan_perc;
+    v[TF_FANRPM] = pwr->fan_rpm;
+    v[TF_SHARES_ACCEPTED] = sys->shares_accepted;
+    v[TF_SHARES_REJECTED] = sys->shares_rejected;
+    v[TF_BEST_DIFF] = sys->best_nonce_diff;
+    v[TF_BEST_SESSION_DIFF] = sys->best_session_nonce_diff;
+
+    strlcpy(s->bestDiff, sys->best_diff_string, sizeof(s->bestDiff));
+    strlcpy(s->bestSessionDiff, sys->best_session_diff_string, sizeof(s->bestSessionDiff));
+}
+
+static int writeFixed(char* const out, const size_t len, const int64_t value, const uint8_t decimals) {
+    if(decimals == 0) {
+        return snprintf(out, len, "%" PRId64, value);
+    }
+    static const int64_t SCALE[] = {1, 10, 100, 1000};
+    const uint64_t abs = value < 0 ? -(uint64_t)value : (uint64_t)value;
+    return snprintf(out, len, "%s%" PRIu64 ".%0*" PRIu64,
+        value < 0 ? "-" : "",
+        abs / SCALE[decimals],
+        (int)decimals, abs % SCALE[decimals]);
+}
+
+/**
+ * @brief Renders the values which changed for \p client into \p out. If none
+ * did, the frame only has "t"; clients rely on one frame per interval.
+ * 
+ * @return the length of the frame, or 0 if it didn't fit.
+ */
+static size_t renderDelta(client_t* const client, const snapshot_t* const s, char* const out, const size_t len) {
+    size_t n = snprintf(out, len, "{\"t\":%" PRId64, s->timeMs);
+
+    for(unsigned i = 0; i < TF_CNT && n < len; ++i) {
+        if(client->primed && client->sent[i] == s->values[i]) {
+            continue;
+        }
+        n += snprintf(out + n, len - n, ",\"%s\":", FIELDS[i].name);
+        if(n >= len) {
+            break;
+        }
+        if(i == TF_BEST_DIFF || i == TF_BEST_SESSION_DIFF) {
+            n += snprintf(out + n, len - n, "\"%s\"", i == TF_BEST_DIFF ? s->bestDiff : s->bestSessionDiff);
+        } else {
+            n += writeFixed(out + n, len - n, s->values[i], FIELDS[i].decimals);
+        }
+        client->sent[i] = s->values[i];
+    }
+
+    if(n + 1 >= len) {
+        // Can't happen with FRAME_SIZE; better send nothing than broken JSON.
+        client->primed = false;
+        return 0;
+    }
+    out[n++] = '}';
+    client->primed = true;
+    return n;
+}
+
+static uint32_t clampInterval(const int64_t ms) {
+    if(ms < TELEMETRY_TICK_MS) {
+        return TELEMETRY_TICK_MS;
+    }
+    if(ms > TELEMETRY_MAX_INTERVAL_MS) {
+        return TELEMETRY_MAX_INTERVAL_MS;
+    }
+    return ms;
+}
+
+static client_t* findClient(const int fd) {
+    for(unsigned i = 0; i < TELEMETRY_MAX_CLIENTS; ++i) {
+        if(clients[i].fd == fd) {
+            return &clients[i];
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t addClient(const int fd, const uint32_t intervalMs) {
+    if(telemetryTask == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t r = ESP_FAIL;
+    xSemaphoreTake(clientsMutex, portMAX_DELAY);
+    client_t* const c = findClient(-1);
+    if(c) {
+        c->fd = fd;
+        c->primed = false;
+        c->intervalMs = intervalMs;
+        c->nextDueMs = 0;
+        clientCnt += 1;
+        r = ESP_OK;
+    }
+    xSemaphoreGive(clientsMutex);
+    if(r == ESP_OK) {
+        xTaskNotifyGive(telemetryTask);
+    }
+    return r;
+}
+
+static void removeClientLocked(client_t* const c) {
+    c->fd = -1;
+    clientCnt -= 1;
+}
+
+void telemetry_remove_client(const int fd) {
+    if(clientsMutex == NULL || fd < 0) {
+        return;
+    }
+    xSemaphoreTake(clientsMutex, portMAX_DELAY);
+    client_t* const c = findClient(fd);
+    if(c) {
+        removeClientLocked(c);
+    }
+    xSemaphoreGive(clientsMutex);
+    if(c) {
+        ESP_LOGI(TAG, "Removed telemetry client, fd: %d", fd);
+    }
+}
+
+static void handleRequest(const int fd, const char* const json) {
+    cJSON* const root = cJSON_Parse(json);
+    if(root == NULL) {
+        return;
+    }
+    const cJSON* const interval = cJSON_GetObjectItem(root, "interval");
+    const cJSON* const full = cJSON_GetObjectItem(root, "full");
+
+    xSemaphoreTake(clientsMutex, portMAX_DELAY);
+    client_t* const c = findClient(fd);
+    if(c) {
+        if(cJSON_IsNumber(interval)) {
+            c->intervalMs = clampInterval(interval->valueint);
+            c->nextDueMs = 0;
+        }
+        if(cJSON_IsTrue(full)) {
+            c->primed = false;
+            c->nextDueMs = 0;
+        }
+    }
+    xSemaphoreGive(clientsMutex);
+
+    cJSON_Delete(root);
+}
+
+esp_err_t telemetry_ws_handler(httpd_req_t* req)
+{
+    if (is_network_allowed(req) != ESP_OK) {
+        return httpd_resp_send_err(req, HTTPD_401_UNAUTHORIZED, "Unauthorized");
+    }
+
+    const int fd = httpd_req_to_sockfd(req);
+
+    if (req->method == HTTP_GET) {
+        uint32_t intervalMs = TELEMETRY_DEFAULT_INTERVAL_MS;
+        {
+            char query[48];
+            char value[12];
+            if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+                httpd_query_key_value(query, "interval", value, sizeof(value)) == ESP_OK) {
+                intervalMs = clampInterval(strtol(value, NULL, 10));
+            }
+        }
+
+        if (addClient(fd, intervalMs) != ESP_OK) {
+            ESP_LOGW(TAG, "Max telemetry clients reached, rejecting fd: %d", fd);
+            esp_err_t ret = httpd_resp_send_custom_err(req, "429 Too Many Requests", "Max telemetry clients reached");
+            httpd_sess_trigger_close(req->handle, fd);
+            return ret;
+        }
+        ESP_LOGI(TAG, "Added telemetry client, fd: %d, interval %" PRIu32 "ms", fd, intervalMs);
+        return ESP_OK;
+    }
+
+    httpd_ws_frame_t ws_pkt;
+    memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
+
+    esp_err_t ret = httpd_ws_recv_frame(req, &ws_pkt, 0);
+    if (ret != ESP_OK) {
+        telemetry_remove_client(fd);
+        return ret;
+    }
+
+    if (ws_pkt.type == HTTPD_WS_TYPE_CLOSE) {
+        telemetry_remove_client(fd);
+        return ESP_OK;
+    }
+
+    if (ws_pkt.len >= MAX_REQUEST_SIZE) {
+        ESP_LOGW(TAG, "Request too long from fd: %d", fd);
+        telemetry_remove_client(fd);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    char buf[MAX_REQUEST_SIZE];
+    ws_pkt.payload = (uint8_t*)buf;
+    ret = httpd_ws_recv_frame(req, &ws_pkt, sizeof(buf) - 1);
+    if (ret != ESP_OK) {
+        telemetry_remove_client(fd);
+        return ret;
+    }
+    buf[ws_pkt.len] = '\0';
+
+    if (ws_pkt.type == HTTPD_WS_TYPE_TEXT) {
+        handleRequest(fd, buf);
+    }
+
+    return ESP_OK;
+}
+
+static void telemetry_task(void* pvParameters) {
+    httpd_handle_t https_handle = (httpd_handle_t)pvParameters;
+
+    static snapshot_t snapshot;
+    static char frame[FRAME_SIZE];
+
+    httpd_ws_frame_t ws_pkt;
+    memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
+    ws_pkt.type = HTTPD_WS_TYPE_TEXT;
+    ws_pkt.payload = (uint8_t*)frame;
+
+    TickType_t lastWake = xTaskGetTickCount();
+
+    while (true) {
+        xSemaphoreTake(clientsMutex, portMAX_DELAY);
+        if (clientCnt == 0) {
+            // addClient() notifies after giving the mutex, so a client
+            // added in between is not missed.
+            xSemaphoreGive(clientsMutex);
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            lastWake = xTaskGetTickCount();
+            xSemaphoreTake(clientsMutex, portMAX_DELAY);
+        }
+
+        const int64_t startTime = esp_timer_get_time();
+        const int64_t nowMs = startTime / 1000;
+        bool haveSnapshot = false;
+
+        for (unsigned i = 0; i < TELEMETRY_MAX_CLIENTS; ++i) {
+            client_t* const c = &clients[i];
+            if (c->fd == -1 || nowMs < c->nextDueMs) {
+                continue;
+            }
+
+            // One snapshot per tick, shared by all clients which are due.
+            if (!haveSnapshot) {
+                takeSnapshot(&snapshot);
+                haveSnapshot = true;
+                stats.snapshots += 1;
+            }
+
+            c->nextDueMs += c->intervalMs;
+            if (c->nextDueMs <= nowMs) {
+                c->nextDueMs = nowMs + c->intervalMs;
+            }
+
+            ws_pkt.len = renderDelta(c, &snapshot, frame, sizeof(frame));
+            if (ws_pkt.len != 0) {
+                if (httpd_ws_send_frame_async(https_handle, c->fd, &ws_pkt) != ESP_OK) {
+                    ESP_LOGI(TAG, "Failed to send telemetry to fd: %d", c->fd);
+                    removeClientLocked(c);
+                } else {
+                    stats.frames += 1;
+                    stats.bytes += ws_pkt.len;
+                }
+            }
+        }
+
+        stats.timeUs += esp_timer_get_time() - startTime;
+
+        xSemaphoreGive(clientsMutex);
+
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(TELEMETRY_TICK_MS));
+    }
+}
+
+bool telemetry_task_start(httpd_handle_t httpserver) {
+    for (unsigned i = 0; i < TELEMETRY_MAX_CLIENTS; ++i) {
+        clients[i].fd = -1;
+    }
+    clientsMutex = xSemaphoreCreateMutexStatic(&clientsMutexMem);
+
+    if (xTaskCreate(telemetry_task, "telemetry_task", 4096, httpserver, 2, &telemetryTask) == pdFAIL) {
+        ESP_LOGE(TAG, "Failed to create telemetry task.");
+        return false;
+    }
+    return true;
+}
+
+void telemetry_get_stats(telemetry_stats_t* const out) {
+    *out = stats;
+}
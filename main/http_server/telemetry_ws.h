@@ -0,0 +1,44 @@
+#ifndef TELEMETRY_WS_H_
+#define TELEMETRY_WS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#define TELEMETRY_MAX_CLIENTS           (10)
+#define TELEMETRY_TICK_MS               (250) // Finest update interval
+#define TELEMETRY_DEFAULT_INTERVAL_MS   (1000)
+#define TELEMETRY_MAX_INTERVAL_MS       (60000)
+
+typedef struct telemetry_stats {
+    uint32_t snapshots; // Snapshots taken; one per tick in which any client was due
+    uint32_t frames;
+    uint64_t bytes;
+    uint64_t timeUs; // Total time spent taking snapshots and rendering frames
+} telemetry_stats_t;
+
+bool telemetry_task_start(httpd_handle_t httpserver);
+
+/**
+ * @brief Websocket handler for /api/ws/telemetry.
+ * 
+ * Clients pick their update interval in ms with the "interval" query parameter,
+ * or at any time by sending {"interval":<ms>}. Sending {"full":true} requests all
+ * values again.
+ * 
+ * Every update is a JSON object with "t" (ms since boot) and only those values
+ * that changed since the last update sent to that client; the first one has all
+ * values. An update is sent every interval, with only "t" if nothing changed,
+ * so that clients can tell a quiet device from a dead connection.
+ */
+esp_err_t telemetry_ws_handler(httpd_req_t* req);
+
+/**
+ * @brief To be called when a socket is closed.
+ */
+void telemetry_remove_client(int fd);
+
+void telemetry_get_stats(telemetry_stats_t* stats);
+
+#endif /* TELEMETRY_WS_H_ */
@@ -3,8 +3,10 @@
 #include "esp_log.h"
 #include "nvs_config.h"
 #include "cJSON.h"
+#include "http_writer.h"
+#include "http_json_writer.h"
 
-//static const char *TAG = "theme_api";
+static const char *TAG = "theme_api";
 
 // Helper function to set CORS headers
 static esp_err_t set_cors_headers(httpd_req_t *req)
@@ -23,57 +25,92 @@ static esp_err_t theme_options_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+static const char DEFAULT_THEME_COLORS[] =
+    "{"
+    "\"--primary-color\":\"#F80421\","
+    "\"--primary-color-text\":\"#ffffff\","
+    "\"--highlight-bg\":\"#F80421\","
+    "\"--highlight-text-color\":\"#ffffff\","
+    "\"--focus-ring\":\"0 0 0 0.2rem rgba(248,4,33,0.2)\","
+    "\"--slider-bg\":\"#dee2e6\","
+    "\"--slider-range-bg\":\"#F80421\","
+    "\"--slider-handle-bg\":\"#F80421\","
+    "\"--progressbar-bg\":\"#dee2e6\","
+    "\"--progressbar-value-bg\":\"#F80421\","
+    "\"--checkbox-border\":\"#F80421\","
+    "\"--checkbox-bg\":\"#F80421\","
+    "\"--checkbox-hover-bg\":\"#df031d\","
+    "\"--button-bg\":\"#F80421\","
+    "\"--button-hover-bg\":\"#df031d\","
+    "\"--button-focus-shadow\":\"0 0 0 2px #ffffff, 0 0 0 4px #F80421\","
+    "\"--togglebutton-bg\":\"#F80421\","
+    "\"--togglebutton-border\":\"1px solid #F80421\","
+    "\"--togglebutton-hover-bg\":\"#df031d\","
+    "\"--togglebutton-hover-border\":\"1px solid #df031d\","
+    "\"--togglebutton-text-color\":\"#ffffff\""
+    "}";
+
+static bool is_json_object(const char* str)
+{
+    cJSON* const json = cJSON_Parse(str);
+    const bool valid = cJSON_IsObject(json);
+    cJSON_Delete(json);
+    return valid;
+}
+
+/**
+ * @brief Checks if the stored \p colors are a JSON object. They are sent
+ * verbatim, so anything else would break the response. Only parses them
+ * again when the stored value was changed since the last check.
+ */
+static bool stored_colors_valid(const char* colors, const uint32_t modcount)
+{
+    static bool checked = false;
+    static bool valid = false;
+    static uint32_t checkedModcount;
+
+    if (colors == NULL) {
+        return false;
+    }
+    if (!checked || nvs_config_is_changed_since(NVS_CONFIG_THEME_COLORS, checkedModcount)) {
+        valid = is_json_object(colors);
+        if (!valid) {
+            ESP_LOGW(TAG, "Stored theme colors are not a JSON object, using the default.");
+        }
+        checked = true;
+        checkedModcount = modcount;
+    }
+    return valid;
+}
+
 // GET /api/theme handler
 static esp_err_t theme_get_handler(httpd_req_t *req)
 {
     httpd_resp_set_type(req, "application/json");
     set_cors_headers(req);
 
+    // Before reading, so a change in between gets checked next time.
+    const uint32_t modcount = nvs_config_get_modcount();
     char *scheme = nvs_config_get_string(NVS_CONFIG_THEME_SCHEME, "dark");
-    char *colors = nvs_config_get_string(NVS_CONFIG_THEME_COLORS, 
-        "{"
-        "\"--primary-color\":\"#F80421\","
-        "\"--primary-color-text\":\"#ffffff\","
-        "\"--highlight-bg\":\"#F80421\","
-        "\"--highlight-text-color\":\"#ffffff\","
-        "\"--focus-ring\":\"0 0 0 0.2rem rgba(248,4,33,0.2)\","
-        "\"--slider-bg\":\"#dee2e6\","
-        "\"--slider-range-bg\":\"#F80421\","
-        "\"--slider-handle-bg\":\"#F80421\","
-        "\"--progressbar-bg\":\"#dee2e6\","
-        "\"--progressbar-value-bg\":\"#F80421\","
-        "\"--checkbox-border\":\"#F80421\","
-        "\"--checkbox-bg\":\"#F80421\","
-        "\"--checkbox-hover-bg\":\"#df031d\","
-        "\"--button-bg\":\"#F80421\","
-        "\"--button-hover-bg\":\"#df031d\","
-        "\"--button-focus-shadow\":\"0 0 0 2px #ffffff, 0 0 0 4px #F80421\","
-        "\"--togglebutton-bg\":\"#F80421\","
-        "\"--togglebutton-border\":\"1px solid #F80421\","
-        "\"--togglebutton-hover-bg\":\"#df031d\","
-        "\"--togglebutton-hover-border\":\"1px solid #df031d\","
-        "\"--togglebutton-text-color\":\"#ffffff\""
-        "}"
-    );
-
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddStringToObject(root, "colorScheme", scheme);
-    
-    // Parse stored colors JSON string
-    cJSON *colors_json = cJSON_Parse(colors);
-    if (colors_json) {
-        cJSON_AddItemToObject(root, "accentColors", colors_json);
-    }
+    char *colors = nvs_config_get_string(NVS_CONFIG_THEME_COLORS, DEFAULT_THEME_COLORS);
+
+    http_writer_t wrtr;
+    http_writer_t* const w = &wrtr;
+    http_writer_init(w,req);
+
+    http_json_start_obj(w,NULL);
+    http_json_write_item(w, "colorScheme", scheme);
+    // Stored colors are already JSON (see theme_post_handler), so send them as they are.
+    http_json_write_raw_item(w, "accentColors",
+        stored_colors_valid(colors, modcount) ? colors : DEFAULT_THEME_COLORS);
+    http_json_end_obj(w);
 
-    const char *response = cJSON_Print(root);
-    httpd_resp_sendstr(req, response);
+    http_writer_finish(w);
 
     free(scheme);
     free(colors);
-    free((char *)response);
-    cJSON_Delete(root);
 
-    return ESP_OK;
+    return w->result;
 }
 
 // POST /api/theme handler
@@ -98,11 +135,16 @@ static esp_err_t theme_post_handler(httpd_req_t *req)
 
     // Update theme settings
     cJSON *item;
-    if ((item = cJSON_GetObjectItem(root, "colorScheme")) != NULL) {
+    if ((item = cJSON_GetObjectItem(root, "accentColors")) != NULL && !cJSON_IsObject(item)) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "accentColors must be an object");
+        return ESP_FAIL;
+    }
+    if ((item = cJSON_GetObjectItem(root, "colorScheme")) != NULL && cJSON_IsString(item)) {
         nvs_config_set_string(NVS_CONFIG_THEME_SCHEME, item->valuestring);
     }
     if ((item = cJSON_GetObjectItem(root, "accentColors")) != NULL) {
-        char *colors_str = cJSON_Print(item);
+        char *colors_str = cJSON_PrintUnformatted(item);
         nvs_config_set_string(NVS_CONFIG_THEME_COLORS, colors_str);
         free(colors_str);
     }
@@ -0,0 +1,212 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "mbedtls/sha256.h"
+
+#include "upload_pipeline.h"
+
+static const char * TAG = "upload";
+
+#define UPLOAD_BUFFER_CNT 2
+#define WRITER_STACK_SIZE 4096
+
+typedef struct chunk {
+    uint8_t* data; // NULL tells the writer to stop.
+    size_t len;
+} chunk_t;
+
+typedef struct pipeline {
+    QueueHandle_t full;
+    QueueHandle_t empty;
+    SemaphoreHandle_t done;
+    upload_write_fn write;
+    void* ctx;
+    mbedtls_sha256_context sha;
+    int64_t writeTimeUs;
+    volatile esp_err_t err;
+} pipeline_t;
+
+static void writer_task(void* pvParameters) {
+    pipeline_t* const p = (pipeline_t*)pvParameters;
+
+    while (true) {
+        chunk_t chunk;
+        xQueueReceive(p->full, &chunk, portMAX_DELAY);
+        if (chunk.data == NULL) {
+            break;
+        }
+        // After an error, just hand the buffers back until told to stop.
+        if (p->err == ESP_OK) {
+            mbedtls_sha256_update(&p->sha, chunk.data, chunk.len);
+            const int64_t start = esp_timer_get_time();
+            p->err = p->write(p->ctx, chunk.data, chunk.len);
+            p->writeTimeUs += esp_timer_get_time() - start;
+        }
+        xQueueSend(p->empty, &chunk, portMAX_DELAY);
+    }
+
+    xSemaphoreGive(p->done);
+    vTaskDelete(NULL);
+}
+
+/*
+    Fills the chunk from the request.
+    Returns false if receiving failed.
+*/
+static bool fill_chunk(httpd_req_t* const req, chunk_t* const chunk, size_t* const remaining) {
+    chunk->len = 0;
+    while (chunk->len < UPLOAD_BUFFER_SIZE && *remaining > 0) {
+        const size_t want = MIN(*remaining, UPLOAD_BUFFER_SIZE - chunk->len);
+        const int recv_len = httpd_req_recv(req, (char*)chunk->data + chunk->len, want);
+
+        // Timeout Error: Just retry
+        if (recv_len == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        } else if (recv_len <= 0) {
+            return false;
+        }
+
+        chunk->len += recv_len;
+        *remaining -= recv_len;
+    }
+    return true;
+}
+
+esp_err_t upload_receive(httpd_req_t* const req, const upload_write_fn write, void* const ctx,
+                         const upload_progress_fn progress, upload_result_t* const result) {
+
+    memset(result, 0, sizeof(*result));
+    const int64_t startTime = esp_timer_get_time();
+
+    pipeline_t p = {
+        .write = write,
+        .ctx = ctx,
+        .err = ESP_OK,
+    };
+    // Freed below on every path, also if the writer never started.
+    mbedtls_sha256_init(&p.sha);
+
+    uint8_t* const mem = malloc(UPLOAD_BUFFER_SIZE * UPLOAD_BUFFER_CNT);
+    // Room for all buffers plus the stop marker.
+    p.full = xQueueCreate(UPLOAD_BUFFER_CNT + 1, sizeof(chunk_t));
+    p.empty = xQueueCreate(UPLOAD_BUFFER_CNT, sizeof(chunk_t));
+    p.done = xSemaphoreCreateBinary();
+
+    esp_err_t err = ESP_OK;
+    TaskHandle_t writer = NULL;
+    if (!mem || !p.full || !p.empty || !p.done) {
+        err = ESP_ERR_NO_MEM;
+    } else {
+        mbedtls_sha256_starts(&p.sha, 0);
+        if (xTaskCreate(writer_task, "upload_writer", WRITER_STACK_SIZE, &p, uxTaskPriorityGet(NULL), &writer) != pdPASS) {
+            err = ESP_ERR_NO_MEM;
+        }
+    }
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set up upload pipeline");
+        result->writeFailed = true;
+    } else {
+        for (unsigned i = 0; i < UPLOAD_BUFFER_CNT; ++i) {
+            const chunk_t chunk = {.data = mem + i * UPLOAD_BUFFER_SIZE, .len = 0};
+            xQueueSend(p.empty, &chunk, 0);
+        }
+
+        size_t remaining = req->content_len;
+        while (remaining > 0 && p.err == ESP_OK) {
+            chunk_t chunk;
+            xQueueReceive(p.empty, &chunk, portMAX_DELAY);
+
+            if (!fill_chunk(req, &chunk, &remaining)) {
+                err = ESP_FAIL;
+                break;
+            }
+
+            xQueueSend(p.full, &chunk, portMAX_DELAY);
+            result->received += chunk.len;
+
+            if (progress) {
+                progress(result->received, req->content_len);
+            }
+        }
+
+        // Let the writer finish the buffers still queued.
+        const chunk_t stop = {.data = NULL, .len = 0};
+        xQueueSend(p.full, &stop, portMAX_DELAY);
+        xSemaphoreTake(p.done, portMAX_DELAY);
+
+        if (p.err != ESP_OK) {
+            err = p.err;
+            result->writeFailed = true;
+        }
+
+        mbedtls_sha256_finish(&p.sha, result->sha256);
+    }
+
+    mbedtls_sha256_free(&p.sha);
+
+    if (p.done) {
+        vSemaphoreDelete(p.done);
+    }
+    if (p.empty) {
+        vQueueDelete(p.empty);
+    }
+    if (p.full) {
+        vQueueDelete(p.full);
+    }
+    free(mem);
+
+    result->writeTimeUs = p.writeTimeUs;
+    result->durationUs = esp_timer_get_time() - startTime;
+
+    return err;
+}
+
+static int hex_value(const char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+esp_err_t upload_get_expected_sha256(httpd_req_t* const req, uint8_t sha256[UPLOAD_SHA256_SIZE], bool* const present) {
+    *present = false;
+
+    const size_t len = httpd_req_get_hdr_value_len(req, UPLOAD_SHA256_HEADER);
+    if (len == 0) {
+        return ESP_OK;
+    }
+    if (len != UPLOAD_SHA256_SIZE * 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char hex[UPLOAD_SHA256_SIZE * 2 + 1];
+    if (httpd_req_get_hdr_value_str(req, UPLOAD_SHA256_HEADER, hex, sizeof(hex)) != ESP_OK) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (size_t i = 0; i < UPLOAD_SHA256_SIZE; ++i) {
+        const int hi = hex_value(hex[i * 2]);
+        const int lo = hex_value(hex[i * 2 + 1]);
+        if (hi < 0 || lo < 0) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        sha256[i] = (uint8_t)((hi << 4) | lo);
+    }
+
+    *present = true;
+    return ESP_OK;
+}
@@ -0,0 +1,71 @@
+#ifndef UPLOAD_PIPELINE_H_
+#define UPLOAD_PIPELINE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Receives the body of a (large) upload request and passes it on to a write
+    function, e.g. esp_ota_write().
+    Receiving and writing are pipelined: While one buffer is being written to
+    flash by a helper task, the next one is filled from the socket, so network
+    and flash latencies overlap instead of adding up. The SHA-256 of the body is
+    computed on the way.
+*/
+
+#define UPLOAD_BUFFER_SIZE 4096
+#define UPLOAD_SHA256_SIZE 32
+
+// Request header the client can send the expected SHA-256 in, as 64 hex digits.
+#define UPLOAD_SHA256_HEADER "X-SHA256"
+
+typedef esp_err_t (*upload_write_fn)(void* ctx, const void* data, size_t len);
+
+/**
+ * @brief Called from the receiving task after each received buffer.
+ */
+typedef void (*upload_progress_fn)(size_t received, size_t total);
+
+typedef struct upload_result {
+    uint8_t sha256[UPLOAD_SHA256_SIZE];
+    size_t received;
+    // Wall time of the whole upload.
+    int64_t durationUs;
+    // Time spent in the write function.
+    int64_t writeTimeUs;
+    // true if the write function failed, false if receiving failed.
+    bool writeFailed;
+} upload_result_t;
+
+/**
+ * @brief Receives the request body and passes it to \p write in chunks of up to
+ * UPLOAD_BUFFER_SIZE bytes, in order.
+ * 
+ * @param progress may be NULL
+ * @return ESP_OK if the whole body was received and written; otherwise the
+ * error from \p write, or ESP_FAIL if receiving failed.
+ */
+esp_err_t upload_receive(httpd_req_t* req, upload_write_fn write, void* ctx,
+                         upload_progress_fn progress, upload_result_t* result);
+
+/**
+ * @brief Reads the expected SHA-256 from the UPLOAD_SHA256_HEADER header.
+ * 
+ * @param[out] present set to whether the header was sent
+ * @return ESP_ERR_INVALID_ARG if the header is present but malformed
+ */
+esp_err_t upload_get_expected_sha256(httpd_req_t* req, uint8_t sha256[UPLOAD_SHA256_SIZE], bool* present);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UPLOAD_PIPELINE_H_
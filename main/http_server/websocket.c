@@ -10,16 +10,21 @@
 #include "freertos/queue.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
-#include "freertos/ringbuf.h"
+#include "freertos/semphr.h"
 
 #include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
 #include "esp_http_server.h"
 
 #include "websocket.h"
 #include "http_server.h"
 
 #include "websocket_intf.h"
+#include "log_ring.h"
+#include "telemetry_ws.h"
+#include "ws_commands.h"
 
 static const char * const TAG = "websocket";
 
@@ -30,10 +35,25 @@ static client_t clients[MAX_WEBSOCKET_CLIENTS];
 
 static SemaphoreHandle_t clients_mutex = NULL;
 
-static RingbufHandle_t ringbuf;
+// Log lines waiting to be sent, and the buffer they are sent from.
+static log_ring_t logRing;
+static char* logFrame;
+static StaticSemaphore_t logMutexMem;
+static SemaphoreHandle_t logMutex;
+static TaskHandle_t wsTask;
+
+static ws_log_stats_t logStats;
 
 void websocket_task(void *pvParameters);
 
+static inline void* allocPrefPSRAM(const size_t sz) {
+    void* m = heap_caps_malloc(sz, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if(m == NULL) {
+        m = heap_caps_malloc(sz, MALLOC_CAP_8BIT);
+    }
+    return m;
+}
+
 
 bool websocket_task_start(httpd_handle_t httpserver) {
     ESP_LOGI(TAG, "websocket_task starting");
@@ -42,11 +62,15 @@ bool websocket_task_start(httpd_handle_t httpserver) {
         *c = -1;
     }
 
-    ringbuf = xRingbufferCreate(WS_LOG_BUFFER_SIZE, RINGBUF_TYPE_BYTEBUF);
-    if(ringbuf == NULL) {
+    char* const ringMem = allocPrefPSRAM(WS_LOG_BUFFER_SIZE);
+    logFrame = allocPrefPSRAM(WS_LOG_BUFFER_SIZE);
+    if(ringMem == NULL || logFrame == NULL) {
         ESP_LOGE(TAG, "Error creating buffer.");
+        free(ringMem);
         goto err;
     }
+    log_ring_init(&logRing, ringMem, WS_LOG_BUFFER_SIZE);
+    logMutex = xSemaphoreCreateMutexStatic(&logMutexMem);
 
     clients_mutex = xSemaphoreCreateMutex();
     if (clients_mutex == NULL) {
@@ -54,7 +78,7 @@ bool websocket_task_start(httpd_handle_t httpserver) {
         goto err;
     }
 
-    if(xTaskCreate(websocket_task, "websocket_task", 4096, httpserver, 2, NULL) == pdFAIL) {
+    if(xTaskCreate(websocket_task, "websocket_task", 4096, httpserver, 2, &wsTask) == pdFAIL) {
         ESP_LOGE(TAG, "Failed to create websocket task.");
         goto err;
     }
@@ -67,10 +91,12 @@ bool websocket_task_start(httpd_handle_t httpserver) {
         vSemaphoreDelete(clients_mutex);
         clients_mutex = NULL; 
     }
-    if(ringbuf) {
-        vRingbufferDelete(ringbuf);
-        ringbuf = NULL;
+    if(logRing.buf) {
+        free(logRing.buf);
+        logRing.buf = NULL;
     }
+    free(logFrame);
+    logFrame = NULL;
     return false;
 }
 
@@ -82,65 +108,78 @@ bool websocket_task_start(httpd_handle_t httpserver) {
     #define UNLIKELY(x) (__builtin_expect(!!(x),0))
 #endif
 
+// Lines up to this long are copied out of the ring to echo them to the console
+// after releasing the lock; longer ones are formatted again.
+#define LOG_ECHO_MAX (128)
+
+/*
+    Formats the line directly into the log ring (dropping the oldest lines if
+    needed), wakes up the websocket task, which sends everything that
+    accumulated within WS_LOG_FLUSH_INTERVAL_MS in one frame, and echoes the
+    line to the console. The slow console write happens outside the lock, so
+    other tasks are not held up by the UART.
+    Never allocates.
+*/
 static int log_to_queue(const char *format, va_list args)
 {
+    // Includes waiting for the lock.
+    const int64_t startTime = esp_timer_get_time();
+
+    if(UNLIKELY(xTaskGetSchedulerState() != taskSCHEDULER_RUNNING ||
+       xSemaphoreTake(logMutex, pdMS_TO_TICKS(WS_LOG_LOCK_TIMEOUT_MS)) != pdTRUE)) {
+        logStats.lockTimeouts += 1;
+        return vprintf(format, args);
+    }
+
+    const bool wasEmpty = log_ring_is_empty(&logRing);
+
+    char echo[LOG_ECHO_MAX];
+    bool echoCopied = false;
     int len;
     {
+        const char* line;
+        int fullLen;
         va_list args_copy;
         va_copy(args_copy, args);
-
-        // Calculate the required buffer size +1 for \n
-        len = vsnprintf(NULL, 0, format, args_copy);
-
+        len = log_ring_vprintf(&logRing, WS_LOG_LINE_MAX, &line, &fullLen, format, args_copy);
         va_end(args_copy);
-    }
-    if(LIKELY( len >= 0 )) {
-
-        // Allocate the buffer dynamically
-        char *log_buffer = (char *)malloc(len+1); // for '\0' / '\n' 
-        if (LIKELY(log_buffer != NULL)) {
-            {
-                va_list args_copy;
-                // Format the string into the allocated buffer
-                va_copy(args_copy, args);
-                vsnprintf(log_buffer, len+1, format, args_copy);
-                va_end(args_copy);
-            }
-            // assert log_buffer[len] == '\0'
-
-            // Ensure the log message ends with a newline
-            if(len == 0 || log_buffer[len-1] != '\n') {
-                log_buffer[len] = '\n';
-                len += 1;
-            }
 
-            // Print to standard output
-            printf("%s", log_buffer);
+        // The line may be overwritten as soon as the lock is released.
+        if(LIKELY( len >= 0 && len == fullLen && (size_t)len <= sizeof(echo) )) {
+            memcpy(echo, line, len);
+            echoCopied = true;
+        }
+    }
 
+    if(LIKELY( len >= 0 )) {
+        const int64_t duration = esp_timer_get_time() - startTime;
+        logStats.lines += 1;
+        logStats.bytes += len;
+        logStats.timeUs += duration;
+        if(duration > logStats.maxTimeUs) {
+            logStats.maxTimeUs = duration;
+        }
 
-            char* lb = log_buffer;
+        if(wasEmpty) {
+            xTaskNotifyGive(wsTask);
+        }
+    }
 
-            if(UNLIKELY(len > WS_LOG_BUFFER_SIZE)) {
-                lb = lb + len - WS_LOG_BUFFER_SIZE;
-                len = WS_LOG_BUFFER_SIZE;
-                lb[0] = ' ';
-                lb[1] = '.';
-                lb[2] = '.';
-                lb[3] = '.';
-                lb[4] = ' ';
-            }
+    xSemaphoreGive(logMutex);
 
-            xRingbufferSend(ringbuf,lb,len,pdMS_TO_TICKS(100));
+    if(LIKELY( echoCopied )) {
+        fwrite(echo, 1, len, stdout);
+    } else if(len >= 0) {
+        // Overlong line; format it again.
+        vprintf(format, args);
+    }
 
-            free(log_buffer);
+    return len;
+}
 
-        } else {
-            // Nope:
-            // ESP_LOGE(TAG, "Failed to allocate memory for log buffer");
-            printf("Failed to allocate memory for log buffer.\n");
-        }
-    } // if len >= 0
-    return 0;
+void websocket_get_log_stats(ws_log_stats_t* const stats) {
+    *stats = logStats;
+    stats->dropped += logRing.dropped;
 }
 
 
@@ -235,6 +274,7 @@ void websocket_close_fn(httpd_handle_t hd, int fd)
 {
     ESP_LOGI(TAG, "WebSocket client disconnected, fd: %d", fd);
     remove_client(fd);
+    telemetry_remove_client(fd);
     close(fd);
 }
 
@@ -285,32 +325,32 @@ esp_err_t websocket_handler(httpd_req_t *req)
         return ret;
     }
 
-    uint8_t *buf = (uint8_t *)calloc(ws_pkt.len, sizeof(uint8_t));
-    if (buf == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate memory for WebSocket frame buffer");
+    if (ws_pkt.len >= WS_COMMAND_MAX_SIZE) {
+        ESP_LOGW(TAG, "WebSocket frame too long from fd: %d", httpd_req_to_sockfd(req));
         remove_client(httpd_req_to_sockfd(req));
-        return ESP_FAIL;
+        return ESP_ERR_INVALID_SIZE;
     }
 
-    ws_pkt.payload = buf;
-    ret = httpd_ws_recv_frame(req, &ws_pkt, ws_pkt.len);
+    char buf[WS_COMMAND_MAX_SIZE];
+    ws_pkt.payload = (uint8_t*)buf;
+    ret = httpd_ws_recv_frame(req, &ws_pkt, sizeof(buf) - 1);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "WebSocket frame receive failed: %s", esp_err_to_name(ret));
-        free(buf);
         remove_client(httpd_req_to_sockfd(req));
         return ret;
     }
+    buf[ws_pkt.len] = '\0';
 
     if (ws_pkt.type == HTTPD_WS_TYPE_CLOSE) {
         ESP_LOGI(TAG, "WebSocket close frame received, fd: %d", httpd_req_to_sockfd(req));
-        free(buf);
         remove_client(httpd_req_to_sockfd(req));
         return ESP_OK;
     }
 
-    // TODO: Handle incoming packets here
+    if (ws_pkt.type == HTTPD_WS_TYPE_TEXT) {
+        return ws_command_handle(req, buf);
+    }
 
-    free(buf);
     return ESP_OK;
 }
 
@@ -318,6 +358,16 @@ static inline bool have_clients(void) {
     return websocket_get_client_count() != 0;
 }
 
+static size_t take_log_lines(void) {
+    size_t len = 0;
+    if(xSemaphoreTake(logMutex, portMAX_DELAY) == pdTRUE) {
+        logStats.dropped += logRing.dropped;
+        len = log_ring_read(&logRing, logFrame, WS_LOG_BUFFER_SIZE);
+        xSemaphoreGive(logMutex);
+    }
+    return len;
+}
+
 void websocket_task(void *pvParameters)
 {
     httpd_handle_t https_handle = (httpd_handle_t)pvParameters;
@@ -325,11 +375,15 @@ void websocket_task(void *pvParameters)
     httpd_ws_frame_t ws_pkt;
     memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
     ws_pkt.type = HTTPD_WS_TYPE_TEXT;
+    ws_pkt.payload = (uint8_t*)logFrame;
 
     while (true) {
 
-        ws_pkt.payload = (uint8_t*)xRingbufferReceiveUpTo(ringbuf,&ws_pkt.len,portMAX_DELAY,WS_LOG_BUFFER_SIZE);
-        if(LIKELY(ws_pkt.payload)) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        // Let more lines accumulate, to send them all in one frame.
+        vTaskDelay(pdMS_TO_TICKS(WS_LOG_FLUSH_INTERVAL_MS));
+
+        while((ws_pkt.len = take_log_lines()) != 0) {
             if( have_clients() && xSemaphoreTake(clients_mutex, pdMS_TO_TICKS(100)) != pdFAIL ) {
 
                 for (int i = 0; i < MAX_WEBSOCKET_CLIENTS; i++) {
@@ -343,8 +397,8 @@ void websocket_task(void *pvParameters)
                 }
 
                 xSemaphoreGive(clients_mutex);
+                logStats.frames += 1;
             }
-            vRingbufferReturnItem(ringbuf,ws_pkt.payload);
         }
     }
 }
@@ -2,16 +2,35 @@
 #define WEBSOCKET_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "esp_err.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
 #define WS_LOG_BUFFER_SIZE      (4096)
+#define WS_LOG_LINE_MAX         (512) // Longer log lines are truncated for websocket clients.
+#define WS_LOG_FLUSH_INTERVAL_MS (100)
+#define WS_LOG_LOCK_TIMEOUT_MS  (10)
 #define MAX_WEBSOCKET_CLIENTS   (10)
 
+typedef struct ws_log_stats {
+    uint32_t lines;
+    uint32_t dropped; // Lines dropped because clients could not keep up
+    uint32_t frames;
+    uint32_t lockTimeouts; // Lines only printed to the console
+    uint64_t bytes;
+    uint64_t timeUs; // Total time spent putting lines into the buffer
+    uint32_t maxTimeUs;
+} ws_log_stats_t;
+
 bool websocket_task_start(httpd_handle_t httpserver);
 
 esp_err_t websocket_handler(httpd_req_t * req);
 void websocket_close_fn(httpd_handle_t hd, int sockfd);
 
+/**
+ * @brief Cost and throughput of the websocket log, for diagnostics.
+ */
+void websocket_get_log_stats(ws_log_stats_t* stats);
+
 #endif /* WEBSOCKET_H_ */
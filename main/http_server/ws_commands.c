@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_http_server.h"
+#include "cJSON.h"
+
+#include "ws_commands.h"
+#include "nvs_config.h"
+#include "deflog.h"
+#include "power_management_task.h"
+
+static const char * const TAG = "ws_commands";
+
+static const char * const LOG_LEVELS[] = {
+    [ESP_LOG_NONE] = "none",
+    [ESP_LOG_ERROR] = "error",
+    [ESP_LOG_WARN] = "warn",
+    [ESP_LOG_INFO] = "info",
+    [ESP_LOG_DEBUG] = "debug",
+    [ESP_LOG_VERBOSE] = "verbose",
+};
+
+static esp_err_t send_ack(httpd_req_t* req, const double id, const char* const error)
+{
+    char buf[96];
+    int len;
+    if (error == NULL) {
+        len = snprintf(buf, sizeof(buf), "{\"id\":%.15g,\"ok\":true}", id);
+    } else {
+        len = snprintf(buf, sizeof(buf), "{\"id\":%.15g,\"ok\":false,\"error\":\"%s\"}", id, error);
+    }
+
+    httpd_ws_frame_t ws_pkt;
+    memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
+    ws_pkt.type = HTTPD_WS_TYPE_TEXT;
+    ws_pkt.payload = (uint8_t*)buf;
+    ws_pkt.len = len;
+    return httpd_ws_send_frame(req, &ws_pkt);
+}
+
+static esp_err_t persist_setting(const pm_live_setting_t setting, const float value)
+{
+    nvs_config_txn_t * const txn = nvs_config_txn_begin();
+    switch (setting) {
+        case PM_LIVE_FAN_SPEED:
+            nvs_config_txn_set_u16(txn, NVS_CONFIG_AUTO_FAN_SPEED, 0);
+            nvs_config_txn_set_u16(txn, NVS_CONFIG_FAN_SPEED, value);
+            break;
+        case PM_LIVE_FREQUENCY:
+            nvs_config_txn_set_float(txn, NVS_CONFIG_ASIC_FREQUENCY_FLOAT, value);
+            // also store as u16 for backwards compatibility
+            nvs_config_txn_set_u16(txn, NVS_CONFIG_ASIC_FREQUENCY, (int) value);
+            break;
+        case PM_LIVE_VOLTAGE:
+            nvs_config_txn_set_u16(txn, NVS_CONFIG_ASIC_VOLTAGE, value);
+            break;
+        default:
+            break;
+    }
+    return nvs_config_txn_commit(txn);
+}
+
+static const char* set_power_setting(const pm_live_setting_t setting, const cJSON* const root)
+{
+    const cJSON* const value = cJSON_GetObjectItem(root, "value");
+    if (!cJSON_IsNumber(value)) {
+        return "Missing value";
+    }
+    if (POWER_MANAGEMENT_set_live(setting, value->valuedouble) != ESP_OK) {
+        return "Invalid value";
+    }
+    if (cJSON_IsTrue(cJSON_GetObjectItem(root, "persist")) && persist_setting(setting, value->valuedouble) != ESP_OK) {
+        return "Failed to save setting";
+    }
+    return NULL;
+}
+
+static const char* set_log_level(const cJSON* const root)
+{
+    const cJSON* const tag = cJSON_GetObjectItem(root, "tag");
+    const char* const level = cJSON_GetStringValue(cJSON_GetObjectItem(root, "level"));
+    if (level == NULL || (tag != NULL && !cJSON_IsString(tag))) {
+        return "Missing level";
+    }
+    for (int i = 0; i < sizeof(LOG_LEVELS) / sizeof(LOG_LEVELS[0]); ++i) {
+        if (strcmp(level, LOG_LEVELS[i]) == 0) {
+            deflog_level_set(tag ? tag->valuestring : "*", (esp_log_level_t)i);
+            return NULL;
+        }
+    }
+    return "Invalid level";
+}
+
+esp_err_t ws_command_handle(httpd_req_t* req, const char* const json)
+{
+    cJSON* const root = cJSON_Parse(json);
+    if (root == NULL) {
+        ESP_LOGW(TAG, "Ignoring malformed command");
+        return ESP_OK;
+    }
+
+    const int64_t startTime = esp_timer_get_time();
+
+    const cJSON* const id = cJSON_GetObjectItem(root, "id");
+    const double reqId = cJSON_IsNumber(id) ? id->valuedouble : 0;
+    const char* const cmd = cJSON_GetStringValue(cJSON_GetObjectItem(root, "cmd"));
+
+    bool restart = false;
+    const char* error = NULL;
+    if (cmd == NULL) {
+        error = "Missing cmd";
+    } else if (strcmp(cmd, "fanSpeed") == 0) {
+        error = set_power_setting(PM_LIVE_FAN_SPEED, root);
+    } else if (strcmp(cmd, "frequency") == 0) {
+        error = set_power_setting(PM_LIVE_FREQUENCY, root);
+    } else if (strcmp(cmd, "coreVoltage") == 0) {
+        error = set_power_setting(PM_LIVE_VOLTAGE, root);
+    } else if (strcmp(cmd, "logLevel") == 0) {
+        error = set_log_level(root);
+    } else if (strcmp(cmd, "restart") == 0) {
+        restart = true;
+    } else {
+        error = "Unknown cmd";
+    }
+
+    if (error == NULL) {
+        ESP_LOGI(TAG, "Command %s done in %" PRId64 "us", cmd, esp_timer_get_time() - startTime);
+    } else {
+        ESP_LOGW(TAG, "Command %s failed: %s", cmd ? cmd : "?", error);
+    }
+
+    const esp_err_t ret = send_ack(req, reqId, error);
+    cJSON_Delete(root);
+
+    if (restart) {
+        ESP_LOGI(TAG, "Restarting System because of websocket command");
+        // Delay to ensure the ack is sent
+        vTaskDelay(1000 / portTICK_PERIOD_MS);
+        esp_restart();
+    }
+
+    return ret;
+}
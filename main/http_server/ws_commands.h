@@ -0,0 +1,29 @@
+#ifndef WS_COMMANDS_H_
+#define WS_COMMANDS_H_
+
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#define WS_COMMAND_MAX_SIZE (256) // Longer frames close the connection.
+
+/**
+ * @brief Executes a command received on /api/ws and sends the ack.
+ *
+ * Commands are JSON objects:
+ *   {"id":<n>, "cmd":"fanSpeed",    "value":<%>,   "persist":<bool>}
+ *   {"id":<n>, "cmd":"frequency",   "value":<MHz>, "persist":<bool>}
+ *   {"id":<n>, "cmd":"coreVoltage", "value":<mV>,  "persist":<bool>}
+ *   {"id":<n>, "cmd":"logLevel", "tag":<tag or "*">, "level":"none|error|warn|info|debug|verbose"}
+ *   {"id":<n>, "cmd":"restart"}
+ *
+ * Settings take effect immediately and last until they are saved or the device
+ * restarts; with "persist":true they are also saved to NVS. Every command is
+ * answered with {"id":<n>,"ok":true} or {"id":<n>,"ok":false,"error":"..."},
+ * the restart before it happens.
+ *
+ * @param json NUL-terminated payload of a text frame
+ */
+esp_err_t ws_command_handle(httpd_req_t* req, const char* json);
+
+#endif /* WS_COMMANDS_H_ */
@@ -0,0 +1,225 @@
+#include <string.h>
+#include <sys/param.h>
+
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+
+#include "www_archive.h"
+
+#define ARCHIVE_MAGIC "AXWA"
+#define ARCHIVE_VERSION 1
+#define FLAG_GZIP 0x0001
+
+static const char* const TAG = "www_archive";
+
+typedef struct archive_header {
+    char magic[4];
+    uint16_t version;
+    uint16_t count;
+    uint32_t size;
+    uint32_t crc;
+} archive_header_t;
+
+typedef struct archive_entry {
+    uint32_t path;
+    uint32_t data;
+    uint32_t dataSize;
+    uint16_t pathLen;
+    uint16_t flags;
+    uint8_t hash[WWW_ARCHIVE_HASH_SIZE];
+} archive_entry_t;
+
+_Static_assert(sizeof(archive_header_t) == 16, "Archive header layout mismatch.");
+_Static_assert(sizeof(archive_entry_t) == 24, "Archive entry layout mismatch.");
+_Static_assert(sizeof(((www_update_t*)0)->header) == sizeof(archive_header_t), "Update header size mismatch.");
+
+static const uint8_t* archive = NULL;
+static esp_partition_mmap_handle_t archiveMap;
+
+static inline const archive_header_t* getHeader(void) {
+    return (const archive_header_t*)archive;
+}
+
+static inline const archive_entry_t* getEntries(void) {
+    return (const archive_entry_t*)(archive + sizeof(archive_header_t));
+}
+
+static inline const esp_partition_t* findPartition(void) {
+    return esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, "www");
+}
+
+static bool isArchiveHeader(const archive_header_t* const header, const size_t maxSize) {
+    return memcmp(header->magic, ARCHIVE_MAGIC, sizeof(header->magic)) == 0 &&
+        header->version == ARCHIVE_VERSION &&
+        header->size >= sizeof(archive_header_t) + header->count * sizeof(archive_entry_t) &&
+        header->size <= maxSize;
+}
+
+static bool entriesValid(const uint8_t* const base, const archive_header_t* const header) {
+    const archive_entry_t* const entries = (const archive_entry_t*)(base + sizeof(archive_header_t));
+    for(unsigned i = 0; i < header->count; ++i) {
+        const archive_entry_t* const e = entries + i;
+        if(e->path >= header->size || e->pathLen >= header->size - e->path ||
+           base[e->path + e->pathLen] != '\0' ||
+           e->data > header->size || e->dataSize > header->size - e->data) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static inline uint32_t bodyCrc(const uint8_t* const base, const size_t size) {
+    return esp_rom_crc32_le(0, base + sizeof(archive_header_t), size - sizeof(archive_header_t));
+}
+
+esp_err_t www_archive_open(void) {
+    if(archive) {
+        return ESP_OK;
+    }
+
+    const esp_partition_t* const part = findPartition();
+    if(part == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    archive_header_t header;
+    esp_err_t r = esp_partition_read(part, 0, &header, sizeof(header));
+    if(r != ESP_OK) {
+        return r;
+    }
+    if(!isArchiveHeader(&header, part->size)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    const void* ptr;
+    r = esp_partition_mmap(part, 0, header.size, ESP_PARTITION_MMAP_DATA, &ptr, &archiveMap);
+    if(r != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to map archive (%s)", esp_err_to_name(r));
+        return r;
+    }
+
+    if(bodyCrc(ptr, header.size) != header.crc || !entriesValid(ptr, &header)) {
+        ESP_LOGE(TAG, "Archive is corrupt.");
+        esp_partition_munmap(archiveMap);
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    archive = ptr;
+    ESP_LOGI(TAG, "Mapped web UI archive: %u files, %" PRIu32 " bytes", header.count, header.size);
+    return ESP_OK;
+}
+
+void www_archive_close(void) {
+    if(archive) {
+        archive = NULL;
+        esp_partition_munmap(archiveMap);
+    }
+}
+
+bool www_archive_is_open(void) {
+    return archive != NULL;
+}
+
+bool www_archive_find(const char* const path, www_file_t* const file) {
+    if(archive == NULL) {
+        return false;
+    }
+    const archive_entry_t* const entries = getEntries();
+    // Binary search; the index is sorted by path.
+    unsigned lo = 0;
+    unsigned hi = getHeader()->count;
+    while(lo < hi) {
+        const unsigned mid = lo + (hi - lo) / 2;
+        const archive_entry_t* const e = entries + mid;
+        const int c = strcmp(path, (const char*)archive + e->path);
+        if(c == 0) {
+            file->data = archive + e->data;
+            file->size = e->dataSize;
+            file->gzip = (e->flags & FLAG_GZIP) != 0;
+            memcpy(file->hash, e->hash, sizeof(file->hash));
+            return true;
+        } else if(c < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return false;
+}
+
+esp_err_t www_update_begin(www_update_t* const update, const size_t size) {
+    if(archive) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    memset(update, 0, sizeof(*update));
+    update->part = findPartition();
+    if(update->part == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if(size > update->part->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return esp_partition_erase_range(update->part, 0, update->part->size);
+}
+
+esp_err_t www_update_write(www_update_t* const update, const void* const data, const size_t len) {
+    const uint8_t* src = data;
+    size_t remaining = len;
+
+    // Hold back the header.
+    if(update->received < sizeof(update->header)) {
+        const size_t n = MIN(remaining, sizeof(update->header) - update->received);
+        memcpy(update->header + update->received, src, n);
+        update->received += n;
+        src += n;
+        remaining -= n;
+    }
+
+    if(remaining == 0) {
+        return ESP_OK;
+    }
+
+    if(remaining > update->part->size - update->received) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const archive_header_t* const header = (const archive_header_t*)update->header;
+    if(update->received < header->size) {
+        update->crc = esp_rom_crc32_le(update->crc, src, MIN(remaining, header->size - update->received));
+    }
+
+    const esp_err_t r = esp_partition_write(update->part, update->received, src, remaining);
+    update->received += remaining;
+    return r;
+}
+
+esp_err_t www_update_end(www_update_t* const update) {
+    if(update->received < sizeof(update->header)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const archive_header_t* const header = (const archive_header_t*)update->header;
+    if(memcmp(header->magic, ARCHIVE_MAGIC, sizeof(header->magic)) == 0) {
+        if(!isArchiveHeader(header, update->received) || update->crc != header->crc) {
+            ESP_LOGE(TAG, "Received archive is corrupt.");
+            return ESP_ERR_INVALID_CRC;
+        }
+
+        // Read back what was written before committing it.
+        const void* ptr;
+        esp_partition_mmap_handle_t map;
+        esp_err_t r = esp_partition_mmap(update->part, 0, header->size, ESP_PARTITION_MMAP_DATA, &ptr, &map);
+        if(r != ESP_OK) {
+            return r;
+        }
+        const bool ok = bodyCrc(ptr, header->size) == header->crc && entriesValid(ptr, header);
+        esp_partition_munmap(map);
+        if(!ok) {
+            ESP_LOGE(TAG, "Archive verification failed.");
+            return ESP_ERR_INVALID_CRC;
+        }
+    }
+
+    // Committing: Only now does the partition hold a valid image.
+    return esp_partition_write(update->part, 0, update->header, sizeof(update->header));
+}
@@ -0,0 +1,81 @@
+#ifndef WWW_ARCHIVE_H_
+#define WWW_ARCHIVE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_partition.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    Read-only archive of the web UI in the "www" partition, as generated by
+    tools/wwwpack.py (see there for the format).
+    The archive is memory-mapped, so file contents can be passed to the HTTP
+    server directly from flash.
+*/
+
+#define WWW_ARCHIVE_HASH_SIZE 8
+
+typedef struct www_file {
+    const uint8_t* data; // Points into the mapped flash.
+    size_t size;
+    bool gzip;
+    uint8_t hash[WWW_ARCHIVE_HASH_SIZE];
+} www_file_t;
+
+/**
+ * @brief Maps and validates the archive in the www partition.
+ * 
+ * @return ESP_ERR_NOT_FOUND if the partition doesn't contain an archive,
+ * e.g. because it holds a SPIFFS image.
+ */
+esp_err_t www_archive_open(void);
+
+void www_archive_close(void);
+
+bool www_archive_is_open(void);
+
+/**
+ * @brief Looks up the file at \p path, e.g. "/index.html".
+ */
+bool www_archive_find(const char* path, www_file_t* file);
+
+/**
+ * @brief State of an update of the www partition.
+ * The first bytes of the image are only written once everything else has been
+ * written and verified, so an interrupted update never leaves a valid-looking
+ * archive behind.
+ */
+typedef struct www_update {
+    const esp_partition_t* part;
+    size_t received;
+    uint32_t crc;
+    uint8_t header[16];
+} www_update_t;
+
+/**
+ * @brief Erases the www partition to receive a new image of \p size bytes.
+ * The archive must have been closed.
+ */
+esp_err_t www_update_begin(www_update_t* update, size_t size);
+
+esp_err_t www_update_write(www_update_t* update, const void* data, size_t len);
+
+/**
+ * @brief Verifies the received image and commits it.
+ * Images which are not archives (i.e. SPIFFS images) are written as they are.
+ * 
+ * @return ESP_ERR_INVALID_CRC if the archive is corrupt.
+ */
+esp_err_t www_update_end(www_update_t* update);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WWW_ARCHIVE_H_
@@ -23,6 +23,8 @@
 #include "cjson_helper.h"
 
 #include "mem_search.h"
+#include "deflog.h"
+#include "pool_trim.h"
 
 GlobalState GLOBAL_STATE;
 
@@ -45,6 +47,12 @@ void app_main(void)
         cjson_use_psram(true);
     }
 
+    if (deflog_init() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start deferred logging");
+    }
+
+    pool_trim_init();
+
     // Init I2C
     ESP_ERROR_CHECK(i2c_bitaxe_init());
     ESP_LOGI(TAG, "I2C initialized successfully");
@@ -2,9 +2,11 @@
 #include "esp_log.h"
 #include "nvs.h"
 #include <string.h>
+#include <stdlib.h>
 #include <functional>
 #include <string_view>
 #include <atomic>
+#include <type_traits>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
@@ -19,6 +21,26 @@ static const char * const TAG = "nvs_config";
 
 static constexpr EventBits_t EB_CONFIG_CHANGED = (1<<0);
 
+// Max. number of keys held in the RAM snapshot; there are about 50 keys in use.
+static constexpr std::size_t SNAPSHOT_MAX_ENTRIES = 64;
+
+// Max. length of a string value NVS can store, including the terminating NUL.
+static constexpr std::size_t NVS_STR_MAX_SIZE = 4000;
+
+static void format_float(char (&out)[FLOAT_STR_LEN], const float value) {
+    snprintf(out, sizeof(out), "%.6f", value);
+}
+
+static bool parse_float(const char* const str, float& out_value) {
+    char *endptr;
+    const float value = strtof(str, &endptr);
+    if (endptr == str || *endptr != '\0') {
+        return false;
+    }
+    out_value = value;
+    return true;
+}
+
 
 template<typename T, auto R, auto W>
 struct NVS_ops {
@@ -65,7 +87,7 @@ template<>
 struct NVS_op<float> {
     static esp_err_t write(nvs_handle_t handle, const char* const key, const float value) {
         char str_value[FLOAT_STR_LEN];
-        snprintf(str_value, sizeof(str_value), "%.6f", value);
+        format_float(str_value, value);
         return NVS_op<char*>::write(handle,key,str_value);
     }
     static esp_err_t read(nvs_handle_t handle, const char* const key, float& out_value) {
@@ -77,13 +99,10 @@ struct NVS_op<float> {
 
         if(r == ESP_OK) {
             if(sz != 0) {
-                char *endptr;
-                float value = strtof(str_value, &endptr);
-                if (endptr == str_value || *endptr != '\0') {
+                if (!parse_float(str_value, out_value)) {
                     ESP_LOGW(TAG, "Invalid float format for key %s: %s", key, str_value);
                     return ESP_FAIL;
                 }
-                out_value = value;
             } else {
                 r = ESP_ERR_NOT_FOUND;
             }
@@ -93,6 +112,412 @@ struct NVS_op<float> {
 };
 
 
+/**
+ * @brief RAM copy of all values in the config namespace.
+ *
+ * Reading a value from NVS means looking the key up in the flash pages, and
+ * strings and floats (which are stored as strings) need an extra copy. Since the
+ * config is read far more often than it is written, all values are read into
+ * RAM once and updated on every write; floats are parsed when they are stored.
+ *
+ * Not thread-safe; NvsCtx only accesses it with its mutex held.
+ */
+class Snapshot {
+    public:
+
+    Snapshot() = default;
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot(Snapshot&&) = delete;
+
+    ~Snapshot() {
+        clear();
+    }
+
+    /**
+     * @brief Reads all entries of the namespace from NVS.
+     *
+     * @return false if the snapshot could not be loaded; readers must go to
+     * NVS directly then.
+     */
+    bool load(const nvs_handle_t handle) {
+        clear();
+
+        nvs_iterator_t it = nullptr;
+        esp_err_t r = nvs_entry_find(NVS_DEFAULT_PART_NAME, NVS_CONFIG_NAMESPACE, NVS_TYPE_ANY, &it);
+        while(r == ESP_OK) {
+            nvs_entry_info_t info;
+            nvs_entry_info(it, &info);
+            if(!loadEntry(handle, info.key, info.type)) {
+                complete = false;
+            }
+            r = nvs_entry_next(&it);
+        }
+        nvs_release_iterator(it);
+
+        if(r != ESP_ERR_NVS_NOT_FOUND) {
+            ESP_LOGW(TAG, "Failed to read config snapshot: %d", r);
+            clear();
+            return false;
+        }
+
+        loaded = true;
+        ESP_LOGI(TAG, "Config snapshot: %u entries%s", (unsigned)cnt, complete ? "" : " (incomplete)");
+        return true;
+    }
+
+    bool isLoaded(void) const {
+        return loaded;
+    }
+
+    /**
+     * @brief Looks up \p key.
+     *
+     * @return ESP_OK if found, ESP_ERR_NVS_TYPE_MISMATCH if the stored value has a
+     * different type, ESP_ERR_NVS_NOT_FOUND if there is no such key and
+     * ESP_ERR_INVALID_STATE if the key may exist but is not in the snapshot.
+     */
+    template<typename T>
+    esp_err_t get(const char* const key, T& out_value) const {
+        const Entry* const e = find(key);
+        if(!e) {
+            return complete ? ESP_ERR_NVS_NOT_FOUND : ESP_ERR_INVALID_STATE;
+        }
+        if constexpr (std::is_same_v<T,float>) {
+            if(e->type != NVS_TYPE_STR) {
+                return ESP_ERR_NVS_TYPE_MISMATCH;
+            }
+            if(e->str[0] == '\0') {
+                return ESP_ERR_NVS_NOT_FOUND;
+            }
+            if(!e->isFloat) {
+                ESP_LOGW(TAG, "Invalid float format for key %s: %s", key, e->str);
+                return ESP_FAIL;
+            }
+            out_value = e->f;
+        } else if constexpr (std::is_same_v<T,const char*>) {
+            if(e->type != NVS_TYPE_STR) {
+                return ESP_ERR_NVS_TYPE_MISMATCH;
+            }
+            out_value = e->str;
+        } else {
+            if(e->type != Type<T>::value) {
+                return ESP_ERR_NVS_TYPE_MISMATCH;
+            }
+            out_value = (T)e->u;
+        }
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Returns true if \p key may have been written to after the mod count
+     * was \p modCnt.
+     */
+    bool isChangedSince(const char* const key, const uint32_t modCnt) const {
+        const Entry* const e = find(key);
+        if(!e) {
+            return !complete;
+        }
+        return (int32_t)(e->modCnt - modCnt) > 0;
+    }
+
+    /**
+     * @brief Stores a value which was just written to NVS.
+     *
+     * @param modCnt the mod count the config has with this value
+     */
+    template<typename T>
+    void set(const char* const key, const T value, const uint32_t modCnt = 0) {
+        if constexpr (std::is_same_v<T,float>) {
+            char str_value[FLOAT_STR_LEN];
+            format_float(str_value, value);
+            set<const char*>(key, str_value, modCnt);
+        } else if constexpr (std::is_same_v<T,const char*>) {
+            char* const str = strdup(value);
+            Entry* const e = str ? insert(key) : nullptr;
+            if(!e) {
+                free(str);
+                // The snapshot would be stale now, so let readers go to NVS.
+                complete = false;
+                remove(key);
+                return;
+            }
+            e->type = NVS_TYPE_STR;
+            e->modCnt = modCnt;
+            e->str = str;
+            e->isFloat = parse_float(str, e->f);
+        } else {
+            Entry* const e = insert(key);
+            if(!e) {
+                complete = false;
+                return;
+            }
+            e->type = Type<T>::value;
+            e->modCnt = modCnt;
+            e->u = (uint64_t)value;
+        }
+    }
+
+    private:
+
+    template<typename T>
+    struct Type {};
+
+    struct Entry {
+        char key[NVS_KEY_NAME_MAX_SIZE];
+        nvs_type_t type;
+        bool isFloat;
+        float f;
+        uint64_t u;
+        char* str;
+        uint32_t modCnt;
+    };
+
+    // Sorted by key.
+    Entry entries[SNAPSHOT_MAX_ENTRIES] {};
+    std::size_t cnt {0};
+    bool loaded {false};
+    // false if some keys could not be added, which then need to be read from NVS.
+    bool complete {true};
+
+    void clear(void) {
+        for(std::size_t i = 0; i < cnt; ++i) {
+            free(entries[i].str);
+        }
+        cnt = 0;
+        loaded = false;
+        complete = true;
+    }
+
+    std::size_t lowerBound(const char* const key) const {
+        std::size_t lo = 0;
+        std::size_t hi = cnt;
+        while(lo < hi) {
+            const std::size_t mid = (lo + hi) / 2;
+            if(strcmp(entries[mid].key, key) < 0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    const Entry* find(const char* const key) const {
+        const std::size_t i = lowerBound(key);
+        if(i < cnt && strcmp(entries[i].key, key) == 0) {
+            return &entries[i];
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Returns the (cleared) entry for \p key, adding it if needed.
+     *
+     * @return nullptr if the key is too long or the snapshot is full
+     */
+    Entry* insert(const char* const key) {
+        if(strlen(key) >= NVS_KEY_NAME_MAX_SIZE) {
+            return nullptr;
+        }
+        const std::size_t i = lowerBound(key);
+        if(i >= cnt || strcmp(entries[i].key, key) != 0) {
+            if(cnt >= SNAPSHOT_MAX_ENTRIES) {
+                return nullptr;
+            }
+            memmove(&entries[i+1], &entries[i], (cnt - i) * sizeof(Entry));
+            cnt += 1;
+            strcpy(entries[i].key, key);
+        } else {
+            free(entries[i].str);
+        }
+        Entry& e = entries[i];
+        e.str = nullptr;
+        e.isFloat = false;
+        e.f = 0;
+        e.u = 0;
+        e.modCnt = 0;
+        return &e;
+    }
+
+    void remove(const char* const key) {
+        const std::size_t i = lowerBound(key);
+        if(i < cnt && strcmp(entries[i].key, key) == 0) {
+            free(entries[i].str);
+            memmove(&entries[i], &entries[i+1], (cnt - i - 1) * sizeof(Entry));
+            cnt -= 1;
+        }
+    }
+
+    bool loadEntry(const nvs_handle_t handle, const char* const key, const nvs_type_t type) {
+        switch(type) {
+            case NVS_TYPE_U16:
+                return loadValue<uint16_t>(handle, key);
+            case NVS_TYPE_I32:
+                return loadValue<int32_t>(handle, key);
+            case NVS_TYPE_U64:
+                return loadValue<uint64_t>(handle, key);
+            case NVS_TYPE_STR: {
+                size_t size = 0;
+                if(nvs_get_str(handle, key, nullptr, &size) != ESP_OK) {
+                    return false;
+                }
+                char* const str = (char*)malloc(size);
+                if(!str || nvs_get_str(handle, key, str, &size) != ESP_OK) {
+                    free(str);
+                    return false;
+                }
+                set<const char*>(key, str);
+                free(str);
+                return find(key) != nullptr;
+            }
+            default:
+                // Not used by the config API, reading it gives the default value.
+                return true;
+        }
+    }
+
+    template<typename T>
+    bool loadValue(const nvs_handle_t handle, const char* const key) {
+        T value;
+        if(NVS_op<T>::read(handle, key, value) != ESP_OK) {
+            return false;
+        }
+        set<T>(key, value);
+        return find(key) != nullptr;
+    }
+
+};
+
+template<>
+struct Snapshot::Type<uint16_t> : std::integral_constant<nvs_type_t,NVS_TYPE_U16> {};
+
+template<>
+struct Snapshot::Type<int32_t> : std::integral_constant<nvs_type_t,NVS_TYPE_I32> {};
+
+template<>
+struct Snapshot::Type<uint64_t> : std::integral_constant<nvs_type_t,NVS_TYPE_U64> {};
+
+
+/**
+ * @brief Values staged for writing with nvs_config_txn_commit().
+ */
+struct nvs_config_txn {
+
+    struct Op {
+        char key[NVS_KEY_NAME_MAX_SIZE];
+        nvs_type_t type;
+        bool isFloat;
+        union {
+            uint16_t u16;
+            int32_t i32;
+            uint64_t u64;
+            float f;
+        };
+        char* str;
+
+        /**
+         * @brief Calls \p fn with the staged value in its proper type.
+         */
+        template<typename F>
+        auto visit(F&& fn) const {
+            switch(type) {
+                case NVS_TYPE_U16:
+                    return fn(u16);
+                case NVS_TYPE_I32:
+                    return fn(i32);
+                case NVS_TYPE_U64:
+                    return fn(u64);
+                default:
+                    if(isFloat) {
+                        return fn(f);
+                    } else {
+                        return fn((const char*)str);
+                    }
+            }
+        }
+    };
+
+    Op ops[NVS_CONFIG_TXN_MAX_KEYS];
+    std::size_t cnt;
+    // The first error while staging; a transaction with an error is not written.
+    esp_err_t err;
+
+    /**
+     * @brief Returns the op for \p key to be (re)filled, or nullptr after
+     * recording an error.
+     */
+    Op* stage(const char* const key) {
+        if(err != ESP_OK) {
+            return nullptr;
+        }
+        if(!key || strlen(key) >= NVS_KEY_NAME_MAX_SIZE) {
+            ESP_LOGW(TAG, "Invalid NVS key \"%s\"", key ? key : "");
+            err = ESP_ERR_INVALID_ARG;
+            return nullptr;
+        }
+        for(std::size_t i = 0; i < cnt; ++i) {
+            if(strcmp(ops[i].key, key) == 0) {
+                // Staged before; the last value wins.
+                free(ops[i].str);
+                ops[i].str = nullptr;
+                return &ops[i];
+            }
+        }
+        if(cnt >= NVS_CONFIG_TXN_MAX_KEYS) {
+            ESP_LOGW(TAG, "Too many keys in transaction, \"%s\" not staged", key);
+            err = ESP_ERR_INVALID_SIZE;
+            return nullptr;
+        }
+        Op* const op = &ops[cnt++];
+        strcpy(op->key, key);
+        op->str = nullptr;
+        return op;
+    }
+
+    template<typename T>
+    void set(const char* const key, const T value) {
+        Op* const op = stage(key);
+        if(!op) {
+            return;
+        }
+        op->isFloat = false;
+        if constexpr (std::is_same_v<T,float>) {
+            op->type = NVS_TYPE_STR;
+            op->isFloat = true;
+            op->f = value;
+        } else if constexpr (std::is_same_v<T,const char*>) {
+            op->type = NVS_TYPE_STR;
+            if(!value || strlen(value) >= NVS_STR_MAX_SIZE) {
+                ESP_LOGW(TAG, "Invalid string value for key \"%s\"", key);
+                err = ESP_ERR_INVALID_ARG;
+                return;
+            }
+            op->str = strdup(value);
+            if(!op->str) {
+                err = ESP_ERR_NO_MEM;
+            }
+        } else if constexpr (std::is_same_v<T,uint16_t>) {
+            op->type = NVS_TYPE_U16;
+            op->u16 = value;
+        } else if constexpr (std::is_same_v<T,int32_t>) {
+            op->type = NVS_TYPE_I32;
+            op->i32 = value;
+        } else {
+            static_assert(std::is_same_v<T,uint64_t>);
+            op->type = NVS_TYPE_U64;
+            op->u64 = value;
+        }
+    }
+
+    void release(void) {
+        for(std::size_t i = 0; i < cnt; ++i) {
+            free(ops[i].str);
+        }
+        free(this);
+    }
+
+};
 
 class NvsCtx {
     public:
@@ -128,6 +553,18 @@ class NvsCtx {
 
     template<typename T>
     T get(const char* const key, const T default_value) {
+        {
+            freertos::Lck lck {acquire()};
+            T val;
+            switch(readSnapshot(key,val)) {
+                case ESP_OK:
+                    return val;
+                case ESP_ERR_INVALID_STATE:
+                    break;
+                default:
+                    return default_value;
+            }
+        }
         return readNvs<NVS_op<T>::read>(key,default_value);
     }
 
@@ -140,6 +577,22 @@ class NvsCtx {
         return this->modCnt.load(std::memory_order::relaxed);
     }
 
+    bool isChangedSince(const char* const key, const uint32_t since) {
+        freertos::Lck lck {acquire()};
+        if(!ensureSnapshot()) {
+            return true;
+        }
+        return snapshot.isChangedSince(key,since);
+    }
+
+    /**
+     * @brief Writes all staged values of \p txn and commits them at once.
+     *
+     * @return the first error; values written before the error was hit stay
+     * written.
+     */
+    esp_err_t commitTxn(const nvs_config_txn& txn);
+
     bool waitForModification(const TickType_t maxWait) {
         return egrp.waitForAnyBit(EB_CONFIG_CHANGED) == EB_CONFIG_CHANGED;
     }
@@ -151,12 +604,88 @@ class NvsCtx {
         return std::invoke(F,doGetHandle(), std::forward<Args>(args)...);
     }
 
+    /**
+     * @brief Returns a malloc'ed copy of the string value of \p key, or of
+     * \p default_value if there is none.
+     */
+    char* get_str(const char* const key, const char* const default_value) {
+        {
+            freertos::Lck lck {acquire()};
+            const char* val;
+            switch(readSnapshot(key,val)) {
+                case ESP_OK:
+                    return strdup(val);
+                case ESP_ERR_INVALID_STATE:
+                    break;
+                default:
+                    return strdup(default_value);
+            }
+        }
+        return execRead<readStr>(key,default_value);
+    }
+
     private:
 
     freertos::Mutex mutex {};
     nvs_handle_t handle {0};
     freertos::EventGroup egrp {};
     std::atomic<uint32_t> modCnt {0};
+    Snapshot snapshot {};
+    bool snapshotFailed {false};
+
+    /**
+     * @brief Looks \p key up in the snapshot, loading the snapshot first if
+     * needed. Must be called with the mutex held.
+     *
+     * @return ESP_ERR_INVALID_STATE if the value must be read from NVS instead
+     */
+    template<typename T>
+    esp_err_t readSnapshot(const char* const key, T& out_value) {
+        if(!ensureSnapshot()) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        return snapshot.get(key,out_value);
+    }
+
+    /**
+     * @brief Loads the snapshot if that wasn't done yet. Must be called with
+     * the mutex held.
+     */
+    bool ensureSnapshot(void) {
+        if(!snapshot.isLoaded()) {
+            if(snapshotFailed) {
+                return false;
+            }
+            const nvs_handle_t h = doGetHandle();
+            if(!h) {
+                return false;
+            }
+            if(!snapshot.load(h)) {
+                snapshotFailed = true;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static char* readStr(const nvs_handle_t handle, const char* const key, const char* const default_value) {
+        size_t size = 0;
+        esp_err_t err = nvs_get_str(handle, key, NULL, &size);
+
+        if (err != ESP_OK) {
+            return strdup(default_value);
+        }
+
+        char * out = (char*)malloc(size);
+        err = nvs_get_str(handle, key, out, &size);
+
+        if (err != ESP_OK) {
+            free(out);
+            return strdup(default_value);
+        }
+
+        return out;
+    }
 
 
     nvs_handle_t doGetHandle(void) {
@@ -185,17 +714,25 @@ class NvsCtx {
         }
     }
 
+    void notifyModification(void) {
+        // Take note of the potential change in config data:
+        modCnt.fetch_add(1,std::memory_order::relaxed);
+        // And notify any listening tasks:
+        egrp.setBits(EB_CONFIG_CHANGED);
+    }
+
     template<auto F, typename T>
     esp_err_t writeNvs(const char* const key, T value) {
         freertos::Lck lck {acquire()};
+        // Load the snapshot before writing so that it records the change.
+        ensureSnapshot();
         const esp_err_t r = std::invoke(F, doGetHandle(), key, value);
         if(r == ESP_OK) {
             doCommit();
-            // Take note of the potential change in config data:
-            modCnt.fetch_add(1,std::memory_order::relaxed);
-            // And notify any listening tasks:
-            egrp.setBits(EB_CONFIG_CHANGED);        
-
+            if(snapshot.isLoaded()) {
+                snapshot.set(key,value,getModCnt() + 1);
+            }
+            notifyModification();
         } else {
             ESP_LOGW(TAG, "Failed to write NVS key \"%s\": %d",key,r);
         }
@@ -218,6 +755,52 @@ class NvsCtx {
 
 };
 
+esp_err_t NvsCtx::commitTxn(const nvs_config_txn& txn) {
+    if(txn.err != ESP_OK) {
+        return txn.err;
+    }
+    if(txn.cnt == 0) {
+        return ESP_OK;
+    }
+
+    freertos::Lck lck {acquire()};
+    ensureSnapshot();
+    const nvs_handle_t h = doGetHandle();
+    if(!h) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const uint32_t newModCnt = getModCnt() + 1;
+    esp_err_t r = ESP_OK;
+    std::size_t written = 0;
+    for(; written < txn.cnt; ++written) {
+        const nvs_config_txn::Op& op = txn.ops[written];
+        r = op.visit([this,h,&op,newModCnt]<typename T>(const T value) {
+            const esp_err_t res = NVS_op<std::conditional_t<std::is_same_v<T,const char*>,char*,T>>::write(h,op.key,value);
+            if(res == ESP_OK && snapshot.isLoaded()) {
+                snapshot.set(op.key,value,newModCnt);
+            }
+            return res;
+        });
+        if(r != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to write NVS key \"%s\": %d",op.key,r);
+            break;
+        }
+    }
+
+    if(written != 0) {
+        const esp_err_t rc = doCommit();
+        if(r == ESP_OK) {
+            r = rc;
+        }
+        notifyModification();
+    }
+
+    ESP_LOGD(TAG, "Transaction: %u of %u keys written", (unsigned)written, (unsigned)txn.cnt);
+
+    return r;
+}
+
 static NvsCtx ctx {};
 
 uint32_t nvs_config_get_modcount(void) {
@@ -228,29 +811,8 @@ bool nvs_config_wait_for_modification(TickType_t maxWait) {
     return ctx.waitForModification(maxWait);
 }
 
-static char * do_nvs_config_get_string(nvs_handle_t handle, const char * key, const char * default_value)
-{
-    esp_err_t err;
-    size_t size = 0;
-    err = nvs_get_str(handle, key, NULL, &size);
-
-    if (err != ESP_OK) {
-        return strdup(default_value);
-    }
-
-    char * out = (char*)malloc(size);
-    err = nvs_get_str(handle, key, out, &size);
-
-    if (err != ESP_OK) {
-        free(out);
-        return strdup(default_value);
-    }
-
-    return out;
-}
-
 char * nvs_config_get_string(const char * key, const char * default_value) {
-    return ctx.execRead<do_nvs_config_get_string>(key,default_value);
+    return ctx.get_str(key,default_value);
 }
 
 
@@ -296,3 +858,72 @@ void nvs_config_set_float(const char *key, float value)
 {
     ctx.set<float>(key,value);
 }
+
+bool nvs_config_is_changed_since(const char * key, uint32_t modcount)
+{
+    return ctx.isChangedSince(key,modcount);
+}
+
+nvs_config_txn_t * nvs_config_txn_begin(void)
+{
+    nvs_config_txn_t * const txn = (nvs_config_txn_t*)calloc(1,sizeof(nvs_config_txn_t));
+    if(!txn) {
+        ESP_LOGE(TAG, "Failed to allocate transaction");
+    }
+    return txn;
+}
+
+void nvs_config_txn_set_string(nvs_config_txn_t * txn, const char * key, const char * value)
+{
+    if(txn) {
+        txn->set<const char*>(key,value);
+    }
+}
+
+void nvs_config_txn_set_u16(nvs_config_txn_t * txn, const char * key, const uint16_t value)
+{
+    if(txn) {
+        txn->set<uint16_t>(key,value);
+    }
+}
+
+void nvs_config_txn_set_i32(nvs_config_txn_t * txn, const char * key, const int32_t value)
+{
+    if(txn) {
+        txn->set<int32_t>(key,value);
+    }
+}
+
+void nvs_config_txn_set_u64(nvs_config_txn_t * txn, const char * key, const uint64_t value)
+{
+    if(txn) {
+        txn->set<uint64_t>(key,value);
+    }
+}
+
+void nvs_config_txn_set_float(nvs_config_txn_t * txn, const char * key, float value)
+{
+    if(txn) {
+        txn->set<float>(key,value);
+    }
+}
+
+esp_err_t nvs_config_txn_commit(nvs_config_txn_t * txn)
+{
+    if(!txn) {
+        return ESP_ERR_NO_MEM;
+    }
+    const esp_err_t r = ctx.commitTxn(*txn);
+    if(r != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to commit transaction: %d", r);
+    }
+    txn->release();
+    return r;
+}
+
+void nvs_config_txn_abort(nvs_config_txn_t * txn)
+{
+    if(txn) {
+        txn->release();
+    }
+}
@@ -2,6 +2,8 @@
 #define MAIN_NVS_CONFIG_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
 #include <freertos/FreeRTOS.h>
 
 #ifdef __cplusplus
@@ -76,11 +78,20 @@ void nvs_config_set_u64(const char * key, const uint64_t value);
 float nvs_config_get_float(const char *key, float default_value);
 void nvs_config_set_float(const char *key, float value);
 
+/*
+ * All values are read from NVS into a RAM snapshot on first access, and the
+ * snapshot is updated on every write. So the getters above don't touch the
+ * flash; only nvs_config_get_string still returns a malloc'ed copy.
+ */
+
 /**
  * @brief Returns the number of times the config was written to since boot.
  * Can be used as a 'dirty' flag to check for possible updates on config values:
  * If two successive calls to \c nvs_config_get_modcount() return the same value,
  * \e no config values were modified between the calls.
+ * The count is incremented after the snapshot was updated, so it serves as the
+ * generation number of the snapshot: a task which caches values it derived
+ * from the config only needs to re-read them when the count changed.
  * 
  * @return NVS config modification count since boot.
  */
@@ -95,6 +106,60 @@ uint32_t nvs_config_get_modcount(void);
  */
 bool nvs_config_wait_for_modification(TickType_t maxWait);
 
+/**
+ * @brief Checks if \p key was written to since the config's modification
+ * count was \p modcount, i.e. if it is one of the keys changed by the
+ * modifications signalled since then.
+ * 
+ * @return false if the value of \p key is the same as at \p modcount
+ */
+bool nvs_config_is_changed_since(const char * key, uint32_t modcount);
+
+// Max. number of keys a transaction can hold.
+#define NVS_CONFIG_TXN_MAX_KEYS 40
+
+typedef struct nvs_config_txn nvs_config_txn_t;
+
+/**
+ * @brief Starts a transaction, which collects changes to several keys and then
+ * writes them with a single NVS commit and a single modification event.
+ *
+ * Usage:
+ * \code
+ * nvs_config_txn_t * txn = nvs_config_txn_begin();
+ * nvs_config_txn_set_u16(txn, NVS_CONFIG_FAN_SPEED, 50);
+ * nvs_config_txn_set_string(txn, NVS_CONFIG_HOSTNAME, "bitaxe");
+ * esp_err_t err = nvs_config_txn_commit(txn);
+ * \endcode
+ *
+ * @return the transaction, or NULL if out of memory. The setters ignore a
+ * NULL transaction and \c nvs_config_txn_commit() fails for it, so the result
+ * only needs to be checked when committing.
+ */
+nvs_config_txn_t * nvs_config_txn_begin(void);
+void nvs_config_txn_set_string(nvs_config_txn_t * txn, const char * key, const char * value);
+void nvs_config_txn_set_u16(nvs_config_txn_t * txn, const char * key, const uint16_t value);
+void nvs_config_txn_set_i32(nvs_config_txn_t * txn, const char * key, const int32_t value);
+void nvs_config_txn_set_u64(nvs_config_txn_t * txn, const char * key, const uint64_t value);
+void nvs_config_txn_set_float(nvs_config_txn_t * txn, const char * key, float value);
+
+/**
+ * @brief Validates and writes all values staged in \p txn, then frees it.
+ *
+ * Nothing is written if any of the staged values is invalid (key too long,
+ * string too long, too many keys) or could not be staged. NVS itself has no
+ * multi-key transactions, so if writing fails halfway, the values written
+ * before remain.
+ *
+ * @return ESP_OK if all values were written
+ */
+esp_err_t nvs_config_txn_commit(nvs_config_txn_t * txn);
+
+/**
+ * @brief Frees \p txn without writing anything.
+ */
+void nvs_config_txn_abort(nvs_config_txn_t * txn);
+
 #ifdef __cplusplus
 }
 #endif
@@ -385,7 +385,7 @@ bool self_test(void * pvParameters)
 
     mining_notify notify_message;
     notify_message.job_id = 0;
-    notify_message.prev_block_hash = "0c859545a3498373a57452fac22eb7113df2a465000543520000000000000000";
+    hex2bin("0c859545a3498373a57452fac22eb7113df2a465000543520000000000000000", notify_message.prev_block_hash.u8, 32);
     notify_message.version = 0x20000004;
     notify_message.target = 0x1705ae3a;
     notify_message.ntime = 0x647025b5;
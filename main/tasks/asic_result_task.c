@@ -6,6 +6,7 @@
 #include "serial.h"
 #include <string.h>
 #include "esp_log.h"
+#include "deflog.h"
 #include "nvs_config.h"
 #include "utils.h"
 #include "stratum_task.h"
@@ -39,7 +40,7 @@ void ASIC_result_task(void *pvParameters)
 
         if (UNLIKELY(GLOBAL_STATE.valid_jobs[job_id] == 0))
         {
-            ESP_LOGI(TAG, "Job no longer valid, 0x%02X", job_id);
+            DEFLOG_I(TAG, "Job no longer valid, 0x%02X", job_id);
             continue;
         }
 
@@ -51,7 +52,7 @@ void ASIC_result_task(void *pvParameters)
         //log the ASIC response
         // ESP_LOGI(TAG, "ID: %s, ver: %08" PRIX32 " Nonce %08" PRIX32 " diff %.1f of %ld.", active_job->jobid, asic_result->rolled_version, asic_result->nonce, nonce_diff, active_job->pool_diff);
         // ESP_LOGI(TAG, "ID: %s, ver: %08" PRIX32 " Nonce %08" PRIX32 " diff %" PRIu64 " of %" PRIu32 ".", active_job->jobid, asic_result->rolled_version, asic_result->nonce, nonce_diff, active_job->pool_diff);
-        ESP_LOGI(TAG, "Result diff %" PRIu64 " of %" PRIu32 ".", nonce_diff, active_job->pool_diff);
+        DEFLOG_I(TAG, "Result diff %" PRIu64 " of %" PRIu32 ".", nonce_diff, active_job->pool_diff);
 
         if (nonce_diff >= active_job->pool_diff || nonce_diff >= GLOBAL_STATE.pool_difficulty)
         {
@@ -43,7 +43,7 @@ bool bm_job_build(mining_notify* const notification,
             free(extranonce_2_str);
             return false;
         }
-        calculate_merkle_root_hash_bin(cbtx,notification->merkle__branches,&merkle_root);
+        calculate_merkle_root_hash_bin(cbtx,notification->merkle_branches,notification->n_merkle_branches,&merkle_root);
     }
   
     construct_bm_job(notification, &merkle_root, GLOBAL_STATE.version_mask, difficulty, build_midstates, out_job);
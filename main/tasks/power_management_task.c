@@ -49,6 +49,153 @@ int pid_startup_counter = 0;
 
 PIDController pid;
 
+// Settings applied via POWER_MANAGEMENT_set_live(), which take precedence over NVS.
+typedef struct
+{
+    bool active;
+    float value;
+    uint32_t modCnt; // Config mod count when set; saving the setting to NVS ends the override.
+} live_setting_t;
+
+static live_setting_t liveSettings[PM_LIVE_CNT];
+static uint32_t liveSettingsSeq;
+static portMUX_TYPE liveSettingsLock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t powerManagementTask;
+
+// NVS keys which end an override of the respective setting when written.
+static const char * const LIVE_SETTING_KEYS[PM_LIVE_CNT][2] = {
+    [PM_LIVE_FAN_SPEED] = {NVS_CONFIG_FAN_SPEED, NVS_CONFIG_AUTO_FAN_SPEED},
+    [PM_LIVE_FREQUENCY] = {NVS_CONFIG_ASIC_FREQUENCY_FLOAT, NVS_CONFIG_ASIC_FREQUENCY},
+    [PM_LIVE_VOLTAGE] = {NVS_CONFIG_ASIC_VOLTAGE, NULL},
+};
+
+/*
+    Lowest and highest of the ascending, 0-terminated options of the ASIC.
+    Returns false if the device config provides none.
+*/
+static bool get_option_range(const uint16_t * options, uint16_t * min, uint16_t * max)
+{
+    if (options == NULL || options[0] == 0) {
+        return false;
+    }
+    *min = options[0];
+    *max = options[0];
+    for (int i = 1; options[i] != 0; ++i) {
+        *max = options[i];
+    }
+    return true;
+}
+
+esp_err_t POWER_MANAGEMENT_set_live(pm_live_setting_t setting, float value)
+{
+    const AsicConfig * const asic = &GLOBAL_STATE.DEVICE_CONFIG.family.asic;
+    uint16_t min, max;
+
+    switch (setting) {
+        case PM_LIVE_FAN_SPEED:
+            if (!(value >= 0 && value <= 100)) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            break;
+        case PM_LIVE_FREQUENCY:
+        case PM_LIVE_VOLTAGE:
+            // Live values are not checked by the UI, so keep them within the options of the ASIC.
+            if (!get_option_range(setting == PM_LIVE_FREQUENCY ? asic->frequency_options : asic->voltage_options, &min, &max)) {
+                return ESP_ERR_INVALID_STATE;
+            }
+            if (!(value >= min && value <= max)) {
+                ESP_LOGW(TAG, "Live %s %g out of range [%u, %u]", setting == PM_LIVE_FREQUENCY ? "frequency" : "voltage",
+                         value, (unsigned) min, (unsigned) max);
+                return ESP_ERR_INVALID_ARG;
+            }
+            break;
+        default:
+            return ESP_ERR_INVALID_ARG;
+    }
+
+    const uint32_t modCnt = nvs_config_get_modcount();
+
+    taskENTER_CRITICAL(&liveSettingsLock);
+    liveSettings[setting] = (live_setting_t) {.active = true, .value = value, .modCnt = modCnt};
+    liveSettingsSeq += 1;
+    taskEXIT_CRITICAL(&liveSettingsLock);
+
+    if (powerManagementTask != NULL) {
+        xTaskNotifyGive(powerManagementTask);
+    }
+    return ESP_OK;
+}
+
+/*
+    Overrides the values just read from NVS with the live settings, and drops
+    live settings which were saved to NVS in the meantime.
+*/
+static void take_live_settings(bool * autoFanSpeed, uint16_t * manualFanSpeed, uint16_t * core_voltage, float * asic_frequency)
+{
+    live_setting_t live[PM_LIVE_CNT];
+    taskENTER_CRITICAL(&liveSettingsLock);
+    memcpy(live, liveSettings, sizeof(live));
+    taskEXIT_CRITICAL(&liveSettingsLock);
+
+    for (int i = 0; i < PM_LIVE_CNT; ++i) {
+        if (!live[i].active) {
+            continue;
+        }
+        const char * const * const keys = LIVE_SETTING_KEYS[i];
+        if (nvs_config_is_changed_since(keys[0], live[i].modCnt) || (keys[1] && nvs_config_is_changed_since(keys[1], live[i].modCnt))) {
+            taskENTER_CRITICAL(&liveSettingsLock);
+            // Unless it was set again meanwhile.
+            if (liveSettings[i].modCnt == live[i].modCnt) {
+                liveSettings[i].active = false;
+            }
+            taskEXIT_CRITICAL(&liveSettingsLock);
+            continue;
+        }
+        switch (i) {
+            case PM_LIVE_FAN_SPEED:
+                *autoFanSpeed = false;
+                *manualFanSpeed = live[i].value;
+                break;
+            case PM_LIVE_FREQUENCY:
+                *asic_frequency = live[i].value;
+                break;
+            case PM_LIVE_VOLTAGE:
+                *core_voltage = live[i].value;
+                break;
+        }
+    }
+}
+
+static void apply_fan_speed(PowerManagementModule * power_management, uint16_t fan_speed)
+{
+    power_management->fan_perc = fan_speed;
+    Thermal_set_fan_percent(&GLOBAL_STATE.DEVICE_CONFIG, fan_speed * 0.01f);
+}
+
+static void apply_core_voltage(uint16_t core_voltage, uint16_t * last_core_voltage)
+{
+    if (core_voltage != *last_core_voltage) {
+        ESP_LOGI(TAG, "Setting new vcore voltage to %" PRIu16 "mV", core_voltage);
+        VCORE_set_voltage(&GLOBAL_STATE, core_voltage * 0.001f);
+        *last_core_voltage = core_voltage;
+    }
+}
+
+static void apply_frequency(PowerManagementModule * power_management, float asic_frequency, float * last_asic_frequency)
+{
+    if (asic_frequency != *last_asic_frequency) {
+        ESP_LOGI(TAG, "New ASIC frequency requested: %g MHz (current: %g MHz)", asic_frequency, *last_asic_frequency);
+        
+        bool success = ASIC_set_frequency(&GLOBAL_STATE, asic_frequency);
+        
+        if (success) {
+            power_management->frequency_value = asic_frequency;
+        }
+        
+        *last_asic_frequency = asic_frequency;
+    }
+}
+
 void POWER_MANAGEMENT_init_frequency(PowerManagementModule * power_management)
 {
     float frequency = nvs_config_get_float(NVS_CONFIG_ASIC_FREQUENCY_FLOAT, -1);
@@ -72,6 +219,8 @@ void POWER_MANAGEMENT_task(void * pvParameters)
     PowerManagementModule * power_management = &GLOBAL_STATE.POWER_MANAGEMENT_MODULE;
     SystemModule * sys_module = &GLOBAL_STATE.SYSTEM_MODULE;
 
+    powerManagementTask = xTaskGetCurrentTaskHandle();
+
     POWER_MANAGEMENT_init_frequency(power_management);
     
     float last_asic_frequency = power_management->frequency_value;
@@ -100,13 +249,16 @@ void POWER_MANAGEMENT_task(void * pvParameters)
     uint16_t new_overheat_mode; 
 
     uint32_t configModCnt = nvs_config_get_modcount() - 1; // Make sure we initially read all config values once.
+    uint32_t liveModCnt = 0;
     while (1) {
 
         // Check for any config modifications and reload values if needed.
         {
             const uint32_t mc = nvs_config_get_modcount();
-            if(configModCnt != mc) {
+            const uint32_t lc = liveSettingsSeq;
+            if(configModCnt != mc || liveModCnt != lc) {
                 configModCnt = mc;
+                liveModCnt = lc;
                 // Config may have changed. Reload all our values.
                 pid_setPoint = nvs_config_get_u16(NVS_CONFIG_TEMP_TARGET, pid_setPoint);
                 autoFanSpeed = (nvs_config_get_u16(NVS_CONFIG_AUTO_FAN_SPEED, 1) == 1);
@@ -116,6 +268,7 @@ void POWER_MANAGEMENT_task(void * pvParameters)
                 core_voltage = nvs_config_get_u16(NVS_CONFIG_ASIC_VOLTAGE, CONFIG_ASIC_VOLTAGE);
                 asic_frequency = nvs_config_get_float(NVS_CONFIG_ASIC_FREQUENCY_FLOAT, CONFIG_ASIC_FREQUENCY);
                 new_overheat_mode = nvs_config_get_u16(NVS_CONFIG_OVERHEAT_MODE, 0);
+                take_live_settings(&autoFanSpeed, &manualFanSpeed, &core_voltage, &asic_frequency);
             }
         }
 
@@ -220,27 +373,11 @@ void POWER_MANAGEMENT_task(void * pvParameters)
                 }
             }
         } else { // Manual fan speed
-            power_management->fan_perc = manualFanSpeed;
-            Thermal_set_fan_percent(&GLOBAL_STATE.DEVICE_CONFIG, manualFanSpeed * 0.01f);
-        }
-
-        if (core_voltage != last_core_voltage) {
-            ESP_LOGI(TAG, "Setting new vcore voltage to %" PRIu16 "mV", core_voltage);
-            VCORE_set_voltage(&GLOBAL_STATE, core_voltage * 0.001f);
-            last_core_voltage = core_voltage;
+            apply_fan_speed(power_management, manualFanSpeed);
         }
 
-        if (asic_frequency != last_asic_frequency) {
-            ESP_LOGI(TAG, "New ASIC frequency requested: %g MHz (current: %g MHz)", asic_frequency, last_asic_frequency);
-            
-            bool success = ASIC_set_frequency(&GLOBAL_STATE, asic_frequency);
-            
-            if (success) {
-                power_management->frequency_value = asic_frequency;
-            }
-            
-            last_asic_frequency = asic_frequency;
-        }
+        apply_core_voltage(core_voltage, &last_core_voltage);
+        apply_frequency(power_management, asic_frequency, &last_asic_frequency);
 
         // Check for changing of overheat mode
         if (new_overheat_mode != sys_module->overheat_mode) {
@@ -250,8 +387,25 @@ void POWER_MANAGEMENT_task(void * pvParameters)
 
         VCORE_check_fault(&GLOBAL_STATE);
 
+        power_management->sample_count += 1;
+
         // looper:
-        vTaskDelay(POLL_RATE / portTICK_PERIOD_MS);
+        // Sleep until the next poll, but apply live settings as soon as they arrive.
+        // The poll itself keeps its period so the PID's timing is unaffected.
+        const TickType_t pollStart = xTaskGetTickCount();
+        TickType_t elapsed;
+        while ((elapsed = xTaskGetTickCount() - pollStart) < pdMS_TO_TICKS(POLL_RATE)) {
+            if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(POLL_RATE) - elapsed) == 0) {
+                continue;
+            }
+            liveModCnt = liveSettingsSeq;
+            take_live_settings(&autoFanSpeed, &manualFanSpeed, &core_voltage, &asic_frequency);
+            if (!autoFanSpeed) {
+                apply_fan_speed(power_management, manualFanSpeed);
+            }
+            apply_core_voltage(core_voltage, &last_core_voltage);
+            apply_frequency(power_management, asic_frequency, &last_asic_frequency);
+        }
         // configChanged = nvs_config_wait_for_modification(POLL_RATE / portTICK_PERIOD_MS);
     }
 }
@@ -1,6 +1,9 @@
 #ifndef POWER_MANAGEMENT_TASK_H_
 #define POWER_MANAGEMENT_TASK_H_
 
+#include <stdint.h>
+#include "esp_err.h"
+
 typedef struct
 {
     uint16_t fan_perc;
@@ -13,10 +16,35 @@ typedef struct
     float frequency_value;
     float power;
     float current;
+    uint32_t sample_count; // Incremented after each update of the values above.
 } PowerManagementModule;
 
 void POWER_MANAGEMENT_init_frequency(PowerManagementModule * power_management);
 
 void POWER_MANAGEMENT_task(void * pvParameters);
 
+typedef enum
+{
+    PM_LIVE_FAN_SPEED,  // Manual fan speed in %; disables the automatic fan control.
+    PM_LIVE_FREQUENCY,  // ASIC frequency in MHz
+    PM_LIVE_VOLTAGE,    // Core voltage in mV
+    PM_LIVE_CNT
+} pm_live_setting_t;
+
+/**
+ * @brief Applies a setting right away without writing it to NVS.
+ *
+ * The value stays in effect until the same setting is saved to NVS or the
+ * device restarts. The power management task is woken up and applies it
+ * within milliseconds instead of at its next poll.
+ *
+ * Frequency and voltage must lie between the lowest and the highest of the
+ * frequency or voltage options of the ASIC. Overclocked values can only be
+ * saved to NVS.
+ *
+ * @return ESP_ERR_INVALID_ARG if the value is out of range,
+ *         ESP_ERR_INVALID_STATE if the ASIC has no options to check against
+ */
+esp_err_t POWER_MANAGEMENT_set_live(pm_live_setting_t setting, float value);
+
 #endif
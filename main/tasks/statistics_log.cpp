@@ -0,0 +1,224 @@
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+#include "esp_log.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#include "flashlog.hpp"
+#include "partition_flash.hpp"
+
+#include "statistics_log.h"
+
+static const char* const TAG = "statistics_log";
+
+static constexpr const char* PARTITION_LABEL = "statslog";
+static constexpr esp_partition_subtype_t PARTITION_SUBTYPE = (esp_partition_subtype_t)0x40;
+
+// Samples are averaged over this long before being persisted (100ms units).
+static constexpr uint32_t AGGREGATION_INTERVAL = 60 * 10;
+
+// Any earlier wall-clock time means the clock was not set yet (2020-09-13).
+static constexpr time_t MIN_VALID_TIME = 1600000000;
+
+// Completed windows waiting for the writer task.
+static constexpr UBaseType_t QUEUE_LEN = 4;
+static constexpr uint32_t WRITER_STACK_SIZE = 3072;
+
+/**
+ * @brief Seconds since the epoch, or 0 if the clock has not been set. The RTC
+ * keeps the time across software resets, but not across power cycles.
+ */
+static uint32_t wallClockNow(void) {
+    const time_t now = std::time(nullptr);
+    return now >= MIN_VALID_TIME ? (uint32_t)now : 0;
+}
+
+namespace {
+
+    /**
+     * @brief What is persisted per aggregation window; a StatisticsData without
+     * the list pointer. Bump LOG_RECORD_VERSION on every change to it.
+     */
+    struct LogRecord {
+        uint32_t timestamp;
+        uint32_t hashrate_MHz;
+        uint32_t freeHeap;
+        float chipTemperature;
+        float vrTemperature;
+        float power;
+        float voltage;
+        float current;
+        int16_t coreVoltageActual;
+        uint16_t fanSpeed;
+        uint16_t fanRPM;
+        int8_t wifiRSSI;
+        uint32_t wallTime; // Seconds since the epoch when persisted; 0 if unknown
+    };
+
+    /**
+     * @brief Running sums over one aggregation window.
+     */
+    struct Aggregate {
+        uint32_t cnt;
+        uint32_t start;
+        uint32_t last;
+        uint64_t hashrate_MHz;
+        uint64_t freeHeap;
+        float chipTemperature;
+        float vrTemperature;
+        float power;
+        float voltage;
+        float current;
+        int32_t coreVoltageActual;
+        uint32_t fanSpeed;
+        uint32_t fanRPM;
+        int32_t wifiRSSI;
+
+        void add(const StatisticsData& s) {
+            if(cnt == 0) {
+                start = s.timestamp;
+            }
+            cnt += 1;
+            last = s.timestamp;
+            hashrate_MHz += s.hashrate_MHz;
+            freeHeap += s.freeHeap;
+            chipTemperature += s.chipTemperature;
+            vrTemperature += s.vrTemperature;
+            power += s.power;
+            voltage += s.voltage;
+            current += s.current;
+            coreVoltageActual += s.coreVoltageActual;
+            fanSpeed += s.fanSpeed;
+            fanRPM += s.fanRPM;
+            wifiRSSI += s.wifiRSSI;
+        }
+
+        bool complete(void) const {
+            return cnt != 0 && (last - start) >= AGGREGATION_INTERVAL;
+        }
+
+        LogRecord average(void) const {
+            const float f = 1.0f / cnt;
+            return LogRecord {
+                .timestamp = last,
+                .hashrate_MHz = (uint32_t)(hashrate_MHz / cnt),
+                .freeHeap = (uint32_t)(freeHeap / cnt),
+                .chipTemperature = chipTemperature * f,
+                .vrTemperature = vrTemperature * f,
+                .power = power * f,
+                .voltage = voltage * f,
+                .current = current * f,
+                .coreVoltageActual = (int16_t)(coreVoltageActual / (int32_t)cnt),
+                .fanSpeed = (uint16_t)(fanSpeed / cnt),
+                .fanRPM = (uint16_t)(fanRPM / cnt),
+                .wifiRSSI = (int8_t)(wifiRSSI / (int32_t)cnt),
+                .wallTime = wallClockNow()
+            };
+        }
+    };
+
+    static constexpr uint32_t LOG_RECORD_VERSION = 1;
+
+    using Log = flashlog::FlashLog<flashlog::PartitionFlash, LogRecord, LOG_RECORD_VERSION>;
+
+    flashlog::PartitionFlash flash {};
+    Log log {flash};
+    bool logReady = false;
+    QueueHandle_t queue = nullptr;
+    Aggregate aggregate {};
+    // Wall-clock time of the newest record loaded, 0 if unknown.
+    uint32_t lastWallTime = 0;
+
+}
+
+static void writerTask(void*) {
+    LogRecord rec;
+    while(true) {
+        if(xQueueReceive(queue, &rec, portMAX_DELAY) == pdTRUE && !log.append(rec)) {
+            ESP_LOGW(TAG, "Failed to write statistics log.");
+        }
+    }
+}
+
+bool statistics_log_init(void) {
+    if(!logReady) {
+        flash = flashlog::PartitionFlash::find(PARTITION_SUBTYPE, PARTITION_LABEL);
+        if(!flash.valid()) {
+            ESP_LOGW(TAG, "No '%s' partition; statistics will not persist across reboots.", PARTITION_LABEL);
+            return false;
+        }
+        if(!log.init()) {
+            ESP_LOGE(TAG, "Failed to initialize statistics log.");
+            return false;
+        }
+        if(log.getReplacedVersion() != 0) {
+            ESP_LOGW(TAG, "Discarded statistics log of layout version %" PRIu32 ", now %" PRIu32 ".",
+                log.getReplacedVersion(), Log::VERSION);
+        }
+        // Appending may erase a sector, which must not stall the timer task.
+        if(queue == nullptr) {
+            queue = xQueueCreate(QUEUE_LEN, sizeof(LogRecord));
+        }
+        if(queue == nullptr || xTaskCreate(writerTask, "statslog", WRITER_STACK_SIZE, nullptr, 1, nullptr) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create statistics log writer.");
+            return false;
+        }
+        logReady = true;
+        ESP_LOGI(TAG, "Statistics log ready, %u bytes, capacity %u samples.", (unsigned)flash.size(), (unsigned)log.getCapacity());
+    }
+    return logReady;
+}
+
+size_t statistics_log_load(void (*cb)(const struct StatisticsData* sample)) {
+    if(!logReady || cb == nullptr) {
+        return 0;
+    }
+    lastWallTime = 0;
+    return log.forEach([cb](const LogRecord& r) {
+        lastWallTime = r.wallTime;
+        const StatisticsData s {
+            .timestamp = r.timestamp,
+            .hashrate_MHz = r.hashrate_MHz,
+            .next = nullptr,
+            .freeHeap = r.freeHeap,
+            .chipTemperature = r.chipTemperature,
+            .vrTemperature = r.vrTemperature,
+            .power = r.power,
+            .voltage = r.voltage,
+            .current = r.current,
+            .coreVoltageActual = r.coreVoltageActual,
+            .fanSpeed = r.fanSpeed,
+            .fanRPM = r.fanRPM,
+            .wifiRSSI = r.wifiRSSI
+        };
+        cb(&s);
+    });
+}
+
+void statistics_log_add(const struct StatisticsData* sample) {
+    if(!logReady || sample == nullptr) {
+        return;
+    }
+    aggregate.add(*sample);
+    if(aggregate.complete()) {
+        const LogRecord rec = aggregate.average();
+        if(xQueueSend(queue, &rec, 0) != pdTRUE) {
+            ESP_LOGW(TAG, "Statistics log writer busy, window dropped.");
+        }
+        aggregate = Aggregate {};
+    }
+}
+
+uint32_t statistics_log_get_downtime(void) {
+    const uint32_t now = wallClockNow();
+    if(lastWallTime == 0 || now == 0 || now <= lastWallTime) {
+        return 0;
+    }
+    const uint32_t secs = now - lastWallTime;
+    // Keep the result within the 100ms time base.
+    return secs < UINT32_MAX / 20 ? secs * 10 : UINT32_MAX / 2;
+}
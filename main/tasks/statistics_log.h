@@ -0,0 +1,48 @@
+#ifndef STATISTICS_LOG_H_
+#define STATISTICS_LOG_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "statistics_task.h"
+#include "stats_history.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Opens the persistent statistics log in the "statslog" partition.
+ * 
+ * @return false if there is no such partition or it cannot be used.
+ */
+bool statistics_log_init(void);
+
+/**
+ * @brief Passes every persisted (aggregated) sample to \p cb, oldest first.
+ * 
+ * @return the number of samples passed
+ */
+size_t statistics_log_load(void (*cb)(const struct StatisticsData* sample));
+
+/**
+ * @brief Returns how long ago (100ms units) the newest sample passed by
+ * statistics_log_load() was persisted, measured by the wall clock.
+ * 
+ * @return 0 if unknown, i.e. the wall clock was not set when the sample was
+ * persisted or is not set now (e.g. after a power cycle, until the pool sent
+ * a time).
+ */
+uint32_t statistics_log_get_downtime(void);
+
+/**
+ * @brief Feeds a sample into the current aggregation window; once the window
+ * is complete, its average is queued for the writer task, which appends it to
+ * the log. Does not touch the flash itself.
+ */
+void statistics_log_add(const struct StatisticsData* sample);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STATISTICS_LOG_H_
@@ -10,248 +10,64 @@
 #include "freertos/semphr.h"
 
 #include "statistics_task.h"
+#include "stats_history.h"
+#include "statistics_log.h"
 #include "global_state.h"
 #include "nvs_config.h"
 #include "power.h"
 #include "connect.h"
 #include "vcore.h"
 
-#include <esp_heap_caps.h>
+#include "esp_random.h"
+#include "esp_system.h"
+#include "sdkconfig.h"
 
 #define DEFAULT_POLL_RATE 5000
 
 static const char* const TAG = "statistics_task";
 
-static StatisticsNodePtr statisticsDataStart = NULL;
-static StatisticsNodePtr statisticsDataEnd = NULL;
-// static pthread_mutex_t statisticsDataLock = PTHREAD_MUTEX_INITIALIZER;
+// Added to the uptime so that timestamps continue after those loaded from flash.
+static uint32_t timeOffset;
 
-static StaticSemaphore_t muxMem;
-static SemaphoreHandle_t mux;
+// Identifies the time base of this boot; never 0, fits into an int32_t.
+static uint32_t bootId;
 
-static void inline stats_lock(void) {
-    if(mux) {
-        xSemaphoreTake(mux,portMAX_DELAY);
-    }
+uint32_t statistics_get_boot_id(void) {
+    return bootId;
 }
 
-static void inline stats_unlock(void) {
-    if(mux) {
-        xSemaphoreGive(mux);
-    }
+uint32_t statistics_get_timestamp(void) {
+    return (uint32_t)(esp_timer_get_time() / (1000*100)) + timeOffset;
 }
 
-
-static const uint16_t maxDataCount = 720;
-static uint16_t currentDataCount;
-
-static struct StatisticsData* statsBuffer;
-
-static inline struct StatisticsData* allocStatNodes(const size_t cnt) {
-    static const size_t ALIGN = alignof(struct StatisticsData);
-    static const size_t SIZE = sizeof(struct StatisticsData);
-    if(cnt == 0) {
-        return NULL;
-    } else {
-        struct StatisticsData* mem;
-        mem = heap_caps_aligned_alloc(ALIGN, cnt * SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-        if(!mem) {
-            // ESP_LOGI(TAG, "Allocating stats buffer in internal RAM.");
-            mem = heap_caps_aligned_alloc(ALIGN, cnt * SIZE, MALLOC_CAP_8BIT);
-        }
-        return mem;
+static void loadPersistedSample(const struct StatisticsData* const sample) {
+    struct StatisticsData data = *sample;
+    addStatisticData(&data);
+    if((int32_t)(sample->timestamp - statistics_get_timestamp()) >= 0) {
+        timeOffset += (sample->timestamp - statistics_get_timestamp()) + 1;
     }
 }
 
-static inline struct StatisticsData* getStatsBuffer(void) {
-
-    struct StatisticsData* mem = statsBuffer;
-
-    {
-        if(!mem) {
-            currentDataCount = 0;
-            mem = allocStatNodes(maxDataCount);
-            statsBuffer = mem;
-            if(!mem) {
-                ESP_LOGE(TAG, "Failed to allocate stats buffer.");
+static inline void loadPersistedStats(void) {
+    if(statistics_log_init()) {
+        const size_t cnt = statistics_log_load(loadPersistedSample);
+        ESP_LOGI(TAG, "Loaded %u samples from flash.", (unsigned)cnt);
+
+        // Keep the time the device was off as a gap in the history. If the
+        // wall clock can't tell how long that was, new samples directly
+        // follow the persisted ones.
+        struct StatisticsData last;
+        const uint32_t downtime = statistics_log_get_downtime();
+        if(downtime != 0 && statisticDataLatest(&last)) {
+            const int32_t shift = (int32_t)((last.timestamp + downtime) - statistics_get_timestamp());
+            if(shift > 0) {
+                timeOffset += shift;
             }
+            ESP_LOGI(TAG, "Down for %" PRIu32 "s.", downtime / 10);
         }
     }
-
-    return mem;
-}
-
-static inline void releaseStatsBuffer(void) {
-    stats_lock();
-    {
-        if(statsBuffer != NULL) {
-            ESP_LOGI(TAG, "Releasing stats buffer.");
-            statisticsDataStart = NULL;
-            statisticsDataEnd = NULL;
-            currentDataCount = 0;
-
-            free(statsBuffer);
-            statsBuffer = NULL;
-        }
-    }
-    stats_unlock();
-}
-
-static inline StatisticsNodePtr getNewNode(void) {
-    if(currentDataCount < maxDataCount) {
-        struct StatisticsData* const buffer = getStatsBuffer();
-        if(buffer) {
-            StatisticsNodePtr node = buffer + currentDataCount;
-            currentDataCount += 1;
-            return node;
-        }
-    }
-    return NULL;
-}
-
-static StatisticsNodePtr addStatisticData(StatisticsNodePtr data)
-{
-    if (NULL == data) {
-        return NULL;
-    }
-
-    StatisticsNodePtr newData = NULL;
-
-    stats_lock();
-    {
-        if(currentDataCount < maxDataCount) {
-            newData = getNewNode();
-            if(!newData) {
-                return NULL;
-            }
-            if(statisticsDataStart == NULL) {
-                statisticsDataStart = newData;
-                statisticsDataEnd = newData;
-            }
-        } else {
-            newData = statisticsDataStart;
-            statisticsDataStart = statisticsDataStart->next;
-        }
-        statisticsDataEnd->next = newData;
-        statisticsDataEnd = newData;
-        *newData = *data;
-        newData->next = NULL;
-    }
-    stats_unlock();
-
-    // create new data block or reuse first data block
-    // if (currentDataCount < maxDataCount) {
-    //     newData = allocStatNodes(1);
-    //     // (StatisticsNodePtr)malloc(sizeof(struct StatisticsData));
-    //     if(NULL != newData) {
-    //         currentDataCount++;
-    //     } else {
-    //         ESP_LOGE(TAG, "Failed to allocate stats node.");
-    //     }
-    // } 
-    // pthread_mutex_lock(&statisticsDataLock);
-    // {
-    //     if(newData == NULL) {
-    //         newData = statisticsDataStart;
-    //         if(statisticsDataStart != NULL) {
-    //             statisticsDataStart = statisticsDataStart->next;
-    //         }
-    //     } 
-    //     if(newData != NULL) {
-    //         if(statisticsDataEnd != NULL /* && newData != statisticsDataEnd */) {
-    //             statisticsDataEnd->next = newData;
-    //         }
-    //         *newData = *data;
-    //         newData->next = NULL;
-    //         statisticsDataEnd = newData;
-    //     }
-
-    // }
-    // pthread_mutex_unlock(&statisticsDataLock);
-    // set data
-    // if (NULL != newData) {
-
-    //     // *newData = *data;
-
-    //     pthread_mutex_lock(&statisticsDataLock);
-
-    //     if (NULL == statisticsDataStart) {
-    //         statisticsDataStart = newData; // set first new data block
-    //     } else {
-    //         if ((statisticsDataStart == newData) && (NULL != statisticsDataStart->next)) {
-    //             statisticsDataStart = statisticsDataStart->next; // move DataStart to next (first data block reused)
-    //         }
-    //     }
-
-
-    //     newData->next = NULL;
-
-    //     if ((NULL != statisticsDataEnd) && (newData != statisticsDataEnd)) {
-    //         statisticsDataEnd->next = newData; // link data block
-    //     }
-    //     statisticsDataEnd = newData; // set DataEnd to new data
-
-    //     pthread_mutex_unlock(&statisticsDataLock);
-    // }
-
-    return newData;
 }
 
-bool statisticDataNext(StatisticsNodePtr prevNode, StatisticsNodePtr dataOut)
-{
-
-    if(NULL == dataOut) {
-        return false;
-    }
-
-    StatisticsNodePtr data = NULL;
-
-    // pthread_mutex_lock(&statisticsDataLock);
-    stats_lock();
-    {
-
-        if(NULL == prevNode) {
-            data = statisticsDataStart;
-        } else {
-            data = prevNode->next;
-        }
-
-        if(NULL != data) {
-            *dataOut = *data;
-        }
-
-    }
-    // pthread_mutex_unlock(&statisticsDataLock);
-    stats_unlock();
-
-    return NULL != data;
-}
-
-void clearStatisticData()
-{
-    if (NULL != statisticsDataStart) {
-        // pthread_mutex_lock(&statisticsDataLock);
-        stats_lock();
-
-        StatisticsNextNodePtr nextNode = statisticsDataStart;
-
-        while (NULL != nextNode) {
-            StatisticsNodePtr node = nextNode;
-            nextNode = node->next;
-            free(node);
-        }
-
-        statisticsDataStart = NULL;
-        statisticsDataEnd = NULL;
-        currentDataCount = 0;
-
-        // pthread_mutex_unlock(&statisticsDataLock);
-        stats_unlock();
-    }
-}
-
-
-
 static TimerHandle_t statsTimerHdl = NULL;
 static StaticTimer_t statsTimerMem;
 static volatile bool statsTimerShutdown;
@@ -262,8 +78,9 @@ bool statistics_set_collection_interval(uint16_t intervalSeconds);
 
 void statistics_init(void)
 {
-    if(mux == NULL) {
-        mux = xSemaphoreCreateMutexStatic(&muxMem);
+    statisticDataInit();
+    if(bootId == 0) {
+        bootId = (esp_random() & 0x7fffffff) | 1;
     }
     if(statsTimerHdl == NULL) {
         // GlobalState* const GLOBAL_STATE = (GlobalState *) pvParameters;
@@ -275,9 +92,12 @@ void statistics_init(void)
             &statsTimerMem);
     }
 
-    statistics_set_collection_interval(
-            nvs_config_get_u16(NVS_CONFIG_STATISTICS_FREQUENCY, 0)
-        );    
+    const uint16_t interval = nvs_config_get_u16(NVS_CONFIG_STATISTICS_FREQUENCY, 0);
+    if(interval != 0) {
+        loadPersistedStats();
+    }
+
+    statistics_set_collection_interval(interval);
 }
 
 
@@ -292,7 +112,7 @@ static inline void collectStats(void) {
     PowerManagementModule* const power_management = &GLOBAL_STATE.POWER_MANAGEMENT_MODULE;
     struct StatisticsData statsData = {};
 
-    const uint32_t currentTime = esp_timer_get_time() / (1000*100); // Resolution: 100ms
+    const uint32_t currentTime = statistics_get_timestamp();
 
     int8_t wifiRSSI = -90;
     get_wifi_current_rssi(&wifiRSSI);
@@ -311,6 +131,7 @@ static inline void collectStats(void) {
     statsData.freeHeap = esp_get_free_heap_size();
 
     addStatisticData(&statsData);
+    statistics_log_add(&statsData);
 
 }
 
@@ -318,7 +139,7 @@ static void statsTimerCb(TimerHandle_t xTimer) {
     if(!statsTimerShutdown) {
         collectStats();
     } else {
-        releaseStatsBuffer();
+        statisticDataRelease();
         /* Controlling a timer from the timer callback could lead to a deadlock,
            so we only wait a little while, and if not successful, we'll try again
            on the next timer cycle.
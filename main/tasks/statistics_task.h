@@ -6,29 +6,6 @@
 extern "C" {
 #endif
 
-typedef struct StatisticsData * StatisticsNodePtr;
-typedef struct StatisticsData * StatisticsNextNodePtr;
-
-struct StatisticsData
-{
-    // Members orderered by size (alignment) to minimize padding.
-    // int64_t timestamp;
-    uint32_t timestamp; // Resolution: 100ms
-    // double hashrate;
-    uint32_t hashrate_MHz;
-    StatisticsNextNodePtr next;
-    uint32_t freeHeap;
-    float chipTemperature;
-    float vrTemperature;
-    float power;
-    float voltage;
-    float current;
-    int16_t coreVoltageActual;
-    uint16_t fanSpeed;
-    uint16_t fanRPM;
-    int8_t wifiRSSI;
-};
-
 // typedef struct
 // {
 //     StatisticsNodePtr * statisticsList;
@@ -54,7 +31,18 @@ void statistics_deinit(void);
  */
 bool statistics_set_collection_interval(const uint16_t intervalSeconds);
 
-bool statisticDataNext(StatisticsNodePtr prevNode, StatisticsNodePtr dataOut);
+/**
+ * @brief Current time in the time base of the samples' timestamps (100ms
+ * resolution). This is the uptime, shifted so that it continues after the
+ * samples restored from flash.
+ */
+uint32_t statistics_get_timestamp(void);
+
+/**
+ * @brief Changes on every boot. Timestamps are only comparable between
+ * responses carrying the same boot id.
+ */
+uint32_t statistics_get_boot_id(void);
 
 
 #ifdef __cplusplus
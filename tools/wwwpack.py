@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""wwwpack.py - packs the AxeOS web UI into a read-only archive (www.bin).
+
+The firmware memory-maps the archive from the "www" partition and serves the
+files straight from flash, without a file system.
+
+Usage:
+  ./wwwpack.py <dist dir> <output file> [--max-size <bytes>]
+
+Files "x.gz" are stored as "x" with the gzip flag set; if both "x" and "x.gz"
+exist, only the gzipped variant is stored.
+
+Layout (all integers little-endian, all sections 4-byte aligned):
+
+  Header (16 bytes)
+    u32 magic      "AXWA"
+    u16 version    1
+    u16 count      number of files
+    u32 size       total size of the archive in bytes
+    u32 crc        CRC-32 (zlib) of bytes [16, size)
+
+  Index: <count> entries of 24 bytes, sorted by path (bytewise)
+    u32 path       offset of the NUL-terminated path, e.g. "/index.html"
+    u32 data       offset of the content
+    u32 dataSize   size of the content
+    u16 pathLen    length of the path without the NUL
+    u16 flags      bit 0: content is gzipped
+    u8[8] hash     first 8 bytes of the SHA-256 of the content (used as ETag)
+
+  Paths, then contents.
+"""
+
+from __future__ import annotations
+
+import argparse
+import hashlib
+import os
+import struct
+import sys
+import zlib
+
+MAGIC = b"AXWA"
+VERSION = 1
+HEADER = struct.Struct("<4sHHII")
+ENTRY = struct.Struct("<IIIHH8s")
+FLAG_GZIP = 0x0001
+
+
+def align(n: int) -> int:
+    return (n + 3) & ~3
+
+
+def collect(dist: str) -> dict[str, tuple[bytes, int]]:
+    """Return {path: (content, flags)} for all files below dist."""
+    files: dict[str, tuple[bytes, int]] = {}
+    for root, _, names in os.walk(dist):
+        for name in names:
+            full = os.path.join(root, name)
+            rel = "/" + os.path.relpath(full, dist).replace(os.sep, "/")
+            flags = 0
+            if rel.endswith(".gz"):
+                rel = rel[:-3]
+                flags = FLAG_GZIP
+            elif rel in files:
+                # Already have the gzipped variant.
+                continue
+            with open(full, "rb") as f:
+                files[rel] = (f.read(), flags)
+    return files
+
+
+def pack(files: dict[str, tuple[bytes, int]]) -> bytes:
+    paths = sorted(files, key=lambda p: p.encode())
+    if len(paths) > 0xFFFF:
+        raise ValueError("too many files")
+
+    offset = HEADER.size + ENTRY.size * len(paths)
+
+    path_offsets = []
+    path_blob = bytearray()
+    for p in paths:
+        path_offsets.append(offset + len(path_blob))
+        path_blob += p.encode() + b"\0"
+    path_blob += b"\0" * (align(len(path_blob)) - len(path_blob))
+    offset += len(path_blob)
+
+    index = bytearray()
+    data_blob = bytearray()
+    for p, path_offset in zip(paths, path_offsets):
+        content, flags = files[p]
+        index += ENTRY.pack(
+            path_offset,
+            offset + len(data_blob),
+            len(content),
+            len(p.encode()),
+            flags,
+            hashlib.sha256(content).digest()[:8],
+        )
+        data_blob += content
+        data_blob += b"\0" * (align(len(data_blob)) - len(data_blob))
+
+    body = bytes(index + path_blob + data_blob)
+    size = HEADER.size + len(body)
+    header = HEADER.pack(MAGIC, VERSION, len(paths), size, zlib.crc32(body))
+    return header + body
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("dist", help="directory with the built web UI")
+    parser.add_argument("output", help="archive file to write")
+    parser.add_argument("--max-size", type=lambda s: int(s, 0), default=0,
+                        help="fail if the archive is bigger than this")
+    args = parser.parse_args()
+
+    files = collect(args.dist)
+    if not files:
+        print(f"wwwpack: no files in {args.dist}", file=sys.stderr)
+        return 1
+
+    archive = pack(files)
+    if args.max_size and len(archive) > args.max_size:
+        print(f"wwwpack: archive is {len(archive)} bytes, partition only {args.max_size}", file=sys.stderr)
+        return 1
+
+    with open(args.output, "wb") as f:
+        f.write(archive)
+
+    print(f"wwwpack: {len(files)} files, {len(archive)} bytes -> {args.output}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())